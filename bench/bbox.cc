@@ -0,0 +1,108 @@
+#include <dballe/db/db.h>
+#include <dballe/core/benchmark.h>
+#include <dballe/core/data.h>
+#include <dballe/core/query.h>
+#include <random>
+#include <vector>
+
+/**
+ * Run many small bounding box queries on a database with many stations, as
+ * a map tile server would
+ */
+struct BenchmarkBBox : public dballe::benchmark::Task
+{
+    std::shared_ptr<dballe::db::DB> db;
+    const char* m_name;
+    unsigned stations;
+    /// Size of the side of each query box, in degrees
+    double size;
+    /// Number of queries run by each iteration
+    unsigned queries;
+    std::vector<dballe::core::Query> boxes;
+
+    BenchmarkBBox(const char* name, unsigned stations, double size, unsigned queries=1000)
+        : m_name(name), stations(stations), size(size), queries(queries)
+    {
+        auto options = dballe::DBConnectOptions::test_create();
+        db = dballe::db::DB::downcast(dballe::DB::connect(*options));
+    }
+
+    const char* name() const override { return m_name; }
+
+    void setup() override
+    {
+        db->reset();
+
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<double> lats(-80.0, 80.0);
+        std::uniform_real_distribution<double> lons(-180.0, 179.0);
+
+        std::vector<dballe::core::Data> records(stations);
+        std::vector<dballe::Data*> data;
+        for (unsigned i = 0; i < stations; ++i)
+        {
+            auto& rec = records[i];
+            rec.station.report = i % 3 ? "synop" : "mobile";
+            rec.station.coords = dballe::Coords(lats(gen), lons(gen));
+            if (i % 3 == 0)
+                rec.station.ident = "mob";
+            rec.level = dballe::Level(1);
+            rec.trange = dballe::Trange::instant();
+            rec.datetime = dballe::Datetime(2018, 1, 1);
+            rec.values.set("B12101", 280.0);
+            data.push_back(&rec);
+        }
+
+        auto tr = db->transaction();
+        tr->insert_data_many(data, dballe::DBInsertOptions::defaults, false);
+        tr->commit();
+
+        boxes.clear();
+        for (unsigned i = 0; i < queries; ++i)
+        {
+            dballe::core::Query query;
+            double lat = lats(gen), lon = lons(gen);
+            query.latrange.set(lat, lat + size);
+            query.lonrange.set(lon, lon + size);
+            boxes.emplace_back(query);
+        }
+    }
+
+    void run_once() override
+    {
+        auto tr = std::dynamic_pointer_cast<dballe::db::Transaction>(db->transaction());
+        for (const auto& query: boxes)
+        {
+            auto cur = tr->query_stations(query);
+            while (cur->next())
+                ++items;
+        }
+        tr->commit();
+    }
+
+    void teardown() override
+    {
+        db->remove_all();
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    using namespace dballe::benchmark;
+    dballe::benchmark::Task* tasks[] = {
+        new BenchmarkBBox("tiles_10k", 10000, 1.0),
+        new BenchmarkBBox("tiles_200k", 200000, 0.5),
+        new BenchmarkBBox("region_200k", 200000, 10.0, 50),
+    };
+
+    Benchmark benchmark;
+    dballe::benchmark::Options options(argc, argv);
+    options.setup(benchmark);
+
+    for (auto task: tasks)
+        if (options.whitelist.has(task->name()))
+            benchmark.timeit(*task, 5);
+
+    options.print(benchmark);
+    return 0;
+}
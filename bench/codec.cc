@@ -0,0 +1,142 @@
+#include <dballe/core/benchmark.h>
+#include <dballe/file.h>
+#include <dballe/importer.h>
+#include <dballe/exporter.h>
+#include <dballe/message.h>
+#include <string>
+#include <vector>
+
+/// Decode all the messages of a file, without any database access
+struct BenchmarkDecode : public dballe::benchmark::Task
+{
+    const char* m_name;
+    const char* m_pathname;
+    dballe::Encoding encoding;
+    std::vector<dballe::BinaryMessage> binmsgs;
+
+    BenchmarkDecode(const char* name, const char* pathname, dballe::Encoding encoding=dballe::Encoding::BUFR)
+        : m_name(name), m_pathname(pathname), encoding(encoding)
+    {
+    }
+
+    const char* name() const override { return m_name; }
+
+    void setup() override
+    {
+        binmsgs.clear();
+        auto file = dballe::File::create(encoding, m_pathname, "r");
+        file->foreach([&](const dballe::BinaryMessage& bmsg) { binmsgs.push_back(bmsg); return true; });
+    }
+
+    void run_once() override
+    {
+        auto importer = dballe::Importer::create(encoding);
+        for (const auto& bmsg: binmsgs)
+            importer->foreach_decoded(bmsg, [&](std::shared_ptr<dballe::Message>) { ++items; return true; });
+    }
+
+    void teardown() override
+    {
+        binmsgs.clear();
+    }
+};
+
+/// Decode JSON messages converted from a BUFR file
+struct BenchmarkDecodeJSON : public BenchmarkDecode
+{
+    BenchmarkDecodeJSON(const char* name, const char* pathname)
+        : BenchmarkDecode(name, pathname, dballe::Encoding::JSON)
+    {
+    }
+
+    void setup() override
+    {
+        binmsgs.clear();
+        dballe::benchmark::Messages messages;
+        messages.load(m_pathname);
+        auto exporter = dballe::Exporter::create(dballe::Encoding::JSON);
+        for (const auto& msgs: messages)
+        {
+            binmsgs.emplace_back(dballe::BinaryMessage(dballe::Encoding::JSON));
+            binmsgs.back().data = exporter->to_binary(msgs);
+        }
+    }
+};
+
+/// Encode messages with a given template
+struct BenchmarkEncode : public dballe::benchmark::Task
+{
+    const char* m_name;
+    const char* m_pathname;
+    dballe::Encoding encoding;
+    std::string template_name;
+    dballe::benchmark::Messages messages;
+
+    BenchmarkEncode(const char* name, const char* pathname, dballe::Encoding encoding, const char* template_name="")
+        : m_name(name), m_pathname(pathname), encoding(encoding), template_name(template_name)
+    {
+    }
+
+    const char* name() const override { return m_name; }
+
+    void setup() override
+    {
+        messages.clear();
+        messages.load(m_pathname);
+    }
+
+    void run_once() override
+    {
+        auto opts = dballe::ExporterOptions::create();
+        opts->template_name = template_name;
+        auto exporter = dballe::Exporter::create(encoding, *opts);
+        for (const auto& msgs: messages)
+        {
+            exporter->to_binary(msgs);
+            ++items;
+        }
+    }
+
+    void teardown() override
+    {
+        messages.clear();
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    using namespace dballe::benchmark;
+    using dballe::Encoding;
+    dballe::benchmark::Task* tasks[] = {
+        new BenchmarkDecode("decode-bufr-synop", "extra/bufr/synop-rad1.bufr"),
+        new BenchmarkDecode("decode-bufr-temp", "extra/bufr/temp-huge.bufr"),
+        new BenchmarkDecode("decode-bufr-acars", "extra/bufr/gts-acars2.bufr"),
+        new BenchmarkDecode("decode-bufr-generic", "extra/bufr/gen-generic.bufr"),
+        new BenchmarkDecode("decode-crex-synop", "extra/crex/test-synop0.crex", Encoding::CREX),
+        new BenchmarkDecode("decode-crex-temp", "extra/crex/test-temp0.crex", Encoding::CREX),
+        new BenchmarkDecodeJSON("decode-json-synop", "extra/bufr/synop-rad1.bufr"),
+        new BenchmarkDecodeJSON("decode-json-temp", "extra/bufr/temp-huge.bufr"),
+        new BenchmarkEncode("encode-bufr-synop", "extra/bufr/synop-rad1.bufr", Encoding::BUFR),
+        new BenchmarkEncode("encode-bufr-synop-wmo", "extra/bufr/synop-rad1.bufr", Encoding::BUFR, "synop-wmo"),
+        new BenchmarkEncode("encode-bufr-synop-generic", "extra/bufr/synop-rad1.bufr", Encoding::BUFR, "generic"),
+        new BenchmarkEncode("encode-bufr-temp", "extra/bufr/temp-huge.bufr", Encoding::BUFR),
+        new BenchmarkEncode("encode-bufr-temp-wmo", "extra/bufr/temp-huge.bufr", Encoding::BUFR, "temp-wmo"),
+        new BenchmarkEncode("encode-bufr-temp-generic", "extra/bufr/temp-huge.bufr", Encoding::BUFR, "generic"),
+        new BenchmarkEncode("encode-bufr-acars", "extra/bufr/gts-acars2.bufr", Encoding::BUFR),
+        new BenchmarkEncode("encode-bufr-acars-wmo", "extra/bufr/gts-acars2.bufr", Encoding::BUFR, "acars-wmo"),
+        new BenchmarkEncode("encode-crex-synop", "extra/bufr/synop-rad1.bufr", Encoding::CREX),
+        new BenchmarkEncode("encode-json-synop", "extra/bufr/synop-rad1.bufr", Encoding::JSON),
+        new BenchmarkEncode("encode-json-temp", "extra/bufr/temp-huge.bufr", Encoding::JSON),
+    };
+
+    Benchmark benchmark;
+    dballe::benchmark::Options options(argc, argv);
+    options.setup(benchmark);
+
+    for (auto task: tasks)
+        if (options.whitelist.has(task->name()))
+            benchmark.timeit(*task, 10);
+
+    options.print(benchmark);
+    return 0;
+}
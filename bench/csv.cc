@@ -0,0 +1,96 @@
+#include <dballe/core/benchmark.h>
+#include <dballe/core/csv.h>
+#include <dballe/msg/msg.h>
+#include <sstream>
+#include <string>
+
+/**
+ * Generate CSV data in the format written by dbamsg convert --dest=csv
+ */
+static std::string make_csv(unsigned stations, unsigned hours)
+{
+    std::stringstream out;
+    out << "Longitude,Latitude,Report,Date,Level1,L1,Level2,L2,Time range,P1,P2,Varcode,Value\r\n";
+    for (unsigned s = 0; s < stations; ++s)
+    {
+        for (unsigned h = 0; h < hours; ++h)
+        {
+            char date[32];
+            snprintf(date, 32, "2018-01-%02u %02u:00:00", 1 + h / 24, h % 24);
+            out << (11.0 + s * 0.01) << "," << (44.0 + s * 0.01) << ",synop," << date
+                << ",1,,,,254,0,0,B12101," << (273.15 + h % 20) << "\r\n";
+            out << (11.0 + s * 0.01) << "," << (44.0 + s * 0.01) << ",synop," << date
+                << ",1,,,,254,0,0,B13003," << (50 + h % 50) << "\r\n";
+            out << (11.0 + s * 0.01) << "," << (44.0 + s * 0.01) << ",synop," << date
+                << ",103,2000,,,254,0,0,B01019,\"Station, " << s << "\"\r\n";
+        }
+    }
+    return out.str();
+}
+
+/// Tokenize CSV input
+struct BenchmarkTokenize : public dballe::benchmark::Task
+{
+    std::string data;
+
+    const char* name() const override { return "tokenize"; }
+
+    void setup() override
+    {
+        data = make_csv(100, 24 * 30);
+    }
+
+    void run_once() override
+    {
+        std::stringstream in(data);
+        dballe::CSVReader reader(in);
+        while (reader.next())
+            ++items;
+    }
+};
+
+/// Parse CSV input into messages
+struct BenchmarkMessages : public dballe::benchmark::Task
+{
+    std::string data;
+
+    const char* name() const override { return "messages"; }
+
+    void setup() override
+    {
+        data = make_csv(100, 24 * 30);
+    }
+
+    void run_once() override
+    {
+        std::stringstream in(data);
+        dballe::CSVReader reader(in);
+        while (true)
+        {
+            auto msgs = dballe::impl::msg::messages_from_csv(reader);
+            if (msgs.empty())
+                break;
+            items += msgs.size();
+        }
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    using namespace dballe::benchmark;
+    dballe::benchmark::Task* tasks[] = {
+        new BenchmarkTokenize,
+        new BenchmarkMessages,
+    };
+
+    Benchmark benchmark;
+    dballe::benchmark::Options options(argc, argv);
+    options.setup(benchmark);
+
+    for (auto task: tasks)
+        if (options.whitelist.has(task->name()))
+            benchmark.timeit(*task, 5);
+
+    options.print(benchmark);
+    return 0;
+}
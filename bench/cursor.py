@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+Benchmark iterating database cursors from Python.
+
+Usage: cursor.py [--json] [task names...]
+
+The database is the test database (see DBA_DB). Output is in the same format
+as the C++ benchmark programs.
+"""
+import argparse
+import datetime
+import json
+import resource
+import sys
+import time
+
+import dballe
+
+
+class Task:
+    repetitions = 10
+
+    def __init__(self, name, func):
+        self.name = name
+        self.func = func
+
+    def run(self, tr):
+        """
+        Run the task, returning a dict with its results
+        """
+        res = {"name": self.name, "type": "timeit", "failed": False}
+        try:
+            items = 0
+            usage_start = resource.getrusage(resource.RUSAGE_SELF)
+            start = time.monotonic()
+            for i in range(self.repetitions):
+                items += self.func(tr)
+            elapsed = time.monotonic() - start
+            usage_end = resource.getrusage(resource.RUSAGE_SELF)
+        except Exception as e:
+            print("{}: failed: {}".format(self.name, e), file=sys.stderr)
+            res["failed"] = True
+            return res
+
+        res["repetitions"] = self.repetitions
+        res["seconds"] = elapsed
+        res["user"] = usage_end.ru_utime - usage_start.ru_utime
+        res["system"] = usage_end.ru_stime - usage_start.ru_stime
+        res["runs_per_second"] = self.repetitions / elapsed if elapsed > 0 else 0.0
+        res["items"] = items
+        res["items_per_second"] = items / elapsed if elapsed > 0 else 0.0
+        return res
+
+
+def populate(db, stations, hours):
+    with db.transaction() as tr:
+        for s in range(stations):
+            for h in range(hours):
+                tr.insert_data({
+                    "report": "synop",
+                    "lat": 44.0 + s * 0.01,
+                    "lon": 11.0 + s * 0.01,
+                    "level": dballe.Level(103, 2000),
+                    "trange": dballe.Trange(254, 0, 0),
+                    "datetime": datetime.datetime(2018, 1, 1) + datetime.timedelta(hours=h),
+                    "B12101": 273.15 + h % 20,
+                    "B13003": 50 + h % 50,
+                }, can_add_stations=True)
+
+
+def iterate(tr):
+    count = 0
+    for row in tr.query_data({}):
+        count += 1
+    return count
+
+
+def iterate_variable(tr):
+    count = 0
+    for row in tr.query_data({}):
+        row["variable"].enq()
+        count += 1
+    return count
+
+
+def iterate_keys(tr):
+    count = 0
+    for row in tr.query_data({}):
+        row["lat"], row["lon"], row["report"], row["level"], row["trange"], row["datetime"]
+        count += 1
+    return count
+
+
+def iterate_data(tr):
+    count = 0
+    for row in tr.query_data({}):
+        row.data
+        count += 1
+    return count
+
+
+def iterate_data_dict(tr):
+    count = 0
+    for row in tr.query_data({}):
+        row.data_dict
+        count += 1
+    return count
+
+
+def volnd_read(tr):
+    from dballe import volnd
+    res = volnd.read(tr.query_data({}), (volnd.AnaIndex(), volnd.DateTimeIndex()))
+    return sum(v.vals.size for v in res.values())
+
+
+TASKS = [
+    Task("iterate", iterate),
+    Task("iterate-variable", iterate_variable),
+    Task("iterate-keys", iterate_keys),
+    Task("iterate-data", iterate_data),
+    Task("iterate-data-dict", iterate_data_dict),
+    Task("volnd", volnd_read),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark iterating database cursors from Python.")
+    parser.add_argument("--json", action="store_true", help="print results as JSON")
+    parser.add_argument("--stations", type=int, default=100, help="number of stations to insert")
+    parser.add_argument("--hours", type=int, default=240, help="number of hours of data for each station")
+    parser.add_argument("tasks", nargs="*", help="names of the tasks to run")
+    args = parser.parse_args()
+
+    progress = sys.stderr if args.json else sys.stdout
+
+    db = dballe.DB.connect_test()
+    db.reset()
+    populate(db, args.stations, args.hours)
+
+    results = []
+    for task in TASKS:
+        if args.tasks and task.name not in args.tasks:
+            continue
+        print("{}: starting...".format(task.name), file=progress)
+        with db.transaction() as tr:
+            results.append(task.run(tr))
+        print("{}: done.".format(task.name), file=progress)
+
+    db.remove_all()
+
+    if args.json:
+        json.dump({
+            "tasks": results,
+            "max_rss_kb": resource.getrusage(resource.RUSAGE_SELF).ru_maxrss,
+        }, sys.stdout)
+        print()
+    else:
+        for res in results:
+            if res["failed"]:
+                continue
+            print("{},{},{:.3f}s".format(res["name"], res["repetitions"], res["seconds"]))
+
+
+if __name__ == "__main__":
+    main()
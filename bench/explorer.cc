@@ -0,0 +1,172 @@
+#include <dballe/db/db.h>
+#include <dballe/db/explorer.h>
+#include <dballe/core/benchmark.h>
+#include <dballe/core/data.h>
+#include <dballe/core/query.h>
+#include <dballe/core/json.h>
+#include <random>
+#include <sstream>
+#include <vector>
+
+/**
+ * Database with many stations, each with a few variables, as browsed by an
+ * explorer
+ */
+struct ExplorerTask : public dballe::benchmark::Task
+{
+    std::shared_ptr<dballe::db::DB> db;
+    const char* m_name;
+    unsigned stations;
+    dballe::db::Explorer explorer;
+
+    ExplorerTask(const char* name, unsigned stations)
+        : m_name(name), stations(stations)
+    {
+        auto options = dballe::DBConnectOptions::test_create();
+        db = dballe::db::DB::downcast(dballe::DB::connect(*options));
+    }
+
+    const char* name() const override { return m_name; }
+
+    void setup() override
+    {
+        db->reset();
+
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<double> lats(-80.0, 80.0);
+        std::uniform_real_distribution<double> lons(-180.0, 179.0);
+        const char* reports[] = { "synop", "metar", "temp", "mobile" };
+
+        std::vector<dballe::core::Data> records;
+        records.reserve(stations * 2);
+        for (unsigned i = 0; i < stations; ++i)
+        {
+            dballe::Coords coords(lats(gen), lons(gen));
+            for (unsigned h = 0; h < 2; ++h)
+            {
+                records.emplace_back();
+                auto& rec = records.back();
+                rec.station.report = reports[i % 4];
+                rec.station.coords = coords;
+                rec.level = i % 4 == 2 ? dballe::Level(100, 85000) : dballe::Level(103, 2000);
+                rec.trange = dballe::Trange::instant();
+                rec.datetime = dballe::Datetime(2018, 1, 1, h * 12);
+                rec.values.set("B12101", 280.0);
+                rec.values.set("B13003", 50);
+                if (i % 2)
+                    rec.values.set("B10004", 100000.0);
+            }
+        }
+        std::vector<dballe::Data*> data;
+        for (auto& rec: records)
+            data.push_back(&rec);
+
+        auto tr = db->transaction();
+        tr->insert_data_many(data, dballe::DBInsertOptions::defaults, false);
+        tr->commit();
+
+        auto t = std::dynamic_pointer_cast<dballe::db::Transaction>(db->transaction());
+        auto update = explorer.rebuild();
+        update.add_db(*t);
+        update.commit();
+        t->rollback();
+    }
+
+    void teardown() override
+    {
+        db->remove_all();
+    }
+};
+
+/// Rebuild the explorer from the database
+struct BenchmarkRebuild : public ExplorerTask
+{
+    using ExplorerTask::ExplorerTask;
+
+    void run_once() override
+    {
+        auto tr = std::dynamic_pointer_cast<dballe::db::Transaction>(db->transaction());
+        {
+            auto update = explorer.rebuild();
+            update.add_db(*tr);
+        }
+        tr->rollback();
+        items += explorer.global_summary().data_count();
+    }
+};
+
+/// Change the explorer filter, as an interactive user would
+struct BenchmarkFilter : public ExplorerTask
+{
+    std::vector<dballe::core::Query> filters;
+
+    BenchmarkFilter(const char* name, unsigned stations)
+        : ExplorerTask(name, stations)
+    {
+        dballe::core::Query query;
+        filters.push_back(query);
+        query.report = "synop";
+        filters.push_back(query);
+        query.varcodes.insert(WR_VAR(0, 12, 101));
+        filters.push_back(query);
+        query = dballe::core::Query();
+        query.latrange.set(30.0, 60.0);
+        query.lonrange.set(-10.0, 40.0);
+        filters.push_back(query);
+        query.level = dballe::Level(103, 2000);
+        filters.push_back(query);
+        query = dballe::core::Query();
+        query.dtrange = dballe::DatetimeRange(dballe::Datetime(2018, 1, 1, 6), dballe::Datetime(2018, 1, 1, 18));
+        filters.push_back(query);
+    }
+
+    void run_once() override
+    {
+        for (const auto& filter: filters)
+        {
+            explorer.set_filter(filter);
+            ++items;
+        }
+    }
+};
+
+/// Serialize the explorer to JSON and load it back
+struct BenchmarkJSON : public ExplorerTask
+{
+    using ExplorerTask::ExplorerTask;
+
+    void run_once() override
+    {
+        std::stringstream buf;
+        dballe::core::JSONWriter writer(buf);
+        explorer.to_json(writer);
+
+        dballe::db::Explorer loaded;
+        auto update = loaded.rebuild();
+        std::string json = buf.str();
+        dballe::core::json::Stream in(json);
+        update.add_json(in);
+        items += loaded.global_summary().data_count();
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    using namespace dballe::benchmark;
+    dballe::benchmark::Task* tasks[] = {
+        new BenchmarkRebuild("rebuild", 10000),
+        new BenchmarkFilter("filter", 10000),
+        new BenchmarkJSON("json", 10000),
+    };
+
+    Benchmark benchmark;
+    dballe::benchmark::Options options(argc, argv);
+    options.setup(benchmark);
+
+    for (auto task: tasks)
+        if (options.whitelist.has(task->name()))
+            benchmark.timeit(*task, 10);
+
+    options.print(benchmark);
+    return 0;
+}
@@ -40,7 +40,10 @@ struct BenchmarkImport : public dballe::benchmark::Task
     {
         auto tr = db->transaction();
         for (const auto& msgs: messages)
+        {
             tr->import_messages(msgs);
+            ++items;
+        }
         tr->commit();
     }
 
@@ -60,12 +63,13 @@ int main(int argc, const char* argv[])
     };
 
     Benchmark benchmark;
-    dballe::benchmark::Whitelist whitelist(argc, argv);
+    dballe::benchmark::Options options(argc, argv);
+    options.setup(benchmark);
 
     for (auto task: tasks)
-        if (whitelist.has(task->name()))
+        if (options.whitelist.has(task->name()))
             benchmark.timeit(*task);
 
-    benchmark.print_timings();
+    options.print(benchmark);
     return 0;
 }
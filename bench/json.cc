@@ -0,0 +1,97 @@
+#include <dballe/core/benchmark.h>
+#include <dballe/file.h>
+#include <dballe/importer.h>
+#include <dballe/message.h>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+/**
+ * Generate JSON data in the format written by the JSON exporter
+ */
+static std::string make_json(unsigned stations, unsigned hours)
+{
+    std::stringstream out;
+    for (unsigned s = 0; s < stations; ++s)
+    {
+        for (unsigned h = 0; h < hours; ++h)
+        {
+            char date[32];
+            snprintf(date, 32, "2018-01-%02uT%02u:00:00Z", 1 + h / 24, h % 24);
+            out << R"({"version":"0.1","network":"synop","ident":null,"lon":)" << (1100000 + s * 1000)
+                << R"(,"lat":)" << (4400000 + s * 1000)
+                << R"(,"date":")" << date << R"(","data":[)"
+                << R"({"vars":{"B01019":{"v":"Station )" << s << R"("},"B07030":{"v":)" << (s % 100) << ".0}}},"
+                << R"({"timerange":[254,0,0],"level":[103,2000,null,null],"vars":{"B12101":{"v":)" << (273.15 + h % 20)
+                << R"(,"a":{"B33007":70}},"B13003":{"v":)" << (50 + h % 50) << "}}}"
+                << "]}\n";
+        }
+    }
+    return out.str();
+}
+
+struct JSONTask : public dballe::benchmark::Task
+{
+    std::string pathname;
+
+    void setup() override
+    {
+        pathname = std::string("bench-") + name() + ".json";
+        std::string data = make_json(100, 24 * 30);
+        FILE* out = fopen(pathname.c_str(), "wb");
+        fwrite(data.data(), data.size(), 1, out);
+        fclose(out);
+    }
+
+    void teardown() override
+    {
+        remove(pathname.c_str());
+    }
+};
+
+/// Split a JSON file into messages
+struct BenchmarkSplit : public JSONTask
+{
+    const char* name() const override { return "split"; }
+
+    void run_once() override
+    {
+        auto file = dballe::File::create(dballe::Encoding::JSON, pathname, "r");
+        file->foreach([&](const dballe::BinaryMessage&) { ++items; return true; });
+    }
+};
+
+/// Decode a JSON file into messages
+struct BenchmarkDecode : public JSONTask
+{
+    const char* name() const override { return "decode"; }
+
+    void run_once() override
+    {
+        auto file = dballe::File::create(dballe::Encoding::JSON, pathname, "r");
+        auto importer = dballe::Importer::create(dballe::Encoding::JSON);
+        file->foreach([&](const dballe::BinaryMessage& bmsg) {
+            return importer->foreach_decoded(bmsg, [&](std::shared_ptr<dballe::Message>) { ++items; return true; });
+        });
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    using namespace dballe::benchmark;
+    dballe::benchmark::Task* tasks[] = {
+        new BenchmarkSplit,
+        new BenchmarkDecode,
+    };
+
+    Benchmark benchmark;
+    dballe::benchmark::Options options(argc, argv);
+    options.setup(benchmark);
+
+    for (auto task: tasks)
+        if (options.whitelist.has(task->name()))
+            benchmark.timeit(*task, 5);
+
+    options.print(benchmark);
+    return 0;
+}
@@ -3,31 +3,36 @@
 #include <dballe/core/benchmark.h>
 #include <dballe/core/query.h>
 #include <dballe/msg/msg.h>
+#include <functional>
 #include <vector>
 
-struct BenchmarkQuery : public dballe::benchmark::Task
+/**
+ * Database populated with copies of the messages in a file, shared by all
+ * the queries run on it
+ */
+struct Dataset
 {
     std::shared_ptr<dballe::db::DB> db;
-    const char* m_name;
-    const char* m_pathname;
+    const char* pathname;
     unsigned months;
     unsigned hours;
     unsigned minutes;
+    bool loaded = false;
+    /// ID of the first station in the database
+    int ana_id = dballe::MISSING_INT;
 
-    BenchmarkQuery(const char* name, const char* pathname, unsigned months=12, unsigned hours=24, unsigned minutes=1)
-        : m_name(name), m_pathname(pathname), months(months), hours(hours), minutes(minutes)
+    Dataset(std::shared_ptr<dballe::db::DB> db, const char* pathname, unsigned months=12, unsigned hours=24, unsigned minutes=1)
+        : db(db), pathname(pathname), months(months), hours(hours), minutes(minutes)
     {
-        auto options = dballe::DBConnectOptions::test_create();
-        db = dballe::db::DB::downcast(dballe::DB::connect(*options));
     }
 
-    const char* name() const override { return m_name; }
-
-    void setup() override
+    void load()
     {
+        if (loaded) return;
+
         db->reset();
         dballe::benchmark::Messages messages;
-        messages.load(m_pathname);
+        messages.load(pathname);
 
         // Multiply messages by changing their datetime
         size_t size = messages.size();
@@ -40,42 +45,131 @@ struct BenchmarkQuery : public dballe::benchmark::Task
         auto tr = db->transaction();
         for (const auto& msgs: messages)
             tr->import_messages(msgs);
+        dballe::core::Query query;
+        auto cur = tr->query_stations(query);
+        if (cur->next())
+            ana_id = cur->get_station().id;
+        cur->discard();
         tr->commit();
+
+        loaded = true;
     }
+};
 
-    void run_once() override
+struct BenchmarkQuery : public dballe::benchmark::Task
+{
+    enum Type {
+        DATA,
+        SUMMARY,
+        MESSAGES,
+    };
+
+    std::shared_ptr<Dataset> dataset;
+    const char* m_name;
+    Type type;
+    std::function<void(Dataset&, dballe::core::Query&)> make_query;
+    dballe::core::Query query;
+
+    BenchmarkQuery(const char* name, std::shared_ptr<Dataset> dataset, Type type=DATA, std::function<void(Dataset&, dballe::core::Query&)> make_query=nullptr)
+        : dataset(dataset), m_name(name), type(type), make_query(make_query)
     {
-        auto tr = std::dynamic_pointer_cast<dballe::db::Transaction>(db->transaction());
-        dballe::core::Query query;
-        auto cur = tr->query_data(query);
-        while (cur->next())
-            ;
-        tr->commit();
     }
 
-    void teardown() override
+    const char* name() const override { return m_name; }
+
+    void setup() override
+    {
+        dataset->load();
+        query = dballe::core::Query();
+        if (make_query)
+            make_query(*dataset, query);
+    }
+
+    void run_once() override
     {
-        db->remove_all();
+        auto tr = std::dynamic_pointer_cast<dballe::db::Transaction>(dataset->db->transaction());
+        switch (type)
+        {
+            case DATA: {
+                auto cur = tr->query_data(query);
+                while (cur->next())
+                    ++items;
+                break;
+            }
+            case SUMMARY: {
+                auto cur = tr->query_summary(query);
+                while (cur->next())
+                    ++items;
+                break;
+            }
+            case MESSAGES: {
+                auto cur = tr->query_messages(query);
+                while (cur->next())
+                    ++items;
+                break;
+            }
+        }
+        tr->commit();
     }
 };
 
 int main(int argc, const char* argv[])
 {
     using namespace dballe::benchmark;
+
+    auto options = dballe::DBConnectOptions::test_create();
+    auto db = dballe::db::DB::downcast(dballe::DB::connect(*options));
+    auto synop = std::make_shared<Dataset>(db, "extra/bufr/synop-rad1.bufr", 1, 24);
+    auto temp = std::make_shared<Dataset>(db, "extra/bufr/temp-huge.bufr", 1, 1);
+    auto acars = std::make_shared<Dataset>(db, "extra/bufr/gts-acars2.bufr", 12, 24, 10);
+
+    // Tasks using the same dataset are listed together, so that it is loaded
+    // only once
     dballe::benchmark::Task* tasks[] = {
-        new BenchmarkQuery("synop", "extra/bufr/synop-rad1.bufr", 1, 24),
-        new BenchmarkQuery("temp", "extra/bufr/temp-huge.bufr", 1, 1),
-        new BenchmarkQuery("acars", "extra/bufr/gts-acars2.bufr", 12, 24, 10),
+        new BenchmarkQuery("synop", synop),
+        new BenchmarkQuery("synop-station", synop, BenchmarkQuery::DATA, [](Dataset& d, dballe::core::Query& q) {
+            q.ana_id = d.ana_id;
+        }),
+        new BenchmarkQuery("synop-varcode", synop, BenchmarkQuery::DATA, [](Dataset&, dballe::core::Query& q) {
+            q.varcodes.insert(WR_VAR(0, 12, 101));
+        }),
+        new BenchmarkQuery("synop-dtrange", synop, BenchmarkQuery::DATA, [](Dataset&, dballe::core::Query& q) {
+            q.dtrange = dballe::DatetimeRange(dballe::Datetime(2016, 1, 1, 6), dballe::Datetime(2016, 1, 1, 11, 59, 59));
+        }),
+        new BenchmarkQuery("synop-best", synop, BenchmarkQuery::DATA, [](Dataset&, dballe::core::Query& q) {
+            q.query = "best";
+        }),
+        new BenchmarkQuery("synop-last", synop, BenchmarkQuery::DATA, [](Dataset&, dballe::core::Query& q) {
+            q.query = "last";
+        }),
+        new BenchmarkQuery("synop-summary", synop, BenchmarkQuery::SUMMARY),
+        new BenchmarkQuery("synop-messages", synop, BenchmarkQuery::MESSAGES),
+        new BenchmarkQuery("temp", temp),
+        new BenchmarkQuery("temp-messages", temp, BenchmarkQuery::MESSAGES),
+        new BenchmarkQuery("acars", acars),
+        new BenchmarkQuery("acars-bbox", acars, BenchmarkQuery::DATA, [](Dataset&, dballe::core::Query& q) {
+            q.latrange.set(0.0, 90.0);
+            q.lonrange.set(-180.0, 0.0);
+        }),
+        new BenchmarkQuery("acars-summary", acars, BenchmarkQuery::SUMMARY),
     };
 
     Benchmark benchmark;
-    dballe::benchmark::Whitelist whitelist(argc, argv);
+    dballe::benchmark::Options bench_options(argc, argv);
+    bench_options.setup(benchmark);
 
     for (auto task: tasks)
-        if (whitelist.has(task->name()))
+        if (bench_options.whitelist.has(task->name()))
+        {
+            // Only one dataset at a time fits in the database
+            auto& dataset = dynamic_cast<BenchmarkQuery*>(task)->dataset;
+            if (!dataset->loaded)
+                for (auto d: { synop, temp, acars })
+                    d->loaded = false;
             benchmark.timeit(*task, 20);
+        }
 
-    benchmark.print_timings();
+    bench_options.print(benchmark);
+    db->remove_all();
     return 0;
 }
-
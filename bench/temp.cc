@@ -0,0 +1,96 @@
+#include <dballe/core/benchmark.h>
+#include <dballe/file.h>
+#include <dballe/importer.h>
+#include <dballe/exporter.h>
+#include <dballe/msg/msg.h>
+#include <vector>
+
+/**
+ * Decode soundings with thousands of levels
+ */
+struct TempTask : public dballe::benchmark::Task
+{
+    const char* m_name;
+    const char* m_pathname;
+    std::vector<dballe::BinaryMessage> binmsgs;
+    std::unique_ptr<dballe::Importer> importer;
+
+    TempTask(const char* name, const char* pathname)
+        : m_name(name), m_pathname(pathname), importer(dballe::Importer::create(dballe::Encoding::BUFR))
+    {
+    }
+
+    const char* name() const override { return m_name; }
+
+    void setup() override
+    {
+        binmsgs.clear();
+        auto file = dballe::File::create(dballe::Encoding::BUFR, m_pathname, "r");
+        file->foreach([&](const dballe::BinaryMessage& bmsg) { binmsgs.push_back(bmsg); return true; });
+    }
+
+    void teardown() override
+    {
+        binmsgs.clear();
+    }
+};
+
+/// Decode, and walk the contexts in order
+struct BenchmarkDecode : public TempTask
+{
+    using TempTask::TempTask;
+
+    void run_once() override
+    {
+        for (const auto& bmsg: binmsgs)
+            importer->foreach_decoded(bmsg, [&](std::shared_ptr<dballe::Message> msg) {
+                ++items;
+                const auto& m = dballe::impl::Message::downcast(*msg);
+                size_t count = 0;
+                for (const auto& ctx: m.data)
+                    count += ctx.values.size();
+                return count > 0;
+            });
+    }
+};
+
+/// Decode and reencode
+struct BenchmarkRoundtrip : public TempTask
+{
+    std::unique_ptr<dballe::Exporter> exporter;
+
+    BenchmarkRoundtrip(const char* name, const char* pathname)
+        : TempTask(name, pathname), exporter(dballe::Exporter::create(dballe::Encoding::BUFR))
+    {
+    }
+
+    void run_once() override
+    {
+        for (const auto& bmsg: binmsgs)
+        {
+            auto msgs = importer->from_binary(bmsg);
+            exporter->to_binary(msgs);
+            items += msgs.size();
+        }
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    using namespace dballe::benchmark;
+    dballe::benchmark::Task* tasks[] = {
+        new BenchmarkDecode("decode", "extra/bufr/temp-huge.bufr"),
+        new BenchmarkRoundtrip("roundtrip", "extra/bufr/temp-huge.bufr"),
+    };
+
+    Benchmark benchmark;
+    dballe::benchmark::Options options(argc, argv);
+    options.setup(benchmark);
+
+    for (auto task: tasks)
+        if (options.whitelist.has(task->name()))
+            benchmark.timeit(*task, 5);
+
+    options.print(benchmark);
+    return 0;
+}
@@ -90,6 +90,85 @@ this->add_method("issue62", [](Fixture& f) {
     wassert(actual(msg->get_datetime()) == Datetime(2016, 3, 14, 23, 0, 4));
 });
 
+this->add_method("export_jobs", [](Fixture& f) {
+    Dbadb dbadb(*f.db);
+
+    cmdline::ReaderOptions opts;
+    cmdline::Reader reader(opts);
+    std::list<std::string> fnames {
+        dballe::tests::datafile("bufr/obs0-1.22.bufr"),
+        dballe::tests::datafile("bufr/obs0-3.504.bufr"),
+        dballe::tests::datafile("bufr/gts-synop-linate.bufr"),
+        dballe::tests::datafile("bufr/issue62.bufr"),
+    };
+    wassert(actual(dbadb.do_import(fnames, reader, DBImportOptions::defaults)) == 0);
+
+    // Export sequentially
+    core::Query query;
+    core::ArrayFile sequential(Encoding::BUFR);
+    wassert(actual(dbadb.do_export(query, sequential, "", nullptr)) == 0);
+    wassert(actual(sequential.msgs.size()) > 2u);
+
+    // Export in parallel, and check that the output is the same
+    ExportOptions export_opts;
+    export_opts.jobs = 3;
+    core::ArrayFile parallel(Encoding::BUFR);
+    wassert(actual(dbadb.do_export(query, parallel, export_opts)) == 0);
+    wassert(actual(parallel.msgs.size()) == sequential.msgs.size());
+    for (unsigned i = 0; i < sequential.msgs.size(); ++i)
+        wassert(actual(parallel.msgs[i].data) == sequential.msgs[i].data);
+});
+
+this->add_method("export_subsets", [](Fixture& f) {
+    Dbadb dbadb(*f.db);
+
+    cmdline::ReaderOptions opts;
+    cmdline::Reader reader(opts);
+    std::list<std::string> fnames {
+        dballe::tests::datafile("bufr/obs0-1.22.bufr"),
+        dballe::tests::datafile("bufr/gts-synop-linate.bufr"),
+        dballe::tests::datafile("bufr/issue62.bufr"),
+    };
+    wassert(actual(dbadb.do_import(fnames, reader, DBImportOptions::defaults)) == 0);
+
+    core::Query query;
+    core::ArrayFile single(Encoding::BUFR);
+    wassert(actual(dbadb.do_export(query, single, "", nullptr)) == 0);
+
+    auto importer = Importer::create(Encoding::BUFR);
+    auto count_subsets = [&](const core::ArrayFile& file) {
+        unsigned count = 0;
+        for (const auto& bm: file.msgs)
+            count += importer->from_binary(bm).size();
+        return count;
+    };
+
+    // Group messages as subsets, with compression
+    ExportOptions export_opts;
+    export_opts.max_subsets = 100;
+    export_opts.compress = true;
+    core::ArrayFile grouped(Encoding::BUFR);
+    wassert(actual(dbadb.do_export(query, grouped, export_opts)) == 0);
+    wassert(actual(grouped.msgs.size()) < single.msgs.size());
+    wassert(actual(count_subsets(grouped)) == single.msgs.size());
+
+    // The same, encoded in parallel
+    export_opts.jobs = 2;
+    core::ArrayFile parallel(Encoding::BUFR);
+    wassert(actual(dbadb.do_export(query, parallel, export_opts)) == 0);
+    wassert(actual(parallel.msgs.size()) == grouped.msgs.size());
+    for (unsigned i = 0; i < grouped.msgs.size(); ++i)
+        wassert(actual(parallel.msgs[i].data) == grouped.msgs[i].data);
+
+    // A size limit smaller than any bulletin splits groups down to one
+    // subset per bulletin
+    export_opts.jobs = 1;
+    export_opts.max_bytes = 1;
+    core::ArrayFile limited(Encoding::BUFR);
+    wassert(actual(dbadb.do_export(query, limited, export_opts)) == 0);
+    wassert(actual(limited.msgs.size()) == single.msgs.size());
+});
+
 }
 
 }
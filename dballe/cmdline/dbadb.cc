@@ -1,10 +1,21 @@
 #include "dbadb.h"
 #include "dballe/message.h"
 #include "dballe/msg/msg.h"
+#include "dballe/msg/wr_codec.h"
 #include "dballe/values.h"
 #include "dballe/db/db.h"
+#include "dballe/core/arrow.h"
 
+#include <wreport/bulletin.h>
 #include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <set>
+#include <exception>
 
 using namespace wreport;
 using namespace std;
@@ -50,6 +61,291 @@ bool Importer::operator()(const Item& item)
     return true;
 }
 
+/**
+ * Encode groups of messages as requested by ExportOptions
+ */
+struct GroupEncoder
+{
+    const ExportOptions& opts;
+    /// True if groups are encoded as subsets of BUFR/CREX bulletins
+    bool use_bulletins;
+
+    GroupEncoder(const ExportOptions& opts, const Exporter& exporter)
+        : opts(opts),
+          use_bulletins((opts.max_subsets > 1 || opts.compress) && dynamic_cast<const impl::msg::WRExporter*>(&exporter))
+    {
+    }
+
+    /**
+     * Encode \a msgs, appending the encoded data to \a out.
+     *
+     * Messages are encoded in the same bulletin, which is split in smaller
+     * ones if its encoded size would exceed ExportOptions::max_bytes.
+     */
+    void encode(const Exporter& exporter, const std::vector<std::shared_ptr<Message>>& msgs, std::vector<std::string>& out) const
+    {
+        if (!use_bulletins)
+        {
+            out.emplace_back(exporter.to_binary(msgs));
+            return;
+        }
+
+        auto bulletin = exporter.to_bulletin(msgs);
+        std::string encoded;
+        BufrBulletin* bufr = dynamic_cast<BufrBulletin*>(bulletin.get());
+        if (bufr && opts.compress)
+        {
+            bufr->compression = true;
+            try {
+                encoded = bulletin->encode();
+            } catch (wreport::error&) {
+                // Compression requires all subsets to have the same
+                // structure, which is not the case, for example, with
+                // different delayed replication counts
+                bufr->compression = false;
+            }
+        }
+        if (encoded.empty())
+            encoded = bulletin->encode();
+
+        if (opts.max_bytes && encoded.size() > opts.max_bytes && msgs.size() > 1)
+        {
+            auto middle = msgs.begin() + msgs.size() / 2;
+            encode(exporter, std::vector<std::shared_ptr<Message>>(msgs.begin(), middle), out);
+            encode(exporter, std::vector<std::shared_ptr<Message>>(middle, msgs.end()), out);
+            return;
+        }
+
+        out.emplace_back(std::move(encoded));
+    }
+};
+
+/**
+ * Encode messages using a pool of worker threads, each with its own Exporter.
+ *
+ * Encoded data is written to the output file by the thread calling submit()
+ * and flush(), in the same order as the messages were submitted.
+ *
+ * Each template sets up its bulletins with its own table versions, and
+ * wreport tables are loaded on first use in a way that is not safe while
+ * other threads are looking them up: the first group of each template is
+ * encoded while no other worker is encoding, so that the others only ever use
+ * tables that have already been loaded.
+ */
+class ParallelEncoder
+{
+protected:
+    struct Job
+    {
+        size_t seq;
+        std::vector<std::shared_ptr<Message>> msgs;
+        /// Template of the messages, if already known
+        std::string tpl;
+
+        Job(size_t seq, std::vector<std::shared_ptr<Message>>&& msgs, const std::string& tpl)
+            : seq(seq), msgs(std::move(msgs)), tpl(tpl) {}
+    };
+
+    File& out;
+    const GroupEncoder& group_encoder;
+    std::vector<std::unique_ptr<Exporter>> exporters;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    /// Notified when new jobs are queued, or on shutdown
+    std::condition_variable jobs_changed;
+    /// Notified when a job has been encoded
+    std::condition_variable results_changed;
+    /// Notified when a worker starts or stops encoding alone
+    std::condition_variable encoding_changed;
+    /// Templates that have already been used to encode a group
+    std::set<std::string> encoded_templates;
+    /// Number of workers encoding groups of already encoded templates
+    unsigned encoding = 0;
+    /// Number of workers waiting to encode the first group of a template
+    unsigned waiting_first = 0;
+    /// True while a worker is encoding the first group of a template
+    bool encoding_first = false;
+    std::deque<Job> jobs;
+    /// Encoded data waiting for its turn to be written, indexed by sequence
+    std::map<size_t, std::vector<std::string>> results;
+    /// Sequence number of the next job to be submitted
+    size_t next_seq = 0;
+    /// Sequence number of the next result to be written
+    size_t next_out = 0;
+    /// Maximum number of jobs in flight
+    size_t max_pending;
+    bool shutting_down = false;
+    /// First error raised by a worker
+    std::exception_ptr error;
+
+    /**
+     * Wait until the worker can encode a group of template \a tpl.
+     *
+     * Returns true if it is the first group of the template, which is then
+     * encoded while no other worker is encoding.
+     */
+    bool start_encoding(std::unique_lock<std::mutex>& lock, const std::string& tpl)
+    {
+        if (encoded_templates.find(tpl) == encoded_templates.end())
+        {
+            ++waiting_first;
+            encoding_changed.wait(lock, [&] { return !encoding_first && encoding == 0; });
+            --waiting_first;
+            encoding_first = true;
+            return true;
+        }
+
+        encoding_changed.wait(lock, [&] { return !encoding_first && waiting_first == 0; });
+        ++encoding;
+        return false;
+    }
+
+    /// Let other workers encode after start_encoding()
+    void end_encoding(const std::string& tpl, bool first)
+    {
+        if (first)
+        {
+            encoded_templates.insert(tpl);
+            encoding_first = false;
+        } else
+            --encoding;
+        encoding_changed.notify_all();
+    }
+
+    void worker_main(const Exporter& exporter)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            jobs_changed.wait(lock, [&] { return shutting_down || !jobs.empty(); });
+            if (shutting_down)
+                return;
+            Job job(std::move(jobs.front()));
+            jobs.pop_front();
+            lock.unlock();
+
+            std::vector<std::string> encoded;
+            std::exception_ptr e;
+            try {
+                if (job.tpl.empty())
+                    if (auto wr_exporter = dynamic_cast<const impl::msg::WRExporter*>(&exporter))
+                        job.tpl = wr_exporter->infer_template(job.msgs)->name();
+            } catch (...) {
+                e = std::current_exception();
+            }
+
+            if (!e)
+            {
+                lock.lock();
+                bool first = start_encoding(lock, job.tpl);
+                lock.unlock();
+                try {
+                    group_encoder.encode(exporter, job.msgs, encoded);
+                } catch (...) {
+                    e = std::current_exception();
+                }
+                lock.lock();
+                end_encoding(job.tpl, first);
+                lock.unlock();
+            }
+            job.msgs.clear();
+
+            lock.lock();
+            if (e)
+            {
+                if (!error) error = e;
+            } else
+                results.emplace(job.seq, std::move(encoded));
+            results_changed.notify_all();
+        }
+    }
+
+    /// Write all results that are ready to be written in sequence
+    void write_ready(std::unique_lock<std::mutex>& lock)
+    {
+        while (true)
+        {
+            if (error)
+                std::rethrow_exception(error);
+            auto i = results.find(next_out);
+            if (i == results.end())
+                return;
+            std::vector<std::string> encoded(std::move(i->second));
+            results.erase(i);
+            ++next_out;
+            lock.unlock();
+            for (const auto& data: encoded)
+                out.write(data);
+            lock.lock();
+        }
+    }
+
+public:
+    ParallelEncoder(File& out, const impl::ExporterOptions& opts, const GroupEncoder& group_encoder, unsigned jobs)
+        : out(out), group_encoder(group_encoder), max_pending(jobs * 4)
+    {
+        // The template registry is initialised on first use, in a way that
+        // is not thread safe
+        impl::msg::wr::TemplateRegistry::get();
+        for (unsigned i = 0; i < jobs; ++i)
+            exporters.emplace_back(Exporter::create(out.encoding(), opts));
+        for (const auto& e: exporters)
+        {
+            const Exporter* exporter = e.get();
+            workers.emplace_back([this, exporter] { worker_main(*exporter); });
+        }
+    }
+    ParallelEncoder(const ParallelEncoder&) = delete;
+    ParallelEncoder& operator=(const ParallelEncoder&) = delete;
+    ~ParallelEncoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shutting_down = true;
+            jobs.clear();
+        }
+        jobs_changed.notify_all();
+        for (auto& w: workers)
+            w.join();
+    }
+
+    /**
+     * Queue messages for encoding, writing out encoded data that is ready.
+     *
+     * \a tpl is the name of the template of the messages, or empty to have
+     * the worker infer it.
+     *
+     * It blocks if too many jobs are in flight. Exceptions raised while
+     * encoding are rethrown here.
+     */
+    void submit(std::vector<std::shared_ptr<Message>>&& msgs, const std::string& tpl)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            write_ready(lock);
+            if (next_seq - next_out < max_pending)
+                break;
+            results_changed.wait(lock);
+        }
+        jobs.emplace_back(next_seq++, std::move(msgs), tpl);
+        jobs_changed.notify_one();
+    }
+
+    /// Wait for all queued jobs to be encoded and written
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            write_ready(lock);
+            if (next_out == next_seq)
+                break;
+            results_changed.wait(lock);
+        }
+    }
+};
+
 }
 
 /// Query data in the database and output results as arbitrary human readable text
@@ -99,6 +395,22 @@ int Dbadb::do_export_dump(const Query& query, FILE* out)
     return 0;
 }
 
+int Dbadb::do_export_arrow(const Query& query, FILE* out)
+{
+    auto tr = db.transaction();
+    ArrowArrayStream stream;
+    core::arrow::export_data(tr->query_data(query), &stream);
+    try {
+        core::arrow::write_ipc_stream(&stream, out);
+    } catch (...) {
+        stream.release(&stream);
+        throw;
+    }
+    stream.release(&stream);
+    tr->rollback();
+    return 0;
+}
+
 int Dbadb::do_import(const list<string>& fnames, Reader& reader, const DBImportOptions& opts)
 {
     Importer importer(db, opts);
@@ -128,29 +440,84 @@ int Dbadb::do_import(const std::string& fname, Reader& reader, const DBImportOpt
 
 int Dbadb::do_export(const Query& query, File& file, const char* output_template, const char* forced_repmemo)
 {
-    impl::ExporterOptions opts;
-    if (output_template && output_template[0] != 0)
-        opts.template_name = output_template;
-
+    ExportOptions opts;
+    if (output_template)
+        opts.output_template = output_template;
     if (forced_repmemo)
-        forced_repmemo = forced_repmemo;
-    auto exporter = Exporter::create(file.encoding(), opts);
+        opts.forced_repmemo = forced_repmemo;
+    return do_export(query, file, opts);
+}
+
+int Dbadb::do_export(const Query& query, File& file, const ExportOptions& opts)
+{
+    impl::ExporterOptions exporter_opts;
+    if (!opts.output_template.empty())
+        exporter_opts.template_name = opts.output_template;
+
+    auto exporter = Exporter::create(file.encoding(), exporter_opts);
+    const impl::msg::WRExporter* wr_exporter = dynamic_cast<const impl::msg::WRExporter*>(exporter.get());
+    GroupEncoder group_encoder(opts, *exporter);
+    std::unique_ptr<ParallelEncoder> encoder;
+    if (opts.jobs > 1)
+        encoder.reset(new ParallelEncoder(file, exporter_opts, group_encoder, opts.jobs));
+
+    // Messages to be encoded together, and the template they use, if known
+    std::vector<std::shared_ptr<Message>> group;
+    std::string group_template;
+    unsigned max_group_size = 1;
+
+    auto flush_group = [&] {
+        if (group.empty())
+            return;
+        if (encoder)
+            encoder->submit(std::move(group), group_template);
+        else {
+            std::vector<std::string> encoded;
+            group_encoder.encode(*exporter, group, encoded);
+            for (const auto& data: encoded)
+                file.write(data);
+        }
+        group.clear();
+    };
 
     auto cursor = db.query_messages(query);
     while (cursor->next())
     {
         auto msg = cursor->get_message();
         /* Override the message type if the user asks for it */
-        if (forced_repmemo != NULL)
+        if (!opts.forced_repmemo.empty())
         {
             impl::Message& m = impl::Message::downcast(*msg);
-            m.type = impl::Message::type_from_repmemo(forced_repmemo);
-            m.set_rep_memo(forced_repmemo);
+            m.type = impl::Message::type_from_repmemo(opts.forced_repmemo.c_str());
+            m.set_rep_memo(opts.forced_repmemo.c_str());
         }
-        std::vector<std::shared_ptr<Message>> msgs;
-        msgs.emplace_back(move(msg));
-        file.write(exporter->to_binary(msgs));
+
+        if (wr_exporter && group_encoder.use_bulletins && opts.max_subsets > 1)
+        {
+            // Only group consecutive messages that use the same template.
+            // Otherwise, templates are inferred when encoding, by the
+            // workers if there are any
+            std::vector<std::shared_ptr<Message>> probe { msg };
+            auto tpl = wr_exporter->infer_template(probe);
+            if (tpl->name() != group_template)
+            {
+                flush_group();
+                group_template = tpl->name();
+                if (group_encoder.use_bulletins && tpl->supports_multiple_subsets())
+                    // BUFR can store at most 65535 subsets per bulletin
+                    max_group_size = std::min(opts.max_subsets, 65535u);
+                else
+                    max_group_size = 1;
+            }
+        }
+
+        group.emplace_back(move(msg));
+        if (group.size() >= max_group_size)
+            flush_group();
     }
+    flush_group();
+    if (encoder)
+        encoder->flush();
     return 0;
 }
 
@@ -6,11 +6,47 @@
 #include <dballe/cmdline/processor.h>
 #include <dballe/db/fwd.h>
 #include <list>
+#include <string>
 #include <cstdio>
 
 namespace dballe {
 namespace cmdline {
 
+/// Options used by Dbadb::do_export
+struct ExportOptions
+{
+    /// Template of the data in output (autoselect if empty)
+    std::string output_template;
+    /// If not empty, force the report of the exported messages
+    std::string forced_repmemo;
+    /**
+     * Number of threads used to encode messages.
+     *
+     * With 1, messages are encoded in the thread that reads the query results.
+     * With more, encoding is done by a pool of worker threads, and the output
+     * is still written in query order.
+     */
+    unsigned jobs = 1;
+    /**
+     * Maximum number of messages to encode as subsets of the same bulletin.
+     *
+     * Consecutive messages that are exported with the same template are
+     * grouped into multi-subset BUFR or CREX bulletins. With 1, each message
+     * is encoded in its own bulletin.
+     */
+    unsigned max_subsets = 1;
+    /**
+     * Maximum size in bytes of an encoded multi-subset bulletin, or 0 for no
+     * limit.
+     *
+     * Groups of messages whose encoded size would exceed it are split into
+     * smaller bulletins.
+     */
+    size_t max_bytes = 0;
+    /// Use BUFR compression when the subsets of a bulletin allow it
+    bool compress = false;
+};
+
 class Dbadb
 {
 protected:
@@ -28,6 +64,9 @@ public:
     /// Export messages and dump their contents to the given file descriptor
     int do_export_dump(const Query& query, FILE* out);
 
+    /// Export data as an Arrow IPC stream written to the given file
+    int do_export_arrow(const Query& query, FILE* out);
+
     /// Import the given files
     int do_import(const std::list<std::string>& fnames, Reader& reader, const DBImportOptions& opts);
 
@@ -36,6 +75,9 @@ public:
 
     /// Export messages writing them to the givne file
     int do_export(const Query& query, File& file, const char* output_template=NULL, const char* forced_repmemo=NULL);
+
+    /// Export messages writing them to the given file
+    int do_export(const Query& query, File& file, const ExportOptions& opts);
 };
 
 
@@ -1,5 +1,6 @@
 #include "dballe/core/tests.h"
 #include "processor.h"
+#include "dballe/file.h"
 #include <limits>
 
 using namespace dballe;
@@ -133,6 +134,47 @@ add_method("issue77", [] {
     reader.read({dballe::tests::datafile("/json/issue77.json")}, action);
 });
 
+add_method("match_prefix", [] {
+    // The prefix check must never reject a message that matches after
+    // decoding
+    const char* queries[] = {
+        "block=16", "block=99", "block=16, station=80",
+        "yearmin=2000", "yearmax=1990", "year=2005, month=1",
+        "latmin=40.0, latmax=50.0, lonmin=5.0, lonmax=15.0",
+        "latmin=-10.0, latmax=0.0, lonmin=-10.0, lonmax=0.0",
+        "rep_memo=synop",
+    };
+    const char* files[] = {
+        "bufr/obs0-1.22.bufr", "bufr/gts-synop-linate.bufr", "bufr/ed4-compr-string.bufr",
+        "bufr/ecmwf-ship-1-11.bufr", "bufr/gts-acars1.bufr", "bufr/temp-gts1.bufr",
+        "bufr/gen-synop.bufr", "bufr/ed4date.bufr",
+    };
+    auto importer = Importer::create(Encoding::BUFR);
+    unsigned rejected = 0;
+    for (const char* query: queries)
+    {
+        Filter filter;
+        filter.matcher_from_record(*dballe::tests::query_from_string(query));
+        for (const char* fname: files)
+        {
+            auto file = File::create(Encoding::BUFR, dballe::tests::datafile(fname), "r");
+            while (BinaryMessage bm = file->read())
+            {
+                Item item;
+                item.rmsg = new BinaryMessage(bm);
+                item.decode(*importer);
+                bool matches = filter.match_item(item);
+                bool may_match = filter.match_prefix(bm);
+                if (matches)
+                    wassert(actual(may_match).istrue());
+                if (!may_match)
+                    ++rejected;
+            }
+        }
+    }
+    wassert(actual(rejected) > 0u);
+});
+
 
 }
 
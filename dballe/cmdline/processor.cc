@@ -205,6 +205,29 @@ bool Filter::match_index(int idx) const
     return imatcher.match(idx);
 }
 
+bool Filter::match_prefix(const BinaryMessage& rmsg) const
+{
+    // Messages that fail to decode are matched differently, leave them to
+    // the full decoding
+    if (unparsable) return true;
+    if (rmsg.encoding != Encoding::BUFR) return true;
+    if (category == -1 && subcategory == -1 && !matcher) return true;
+
+    MatchedBufrPrefix prefix(rmsg.data);
+    if (!prefix.header_decoded) return true;
+
+    if (category != -1 && category != prefix.data_category)
+        return false;
+
+    if (subcategory != -1 && subcategory != prefix.data_subcategory)
+        return false;
+
+    if (matcher && matcher->match(prefix) == matcher::MATCH_NO)
+        return false;
+
+    return true;
+}
+
 bool Filter::match_common(const BinaryMessage&, const std::vector<std::shared_ptr<dballe::Message>>* msgs) const
 {
     if (msgs == NULL && parsable)
@@ -414,6 +437,10 @@ void Reader::read_file(const std::list<std::string>& fnames, Action& action)
                 if (!filter.match_index(item.idx))
                     continue;
 
+                // Skip decoding messages that cannot match
+                if (!filter.match_prefix(*item.rmsg))
+                    continue;
+
                 try {
                     item.decode(*imp, print_errors);
                 } catch (std::exception& e) {
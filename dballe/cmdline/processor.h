@@ -166,6 +166,13 @@ struct Filter
     void matcher_from_record(const Query& query);
 
     bool match_index(int idx) const;
+    /**
+     * Check if a message may match, looking only at what can be read from it
+     * without decoding it.
+     *
+     * Returns false only if the message can never match the filter.
+     */
+    bool match_prefix(const BinaryMessage& rmsg) const;
     bool match_common(const BinaryMessage& rmsg, const std::vector<std::shared_ptr<dballe::Message>>* msgs) const;
     bool match_msgs(const std::vector<std::shared_ptr<dballe::Message>>& msgs) const;
     bool match_bufrex(const BinaryMessage& rmsg, const wreport::Bulletin* rm, const std::vector<std::shared_ptr<dballe::Message>>* msgs) const;
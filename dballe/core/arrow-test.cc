@@ -0,0 +1,151 @@
+#include "dballe/msg/tests.h"
+#include "dballe/msg/msg.h"
+#include "dballe/core/query.h"
+#include "arrow.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace dballe;
+using namespace dballe::tests;
+using namespace std;
+
+namespace {
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override;
+} tests("core_arrow");
+
+void Tests::register_tests()
+{
+
+add_method("export", []() {
+    auto msgs = read_msgs("bufr/obs0-1.22.bufr", Encoding::BUFR);
+    auto count = msgs[0]->query_data(core::Query())->remaining();
+    wassert(actual(count) > 0);
+
+    ArrowArrayStream stream;
+    core::arrow::export_data(msgs[0]->query_data(core::Query()), &stream, 4);
+
+    ArrowSchema schema;
+    wassert(actual(stream.get_schema(&stream, &schema)) == 0);
+    wassert(actual(schema.format) == "+s");
+    wassert(actual(schema.n_children) == 12);
+    wassert(actual(schema.children[0]->name) == "ana_id");
+    wassert(actual(schema.children[1]->name) == "report");
+    wassert(actual(schema.children[1]->dictionary->format) == "u");
+    wassert(actual(schema.children[7]->format) == "tss:");
+    wassert(actual(schema.children[11]->format) == "+l");
+    wassert(actual(schema.children[11]->children[0]->n_children) == 3);
+    schema.release(&schema);
+    wassert_false(schema.release);
+
+    int total = 0;
+    unsigned batches = 0;
+    while (true)
+    {
+        ArrowArray array;
+        wassert(actual(stream.get_next(&stream, &array)) == 0);
+        if (!array.release) break;
+        wassert(actual(array.n_children) == 12);
+        wassert(actual(array.length) <= 4);
+        for (unsigned i = 0; i < array.n_children; ++i)
+            wassert(actual(array.children[i]->length) == array.length);
+
+        // The var column is dictionary encoded
+        const ArrowArray* var = array.children[8];
+        wassert(actual((bool)var->dictionary).istrue());
+        const int32_t* indices = static_cast<const int32_t*>(var->buffers[1]);
+        for (int64_t i = 0; i < var->length; ++i)
+            wassert(actual(indices[i]) < var->dictionary->length);
+
+        total += array.length;
+        ++batches;
+        array.release(&array);
+    }
+
+    wassert(actual(total) == count);
+    wassert(actual(batches) == (count + 3) / 4);
+    wassert_false(stream.get_last_error(&stream));
+    stream.release(&stream);
+});
+
+add_method("values", []() {
+    auto msgs = read_msgs("bufr/obs0-1.22.bufr", Encoding::BUFR);
+
+    ArrowArrayStream stream;
+    core::arrow::export_data(msgs[0]->query_data(core::Query()), &stream);
+
+    ArrowArray array;
+    wassert(actual(stream.get_next(&stream, &array)) == 0);
+
+    // Look up B12101 in the var dictionary
+    const ArrowArray* var = array.children[8];
+    const int32_t* offsets = static_cast<const int32_t*>(var->dictionary->buffers[1]);
+    const char* chars = static_cast<const char*>(var->dictionary->buffers[2]);
+    int32_t b12101 = -1;
+    for (int64_t i = 0; i < var->dictionary->length; ++i)
+        if (string(chars + offsets[i], offsets[i + 1] - offsets[i]) == "B12101")
+            b12101 = i;
+    wassert(actual(b12101) != -1);
+
+    const int32_t* indices = static_cast<const int32_t*>(var->buffers[1]);
+    int64_t row = -1;
+    for (int64_t i = 0; i < var->length; ++i)
+        if (indices[i] == b12101)
+            row = i;
+    wassert(actual(row) != -1);
+
+    // Temperature is a numeric variable, stored in value
+    const double* value = static_cast<const double*>(array.children[9]->buffers[1]);
+    wassert(actual(value[row]) == 289.2);
+    const uint8_t* str_validity = static_cast<const uint8_t*>(array.children[10]->buffers[0]);
+    wassert(actual((bool)str_validity).istrue());
+    wassert_false(str_validity[row / 8] & (1 << (row % 8)));
+
+    const int64_t* datetime = static_cast<const int64_t*>(array.children[7]->buffers[1]);
+    wassert(actual(datetime[row]) == 1101816000);
+
+    const int32_t* lat = static_cast<const int32_t*>(array.children[2]->buffers[1]);
+    wassert(actual(lat[row]) == 3388000);
+    array.release(&array);
+
+    wassert(actual(stream.get_next(&stream, &array)) == 0);
+    wassert_false(array.release);
+    stream.release(&stream);
+});
+
+}
+
+add_method("ipc", []() {
+    auto msgs = read_msgs("bufr/obs0-1.22.bufr", Encoding::BUFR);
+
+    ArrowArrayStream stream;
+    core::arrow::export_data(msgs[0]->query_data(core::Query()), &stream, 4);
+    FILE* out = tmpfile();
+    wassert(core::arrow::write_ipc_stream(&stream, out));
+    stream.release(&stream);
+
+    string buf(ftell(out), 0);
+    rewind(out);
+    wassert(actual(fread(&buf[0], buf.size(), 1, out)) == 1u);
+    fclose(out);
+
+    // Messages are framed with a continuation marker and the size of their
+    // metadata, and everything is aligned to 8 bytes
+    wassert(actual(buf.size() % 8) == 0u);
+    uint32_t prefix[2];
+    memcpy(prefix, buf.data(), 8);
+    wassert(actual(prefix[0]) == 0xffffffffu);
+    wassert(actual(prefix[1] % 8) == 0u);
+    wassert(actual(buf.size()) > prefix[1] + 16u);
+
+    // The stream ends with an end of stream marker
+    memcpy(prefix, buf.data() + buf.size() - 8, 8);
+    wassert(actual(prefix[0]) == 0xffffffffu);
+    wassert(actual(prefix[1]) == 0u);
+});
+
+}
@@ -0,0 +1,973 @@
+#include "arrow.h"
+#include "dballe/cursor.h"
+#include "dballe/types.h"
+#include "dballe/core/var.h"
+#include <wreport/error.h>
+#include <wreport/var.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace wreport;
+using namespace std;
+
+namespace dballe {
+namespace core {
+namespace arrow {
+
+namespace {
+
+/// Memory owned by an exported ArrowArray
+struct ArrayPrivate
+{
+    std::vector<uint8_t> validity;
+    std::vector<int32_t> i32;
+    std::vector<int64_t> i64;
+    std::vector<double> f64;
+    std::string chars;
+    const void* buffers[3] = { nullptr, nullptr, nullptr };
+    std::vector<ArrowArray*> children;
+    ArrowArray* dictionary = nullptr;
+
+    ~ArrayPrivate()
+    {
+        for (auto child: children)
+        {
+            if (child->release) child->release(child);
+            delete child;
+        }
+        if (dictionary)
+        {
+            if (dictionary->release) dictionary->release(dictionary);
+            delete dictionary;
+        }
+    }
+};
+
+void release_array(ArrowArray* array)
+{
+    delete static_cast<ArrayPrivate*>(array->private_data);
+    array->release = nullptr;
+}
+
+void init_array(ArrowArray* out, ArrayPrivate* priv, int64_t length, int64_t null_count, int64_t n_buffers)
+{
+    out->length = length;
+    out->null_count = null_count;
+    out->offset = 0;
+    out->n_buffers = n_buffers;
+    out->n_children = priv->children.size();
+    out->buffers = priv->buffers;
+    out->children = priv->children.empty() ? nullptr : priv->children.data();
+    out->dictionary = priv->dictionary;
+    out->release = release_array;
+    out->private_data = priv;
+}
+
+/// Memory owned by an exported ArrowSchema
+struct SchemaPrivate
+{
+    std::string format;
+    std::string name;
+    std::vector<ArrowSchema*> children;
+    ArrowSchema* dictionary = nullptr;
+
+    ~SchemaPrivate()
+    {
+        for (auto child: children)
+        {
+            if (child->release) child->release(child);
+            delete child;
+        }
+        if (dictionary)
+        {
+            if (dictionary->release) dictionary->release(dictionary);
+            delete dictionary;
+        }
+    }
+};
+
+void release_schema(ArrowSchema* schema)
+{
+    delete static_cast<SchemaPrivate*>(schema->private_data);
+    schema->release = nullptr;
+}
+
+ArrowSchema* make_schema(const char* format, const char* name, std::vector<ArrowSchema*> children=std::vector<ArrowSchema*>(), ArrowSchema* dictionary=nullptr, ArrowSchema* out=nullptr)
+{
+    if (!out) out = new ArrowSchema;
+    SchemaPrivate* priv = new SchemaPrivate;
+    priv->format = format;
+    priv->name = name;
+    priv->children = move(children);
+    priv->dictionary = dictionary;
+    out->format = priv->format.c_str();
+    out->name = priv->name.c_str();
+    out->metadata = nullptr;
+    out->flags = ARROW_FLAG_NULLABLE;
+    out->n_children = priv->children.size();
+    out->children = priv->children.empty() ? nullptr : priv->children.data();
+    out->dictionary = dictionary;
+    out->release = release_schema;
+    out->private_data = priv;
+    return out;
+}
+
+/// Schema of a string column dictionary encoded with int32 indices
+ArrowSchema* make_dictionary_schema(const char* name)
+{
+    return make_schema("i", name, std::vector<ArrowSchema*>(), make_schema("u", ""));
+}
+
+void make_data_schema(ArrowSchema* out)
+{
+    std::vector<ArrowSchema*> attr_fields {
+        make_schema("u", "code"),
+        make_schema("g", "value"),
+        make_schema("u", "value_str"),
+    };
+    std::vector<ArrowSchema*> fields {
+        make_schema("i", "ana_id"),
+        make_dictionary_schema("report"),
+        make_schema("i", "lat"),
+        make_schema("i", "lon"),
+        make_schema("u", "ident"),
+        make_dictionary_schema("level"),
+        make_dictionary_schema("trange"),
+        make_schema("tss:", "datetime"),
+        make_dictionary_schema("var"),
+        make_schema("g", "value"),
+        make_schema("u", "value_str"),
+        make_schema("+l", "attrs", { make_schema("+s", "item", move(attr_fields)) }),
+    };
+    make_schema("+s", "", move(fields), nullptr, out);
+    out->flags = 0;
+}
+
+/// Validity bitmap of a column
+struct Validity
+{
+    std::vector<uint8_t> bits;
+    int64_t size = 0;
+    int64_t null_count = 0;
+
+    void append(bool valid)
+    {
+        if (size % 8 == 0)
+            bits.push_back(0);
+        if (valid)
+            bits.back() |= 1 << (size % 8);
+        else
+            ++null_count;
+        ++size;
+    }
+
+    /// Move the bitmap into \a priv
+    void export_to(ArrayPrivate* priv)
+    {
+        if (null_count == 0) return;
+        priv->validity = move(bits);
+        priv->buffers[0] = priv->validity.data();
+    }
+};
+
+struct Int32Column
+{
+    Validity validity;
+    std::vector<int32_t> values;
+
+    /// Append a value, using null for MISSING_INT
+    void append(int val)
+    {
+        validity.append(val != MISSING_INT);
+        values.push_back(val == MISSING_INT ? 0 : val);
+    }
+
+    ArrayPrivate* to_array(ArrowArray* out)
+    {
+        ArrayPrivate* priv = new ArrayPrivate;
+        int64_t size = validity.size;
+        int64_t null_count = validity.null_count;
+        validity.export_to(priv);
+        priv->i32 = move(values);
+        priv->buffers[1] = priv->i32.data();
+        init_array(out, priv, size, null_count, 2);
+        return priv;
+    }
+};
+
+struct Int64Column
+{
+    Validity validity;
+    std::vector<int64_t> values;
+
+    void append(int64_t val)
+    {
+        validity.append(true);
+        values.push_back(val);
+    }
+
+    void append_null()
+    {
+        validity.append(false);
+        values.push_back(0);
+    }
+
+    void to_array(ArrowArray* out)
+    {
+        ArrayPrivate* priv = new ArrayPrivate;
+        int64_t size = validity.size;
+        int64_t null_count = validity.null_count;
+        validity.export_to(priv);
+        priv->i64 = move(values);
+        priv->buffers[1] = priv->i64.data();
+        init_array(out, priv, size, null_count, 2);
+    }
+};
+
+struct Float64Column
+{
+    Validity validity;
+    std::vector<double> values;
+
+    void append(double val)
+    {
+        validity.append(true);
+        values.push_back(val);
+    }
+
+    void append_null()
+    {
+        validity.append(false);
+        values.push_back(0);
+    }
+
+    void to_array(ArrowArray* out)
+    {
+        ArrayPrivate* priv = new ArrayPrivate;
+        int64_t size = validity.size;
+        int64_t null_count = validity.null_count;
+        validity.export_to(priv);
+        priv->f64 = move(values);
+        priv->buffers[1] = priv->f64.data();
+        init_array(out, priv, size, null_count, 2);
+    }
+};
+
+struct StringColumn
+{
+    Validity validity;
+    std::vector<int32_t> offsets { 0 };
+    std::string chars;
+
+    void append(const char* val, size_t len)
+    {
+        validity.append(true);
+        chars.append(val, len);
+        offsets.push_back(chars.size());
+    }
+
+    void append(const std::string& val) { append(val.data(), val.size()); }
+    void append(const char* val) { append(val, strlen(val)); }
+
+    void append_null()
+    {
+        validity.append(false);
+        offsets.push_back(chars.size());
+    }
+
+    void to_array(ArrowArray* out)
+    {
+        ArrayPrivate* priv = new ArrayPrivate;
+        int64_t size = validity.size;
+        int64_t null_count = validity.null_count;
+        validity.export_to(priv);
+        priv->i32 = move(offsets);
+        priv->chars = move(chars);
+        priv->buffers[1] = priv->i32.data();
+        priv->buffers[2] = priv->chars.data();
+        init_array(out, priv, size, null_count, 3);
+    }
+};
+
+std::string dictionary_label(const std::string& val) { return val; }
+std::string dictionary_label(const Level& val) { return val.to_string(); }
+std::string dictionary_label(const Trange& val) { return val.to_string(); }
+std::string dictionary_label(Varcode val)
+{
+    char buf[7];
+    format_code(val, buf);
+    return buf;
+}
+
+/// String column dictionary encoded with int32 indices
+template<typename Key>
+struct DictionaryColumn
+{
+    std::map<Key, int32_t> ids;
+    Int32Column indices;
+    StringColumn dictionary;
+
+    void append(const Key& key)
+    {
+        auto i = ids.find(key);
+        if (i == ids.end())
+        {
+            i = ids.insert(make_pair(key, (int32_t)ids.size())).first;
+            dictionary.append(dictionary_label(key));
+        }
+        indices.append(i->second);
+    }
+
+    void to_array(ArrowArray* out)
+    {
+        ArrayPrivate* priv = indices.to_array(out);
+        priv->dictionary = new ArrowArray;
+        priv->dictionary->release = nullptr;
+        dictionary.to_array(priv->dictionary);
+        out->dictionary = priv->dictionary;
+    }
+};
+
+/// Append the value of \a var to the value and value_str columns
+void append_value(const Var& var, Float64Column& value, StringColumn& value_str)
+{
+    if (!var.isset())
+    {
+        value.append_null();
+        value_str.append_null();
+        return;
+    }
+
+    switch (var.info()->type)
+    {
+        case Vartype::String:
+            value.append_null();
+            value_str.append(var.enqc());
+            break;
+        case Vartype::Binary:
+            value.append_null();
+            value_str.append_null();
+            break;
+        case Vartype::Integer:
+        case Vartype::Decimal:
+            value.append(var.enqd());
+            value_str.append_null();
+            break;
+    }
+}
+
+/// List of attributes of each variable
+struct AttrsColumn
+{
+    std::vector<int32_t> offsets { 0 };
+    int32_t count = 0;
+    StringColumn code;
+    Float64Column value;
+    StringColumn value_str;
+
+    void append(const Var& var)
+    {
+        for (const Var* a = var.next_attr(); a != nullptr; a = a->next_attr())
+        {
+            code.append(dictionary_label(a->code()));
+            append_value(*a, value, value_str);
+            ++count;
+        }
+        offsets.push_back(count);
+    }
+
+    void to_array(ArrowArray* out)
+    {
+        ArrayPrivate* items = new ArrayPrivate;
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            items->children.push_back(new ArrowArray);
+            items->children.back()->release = nullptr;
+        }
+        code.to_array(items->children[0]);
+        value.to_array(items->children[1]);
+        value_str.to_array(items->children[2]);
+        ArrowArray* items_array = new ArrowArray;
+        init_array(items_array, items, count, 0, 1);
+
+        ArrayPrivate* priv = new ArrayPrivate;
+        priv->children.push_back(items_array);
+        int64_t size = offsets.size() - 1;
+        priv->i32 = move(offsets);
+        priv->buffers[1] = priv->i32.data();
+        init_array(out, priv, size, 0, 2);
+    }
+};
+
+int64_t to_unix_time(const Datetime& dt)
+{
+    static const int epoch = Date::calendar_to_julian(1970, 1, 1);
+    return (int64_t)(dt.to_julian() - epoch) * 86400 + dt.hour * 3600 + dt.minute * 60 + dt.second;
+}
+
+/// Columns of a batch of exported rows
+struct Batch
+{
+    int64_t size = 0;
+    Int32Column ana_id;
+    DictionaryColumn<std::string> report;
+    Int32Column lat;
+    Int32Column lon;
+    StringColumn ident;
+    DictionaryColumn<Level> level;
+    DictionaryColumn<Trange> trange;
+    Int64Column datetime;
+    DictionaryColumn<Varcode> var;
+    Float64Column value;
+    StringColumn value_str;
+    AttrsColumn attrs;
+
+    void add(const dballe::CursorData& cur)
+    {
+        DBStation station = cur.get_station();
+        ana_id.append(station.id);
+        report.append(station.report);
+        lat.append(station.coords.lat);
+        lon.append(station.coords.lon);
+        if (station.ident.is_missing())
+            ident.append_null();
+        else
+            ident.append(station.ident.get());
+        level.append(cur.get_level());
+        trange.append(cur.get_trange());
+        Datetime dt = cur.get_datetime();
+        if (dt.is_missing())
+            datetime.append_null();
+        else
+            datetime.append(to_unix_time(dt));
+        var.append(cur.get_varcode());
+        Var v = cur.get_var();
+        append_value(v, value, value_str);
+        attrs.append(v);
+        ++size;
+    }
+
+    void to_array(ArrowArray* out)
+    {
+        ArrayPrivate* priv = new ArrayPrivate;
+        for (unsigned i = 0; i < 12; ++i)
+        {
+            priv->children.push_back(new ArrowArray);
+            priv->children.back()->release = nullptr;
+        }
+        init_array(out, priv, size, 0, 1);
+        ana_id.to_array(priv->children[0]);
+        report.to_array(priv->children[1]);
+        lat.to_array(priv->children[2]);
+        lon.to_array(priv->children[3]);
+        ident.to_array(priv->children[4]);
+        level.to_array(priv->children[5]);
+        trange.to_array(priv->children[6]);
+        datetime.to_array(priv->children[7]);
+        var.to_array(priv->children[8]);
+        value.to_array(priv->children[9]);
+        value_str.to_array(priv->children[10]);
+        attrs.to_array(priv->children[11]);
+    }
+};
+
+/// State of an exported stream
+struct StreamPrivate
+{
+    std::shared_ptr<dballe::CursorData> cursor;
+    unsigned batch_size;
+    bool done = false;
+    std::string last_error;
+};
+
+int stream_get_schema(ArrowArrayStream* stream, ArrowSchema* out)
+{
+    StreamPrivate* priv = static_cast<StreamPrivate*>(stream->private_data);
+    try {
+        make_data_schema(out);
+        return 0;
+    } catch (std::exception& e) {
+        priv->last_error = e.what();
+        return EIO;
+    }
+}
+
+int stream_get_next(ArrowArrayStream* stream, ArrowArray* out)
+{
+    StreamPrivate* priv = static_cast<StreamPrivate*>(stream->private_data);
+    try {
+        Batch batch;
+        while (!priv->done && batch.size < priv->batch_size)
+        {
+            if (!priv->cursor->next())
+            {
+                priv->done = true;
+                break;
+            }
+            batch.add(*priv->cursor);
+        }
+
+        if (batch.size == 0)
+        {
+            // End of stream
+            out->release = nullptr;
+            return 0;
+        }
+
+        batch.to_array(out);
+        return 0;
+    } catch (std::exception& e) {
+        priv->last_error = e.what();
+        return EIO;
+    }
+}
+
+const char* stream_get_last_error(ArrowArrayStream* stream)
+{
+    StreamPrivate* priv = static_cast<StreamPrivate*>(stream->private_data);
+    if (priv->last_error.empty()) return nullptr;
+    return priv->last_error.c_str();
+}
+
+void stream_release(ArrowArrayStream* stream)
+{
+    delete static_cast<StreamPrivate*>(stream->private_data);
+    stream->release = nullptr;
+}
+
+}
+
+namespace {
+
+/**
+ * Minimal FlatBuffers builder, enough to encode Arrow IPC metadata.
+ *
+ * As in the FlatBuffers library, the buffer is built back to front, so that
+ * objects are created before the tables that refer to them. Objects are
+ * identified by their distance from the end of the buffer.
+ */
+class FlatBuilder
+{
+protected:
+    std::string buf;
+
+    void push(const void* data, size_t size)
+    {
+        buf.insert(0, static_cast<const char*>(data), size);
+    }
+
+    /// Pad so that after pushing \a size more bytes, they are aligned
+    void align(size_t size, size_t alignment)
+    {
+        size_t pad = (alignment - (buf.size() + size) % alignment) % alignment;
+        buf.insert(0, pad, 0);
+    }
+
+public:
+    template<typename T>
+    void push_scalar(T val)
+    {
+        align(sizeof(T), sizeof(T));
+        push(&val, sizeof(T));
+    }
+
+    void push_offset(uint32_t ref)
+    {
+        align(4, 4);
+        push_scalar<uint32_t>(buf.size() + 4 - ref);
+    }
+
+    uint32_t size() const { return buf.size(); }
+
+    uint32_t create_string(const std::string& str)
+    {
+        align(str.size() + 1 + 4, 4);
+        push("", 1);
+        push(str.data(), str.size());
+        push_scalar<uint32_t>(str.size());
+        return size();
+    }
+
+    uint32_t create_offsets(const std::vector<uint32_t>& refs)
+    {
+        for (auto i = refs.rbegin(); i != refs.rend(); ++i)
+            push_offset(*i);
+        push_scalar<uint32_t>(refs.size());
+        return size();
+    }
+
+    /// Create a vector of structs made of two int64 values
+    uint32_t create_pairs(const std::vector<std::pair<int64_t, int64_t>>& pairs)
+    {
+        align(pairs.size() * 16, 8);
+        for (auto i = pairs.rbegin(); i != pairs.rend(); ++i)
+        {
+            push(&i->second, 8);
+            push(&i->first, 8);
+        }
+        push_scalar<uint32_t>(pairs.size());
+        return size();
+    }
+
+    /// Build a table, adding fields with its methods and ending with finish()
+    class Table
+    {
+        FlatBuilder& b;
+        uint32_t end;
+        std::vector<std::pair<unsigned, uint32_t>> fields;
+
+    public:
+        Table(FlatBuilder& b) : b(b), end(b.size()) {}
+
+        template<typename T>
+        void add(unsigned id, T val)
+        {
+            b.push_scalar(val);
+            fields.emplace_back(id, b.size());
+        }
+
+        void add_offset(unsigned id, uint32_t ref)
+        {
+            b.push_offset(ref);
+            fields.emplace_back(id, b.size());
+        }
+
+        uint32_t finish()
+        {
+            b.push_scalar<int32_t>(0);
+            uint32_t table = b.size();
+
+            unsigned count = 0;
+            for (const auto& f: fields)
+                count = std::max(count, f.first + 1);
+            std::vector<uint16_t> vtable(count, 0);
+            for (const auto& f: fields)
+                vtable[f.first] = table - f.second;
+            for (auto i = vtable.rbegin(); i != vtable.rend(); ++i)
+                b.push(&*i, 2);
+            uint16_t table_size = table - end;
+            b.push(&table_size, 2);
+            uint16_t vtable_size = 4 + 2 * count;
+            b.push(&vtable_size, 2);
+
+            // Point the table to its vtable, which precedes it
+            int32_t soffset = b.size() - table;
+            memcpy(&b.buf[b.size() - table], &soffset, 4);
+            return table;
+        }
+    };
+
+    /// Add the root table offset, and return the buffer padded to 8 bytes
+    std::string finish(uint32_t root)
+    {
+        align(4, 8);
+        push_offset(root);
+        return buf;
+    }
+};
+
+// Arrow IPC metadata, from
+// https://github.com/apache/arrow/tree/main/format
+const int16_t ipc_metadata_v5 = 4;
+const uint8_t ipc_header_schema = 1;
+const uint8_t ipc_header_dictionary_batch = 2;
+const uint8_t ipc_header_record_batch = 3;
+const uint8_t ipc_type_int = 2;
+const uint8_t ipc_type_floating_point = 3;
+const uint8_t ipc_type_utf8 = 5;
+const uint8_t ipc_type_timestamp = 10;
+const uint8_t ipc_type_list = 12;
+const uint8_t ipc_type_struct = 13;
+
+/// Writer of the Arrow IPC stream format
+class IPCWriter
+{
+protected:
+    FILE* out;
+    /// Dictionary encoded fields, indexed by dictionary ID
+    std::vector<const ArrowSchema*> dictionaries;
+    /// Body of the message being built
+    std::string body;
+    std::vector<std::pair<int64_t, int64_t>> nodes;
+    std::vector<std::pair<int64_t, int64_t>> buffers;
+
+    void write(const void* data, size_t size)
+    {
+        if (size && fwrite(data, size, 1, out) != 1)
+            throw error_system("cannot write Arrow IPC stream");
+    }
+
+    void write_message(uint8_t header_type, FlatBuilder& fb, uint32_t header)
+    {
+        FlatBuilder::Table message(fb);
+        message.add<int64_t>(3, body.size());
+        message.add_offset(2, header);
+        message.add<int16_t>(0, ipc_metadata_v5);
+        message.add<uint8_t>(1, header_type);
+        std::string metadata = fb.finish(message.finish());
+
+        uint32_t prefix[2] = { 0xffffffff, (uint32_t)metadata.size() };
+        write(prefix, 8);
+        write(metadata.data(), metadata.size());
+        write(body.data(), body.size());
+        body.clear();
+        nodes.clear();
+        buffers.clear();
+    }
+
+    static int64_t int_width(const char* format)
+    {
+        switch (format[0])
+        {
+            case 'i': return 4;
+            case 'l': return 8;
+            case 'g': return 8;
+            case 't': return 8;
+            default: error_unimplemented::throwf("cannot write Arrow format %s in IPC streams", format);
+        }
+    }
+
+    /// Create the Type table of the values of a field, returning its type id
+    uint8_t create_type(FlatBuilder& fb, const char* format, uint32_t& ref)
+    {
+        FlatBuilder::Table type(fb);
+        uint8_t res;
+        switch (format[0])
+        {
+            case 'i':
+            case 'l':
+                type.add<int32_t>(0, int_width(format) * 8);
+                type.add<uint8_t>(1, 1);
+                res = ipc_type_int;
+                break;
+            case 'g':
+                type.add<int16_t>(0, 2);
+                res = ipc_type_floating_point;
+                break;
+            case 'u':
+                res = ipc_type_utf8;
+                break;
+            case 't':
+                if (strcmp(format, "tss:") != 0)
+                    error_unimplemented::throwf("cannot write Arrow format %s in IPC streams", format);
+                type.add<int16_t>(0, 0);
+                res = ipc_type_timestamp;
+                break;
+            case '+':
+                if (format[1] == 'l')
+                    res = ipc_type_list;
+                else if (format[1] == 's')
+                    res = ipc_type_struct;
+                else
+                    error_unimplemented::throwf("cannot write Arrow format %s in IPC streams", format);
+                break;
+            default:
+                error_unimplemented::throwf("cannot write Arrow format %s in IPC streams", format);
+        }
+        ref = type.finish();
+        return res;
+    }
+
+    uint32_t create_field(FlatBuilder& fb, const ArrowSchema& schema)
+    {
+        std::vector<uint32_t> children;
+        for (int64_t i = 0; i < schema.n_children; ++i)
+            children.push_back(create_field(fb, *schema.children[i]));
+        uint32_t children_ref = fb.create_offsets(children);
+
+        uint32_t dictionary_ref = 0;
+        const char* format = schema.format;
+        if (schema.dictionary)
+        {
+            if (strcmp(schema.format, "i") != 0)
+                error_unimplemented::throwf("cannot write Arrow dictionaries indexed by %s in IPC streams", schema.format);
+            FlatBuilder::Table index_type(fb);
+            index_type.add<int32_t>(0, 32);
+            index_type.add<uint8_t>(1, 1);
+            uint32_t index_type_ref = index_type.finish();
+
+            FlatBuilder::Table encoding(fb);
+            encoding.add<int64_t>(0, dictionaries.size());
+            encoding.add_offset(1, index_type_ref);
+            dictionary_ref = encoding.finish();
+            dictionaries.push_back(&schema);
+            format = schema.dictionary->format;
+        }
+
+        uint32_t type_ref;
+        uint8_t type_type = create_type(fb, format, type_ref);
+        uint32_t name_ref = fb.create_string(schema.name ? schema.name : "");
+
+        FlatBuilder::Table field(fb);
+        field.add_offset(0, name_ref);
+        field.add_offset(3, type_ref);
+        if (dictionary_ref)
+            field.add_offset(4, dictionary_ref);
+        field.add_offset(5, children_ref);
+        field.add<uint8_t>(1, (schema.flags & ARROW_FLAG_NULLABLE) ? 1 : 0);
+        field.add<uint8_t>(2, type_type);
+        return field.finish();
+    }
+
+    void add_buffer(const void* data, int64_t size)
+    {
+        buffers.emplace_back(body.size(), size);
+        if (size)
+            body.append(static_cast<const char*>(data), size);
+        body.append((8 - body.size() % 8) % 8, 0);
+    }
+
+    /// Append the nodes and buffers of \a array to the message body
+    void add_array(const ArrowSchema& schema, const ArrowArray& array)
+    {
+        if (array.offset != 0)
+            throw error_unimplemented("cannot write Arrow arrays with an offset in IPC streams");
+        nodes.emplace_back(array.length, array.null_count);
+        add_buffer(array.buffers[0], array.buffers[0] ? (array.length + 7) / 8 : 0);
+        const char* format = schema.format;
+        switch (format[0])
+        {
+            case 'u': {
+                const int32_t* offsets = static_cast<const int32_t*>(array.buffers[1]);
+                add_buffer(offsets, (array.length + 1) * 4);
+                add_buffer(array.buffers[2], offsets[array.length]);
+                break;
+            }
+            case '+':
+                if (format[1] == 'l')
+                    add_buffer(array.buffers[1], (array.length + 1) * 4);
+                break;
+            default:
+                add_buffer(array.buffers[1], array.length * int_width(format));
+                break;
+        }
+        for (int64_t i = 0; i < schema.n_children; ++i)
+            add_array(*schema.children[i], *array.children[i]);
+    }
+
+    uint32_t create_record_batch(FlatBuilder& fb, int64_t length)
+    {
+        uint32_t buffers_ref = fb.create_pairs(buffers);
+        uint32_t nodes_ref = fb.create_pairs(nodes);
+        FlatBuilder::Table batch(fb);
+        batch.add<int64_t>(0, length);
+        batch.add_offset(1, nodes_ref);
+        batch.add_offset(2, buffers_ref);
+        return batch.finish();
+    }
+
+    /// Find the dictionaries of \a array, in the same order as in the schema
+    static void find_dictionaries(const ArrowSchema& schema, const ArrowArray& array, std::vector<const ArrowArray*>& out)
+    {
+        if (schema.dictionary)
+            out.push_back(array.dictionary);
+        for (int64_t i = 0; i < schema.n_children; ++i)
+            find_dictionaries(*schema.children[i], *array.children[i], out);
+    }
+
+public:
+    IPCWriter(FILE* out) : out(out) {}
+
+    void write_schema(const ArrowSchema& schema)
+    {
+        if (strcmp(schema.format, "+s") != 0)
+            throw error_consistency("Arrow IPC streams need a struct schema");
+        FlatBuilder fb;
+        std::vector<uint32_t> fields;
+        for (int64_t i = 0; i < schema.n_children; ++i)
+            fields.push_back(create_field(fb, *schema.children[i]));
+        uint32_t fields_ref = fb.create_offsets(fields);
+        FlatBuilder::Table table(fb);
+        table.add_offset(1, fields_ref);
+        write_message(ipc_header_schema, fb, table.finish());
+    }
+
+    void write_batch(const ArrowSchema& schema, const ArrowArray& array)
+    {
+        // Dictionaries change with each batch, and are sent as replacements
+        std::vector<const ArrowArray*> dicts;
+        for (int64_t i = 0; i < schema.n_children; ++i)
+            find_dictionaries(*schema.children[i], *array.children[i], dicts);
+        for (size_t id = 0; id < dicts.size(); ++id)
+        {
+            add_array(*dictionaries[id]->dictionary, *dicts[id]);
+            FlatBuilder fb;
+            uint32_t data = create_record_batch(fb, dicts[id]->length);
+            FlatBuilder::Table batch(fb);
+            batch.add<int64_t>(0, id);
+            batch.add_offset(1, data);
+            write_message(ipc_header_dictionary_batch, fb, batch.finish());
+        }
+
+        for (int64_t i = 0; i < schema.n_children; ++i)
+            add_array(*schema.children[i], *array.children[i]);
+        FlatBuilder fb;
+        write_message(ipc_header_record_batch, fb, create_record_batch(fb, array.length));
+    }
+
+    void write_end()
+    {
+        uint32_t eos[2] = { 0xffffffff, 0 };
+        write(eos, 8);
+    }
+};
+
+}
+
+void write_ipc_stream(ArrowArrayStream* stream, FILE* out)
+{
+    auto check = [&](int res) {
+        if (res == 0) return;
+        const char* msg = stream->get_last_error(stream);
+        error_consistency::throwf("cannot read Arrow stream: %s", msg ? msg : strerror(res));
+    };
+
+    ArrowSchema schema;
+    check(stream->get_schema(stream, &schema));
+    try {
+        IPCWriter writer(out);
+        writer.write_schema(schema);
+        while (true)
+        {
+            ArrowArray array;
+            check(stream->get_next(stream, &array));
+            if (!array.release) break;
+            try {
+                writer.write_batch(schema, array);
+            } catch (...) {
+                array.release(&array);
+                throw;
+            }
+            array.release(&array);
+        }
+        writer.write_end();
+    } catch (...) {
+        schema.release(&schema);
+        throw;
+    }
+    schema.release(&schema);
+}
+
+void export_data(std::shared_ptr<dballe::CursorData> cursor, ArrowArrayStream* out, unsigned batch_size)
+{
+    if (batch_size == 0)
+        throw error_consistency("batch size must be at least 1");
+
+    StreamPrivate* priv = new StreamPrivate;
+    priv->cursor = cursor;
+    priv->batch_size = batch_size;
+    out->get_schema = stream_get_schema;
+    out->get_next = stream_get_next;
+    out->get_last_error = stream_get_last_error;
+    out->release = stream_release;
+    out->private_data = priv;
+}
+
+}
+}
+}
@@ -0,0 +1,133 @@
+#ifndef DBALLE_CORE_ARROW_H
+#define DBALLE_CORE_ARROW_H
+
+/** @file
+ * @ingroup core
+ * Export query results in Apache Arrow columnar format.
+ *
+ * Data is exported through the Arrow C data interface, which needs no Arrow
+ * library to produce, and can be imported by any Arrow implementation (for
+ * example pyarrow) to be processed or written as Parquet or Arrow IPC files.
+ *
+ * Streams can also be written directly in the Arrow IPC stream format, which
+ * is readable by all Arrow implementations.
+ */
+
+#include <dballe/fwd.h>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+// Arrow C data interface and C stream interface, as defined in
+// https://arrow.apache.org/docs/format/CDataInterface.html and
+// https://arrow.apache.org/docs/format/CStreamInterface.html
+extern "C" {
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray {
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream {
+    // Callbacks providing stream functionality
+    int (*get_schema)(struct ArrowArrayStream*, struct ArrowSchema* out);
+    int (*get_next)(struct ArrowArrayStream*, struct ArrowArray* out);
+    const char* (*get_last_error)(struct ArrowArrayStream*);
+
+    // Release callback
+    void (*release)(struct ArrowArrayStream*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+#endif  // ARROW_C_STREAM_INTERFACE
+
+}
+
+namespace dballe {
+namespace core {
+namespace arrow {
+
+/**
+ * Export the rows of a data cursor as a stream of Arrow record batches.
+ *
+ * Each batch is a struct array with these columns:
+ *
+ * * ana_id: int32, station ID, null if not available
+ * * report: dictionary encoded string
+ * * lat, lon: int32, coordinates in 1/100000 of a degree
+ * * ident: string, null for fixed stations
+ * * level, trange: dictionary encoded string, formatted like
+ *   Level::to_string() and Trange::to_string()
+ * * datetime: timestamp with second precision
+ * * var: dictionary encoded string, the variable code
+ * * value: float64, the value of numeric variables
+ * * value_str: string, the value of string variables
+ * * attrs: list of structs with code, value and value_str fields, for the
+ *   attributes loaded with the variable (see the "attrs" query modifier)
+ *
+ * Dictionaries are built for each batch, so that each distinct level, time
+ * range, report and variable code is formatted only once per batch.
+ *
+ * The stream keeps a reference to the cursor, and reads it as batches are
+ * requested. \a out is initialised and must be released by the caller.
+ */
+void export_data(std::shared_ptr<dballe::CursorData> cursor, ArrowArrayStream* out, unsigned batch_size=65536);
+
+/**
+ * Write all the batches of \a stream to \a out, in the Arrow IPC stream
+ * format.
+ *
+ * Only the column types produced by export_data() are supported. Dictionaries
+ * are written again before each batch that uses them, as replacements of the
+ * previous ones.
+ *
+ * \a stream is read until its end, and is not released.
+ */
+void write_ipc_stream(ArrowArrayStream* stream, FILE* out);
+
+}
+}
+}
+
+#endif
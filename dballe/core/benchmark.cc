@@ -7,6 +7,9 @@
 #include <algorithm>
 #include "dballe/msg/msg.h"
 #include "dballe/importer.h"
+#include "dballe/core/json.h"
+#include <cstring>
+#include <sstream>
 
 using namespace std;
 
@@ -78,19 +81,27 @@ void Timeit::run(Progress& progress, Task& task)
     try {
         task.setup();
 
+        task.items = 0;
         bench_getrusage(RUSAGE_SELF, &res_at_start);
         bench_clock_gettime(CLOCK_MONOTONIC_RAW, &time_at_start);
         for (unsigned i = 0; i < repetitions; ++i)
             task.run_once();
         bench_clock_gettime(CLOCK_MONOTONIC_RAW, &time_at_end);
         bench_getrusage(RUSAGE_SELF, &res_at_end);
+        items = task.items;
     } catch (std::exception& e) {
+        failed = true;
         progress.test_failed(task, e);
     }
     task.teardown();
     progress.end_timeit(*this);
 }
 
+double Timeit::elapsed() const
+{
+    return (time_at_end.tv_sec - time_at_start.tv_sec) + (time_at_end.tv_nsec - time_at_start.tv_nsec) / 1000000000.0;
+}
+
 void Throughput::run(Progress& progress, Task& task)
 {
     task_name = task.name();
@@ -104,6 +115,7 @@ void Throughput::run(Progress& progress, Task& task)
         time_at_end.tv_sec  = time_at_start.tv_sec + time_at_end.tv_nsec / 1000000000 + (long)floor(run_time);
         time_at_end.tv_nsec = time_at_end.tv_nsec % 1000000000;
 
+        task.items = 0;
         struct timespec time_cur;
         for ( ; true; ++times_run)
         {
@@ -114,7 +126,9 @@ void Throughput::run(Progress& progress, Task& task)
         }
 
         run_time = time_cur.tv_sec - time_at_start.tv_sec + (time_cur.tv_nsec - time_at_start.tv_nsec) / 1000000000.0;
+        items = task.items;
     } catch (std::exception& e) {
+        failed = true;
         progress.test_failed(task, e);
     }
     task.teardown();
@@ -170,6 +184,63 @@ void Benchmark::print_timings()
     */
 }
 
+static double timeval_seconds(const struct timeval& begin, const struct timeval& until)
+{
+    return (until.tv_sec - begin.tv_sec) + (until.tv_usec - begin.tv_usec) / 1000000.0;
+}
+
+void Benchmark::print_json(FILE* out)
+{
+    std::stringstream buf;
+    core::JSONWriter writer(buf);
+    writer.start_mapping();
+    writer.add("tasks");
+    writer.start_list();
+    for (auto& t: timeit_tasks)
+    {
+        double elapsed = t.elapsed();
+        writer.start_mapping();
+        writer.add("name", t.task_name);
+        writer.add("type", "timeit");
+        writer.add("failed", t.failed);
+        if (!t.failed)
+        {
+            writer.add("repetitions", (int)t.repetitions);
+            writer.add("seconds", elapsed);
+            writer.add("user", timeval_seconds(t.res_at_start.ru_utime, t.res_at_end.ru_utime));
+            writer.add("system", timeval_seconds(t.res_at_start.ru_stime, t.res_at_end.ru_stime));
+            writer.add("runs_per_second", elapsed > 0 ? t.repetitions / elapsed : 0.0);
+            writer.add("items", t.items);
+            writer.add("items_per_second", elapsed > 0 ? t.items / elapsed : 0.0);
+        }
+        writer.end_mapping();
+    }
+    for (auto& t: throughput_tasks)
+    {
+        writer.start_mapping();
+        writer.add("name", t.task_name);
+        writer.add("type", "throughput");
+        writer.add("failed", t.failed);
+        if (!t.failed)
+        {
+            writer.add("repetitions", (int)t.times_run);
+            writer.add("seconds", t.run_time);
+            writer.add("runs_per_second", t.run_time > 0 ? t.times_run / t.run_time : 0.0);
+            writer.add("items", t.items);
+            writer.add("items_per_second", t.run_time > 0 ? t.items / t.run_time : 0.0);
+        }
+        writer.end_mapping();
+    }
+    writer.end_list();
+    // Peak RSS is process-wide, so it is reported for the whole run
+    struct rusage res;
+    bench_getrusage(RUSAGE_SELF, &res);
+    writer.add("max_rss_kb", (int)res.ru_maxrss);
+    writer.end_mapping();
+    buf << std::endl;
+    fputs(buf.str().c_str(), out);
+}
+
 BasicProgress::BasicProgress(FILE* out, FILE* err)
     : out(out), err(err) {}
 
@@ -219,7 +290,8 @@ void Messages::duplicate(size_t size, const Datetime& datetime)
 Whitelist::Whitelist(int argc, const char* argv[])
 {
     for (int i = 1; i < argc; ++i)
-        emplace_back(argv[i]);
+        if (strncmp(argv[i], "--", 2) != 0)
+            emplace_back(argv[i]);
 }
 
 bool Whitelist::has(const std::string& val)
@@ -228,5 +300,27 @@ bool Whitelist::has(const std::string& val)
     return std::find(begin(), end(), val) != end();
 }
 
+Options::Options(int argc, const char* argv[])
+    : whitelist(argc, argv)
+{
+    for (int i = 1; i < argc; ++i)
+        if (strcmp(argv[i], "--json") == 0)
+            json = true;
+}
+
+void Options::setup(Benchmark& benchmark)
+{
+    if (json)
+        benchmark.progress = make_shared<BasicProgress>(stderr, stderr);
+}
+
+void Options::print(Benchmark& benchmark)
+{
+    if (json)
+        benchmark.print_json();
+    else
+        benchmark.print_timings();
+}
+
 }
 }
@@ -31,6 +31,15 @@ struct Task
     Task& operator=(const Task&) = delete;
     Task& operator=(Task&&) = delete;
 
+    /**
+     * Number of items (messages, rows, ...) processed by run_once(), used to
+     * compute throughput.
+     *
+     * It is reset before each measurement, and tasks can increment it in
+     * run_once(). It is left to 0 by tasks for which it is not meaningful.
+     */
+    size_t items = 0;
+
     virtual const char* name() const = 0;
 
     /// Set up the environment for running run_once()
@@ -59,8 +68,15 @@ struct Timeit
     struct timespec time_at_end;
     struct rusage res_at_start;
     struct rusage res_at_end;
+    /// Items processed by all repetitions
+    size_t items = 0;
+    /// True if the task failed
+    bool failed = false;
 
     void run(Progress& progress, Task& task);
+
+    /// Elapsed wall clock time in seconds
+    double elapsed() const;
 };
 
 struct Throughput
@@ -69,6 +85,10 @@ struct Throughput
     /// How many seconds to run the task to see how many times per second it runs
     double run_time = 0.5;
     unsigned times_run = 0;
+    /// Items processed by all runs
+    size_t items = 0;
+    /// True if the task failed
+    bool failed = false;
 
     void run(Progress& progress, Task& task);
 };
@@ -136,6 +156,16 @@ struct Benchmark
 
     /// Print timings to stdout
     void print_timings();
+
+    /**
+     * Print timings, throughput and peak resident set size to \a out as
+     * JSON.
+     *
+     * Peak resident set size is the one of the whole process at the end of
+     * each task, in kilobytes: run one task per process to measure it for
+     * each task.
+     */
+    void print_json(FILE* out=stdout);
 };
 
 
@@ -151,6 +181,7 @@ struct Messages : public std::vector<std::vector<std::shared_ptr<dballe::Message
     void duplicate(size_t size, const Datetime& datetime);
 };
 
+/// List of task names given on the command line, ignoring options
 struct Whitelist : protected std::vector<std::string>
 {
     Whitelist(int argc, const char* argv[]);
@@ -158,6 +189,31 @@ struct Whitelist : protected std::vector<std::string>
     bool has(const std::string& val);
 };
 
+/**
+ * Command line options of benchmark programs.
+ *
+ * Usage: program [--json] [task names...]
+ */
+struct Options
+{
+    /// Tasks to run
+    Whitelist whitelist;
+    /// Print results as JSON instead of CSV
+    bool json = false;
+
+    Options(int argc, const char* argv[]);
+
+    /**
+     * Configure \a benchmark for these options.
+     *
+     * When printing JSON, this sends progress information to stderr.
+     */
+    void setup(Benchmark& benchmark);
+
+    /// Print the results of \a benchmark in the requested format
+    void print(Benchmark& benchmark);
+};
+
 }
 }
 
@@ -180,6 +180,36 @@ class Tests : public TestCase
             }
         });
 
+        // Test columns spanning input blocks
+        add_method("reader_blocks", []() {
+            std::string long_value(100000, 'a');
+            std::string long_quoted(70000, 'b');
+            stringstream in;
+            for (unsigned i = 0; i < 10000; ++i)
+                in << i << ",\"x,\"\"y\"\"\"," << long_value.substr(0, i % 100) << "\r\n";
+            in << long_value << ",\"" << long_quoted << "\n\"\"\"\n";
+            in << "last,line";
+
+            CSVReader reader(in);
+            for (unsigned i = 0; i < 10000; ++i)
+            {
+                wassert(actual(reader.next()).istrue());
+                wassert(actual(reader.cols.size()) == 3u);
+                wassert(actual(reader.as_int(0)) == (int)i);
+                wassert(actual(reader.cols[1]) == "x,\"y\"");
+                wassert(actual(reader.cols[2]) == long_value.substr(0, i % 100));
+            }
+            wassert(actual(reader.next()).istrue());
+            wassert(actual(reader.cols.size()) == 2u);
+            wassert(actual(reader.cols[0]) == long_value);
+            wassert(actual(reader.cols[1]) == long_quoted + "\n\"");
+            wassert(actual(reader.next()).istrue());
+            wassert(actual(reader.cols.size()) == 2u);
+            wassert(actual(reader.cols[0]) == "last");
+            wassert(actual(reader.cols[1]) == "line");
+            wassert(actual(reader.next()).isfalse());
+        });
+
         // Test write/read cycles
         add_method("writer", []() {
             MemoryCSVWriter out;
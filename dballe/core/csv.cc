@@ -83,6 +83,7 @@ void CSVReader::close()
     if (in && close_on_exit)
         delete in;
     in = 0;
+    buf_pos = buf_end = 0;
     close_on_exit = true;
 }
 
@@ -140,19 +141,69 @@ bool CSVReader::move_to_data(unsigned number_col)
     return true;
 }
 
-int CSVReader::next_char()
+bool CSVReader::refill()
 {
-    int res = in->get();
-    if (res == EOF && !in->eof())
-        throw error_system("reading a character from CSV input");
-    return res;
+    if (buf.empty())
+        buf.resize(65536);
+    in->read(buf.data(), buf.size());
+    if (in->bad())
+        throw error_system("reading CSV input");
+    buf_pos = 0;
+    buf_end = in->gcount();
+    return buf_end > 0;
+}
+
+void CSVReader::scan_run(std::string& col, bool quoted)
+{
+    while (true)
+    {
+        const char* start = buf.data() + buf_pos;
+        const char* end = buf.data() + buf_end;
+        const char* found;
+        if (quoted)
+            found = (const char*)memchr(start, '"', end - start);
+        else
+        {
+            found = start;
+            while (found != end && *found != ',' && *found != '\r' && *found != '\n')
+                ++found;
+            if (found == end)
+                found = nullptr;
+        }
+
+        if (found)
+        {
+            col.append(start, found - start);
+            buf_pos = found - buf.data();
+            return;
+        }
+
+        col.append(start, end - start);
+        buf_pos = buf_end;
+        if (!refill())
+            return;
+    }
+}
+
+void CSVReader::push_col(std::string& col)
+{
+    // Swap strings, to reuse the memory allocated for previous lines
+    if (ncols < cols.size())
+        cols[ncols].swap(col);
+    else
+    {
+        cols.emplace_back();
+        cols.back().swap(col);
+    }
+    ++ncols;
+    col.clear();
 }
 
 bool CSVReader::next()
 {
     if (!in) return false;
 
-    cols.clear();
+    ncols = 0;
 
     // Tokenize the input line
     enum State { BEG, COL, QCOL, EQCOL, HALFEOL } state = BEG;
@@ -171,18 +222,19 @@ bool CSVReader::next()
                         break;
                     case ',':
                         state = BEG;
-                        cols.push_back(col);
-                        col.clear();
+                        push_col(col);
                         break;
                     case '\r':
                         state = HALFEOL;
                         break;
                     case '\n':
-                        cols.push_back(col);
+                        push_col(col);
+                        cols.resize(ncols);
                         return true;
                     default:
                         state = COL;
                         col += c;
+                        scan_run(col, false);
                         break;
                 }
                 break;
@@ -192,17 +244,18 @@ bool CSVReader::next()
                 {
                     case ',':
                         state = BEG;
-                        cols.push_back(col);
-                        col.clear();
+                        push_col(col);
                         break;
                     case '\r':
                         state = HALFEOL;
                         break;
                     case '\n':
-                        cols.push_back(col);
+                        push_col(col);
+                        cols.resize(ncols);
                         return true;
                     default:
                         col += c;
+                        scan_run(col, false);
                         break;
                 }
                 break;
@@ -215,6 +268,7 @@ bool CSVReader::next()
                         break;
                     default:
                         col += c;
+                        scan_run(col, true);
                         break;
                 }
                 break;
@@ -225,14 +279,14 @@ bool CSVReader::next()
                     // The quote marked the end of the value
                     case ',':
                         state = BEG;
-                        cols.push_back(col);
-                        col.clear();
+                        push_col(col);
                         break;
                     case '\r':
                         state = HALFEOL;
                         break;
                     case '\n':
-                        cols.push_back(col);
+                        push_col(col);
+                        cols.resize(ncols);
                         return true;
                     // The quote was an escape
                     default:
@@ -246,7 +300,8 @@ bool CSVReader::next()
                 switch (c)
                 {
                     case '\n':
-                        cols.push_back(col);
+                        push_col(col);
+                        cols.resize(ncols);
                         return true;
                     default:
                         state = COL;
@@ -259,10 +314,14 @@ bool CSVReader::next()
     }
 
     if (state == BEG)
+    {
+        cols.resize(ncols);
         return false;
+    }
 
     if (!col.empty())
-        cols.push_back(col);
+        push_col(col);
+    cols.resize(ncols);
 
     return true;
 }
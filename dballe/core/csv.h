@@ -53,7 +53,34 @@ class CSVReader
 protected:
     std::istream* in;
 
-    int next_char();
+    /// Block of input data being tokenized
+    std::vector<char> buf;
+    /// Position of the next character to read in buf
+    size_t buf_pos = 0;
+    /// Number of valid characters in buf
+    size_t buf_end = 0;
+    /// Number of columns parsed so far in the current line
+    unsigned ncols = 0;
+
+    /// Read the next block of input, returning false on EOF
+    bool refill();
+
+    int next_char()
+    {
+        if (buf_pos == buf_end && !refill())
+            return EOF;
+        return (unsigned char)buf[buf_pos++];
+    }
+
+    /**
+     * Append to col all the characters from the current position up to the
+     * first one that is a separator, a newline or (if quoted is true) a
+     * quote, without consuming it
+     */
+    void scan_run(std::string& col, bool quoted);
+
+    /// Store col as the next column of the current line, and clear it
+    void push_col(std::string& col);
 
 public:
     /**
@@ -100,6 +100,11 @@ void CrexFile::write(const std::string& msg)
     CrexBulletin::write(msg, fd, m_name.c_str());
 }
 
+JsonFile::~JsonFile()
+{
+    free(line_buf);
+}
+
 BinaryMessage JsonFile::read()
 {
     if (fd == nullptr)
@@ -107,15 +112,16 @@ BinaryMessage JsonFile::read()
 
     BinaryMessage res(Encoding::JSON);
     long offset = ftell(fd);
-    int c;
-    while ((c = getc(fd)) != EOF)
-    {
-        if (c == '\n')
-            break;
-        res.data += c;
-    }
-    if (res.data.empty())
+    // getline scans the stdio buffer with memchr, instead of going through
+    // it one character at a time
+    ssize_t len = getline(&line_buf, &line_size, fd);
+    if (len <= 0)
+        return res;
+    if (line_buf[len - 1] == '\n')
+        --len;
+    if (len == 0)
         return res;
+    res.data.assign(line_buf, len);
 
     res.pathname = m_name;
     res.index = idx++;
@@ -71,9 +71,16 @@ public:
 
 class JsonFile : public dballe::core::File
 {
+protected:
+    /// Line buffer reused across calls to read()
+    char* line_buf = nullptr;
+    /// Allocated size of line_buf
+    size_t line_size = 0;
+
 public:
     JsonFile(const std::string& name, FILE* fd, bool close_on_exit=true)
         : File(name, fd, close_on_exit) {}
+    ~JsonFile();
 
     Encoding encoding() const override { return Encoding::JSON; }
     BinaryMessage read() override;
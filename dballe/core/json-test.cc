@@ -100,6 +100,32 @@ class Tests : public TestCase
             writer.end_mapping();
             wassert(actual(out.str()) == "{\"\":1,\"antani\":1.0}");
         });
+        add_method("stream_buffer", []() {
+            // Parsing from memory and from an istream gives the same results
+            std::string json = "{\"r\": \"synop\", \"c\": [4500000, 1100000], \"i\": \"a\\\"b\\\\c\\nd\"} [1, null, 2] x";
+            auto check = [](core::json::Stream& in) {
+                Station st = in.parse_station();
+                wassert(actual(st.report) == "synop");
+                wassert(actual(st.coords) == Coords(45.0, 11.0));
+                wassert(actual(st.ident.get()) == "a\"b\\c\nd");
+                Level lev = in.parse_level();
+                wassert(actual(lev) == Level(1, MISSING_INT, 2));
+                wassert_false(in.at_end());
+                wassert(actual(in.get()) == 'x');
+                wassert_true(in.at_end());
+                wassert(actual(in.get()) == EOF);
+            };
+
+            core::json::Stream membuf(json);
+            wassert(check(membuf));
+
+            std::istringstream sin(json);
+            core::json::Stream stream(sin);
+            wassert(check(stream));
+
+            core::json::Stream truncated(json.data(), 10);
+            wassert_throws(core::JSONParseException, truncated.parse_station());
+        });
     };
 } test("core_json");
 
@@ -248,7 +248,7 @@ void Stream::expect_token(const char* token)
 {
     for (const char* s = token; *s; ++s)
     {
-        int c = in.get();
+        int c = get();
         if (c != *s)
         {
             if (c == EOF)
@@ -263,8 +263,14 @@ void Stream::expect_token(const char* token)
 
 void Stream::skip_spaces()
 {
-    while (isspace(in.peek()))
-        in.get();
+    if (!in)
+    {
+        while (pos != end && isspace((unsigned char)*pos))
+            ++pos;
+        return;
+    }
+    while (isspace(peek()))
+        get();
 }
 
 double Stream::parse_double()
@@ -281,7 +287,7 @@ std::tuple<std::string, bool> Stream::parse_number()
     bool is_double = false;
     while (!done)
     {
-        int c = in.peek();
+        int c = peek();
         switch (c)
         {
             case '-':
@@ -295,14 +301,14 @@ std::tuple<std::string, bool> Stream::parse_number()
             case '7':
             case '8':
             case '9':
-                num.append(1, in.get());
+                num.append(1, get());
                 break;
             case '.':
             case 'e':
             case 'E':
             case '+':
                 is_double = true;
-                num.append(1, in.get());
+                num.append(1, get());
                 break;
             default:
                 done = true;
@@ -317,17 +323,26 @@ std::tuple<std::string, bool> Stream::parse_number()
 std::string Stream::parse_string()
 {
     string res;
-    int c = in.get(); // Eat the leading '"'
+    int c = get(); // Eat the leading '"'
     if (c != '"')
         throw JSONParseException("expected string does not begin with '\"'");
     bool done = false;
     while (!done)
     {
-        int c = in.get();
+        if (!in)
+        {
+            // Copy runs of plain characters in one go
+            const char* run = pos;
+            while (run != end && *run != '"' && *run != '\\')
+                ++run;
+            res.append(pos, run);
+            pos = run;
+        }
+        int c = get();
         switch (c)
         {
             case '\\':
-                c = in.get();
+                c = get();
                 if (c == EOF)
                     throw JSONParseException("unterminated string");
                 switch (c)
@@ -529,43 +544,43 @@ DatetimeRange Stream::parse_datetimerange()
 
 void Stream::parse_array(std::function<void()> on_element)
 {
-    if (in.get() != '[')
+    if (get() != '[')
         throw JSONParseException("expected array does not begin with '['");
     skip_spaces();
-    while (in.peek() != ']')
+    while (peek() != ']')
     {
         on_element();
-        if (in.peek() == ',')
-            in.get();
+        if (peek() == ',')
+            get();
         skip_spaces();
     }
-    if (in.get() != ']')
+    if (get() != ']')
         throw JSONParseException("array does not end with '['");
     skip_spaces();
 }
 
 void Stream::parse_object(std::function<void(const std::string& key)> on_value)
 {
-    if (in.get() != '{')
+    if (get() != '{')
         throw JSONParseException("expected object does not begin with '{'");
     skip_spaces();
-    while (in.peek() != '}')
+    while (peek() != '}')
     {
-        if (in.peek() != '"')
+        if (peek() != '"')
             throw JSONParseException("expected a string as object key");
         std::string key = parse_string();
         skip_spaces();
-        if (in.peek() == ':')
-            in.get();
+        if (peek() == ':')
+            get();
         else
             throw JSONParseException("':' expected after object key");
         skip_spaces();
         on_value(key);
-        if (in.peek() == ',')
-            in.get();
+        if (peek() == ',')
+            get();
         skip_spaces();
     }
-    if (in.get() != '}')
+    if (get() != '}')
         throw JSONParseException("expected object does not end with '}'");
     skip_spaces();
 }
@@ -573,7 +588,7 @@ void Stream::parse_object(std::function<void(const std::string& key)> on_value)
 Element Stream::identify_next()
 {
     skip_spaces();
-    switch (in.peek())
+    switch (peek())
     {
         case EOF:
             throw JSONParseException("JSON string is truncated");
@@ -595,7 +610,7 @@ Element Stream::identify_next()
         case 'f': return JSON_FALSE;
         case 'n': return JSON_NULL;
         default:
-            // throw JSONParseException(str::fmtf("unexpected character '%c'", in.in.peek()));
+            // throw JSONParseException(str::fmtf("unexpected character '%c'", in.peek()));
             throw JSONParseException("unexpected character");
     }
 }
@@ -651,7 +666,7 @@ static void parse_value(json::Stream& in, JSONReader& e)
             in.skip_spaces();
             break;
         default:
-            // throw JSONParseException(str::fmtf("unexpected character '%c'", in.in.peek()));
+            // throw JSONParseException(str::fmtf("unexpected character '%c'", in.peek()));
             throw JSONParseException("unexpected character");
     }
     in.skip_spaces();
@@ -662,5 +677,9 @@ void JSONReader::parse(std::istream& in) {
     parse_value(jstream, *this);
 }
 
+void JSONReader::parse(json::Stream& in) {
+    parse_value(in, *this);
+}
+
 }
 }
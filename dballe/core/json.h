@@ -8,6 +8,8 @@
 #include <vector>
 #include <ostream>
 #include <istream>
+#include <cstdio>
+#include <string>
 
 namespace dballe {
 namespace core {
@@ -124,6 +126,10 @@ public:
     }
 };
 
+namespace json {
+struct Stream;
+}
+
 /**
  * JSON sax-like parser.
  */
@@ -146,6 +152,9 @@ public:
 
     // Parse a stream
     void parse(std::istream& in);
+
+    // Parse the next value from a json::Stream
+    void parse(json::Stream& in);
 };
 
 
@@ -162,11 +171,48 @@ enum Element
     JSON_NULL,
 };
 
+/**
+ * JSON input stream.
+ *
+ * It can read either from a std::istream, or directly from a memory buffer.
+ * Parsing from a memory buffer avoids going through the istream machinery for
+ * each character, and is considerably faster: use it when the whole JSON data
+ * is already in memory.
+ */
 struct Stream
 {
-    std::istream& in;
+    /// Input stream, or nullptr when reading from a memory buffer
+    std::istream* in = nullptr;
+    /// Current position in the memory buffer
+    const char* pos = nullptr;
+    /// End of the memory buffer
+    const char* end = nullptr;
+
+    Stream(std::istream& in) : in(&in) {}
+    Stream(const char* buf, size_t size) : pos(buf), end(buf + size) {}
+    Stream(const std::string& buf) : pos(buf.data()), end(buf.data() + buf.size()) {}
+
+    /// Return the next character without consuming it, or EOF
+    int peek()
+    {
+        if (in) return in->peek();
+        if (pos == end) return EOF;
+        return (unsigned char)*pos;
+    }
 
-    Stream(std::istream& in) : in(in) {}
+    /// Consume and return the next character, or EOF
+    int get()
+    {
+        if (in) return in->get();
+        if (pos == end) return EOF;
+        return (unsigned char)*pos++;
+    }
+
+    /// Check if there is no more data to read
+    bool at_end()
+    {
+        return peek() == EOF;
+    }
 
     /// Raise a parse error if the stream does not yield this exact token
     void expect_token(const char* token);
@@ -181,9 +227,9 @@ struct Stream
         T res = 0;
         while (true)
         {
-            int c = in.peek();
+            int c = peek();
             if (c >= '0' and c <= '9')
-                res = res * 10 + in.get() - '0';
+                res = res * 10 + get() - '0';
             else
                 break;
         }
@@ -195,9 +241,9 @@ struct Stream
     template<typename T>
     T parse_signed()
     {
-        if (in.peek() == '-')
+        if (peek() == '-')
         {
-            in.get();
+            get();
             return -parse_unsigned<T>();
         } else
             return parse_unsigned<T>();
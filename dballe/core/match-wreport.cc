@@ -2,7 +2,12 @@
 #include <dballe/core/defs.h>
 #include <wreport/subset.h>
 #include <wreport/bulletin.h>
+#include <wreport/tables.h>
+#include <wreport/vartable.h>
+#include <wreport/dtable.h>
+#include <wreport/opcodes.h>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 
 using namespace wreport;
@@ -173,4 +178,319 @@ matcher::Result MatchedBulletin::match_rep_memo(const char* memo) const
     return matcher::MATCH_NA;
 }
 
+namespace {
+
+/// Read big endian bit fields from a buffer
+struct BitReader
+{
+    const uint8_t* buf;
+    size_t size;
+    /// Position in bits
+    size_t pos = 0;
+
+    BitReader(const uint8_t* buf, size_t size) : buf(buf), size(size) {}
+
+    bool has(size_t bits) const { return pos + bits <= size * 8; }
+
+    /// Read up to 32 bits
+    uint32_t read(unsigned bits)
+    {
+        uint32_t res = 0;
+        while (bits > 0)
+        {
+            unsigned avail = 8 - pos % 8;
+            unsigned take = bits < avail ? bits : avail;
+            uint32_t chunk = (buf[pos / 8] >> (avail - take)) & ((1u << take) - 1);
+            res = (res << take) | chunk;
+            pos += take;
+            bits -= take;
+        }
+        return res;
+    }
+};
+
+unsigned read_u24(const uint8_t* p) { return (p[0] << 16) | (p[1] << 8) | p[2]; }
+
+/**
+ * Expand \a ops into a list of element descriptors, stopping at the first
+ * replication or operator.
+ *
+ * Returns true if the whole sequence has been expanded.
+ */
+bool expand_elements(const Tables& tables, const Opcodes& ops, std::vector<Varinfo>& out)
+{
+    for (unsigned i = 0; i < ops.size(); ++i)
+    {
+        Varcode code = ops[i];
+        switch (WR_VAR_F(code))
+        {
+            case 0:
+                out.push_back(tables.btable->query(code));
+                break;
+            case 3:
+                if (!expand_elements(tables, tables.dtable->query(code), out))
+                    return false;
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+bool is_leading_var(Varcode code)
+{
+    switch (code)
+    {
+        case WR_VAR(0,  1,   1):
+        case WR_VAR(0,  1,   2):
+        case WR_VAR(0,  4,   1):
+        case WR_VAR(0,  4,   2):
+        case WR_VAR(0,  4,   3):
+        case WR_VAR(0,  4,   4):
+        case WR_VAR(0,  4,   5):
+        case WR_VAR(0,  4,   6):
+        case WR_VAR(0,  5,   1):
+        case WR_VAR(0,  5,   2):
+        case WR_VAR(0,  6,   1):
+        case WR_VAR(0,  6,   2):
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Collect the leading values of a subset, as they are read
+struct LeadingScan
+{
+    int ye = MISSING_INT, mo = MISSING_INT, da = MISSING_INT;
+    int ho = MISSING_INT, mi = MISSING_INT, se = MISSING_INT;
+    double lat = NAN, lon = NAN;
+    int block = MISSING_INT, station = MISSING_INT;
+
+    /// Store a value, with its unscaled binary representation
+    void set(const Varinfo& info, int64_t raw)
+    {
+        double val = (double)(raw + info->bit_ref);
+        if (info->scale)
+            val /= pow(10.0, info->scale);
+        switch (info->code)
+        {
+            case WR_VAR(0,  1,   1): block = lround(val); break;
+            case WR_VAR(0,  1,   2): station = lround(val); break;
+            case WR_VAR(0,  4,   1): ye = lround(val); break;
+            case WR_VAR(0,  4,   2): mo = lround(val); break;
+            case WR_VAR(0,  4,   3): da = lround(val); break;
+            case WR_VAR(0,  4,   4): ho = lround(val); break;
+            case WR_VAR(0,  4,   5): mi = lround(val); break;
+            case WR_VAR(0,  4,   6): se = lround(val); break;
+            case WR_VAR(0,  5,   1):
+            case WR_VAR(0,  5,   2): lat = val; break;
+            case WR_VAR(0,  6,   1):
+            case WR_VAR(0,  6,   2): lon = val; break;
+        }
+    }
+
+    MatchedBufrPrefix::Leading result() const
+    {
+        MatchedBufrPrefix::Leading res;
+        res.block = block;
+        res.station = station;
+        try {
+            // Imported messages need at least up to the hour to have a datetime
+            if (ye != MISSING_INT && mo != MISSING_INT && da != MISSING_INT && ho != MISSING_INT)
+                res.datetime = DatetimeRange(ye, mo, da, ho, mi, se, ye, mo, da, ho, mi, se);
+        } catch (std::exception&) {
+            // Leave invalid datetimes to the full decoding
+        }
+        if (!std::isnan(lat) && !std::isnan(lon))
+            res.coords = Coords(lat, lon);
+        return res;
+    }
+};
+
+uint32_t all_ones(unsigned bits)
+{
+    return bits >= 32 ? 0xffffffff : (1u << bits) - 1;
+}
+
+}
+
+MatchedBufrPrefix::Leading::Leading()
+    : block(MISSING_INT), station(MISSING_INT)
+{
+}
+
+MatchedBufrPrefix::MatchedBufrPrefix(const std::string& data)
+{
+    try {
+        scan(data);
+    } catch (std::exception&) {
+        // Anything that cannot be read is left for the full decoding to
+        // report
+    }
+}
+
+MatchedBufrPrefix::~MatchedBufrPrefix()
+{
+}
+
+void MatchedBufrPrefix::scan(const std::string& data)
+{
+    auto header = BufrBulletin::decode_header(data);
+    header->load_tables();
+    data_category = header->data_category;
+    data_subcategory = header->data_subcategory;
+    header_decoded = true;
+
+    // Locate sections 3 and 4
+    const uint8_t* buf = (const uint8_t*)data.data();
+    size_t size = data.size();
+    if (size < 8 || buf[7] < 2) return;
+    size_t pos = 8;
+    if (pos + 10 > size) return;
+    unsigned sec1_len = read_u24(buf + pos);
+    bool has_sec2 = (buf[7] >= 4 ? buf[pos + 9] : buf[pos + 7]) & 0x80;
+    pos += sec1_len;
+    if (has_sec2)
+    {
+        if (pos + 3 > size) return;
+        pos += read_u24(buf + pos);
+    }
+    if (pos + 7 > size) return;
+    unsigned sec3_len = read_u24(buf + pos);
+    if (sec3_len < 7 || pos + sec3_len + 4 > size) return;
+    subset_count = (buf[pos + 4] << 8) | buf[pos + 5];
+    bool compressed = buf[pos + 6] & 0x40;
+    size_t sec4 = pos + sec3_len;
+    unsigned sec4_len = read_u24(buf + sec4);
+    if (sec4_len < 4 || sec4 + sec4_len > size) return;
+
+    // Expand the leading run of element descriptors
+    std::vector<Varinfo> elements;
+    bool fixed_size = expand_elements(header->tables, Opcodes(header->datadesc), elements);
+
+    // Skip the trailing elements that are not of interest
+    unsigned used = 0;
+    for (unsigned i = 0; i < elements.size(); ++i)
+        if (is_leading_var(elements[i]->code))
+            used = i + 1;
+    if (used == 0) return;
+
+    BitReader in(buf + sec4 + 4, sec4_len - 4);
+    if (compressed)
+    {
+        // Each element is stored as a reference value, the bit width of the
+        // increments, and then the increments for each subset
+        std::vector<LeadingScan> scans(subset_count);
+        for (unsigned i = 0; i < used; ++i)
+        {
+            const Varinfo& info = elements[i];
+            if (!in.has(info->bit_len + 6)) return;
+            if (info->type == Vartype::Binary) return;
+            if (info->type == Vartype::String)
+            {
+                in.pos += info->bit_len;
+                unsigned nbinc = in.read(6);
+                if (!in.has((size_t)nbinc * 8 * subset_count)) return;
+                in.pos += (size_t)nbinc * 8 * subset_count;
+                continue;
+            }
+            if (info->bit_len > 32) return;
+            uint32_t ref = in.read(info->bit_len);
+            unsigned nbinc = in.read(6);
+            if (nbinc == 0)
+            {
+                if (ref == all_ones(info->bit_len) || !is_leading_var(info->code))
+                    continue;
+                for (auto& s: scans)
+                    s.set(info, ref);
+                continue;
+            }
+            if (nbinc > 32 || !in.has((size_t)nbinc * subset_count)) return;
+            for (auto& s: scans)
+            {
+                uint32_t inc = in.read(nbinc);
+                if (inc != all_ones(nbinc) && is_leading_var(info->code))
+                    s.set(info, (int64_t)ref + inc);
+            }
+        }
+        for (const auto& s: scans)
+            leading.push_back(s.result());
+    } else {
+        // Subsets follow each other: past the first one, they can be located
+        // only if they contain no replications or operators
+        size_t subset_bits = 0;
+        for (const auto& info: elements)
+            subset_bits += info->bit_len;
+        unsigned count = fixed_size ? subset_count : 1;
+        for (unsigned s = 0; s < count; ++s)
+        {
+            in.pos = s * subset_bits;
+            LeadingScan scan;
+            for (unsigned i = 0; i < used; ++i)
+            {
+                const Varinfo& info = elements[i];
+                if (!in.has(info->bit_len)) return;
+                if (info->type == Vartype::String || info->type == Vartype::Binary || info->bit_len > 32 || !is_leading_var(info->code))
+                {
+                    in.pos += info->bit_len;
+                    continue;
+                }
+                uint32_t val = in.read(info->bit_len);
+                if (val != all_ones(info->bit_len))
+                    scan.set(info, val);
+            }
+            leading.push_back(scan.result());
+        }
+    }
+}
+
+matcher::Result MatchedBufrPrefix::match_var_id(int) const
+{
+    return matcher::MATCH_YES;
+}
+
+matcher::Result MatchedBufrPrefix::match_station_id(int) const
+{
+    return matcher::MATCH_YES;
+}
+
+matcher::Result MatchedBufrPrefix::match_station_wmo(int block, int station) const
+{
+    if (!all_read()) return matcher::MATCH_YES;
+    for (const auto& l: leading)
+    {
+        if (l.block == MISSING_INT || l.block == block)
+        {
+            if (station == -1 || l.station == MISSING_INT || l.station == station)
+                return matcher::MATCH_YES;
+        }
+    }
+    return matcher::MATCH_NO;
+}
+
+matcher::Result MatchedBufrPrefix::match_datetime(const DatetimeRange& range) const
+{
+    if (!all_read()) return matcher::MATCH_YES;
+    for (const auto& l: leading)
+        if (l.datetime.is_missing() || !l.datetime.is_disjoint(range))
+            return matcher::MATCH_YES;
+    return matcher::MATCH_NO;
+}
+
+matcher::Result MatchedBufrPrefix::match_coords(const LatRange& latrange, const LonRange& lonrange) const
+{
+    if (!all_read()) return matcher::MATCH_YES;
+    for (const auto& l: leading)
+        if (l.coords.is_missing() || (latrange.contains(l.coords.lat) && lonrange.contains(l.coords.lon)))
+            return matcher::MATCH_YES;
+    return matcher::MATCH_NO;
+}
+
+matcher::Result MatchedBufrPrefix::match_rep_memo(const char*) const
+{
+    return matcher::MATCH_YES;
+}
+
 }
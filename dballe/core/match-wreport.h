@@ -7,6 +7,8 @@
  */
 
 #include <dballe/core/matcher.h>
+#include <string>
+#include <vector>
 
 namespace wreport {
 struct Var;
@@ -64,5 +66,59 @@ protected:
     const MatchedSubset** subsets;
 };
 
+/**
+ * Match the station and datetime values found at the start of the subsets of
+ * a BUFR message, reading them from the encoded data without decoding the
+ * whole message.
+ *
+ * This is meant as a cheap prefilter: anything that cannot be read from the
+ * header or from the leading elements of the data section is taken as
+ * possibly matching. MATCH_NO means that no subset of the message can match,
+ * MATCH_YES means that the message needs decoding to know.
+ */
+struct MatchedBufrPrefix : public Matched
+{
+    /// Values read from the leading elements of a subset
+    struct Leading
+    {
+        int block;
+        int station;
+        /// Possible datetimes of the subset, missing if unknown
+        DatetimeRange datetime;
+        /// Coordinates of the subset, missing if unknown
+        Coords coords;
+
+        Leading();
+    };
+
+    /// True if the message header could be decoded
+    bool header_decoded = false;
+    int data_category = -1;
+    int data_subcategory = -1;
+    /// Number of subsets declared in the message
+    unsigned subset_count = 0;
+    /**
+     * Leading values of the subsets that could be read. Subsets past the end
+     * of this vector have not been read.
+     */
+    std::vector<Leading> leading;
+
+    MatchedBufrPrefix(const std::string& data);
+    ~MatchedBufrPrefix();
+
+    matcher::Result match_var_id(int val) const override;
+    matcher::Result match_station_id(int val) const override;
+    matcher::Result match_station_wmo(int block, int station=-1) const override;
+    matcher::Result match_datetime(const DatetimeRange& range) const override;
+    matcher::Result match_coords(const LatRange& latrange, const LonRange& lonrange) const override;
+    matcher::Result match_rep_memo(const char* memo) const override;
+
+protected:
+    void scan(const std::string& data);
+
+    /// Check if the leading values of all subsets have been read
+    bool all_read() const { return !leading.empty() && leading.size() == subset_count; }
+};
+
 }
 #endif
@@ -88,6 +88,34 @@ add_method("by_64", []{
     wassert_true(s.find(33) == s.end());
 });
 
+add_method("erase", []{
+    IntSmallSet s;
+    for (int i = 31; i >= 0; --i)
+        s.add(i);
+
+    wassert_false(s.erase(33));
+    for (int i = 0; i < 32; i += 2)
+        wassert_true(s.erase(i));
+    wassert(actual(s.size()) == 16u);
+
+    for (int i = 0; i < 32; ++i)
+    {
+        auto it = s.find(i);
+        if (i % 2)
+        {
+            wassert_true(it != s.end());
+            wassert(actual(*it) == i);
+        } else
+            wassert_true(it == s.end());
+    }
+
+    // Items added after erasing are still found
+    s.add(4);
+    wassert_true(s.find(4) != s.end());
+    wassert_true(s.erase(4));
+    wassert_true(s.find(4) == s.end());
+});
+
 }
 
 }
@@ -147,6 +147,30 @@ struct SmallSet
         return items.back();
     }
 
+    /**
+     * Remove the item with the given value, if present.
+     *
+     * Returns true if an item was removed.
+     */
+    bool erase(const Value& value)
+    {
+        // Sort all items first, so that the set stays sorted after erasing
+        if (dirty > 16)
+        {
+            std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+                return get_value(a) < get_value(b);
+            });
+            dirty = 0;
+        } else if (dirty)
+            rearrange_dirty();
+
+        auto i = find(value);
+        if (i == end())
+            return false;
+        items.erase(i);
+        return true;
+    }
+
     // static const Value& _smallset_get_value(const Item&);
 
     void rearrange_dirty() const
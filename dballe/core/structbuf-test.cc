@@ -63,6 +63,33 @@ class Tests : public TestCase
             for (unsigned i = 0; i < 8; ++i)
                 wassert(actual(buf[i]) == i + 1);
         });
+
+        // Test appending many items at a time
+        add_method("append_many", []() {
+            Structbuf<char, 4> buf;
+            buf.append("abc", 3);
+            wassert(actual(buf.is_file_backed()).isfalse());
+            buf.append("defghij", 7);
+            wassert(actual(buf.size()) == 10u);
+            wassert(actual(buf.is_file_backed()).istrue());
+
+            buf.ready_to_read();
+            wassert(actual(std::string(&buf[0], 10)) == "abcdefghij");
+        });
+
+        // Test setting the in-memory size at construction
+        add_method("max_membuf", []() {
+            Structbuf<int> buf(100);
+            for (int i = 0; i < 100; ++i)
+                buf.append(i);
+            wassert(actual(buf.is_file_backed()).isfalse());
+            buf.append(100);
+            wassert(actual(buf.is_file_backed()).istrue());
+
+            buf.ready_to_read();
+            for (unsigned i = 0; i < 101; ++i)
+                wassert(actual(buf[i]) == i);
+        });
     }
 } test("core_structbuf");
 
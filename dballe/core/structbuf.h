@@ -23,6 +23,7 @@
 #define DBALLE_CORE_STRUCTBUF_H
 
 #include <wreport/error.h>
+#include <algorithm>
 #include <cstdlib>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -38,8 +39,9 @@ void write_buffer(int fd, void* buf, size_t size);
  * Buffer of simple structures that becomes file backed if it grows beyond a
  * certain size.
  *
- * bufsize is the number of T items that we keep in memory before becoming
- * file-backed.
+ * bufsize is the default number of T items that we keep in memory before
+ * becoming file-backed, and it can be changed at construction time. Memory
+ * is allocated as items are appended.
  */
 template<typename T, int bufsize=1024>
 class Structbuf
@@ -51,8 +53,14 @@ protected:
      */
     T* membuf = nullptr;
 
+    /// Number of items that can be stored in membuf
+    size_t membuf_size = 0;
+
     /// Number of items in membuf
-    unsigned membuf_last = 0;
+    size_t membuf_last = 0;
+
+    /// Maximum number of items to keep in memory
+    size_t max_membuf;
 
     /**
      * Memory area used for reading. It points to membuf if we are
@@ -68,10 +76,12 @@ protected:
     int tmpfile_fd = -1;
 
 public:
-    Structbuf()
-        : membuf(new T[bufsize])
+    explicit Structbuf(size_t max_membuf=bufsize)
+        : max_membuf(std::max(max_membuf, (size_t)1))
     {
     }
+    Structbuf(const Structbuf&) = delete;
+    Structbuf& operator=(const Structbuf&) = delete;
     ~Structbuf()
     {
         delete[] membuf;
@@ -94,12 +104,30 @@ public:
     {
         if (readbuf != MAP_FAILED)
             throw wreport::error_consistency("writing to a Structbuf that is already being read");
-        if (membuf_last == bufsize)
-            write_to_file();
+        if (membuf_last == membuf_size)
+            make_room();
         membuf[membuf_last++] = val;
         ++m_count;
     }
 
+    /// Append count consecutive items to the buffer
+    void append(const T* vals, size_t count)
+    {
+        if (readbuf != MAP_FAILED)
+            throw wreport::error_consistency("writing to a Structbuf that is already being read");
+        while (count)
+        {
+            if (membuf_last == membuf_size)
+                make_room();
+            size_t chunk = std::min(count, membuf_size - membuf_last);
+            std::copy(vals, vals + chunk, membuf + membuf_last);
+            membuf_last += chunk;
+            m_count += chunk;
+            vals += chunk;
+            count -= chunk;
+        }
+    }
+
     /// Stop appending and get ready to read back the data
     void ready_to_read()
     {
@@ -124,6 +152,22 @@ public:
     }
 
 protected:
+    /// Grow membuf if it is smaller than max_membuf, else flush it to file
+    void make_room()
+    {
+        if (membuf_size == max_membuf)
+        {
+            write_to_file();
+            return;
+        }
+        size_t new_size = std::min(std::max(membuf_size * 2, (size_t)64), max_membuf);
+        T* new_membuf = new T[new_size];
+        std::copy(membuf, membuf + membuf_last, new_membuf);
+        delete[] membuf;
+        membuf = new_membuf;
+        membuf_size = new_size;
+    }
+
     void write_to_file()
     {
         if (tmpfile_fd == -1)
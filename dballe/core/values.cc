@@ -60,6 +60,7 @@ void Encoder::append_attributes(const wreport::Var& var)
 }
 
 Decoder::Decoder(const std::vector<uint8_t>& buf) : buf(buf.data()), size(buf.size()) {}
+Decoder::Decoder(const uint8_t* buf, unsigned size) : buf(buf), size(size) {}
 
 uint16_t Decoder::decode_uint16()
 {
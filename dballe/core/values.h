@@ -27,6 +27,7 @@ struct Decoder
     unsigned size;
 
     Decoder(const std::vector<uint8_t>& buf);
+    Decoder(const uint8_t* buf, unsigned size);
     uint16_t decode_uint16();
     uint32_t decode_uint32();
     const char* decode_cstring();
@@ -21,6 +21,7 @@
 
 #include "var.h"
 #include <wreport/vartable.h>
+#include <cstring>
 
 using namespace wreport;
 using namespace std;
@@ -176,4 +177,26 @@ std::unique_ptr<wreport::Var> var_copy_without_unset_attrs(
     return copy;
 }
 
+/// Check if values described by \a a are described in the same way by \a b
+static bool same_varinfo(wreport::Varinfo a, wreport::Varinfo b)
+{
+    if (a == b) return true;
+    return a->code == b->code && a->type == b->type
+        && a->scale == b->scale && a->len == b->len
+        && a->bit_ref == b->bit_ref && a->bit_len == b->bit_len
+        && strcmp(a->unit, b->unit) == 0 && strcmp(a->desc, b->desc) == 0;
+}
+
+std::unique_ptr<wreport::Var> var_move_without_unset_attrs(wreport::Var&& var, wreport::Varcode code)
+{
+    if (!same_varinfo(var.info(), varinfo(code)))
+        return var_copy_without_unset_attrs(var, code);
+
+    for (const Var* a = var.next_attr(); a; a = a->next_attr())
+        if (!a->isset() || !same_varinfo(a->info(), varinfo(map_code_to_dballe(a->code()))))
+            return var_copy_without_unset_attrs(var, code);
+
+    return unique_ptr<Var>(new Var(std::move(var)));
+}
+
 }
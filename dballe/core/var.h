@@ -30,6 +30,15 @@ std::unique_ptr<wreport::Var> var_copy_without_unset_attrs(const wreport::Var& v
  */
 std::unique_ptr<wreport::Var> var_copy_without_unset_attrs(const wreport::Var& var, wreport::Varcode code);
 
+/**
+ * Same as var_copy_without_unset_attrs(var, code), but take the value and
+ * attributes of \a var instead of copying them, when they are all set and
+ * already described as in the local B table.
+ *
+ * \a var is left in an unspecified state.
+ */
+std::unique_ptr<wreport::Var> var_move_without_unset_attrs(wreport::Var&& var, wreport::Varcode code);
+
 /**
  * Format the code to its string representation
  *
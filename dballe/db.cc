@@ -1,5 +1,6 @@
 #include "db.h"
 #include "db/db.h"
+#include "db/remote.h"
 #include "sql/sql.h"
 #include "core/string.h"
 #include "wreport/utils/string.h"
@@ -102,6 +103,12 @@ void Transaction::import_messages(const std::vector<std::shared_ptr<Message>>& m
         import_message(*i, opts);
 }
 
+void Transaction::insert_data_many(const std::vector<Data*>& data, const DBInsertOptions& opts, bool with_ids)
+{
+    for (auto d: data)
+        insert_data(*d, opts);
+}
+
 
 /*
  * DB
@@ -116,6 +123,10 @@ std::shared_ptr<DB> DB::connect(const DBConnectOptions& opts)
     if (opts.url == "mem:")
     {
         return db::DB::connect_memory();
+    } else if (strncmp(opts.url.c_str(), "unix://", 7) == 0) {
+        if (opts.wipe)
+            throw error_unimplemented("wiping the database is not supported through a dballe server");
+        return db::remote::DB::connect(opts.url.substr(7));
     } else {
         auto conn(sql::Connection::create(opts));
         auto res = db::DB::create(conn);
@@ -209,4 +220,11 @@ void DB::insert_data(Data& vals, const DBInsertOptions& opts)
     t->commit();
 }
 
+void DB::insert_data_many(const std::vector<Data*>& data, const DBInsertOptions& opts, bool with_ids)
+{
+    auto t = transaction();
+    t->insert_data_many(data, opts, with_ids);
+    t->commit();
+}
+
 }
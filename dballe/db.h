@@ -290,6 +290,23 @@ public:
      *   Options controlling the insert operation
      */
     virtual void insert_data(Data& data, const DBInsertOptions& opts=DBInsertOptions::defaults) = 0;
+
+    /**
+     * Insert many data values into the database
+     *
+     * This has the same effect as calling insert_data on each element of
+     * data, in order, but values are grouped by station and datetime and
+     * written in bulk.
+     *
+     * @param data
+     *   The values to insert.
+     * @param opts
+     *   Options controlling the insert operation
+     * @param with_ids
+     *   If true, the IDs of the station and all variables that were inserted
+     *   will be stored in each element of data
+     */
+    virtual void insert_data_many(const std::vector<Data*>& data, const DBInsertOptions& opts=DBInsertOptions::defaults, bool with_ids=true);
 };
 
 
@@ -439,6 +456,19 @@ public:
      *   Options controlling the insert operation
      */
     void insert_data(Data& vals, const DBInsertOptions& opts=DBInsertOptions::defaults);
+
+    /**
+     * Insert many data values into the database
+     *
+     * @param data
+     *   The values to insert.
+     * @param opts
+     *   Options controlling the insert operation
+     * @param with_ids
+     *   If true, the IDs of the station and all variables that were inserted
+     *   will be stored in each element of data
+     */
+    void insert_data_many(const std::vector<Data*>& data, const DBInsertOptions& opts=DBInsertOptions::defaults, bool with_ids=true);
 };
 
 }
@@ -319,6 +319,48 @@ this->add_method("update_with_ana_id", [](Fixture& f) {
     wassert(actual(var.enqd()) == 296.2);
 });
 
+this->add_method("insert_data_many", [](Fixture& f) {
+    // Interleave records of two stations
+    std::vector<core::Data> records(6);
+    for (unsigned i = 0; i < records.size(); ++i)
+    {
+        core::Data& vals = records[i];
+        vals.station.report = "synop";
+        vals.station.coords = Coords(i % 2 ? 45.0 : 44.0, 11.0);
+        vals.level = Level(1);
+        vals.trange = Trange::instant();
+        vals.datetime = Datetime(2015, 4, 25, i / 2);
+        vals.values.set("B12101", 290.0 + i);
+    }
+    // The same value, given again, replaces the previous one
+    records[4].values.set("B12101", 310.0);
+    records[4].datetime = records[0].datetime;
+
+    std::vector<dballe::Data*> data;
+    for (auto& r: records)
+        data.push_back(&r);
+    impl::DBInsertOptions opts;
+    opts.can_replace = true;
+    wassert(f.tr->insert_data_many(data, opts));
+
+    wassert(actual(records[0].station.id) != MISSING_INT);
+    wassert(actual(records[1].station.id) != records[0].station.id);
+    wassert(actual(records[2].station.id) == records[0].station.id);
+    wassert(actual(records[0].values.value("B12101").data_id) != MISSING_INT);
+    wassert(actual(records[4].values.value("B12101").data_id) == records[0].values.value("B12101").data_id);
+
+    core::Query query;
+    auto cur = f.tr->query_data(query);
+    wassert(actual(cur->remaining()) == 5u);
+
+    query.ana_id = records[0].station.id;
+    query.datetime = DatetimeRange(records[0].datetime, records[0].datetime);
+    cur = f.tr->query_data(query);
+    wassert(actual(cur->remaining()) == 1u);
+    wassert(cur->next());
+    wassert(actual(cur->get_var().enqd()) == 310.0);
+});
+
 this->add_method("discriminate_ana_id", [](Fixture& f) {
     // Generate two station IDs
     core::Data vals1;
@@ -545,6 +587,40 @@ this->add_method("vacuum", [](Fixture& f) {
     }
 });
 
+this->add_method("remove_data_before", [](Fixture& f) {
+    auto& db = *f.db;
+    core::Data vals;
+    vals.station.report = "synop";
+    vals.station.coords = Coords(44.5, 11.3);
+    vals.values.set("B01019", "Station 1");
+    wassert(db.insert_station_data(vals));
+
+    vals.values.clear();
+    vals.level = Level(1);
+    vals.trange = Trange::instant();
+    vals.values.set("B12101", 280.0);
+    for (int year: { 2016, 2017, 2018 })
+        for (int month: { 1, 6, 12 })
+        {
+            vals.datetime = Datetime(year, month, 15, 12);
+            wassert(db.insert_data(vals));
+        }
+
+    wassert(db.remove_data_before(Datetime(2017, 6, 1)));
+
+    core::Query q;
+    auto c = db.query_data(q);
+    wassert(actual(c->remaining()) == 5);
+    q.datetime = DatetimeRange(Datetime(), Datetime(2017, 6, 1));
+    c = db.query_data(q);
+    wassert(actual(c->remaining()) == 0);
+
+    // Station data is kept
+    core::Query sq;
+    auto sd = db.query_station_data(sq);
+    wassert(actual(sd->remaining()) == 1);
+});
+
 // Test simple queries
 this->add_method("wipe", [](Fixture& f) {
     // We are connected to an empty database
@@ -1,6 +1,7 @@
 #include "dballe/db/tests.h"
 #include "v7/db.h"
 #include "v7/transaction.h"
+#include "v7/cursor.h"
 #include "config.h"
 #include <algorithm>
 #include <cstring>
@@ -632,6 +633,77 @@ this->add_method("longitude_wrap", [](Fixture& f) {
     wassert(actual(cur->remaining()) == 2);
     cur->discard();
 });
+this->add_method("area_precision", [](Fixture& f) {
+    // Stations one unit apart at the edge of the coordinate range, where a
+    // spatial index with reduced precision would not tell them apart
+    impl::DBInsertOptions opts;
+    opts.can_replace = opts.can_add_stations = true;
+    for (double lon: { 179.99997, 179.99998, 179.99999 })
+    {
+        core::Data vals;
+        vals.station.report = "synop";
+        vals.station.coords = Coords(89.99998, lon);
+        vals.level = Level(1);
+        vals.trange = Trange::instant();
+        vals.datetime = Datetime(2015, 4, 25, 12);
+        vals.values.set("B12101", 280.0);
+        wassert(f.tr->insert_data(vals, opts));
+    }
+
+    auto cur = f.tr->query_stations(*query_from_string("latmin=89.99998, latmax=89.99998, lonmin=179.99998, lonmax=179.99998"));
+    wassert(actual(cur->remaining()) == 1);
+    cur->discard();
+
+    cur = f.tr->query_stations(*query_from_string("latmin=89.9, lonmin=179.99998, lonmax=179.99999"));
+    wassert(actual(cur->remaining()) == 2);
+    cur->discard();
+
+    cur = f.tr->query_stations(*query_from_string("latmin=89.99999, lonmin=179.99997, lonmax=179.99999"));
+    wassert(actual(cur->remaining()) == 0);
+    cur->discard();
+});
+this->add_method("query_file_backed", [](Fixture& f) {
+    // Query enough values to make the cursor buffer file-backed
+    std::vector<core::Data> records(3000);
+    std::vector<dballe::Data*> data;
+    for (unsigned i = 0; i < records.size(); ++i)
+    {
+        core::Data& vals = records[i];
+        vals.station.report = "synop";
+        vals.station.coords = Coords(44.5 + (i % 3), 11.3);
+        vals.level = Level(1);
+        vals.trange = Trange::instant();
+        vals.datetime = Datetime::from_julian(2458000 + i / 24, i % 24);
+        vals.values.set("B12101", 250.0 + (i % 100));
+        vals.values.set("B01019", "test string");
+        data.push_back(&vals);
+    }
+    wassert(f.tr->insert_data_many(data));
+
+    // With the default settings, results are kept in memory
+    auto cur = v7::cursor::Data::downcast(f.tr->query_data(core::Query()));
+    wassert(actual(cur->remaining()) == 6000);
+    wassert_false(cur->results.is_file_backed());
+    cur->discard();
+
+    f.db->cursor_memory = 16384;
+    cur = v7::cursor::Data::downcast(f.tr->query_data(core::Query()));
+    f.db->cursor_memory = 64 * 1024 * 1024;
+    wassert(actual(cur->remaining()) == 6000);
+    wassert_true(cur->results.is_file_backed());
+
+    unsigned count = 0;
+    while (cur->next())
+    {
+        if (cur->get_varcode() == WR_VAR(0, 12, 101))
+            wassert(actual(cur->get_var().enqd()) >= 250.0);
+        else
+            wassert(actual(cur->get_var().enqs()) == "test string");
+        wassert(actual(cur->get_station().coords.lon) == 1130000);
+        ++count;
+    }
+    wassert(actual(count) == 6000u);
+});
 this->add_method("query_ana_filter", [](Fixture& f) {
     // Test numeric comparisons in ana_filter
     OldDballeTestDataSet oldf;
@@ -1040,6 +1112,86 @@ this->add_method("fd_leaks", [](Fixture& f) {
     }
 });
 
+this->add_method("query_cache", [](Fixture& f) {
+    f.db->query_cache.reset(new v7::cursor::QueryCache(16));
+    impl::DBInsertOptions opts;
+    opts.can_add_stations = true;
+
+    auto insert = [&](double lat) {
+        core::Data vals;
+        vals.station.report = "synop";
+        vals.station.coords = Coords(lat, 11.0);
+        vals.level = Level(1);
+        vals.trange = Trange::instant();
+        vals.datetime = Datetime(2015, 4, 25, 12);
+        vals.values.set("B12101", 280.0);
+        auto tr = f.db->transaction();
+        tr->insert_data(vals, opts);
+        tr->commit();
+    };
+
+    wassert(insert(44.0));
+    std::string generation = f.db->driver().write_generation();
+    wassert(actual(generation) != "");
+
+    // Identical queries share their results
+    {
+        auto tr = f.db->transaction();
+        auto cur1 = v7::cursor::Summary::downcast(tr->query_summary(core::Query()));
+        auto cur2 = v7::cursor::Summary::downcast(tr->query_summary(core::Query()));
+        wassert(actual(cur1->results.shared() == cur2->results.shared()).istrue());
+        wassert(actual(cur2->remaining()) == 1);
+        wassert(actual(cur2->next()).istrue());
+        wassert(actual(cur2->get_varcode()) == WR_VAR(0, 12, 101));
+        wassert(actual(cur2->get_level()) == Level(1));
+        wassert(actual(cur1->remaining()) == 1);
+
+        auto st1 = v7::cursor::Stations::downcast(tr->query_stations(core::Query()));
+        auto st2 = v7::cursor::Stations::downcast(tr->query_stations(core::Query()));
+        wassert(actual(st1->results.shared() == st2->results.shared()).istrue());
+        tr->rollback();
+    }
+
+    // Transactions with uncommitted changes do not use the cache
+    {
+        auto tr = dynamic_pointer_cast<v7::Transaction>(f.db->transaction());
+        core::Data vals;
+        vals.station.report = "synop";
+        vals.station.coords = Coords(45.0, 11.0);
+        vals.values.set("B07030", 78);
+        tr->insert_station_data(vals, opts);
+        wassert(actual(tr->query_stations(core::Query())->remaining()) == 2);
+        tr->rollback();
+    }
+    wassert(actual(f.db->driver().write_generation()) == generation);
+
+    // Committed changes invalidate the cache
+    wassert(insert(46.0));
+    wassert(actual(f.db->driver().write_generation()) != generation);
+    {
+        auto tr = f.db->transaction();
+        wassert(actual(tr->query_stations(core::Query())->remaining()) == 2);
+        wassert(actual(tr->query_summary(core::Query())->remaining()) == 2);
+        tr->rollback();
+    }
+
+    // Data retention also changes the generation
+    generation = f.db->driver().write_generation();
+    wassert(f.db->remove_data_before(Datetime(2000, 1, 1)));
+    wassert(actual(f.db->driver().write_generation()) != generation);
+
+    // Resetting the database never takes the generation back
+    generation = f.db->driver().write_generation();
+    wassert(f.db->reset());
+    std::string after_reset = f.db->driver().write_generation();
+    wassert(actual(std::stoull(after_reset) > std::stoull(generation)).istrue());
+    wassert(f.db->disappear());
+    wassert(f.db->reset());
+    wassert(actual(std::stoull(f.db->driver().write_generation()) > std::stoull(after_reset)).istrue());
+
+    f.db->query_cache.reset();
+});
+
 }
 
 }
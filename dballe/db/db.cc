@@ -72,6 +72,7 @@ bool DB::is_url(const char* str)
     if (strncmp(str, "postgresql:", 11) == 0) return true;
     if (strncmp(str, "mysql:", 6) == 0) return true;
     if (strncmp(str, "test:", 5) == 0) return true;
+    if (strncmp(str, "unix:", 5) == 0) return true;
     return false;
 }
 
@@ -243,6 +243,18 @@ public:
      */
     virtual void update_repinfo(const char* repinfo_file, int* added, int* deleted, int* updated) = 0;
 
+    /**
+     * Record in \a delta a summary of the data added and removed by this
+     * transaction, that can be merged into an Explorer with
+     * Explorer::Update::add_delta instead of summarising the whole database
+     * again.
+     *
+     * Changes are added to \a delta when the transaction is committed, and
+     * are discarded if it is rolled back. Pass nullptr to stop recording
+     * changes.
+     */
+    virtual void set_summary_delta(std::shared_ptr<summary::Delta> delta) = 0;
+
     /**
      * Dump the entire contents of the database to an output stream
      */
@@ -324,6 +336,17 @@ public:
      */
     virtual void vacuum() = 0;
 
+    /**
+     * Delete all data (but not station data) with datetime before the given
+     * one.
+     *
+     * If the database is partitioned by time, whole partitions are dropped
+     * when possible, which is much faster than deleting their rows.
+     *
+     * Stations and levels left without data are removed by vacuum().
+     */
+    virtual void remove_data_before(const Datetime& before) = 0;
+
     /**
      * Query attributes on a station value
      *
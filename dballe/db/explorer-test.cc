@@ -4,6 +4,7 @@
 #include "dballe/db/v7/transaction.h"
 #include "wreport/utils/sys.h"
 #include "explorer.h"
+#include "summary_memory.h"
 #include "config.h"
 
 using namespace dballe;
@@ -103,6 +104,22 @@ void test_explorer_contents(const BaseExplorer<Station>& explorer)
     wassert(actual(vars[1]) == WR_VAR(0, 1, 12));
 }
 
+template<typename Station>
+vector<Station> global_stations(const BaseExplorer<Station>& explorer)
+{
+    vector<Station> res;
+    explorer.global_summary().stations([&](const Station& s) { res.push_back(s); return true; });
+    return res;
+}
+
+template<typename Station>
+vector<Varcode> global_varcodes(const BaseExplorer<Station>& explorer)
+{
+    vector<Varcode> res;
+    explorer.global_summary().varcodes([&](const Varcode& v) { res.push_back(v); return true; });
+    return res;
+}
+
 template<typename DB, typename EXPLORER>
 void Tests<DB, EXPLORER>::register_tests()
 {
@@ -184,6 +201,54 @@ this->add_method("merge", [](Fixture& f) {
     wassert(actual(explorer1.active_summary().data_count()) == 4u);
 });
 
+this->add_method("delta", [](Fixture& f) {
+    OldDballeTestDataSet test_data;
+    wassert(f.populate(test_data));
+
+    EXPLORER explorer;
+    {
+        auto update = explorer.rebuild();
+        wassert(update.add_db(*f.tr));
+    }
+
+    // Record changes made to the database
+    auto delta = make_shared<summary::Delta>();
+    f.tr->set_summary_delta(delta);
+
+    auto msgs = read_msgs("bufr/obs0-1.22.bufr", Encoding::BUFR);
+    f.tr->import_messages(msgs, DBImportOptions::defaults);
+
+    core::Query query;
+    query.report = "metar";
+    f.tr->remove_data(query);
+
+    // Changes are only added to delta on commit
+    wassert_true(delta->empty());
+    summary::Delta* pending = f.tr->pending_summary_delta();
+    wassert_false(pending->empty());
+
+    {
+        auto update = explorer.update();
+        wassert(update.add_delta(*pending));
+    }
+
+    // The result is the same as summarising the database again
+    EXPLORER expected;
+    {
+        auto update = expected.rebuild();
+        wassert(update.add_db(*f.tr));
+    }
+
+    wassert_true(global_stations(explorer) == global_stations(expected));
+    wassert_true(global_varcodes(explorer) == global_varcodes(expected));
+    wassert(actual(explorer.global_summary().data_count()) == expected.global_summary().data_count());
+    wassert(actual(explorer.global_summary().datetime_min()) == expected.global_summary().datetime_min());
+    wassert(actual(explorer.global_summary().datetime_max()) == expected.global_summary().datetime_max());
+
+    f.tr->set_summary_delta(nullptr);
+    wassert_true(f.tr->pending_summary_delta() == nullptr);
+});
+
 this->add_method("merge_self", [](Fixture& f) {
     EXPLORER explorer;
     {
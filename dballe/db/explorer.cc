@@ -187,6 +187,12 @@ void BaseExplorer<Station>::Update::add_cursor(dballe::CursorSummary& cur)
         explorer->_global_summary->add_cursor(cur);
 }
 
+template<typename Station>
+void BaseExplorer<Station>::Update::add_delta(const summary::Delta& delta)
+{
+    explorer->_global_summary->add_delta(delta);
+}
+
 template<typename Station>
 void BaseExplorer<Station>::Update::add_json(core::json::Stream& in)
 {
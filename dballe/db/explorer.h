@@ -53,6 +53,12 @@ public:
         /// Merge summary data from a database
         void add_cursor(dballe::CursorSummary& cur);
 
+        /**
+         * Merge the changes made to a database, as recorded by
+         * db::Transaction::set_summary_delta
+         */
+        void add_delta(const summary::Delta& delta);
+
         /// Load the explorer contents from JSON
         void add_json(core::json::Stream& in);
 
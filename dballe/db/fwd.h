@@ -9,6 +9,10 @@ class CursorData;
 class CursorSummary;
 class DB;
 class Transaction;
+
+namespace summary {
+struct Delta;
+}
 }
 }
 
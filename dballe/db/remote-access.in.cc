@@ -0,0 +1,167 @@
+#include "dballe/db/remote.h"
+#include <cstring>
+
+using namespace wreport;
+
+namespace dballe {
+namespace db {
+namespace remote {
+namespace cursor {
+
+/*
+ * Stations
+ */
+
+void Stations::enq(impl::Enq& enq) const
+{
+    if (enq.search_b_values(values)) return;
+
+    const auto key = enq.key;
+    const auto len = enq.len;
+
+    switch (key) { // mklookup
+        case "priority":    enq.set_dballe_int(priority);
+        case "rep_memo":    enq.set_string(station.report);
+        case "report":      enq.set_string(station.report);
+        case "ana_id":      enq.set_dballe_int(station.id);
+        case "mobile":      enq.set_bool(!station.ident.is_missing());
+        case "ident":       enq.set_ident(station.ident);
+        case "lat":         enq.set_lat(station.coords.lat);
+        case "lon":         enq.set_lon(station.coords.lon);
+        case "coords":      enq.set_coords(station.coords);
+        case "station":     enq.set_station(station);
+        default:            enq.search_alias_values(values);
+    }
+}
+
+
+/*
+ * StationData
+ */
+
+void StationData::enq(impl::Enq& enq) const
+{
+    if (enq.search_b_value(value)) return;
+
+    const auto key = enq.key;
+    const auto len = enq.len;
+
+    switch (key) { // mklookup
+        case "priority":    enq.set_dballe_int(priority);
+        case "rep_memo":    enq.set_string(station.report);
+        case "report":      enq.set_string(station.report);
+        case "ana_id":      enq.set_dballe_int(station.id);
+        case "mobile":      enq.set_bool(!station.ident.is_missing());
+        case "ident":       enq.set_ident(station.ident);
+        case "lat":         enq.set_lat(station.coords.lat);
+        case "lon":         enq.set_lon(station.coords.lon);
+        case "coords":      enq.set_coords(station.coords);
+        case "station":     enq.set_station(station);
+        case "var":         enq.set_varcode(value.code());
+        case "variable":    enq.set_var(value.get());
+        case "attrs":       enq.set_attrs(value.get());
+        case "context_id":  enq.set_dballe_int(value.data_id);
+        default:            enq.search_alias_value(value);
+    }
+}
+
+/*
+ * Data
+ */
+
+void Data::enq(impl::Enq& enq) const
+{
+    if (enq.search_b_value(value)) return;
+
+    const auto key = enq.key;
+    const auto len = enq.len;
+
+    switch (key) { // mklookup
+        case "priority":    enq.set_dballe_int(priority);
+        case "rep_memo":    enq.set_string(station.report);
+        case "report":      enq.set_string(station.report);
+        case "ana_id":      enq.set_dballe_int(station.id);
+        case "mobile":      enq.set_bool(!station.ident.is_missing());
+        case "ident":       enq.set_ident(station.ident);
+        case "lat":         enq.set_lat(station.coords.lat);
+        case "lon":         enq.set_lon(station.coords.lon);
+        case "coords":      enq.set_coords(station.coords);
+        case "station":     enq.set_station(station);
+        case "datetime":    enq.set_datetime(datetime);
+        case "year":        enq.set_int(datetime.year);
+        case "month":       enq.set_int(datetime.month);
+        case "day":         enq.set_int(datetime.day);
+        case "hour":        enq.set_int(datetime.hour);
+        case "min":         enq.set_int(datetime.minute);
+        case "sec":         enq.set_int(datetime.second);
+        case "level":       enq.set_level(level);
+        case "leveltype1":  enq.set_dballe_int(level.ltype1);
+        case "l1":          enq.set_dballe_int(level.l1);
+        case "leveltype2":  enq.set_dballe_int(level.ltype2);
+        case "l2":          enq.set_dballe_int(level.l2);
+        case "trange":      enq.set_trange(trange);
+        case "pindicator":  enq.set_dballe_int(trange.pind);
+        case "p1":          enq.set_dballe_int(trange.p1);
+        case "p2":          enq.set_dballe_int(trange.p2);
+        case "var":         enq.set_varcode(value.code());
+        case "variable":    enq.set_var(value.get());
+        case "attrs":       enq.set_attrs(value.get());
+        case "context_id":  enq.set_dballe_int(value.data_id);
+        default:            enq.search_alias_value(value);
+    }
+}
+
+/*
+ * Summary
+ */
+
+void Summary::enq(impl::Enq& enq) const
+{
+    const auto key = enq.key;
+    const auto len = enq.len;
+
+    switch (key) { // mklookup
+        case "priority":    enq.set_dballe_int(priority);
+        case "rep_memo":    enq.set_string(station.report);
+        case "report":      enq.set_string(station.report);
+        case "ana_id":      enq.set_dballe_int(station.id);
+        case "mobile":      enq.set_bool(!station.ident.is_missing());
+        case "ident":       enq.set_ident(station.ident);
+        case "lat":         enq.set_lat(station.coords.lat);
+        case "lon":         enq.set_lon(station.coords.lon);
+        case "coords":      enq.set_coords(station.coords);
+        case "station":     enq.set_station(station);
+        case "datetimemax": if (dtrange.is_missing()) return; else enq.set_datetime(dtrange.max);
+        case "datetimemin": if (dtrange.is_missing()) return; else enq.set_datetime(dtrange.min);
+        case "yearmax":     if (dtrange.is_missing()) return; else enq.set_int(dtrange.max.year);
+        case "yearmin":     if (dtrange.is_missing()) return; else enq.set_int(dtrange.min.year);
+        case "monthmax":    if (dtrange.is_missing()) return; else enq.set_int(dtrange.max.month);
+        case "monthmin":    if (dtrange.is_missing()) return; else enq.set_int(dtrange.min.month);
+        case "daymax":      if (dtrange.is_missing()) return; else enq.set_int(dtrange.max.day);
+        case "daymin":      if (dtrange.is_missing()) return; else enq.set_int(dtrange.min.day);
+        case "hourmax":     if (dtrange.is_missing()) return; else enq.set_int(dtrange.max.hour);
+        case "hourmin":     if (dtrange.is_missing()) return; else enq.set_int(dtrange.min.hour);
+        case "minumax":     if (dtrange.is_missing()) return; else enq.set_int(dtrange.max.minute);
+        case "minumin":     if (dtrange.is_missing()) return; else enq.set_int(dtrange.min.minute);
+        case "secmax":      if (dtrange.is_missing()) return; else enq.set_int(dtrange.max.second);
+        case "secmin":      if (dtrange.is_missing()) return; else enq.set_int(dtrange.min.second);
+        case "level":       enq.set_level(level);
+        case "leveltype1":  enq.set_dballe_int(level.ltype1);
+        case "l1":          enq.set_dballe_int(level.l1);
+        case "leveltype2":  enq.set_dballe_int(level.ltype2);
+        case "l2":          enq.set_dballe_int(level.l2);
+        case "trange":      enq.set_trange(trange);
+        case "pindicator":  enq.set_dballe_int(trange.pind);
+        case "p1":          enq.set_dballe_int(trange.p1);
+        case "p2":          enq.set_dballe_int(trange.p2);
+        case "var":         enq.set_varcode(code);
+        case "context_id":  enq.set_int(entry_count);
+        case "count":       enq.set_int(entry_count);
+        default:            wreport::error_notfound::throwf("key %s not found on this query result", key);
+    }
+}
+
+}
+}
+}
+}
@@ -0,0 +1,720 @@
+#include "remote.h"
+#include "dballe/msg/msg.h"
+#include "dballe/core/json.h"
+#include "dballe/var.h"
+#include <wreport/error.h>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace wreport;
+
+namespace dballe {
+namespace db {
+namespace remote {
+
+/*
+ * Encoder
+ */
+
+void Encoder::start(uint8_t type)
+{
+    frame_start = buf.size();
+    append_uint32(0);
+    buf.push_back(type);
+}
+
+void Encoder::finish()
+{
+    size_t size = buf.size() - frame_start - 4;
+    if (size > max_frame_size)
+        error_consistency::throwf("cannot send a frame of %zu bytes, larger than the maximum of %zu bytes", size, max_frame_size);
+    uint32_t encoded = htonl(size);
+    memcpy(buf.data() + frame_start, &encoded, 4);
+}
+
+void Encoder::append_uint8(uint8_t val)
+{
+    buf.push_back(val);
+}
+
+void Encoder::append_int(int val)
+{
+    append_uint32((uint32_t)val);
+}
+
+void Encoder::append_string(const std::string& val)
+{
+    append_uint32(val.size());
+    buf.insert(buf.end(), val.begin(), val.end());
+}
+
+void Encoder::append_station(const DBStation& station, int priority)
+{
+    append_int(station.id);
+    append_string(station.report);
+    append_int(station.coords.lat);
+    append_int(station.coords.lon);
+    if (station.ident.is_missing())
+        append_uint8(0);
+    else
+    {
+        append_uint8(1);
+        append_cstring(station.ident.get());
+    }
+    append_int(priority);
+}
+
+void Encoder::append_datetime(const Datetime& dt)
+{
+    append_uint16(dt.year);
+    append_uint8(dt.month);
+    append_uint8(dt.day);
+    append_uint8(dt.hour);
+    append_uint8(dt.minute);
+    append_uint8(dt.second);
+}
+
+void Encoder::append_level(const Level& level)
+{
+    append_int(level.ltype1);
+    append_int(level.l1);
+    append_int(level.ltype2);
+    append_int(level.l2);
+}
+
+void Encoder::append_trange(const Trange& trange)
+{
+    append_int(trange.pind);
+    append_int(trange.p1);
+    append_int(trange.p2);
+}
+
+void Encoder::append_var(const wreport::Var& var)
+{
+    append_uint16(var.code());
+    if (!var.isset())
+        append_uint8(0);
+    else
+    {
+        append_uint8(1);
+        switch (var.info()->type)
+        {
+            case Vartype::Binary:
+            case Vartype::String:
+                append_cstring(var.enqc());
+                break;
+            case Vartype::Integer:
+            case Vartype::Decimal:
+                append_uint32(var.enqi());
+                break;
+        }
+    }
+
+    unsigned count = 0;
+    for (const Var* a = var.next_attr(); a; a = a->next_attr())
+        ++count;
+    append_uint16(count);
+    for (const Var* a = var.next_attr(); a; a = a->next_attr())
+        append_var(*a);
+}
+
+void Encoder::append_query(const Query& query)
+{
+    const core::Query& q = core::Query::downcast(query);
+    append_uint32(q.want_missing);
+    std::stringstream json;
+    core::JSONWriter writer(json);
+    writer.start_mapping();
+    q.serialize(writer);
+    writer.end_mapping();
+    append_string(json.str());
+}
+
+void Encoder::append_message(const Message& message)
+{
+    const impl::Message& msg = impl::Message::downcast(message);
+    append_uint8((uint8_t)msg.type);
+    append_uint32(msg.station_data.size());
+    for (const auto& val: msg.station_data)
+        append_var(*val);
+    append_uint32(msg.data.size());
+    for (const auto& ctx: msg.data)
+    {
+        append_level(ctx.level);
+        append_trange(ctx.trange);
+        append_uint32(ctx.values.size());
+        for (const auto& val: ctx.values)
+            append_var(*val);
+    }
+}
+
+void Encoder::append_import_options(const DBImportOptions& opts)
+{
+    append_string(opts.report);
+    append_uint8(opts.import_attributes);
+    append_uint8(opts.update_station);
+    append_uint8(opts.overwrite);
+    append_uint32(opts.varlist.size());
+    for (const auto& code: opts.varlist)
+        append_uint16(code);
+}
+
+
+/*
+ * Decoder
+ */
+
+uint8_t Decoder::decode_uint8()
+{
+    if (size < 1) error_toolong::throwf("cannot decode an 8 bit integer: the buffer is empty");
+    uint8_t res = *buf;
+    ++buf;
+    --size;
+    return res;
+}
+
+int Decoder::decode_int()
+{
+    return (int)decode_uint32();
+}
+
+std::string Decoder::decode_string()
+{
+    uint32_t len = decode_uint32();
+    if (size < len) error_toolong::throwf("cannot decode a string of %u bytes: only %u bytes are left to read", (unsigned)len, size);
+    std::string res((const char*)buf, len);
+    buf += len;
+    size -= len;
+    return res;
+}
+
+DBStation Decoder::decode_station(int& priority)
+{
+    DBStation res;
+    res.id = decode_int();
+    res.report = decode_string();
+    res.coords.lat = decode_int();
+    res.coords.lon = decode_int();
+    if (decode_uint8())
+        res.ident = decode_cstring();
+    priority = decode_int();
+    return res;
+}
+
+Datetime Decoder::decode_datetime()
+{
+    Datetime res;
+    res.year = decode_uint16();
+    res.month = decode_uint8();
+    res.day = decode_uint8();
+    res.hour = decode_uint8();
+    res.minute = decode_uint8();
+    res.second = decode_uint8();
+    return res;
+}
+
+Level Decoder::decode_level()
+{
+    Level res;
+    res.ltype1 = decode_int();
+    res.l1 = decode_int();
+    res.ltype2 = decode_int();
+    res.l2 = decode_int();
+    return res;
+}
+
+Trange Decoder::decode_trange()
+{
+    Trange res;
+    res.pind = decode_int();
+    res.p1 = decode_int();
+    res.p2 = decode_int();
+    return res;
+}
+
+std::unique_ptr<wreport::Var> Decoder::decode_var()
+{
+    std::unique_ptr<wreport::Var> res(new wreport::Var(varinfo(decode_uint16())));
+    if (decode_uint8())
+    {
+        switch (res->info()->type)
+        {
+            case Vartype::Binary:
+            case Vartype::String:
+                res->setc(decode_cstring());
+                break;
+            case Vartype::Integer:
+            case Vartype::Decimal:
+                res->seti((int)decode_uint32());
+                break;
+        }
+    }
+
+    unsigned count = decode_uint16();
+    for (unsigned i = 0; i < count; ++i)
+        res->seta(decode_var());
+    return res;
+}
+
+core::Query Decoder::decode_query()
+{
+    uint32_t want_missing = decode_uint32();
+    std::string json = decode_string();
+    core::json::Stream in(json);
+    core::Query res = core::Query::from_json(in);
+    res.want_missing = want_missing;
+    return res;
+}
+
+std::shared_ptr<Message> Decoder::decode_message()
+{
+    auto res = std::make_shared<impl::Message>();
+    res->type = (MessageType)decode_uint8();
+    unsigned count = decode_uint32();
+    for (unsigned i = 0; i < count; ++i)
+        res->station_data.set(decode_var());
+    unsigned ctx_count = decode_uint32();
+    for (unsigned i = 0; i < ctx_count; ++i)
+    {
+        Level level = decode_level();
+        Trange trange = decode_trange();
+        msg::Context& ctx = res->obtain_context(level, trange);
+        count = decode_uint32();
+        for (unsigned j = 0; j < count; ++j)
+            ctx.values.set(decode_var());
+    }
+    return res;
+}
+
+std::unique_ptr<DBImportOptions> Decoder::decode_import_options()
+{
+    auto res = DBImportOptions::create();
+    res->report = decode_string();
+    res->import_attributes = decode_uint8();
+    res->update_station = decode_uint8();
+    res->overwrite = decode_uint8();
+    unsigned count = decode_uint32();
+    for (unsigned i = 0; i < count; ++i)
+        res->varlist.push_back(decode_uint16());
+    return res;
+}
+
+void Decoder::throw_error()
+{
+    ErrorCode code = (ErrorCode)decode_uint8();
+    std::string msg = decode_string();
+    switch (code)
+    {
+        case WR_ERR_NOTFOUND: throw error_notfound(msg);
+        case WR_ERR_TYPE: throw error_type(msg);
+        case WR_ERR_UNIMPLEMENTED: throw error_unimplemented(msg);
+        default: throw error_consistency(msg);
+    }
+}
+
+
+/*
+ * Connection
+ */
+
+Connection::Connection(int sock)
+    : sock(sock)
+{
+}
+
+Connection::Connection(const std::string& path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        error_consistency::throwf("socket pathname %s is too long", path.c_str());
+    memcpy(addr.sun_path, path.data(), path.size());
+
+    sock = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock == -1)
+        throw error_system("cannot create a Unix socket");
+    if (::connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+    {
+        int e = errno;
+        ::close(sock);
+        sock = -1;
+        throw error_system("cannot connect to " + path, e);
+    }
+}
+
+Connection::~Connection()
+{
+    if (sock != -1)
+        ::close(sock);
+}
+
+void Connection::send(const Encoder& enc)
+{
+    const uint8_t* data = enc.buf.data();
+    size_t size = enc.buf.size();
+    while (size)
+    {
+        ssize_t res = ::send(sock, data, size, MSG_NOSIGNAL);
+        if (res == -1)
+        {
+            if (errno == EINTR) continue;
+            throw error_system("cannot write to socket");
+        }
+        data += res;
+        size -= res;
+    }
+}
+
+bool Connection::fill(size_t size)
+{
+    if (pos == buf.size())
+    {
+        buf.clear();
+        pos = 0;
+    } else if (pos > 65536) {
+        buf.erase(buf.begin(), buf.begin() + pos);
+        pos = 0;
+    }
+
+    while (buf.size() - pos < size)
+    {
+        size_t old_size = buf.size();
+        // Grow the buffer as data arrives, rather than trusting the frame
+        // length sent by the peer
+        size_t chunk = std::min(std::max(size - (old_size - pos), (size_t)65536), (size_t)(1024 * 1024));
+        buf.resize(old_size + chunk);
+        ssize_t res = ::recv(sock, buf.data() + old_size, chunk, 0);
+        if (res == -1)
+        {
+            buf.resize(old_size);
+            if (errno == EINTR) continue;
+            throw error_system("cannot read from socket");
+        }
+        buf.resize(old_size + res);
+        if (res == 0)
+            return false;
+    }
+    return true;
+}
+
+bool Connection::read(uint8_t& type, Decoder& payload)
+{
+    if (!fill(4))
+    {
+        if (pos == buf.size())
+            return false;
+        throw error_consistency("connection closed in the middle of a frame");
+    }
+
+    uint32_t len;
+    memcpy(&len, buf.data() + pos, 4);
+    len = ntohl(len);
+    if (len == 0)
+        throw error_consistency("received a frame with no type");
+    if (len > max_frame_size)
+        error_consistency::throwf("received a frame of %u bytes, larger than the maximum of %zu bytes", (unsigned)len, max_frame_size);
+    if (!fill(4 + len))
+        throw error_consistency("connection closed in the middle of a frame");
+
+    type = buf[pos + 4];
+    payload = Decoder(buf.data() + pos + 5, len - 1);
+    pos += 4 + len;
+    return true;
+}
+
+uint8_t Connection::read(Decoder& payload)
+{
+    uint8_t type;
+    if (!read(type, payload))
+        throw error_consistency("the server closed the connection before sending a reply");
+    return type;
+}
+
+
+/*
+ * Cursors
+ */
+
+namespace cursor {
+
+template<typename Interface>
+Base<Interface>::Base(std::unique_ptr<Connection> conn)
+    : conn(std::move(conn))
+{
+    Decoder dec(nullptr, 0);
+    switch ((Reply)this->conn->read(dec))
+    {
+        case Reply::COUNT: count = dec.decode_int(); break;
+        case Reply::ERROR: dec.throw_error();
+        default: throw error_consistency("unexpected reply from the server");
+    }
+}
+
+template<typename Interface>
+bool Base<Interface>::next()
+{
+    valid = false;
+    if (!conn)
+        return false;
+
+    Decoder dec(nullptr, 0);
+    while (true)
+    {
+        switch ((Reply)conn->read(dec))
+        {
+            case Reply::STATION:
+                station = dec.decode_station(priority);
+                break;
+            case Reply::ROW:
+                decode_row(dec);
+                ++fetched;
+                valid = true;
+                return true;
+            case Reply::END:
+                conn.reset();
+                return false;
+            case Reply::ERROR:
+            {
+                // Close the connection after the error has been decoded
+                std::unique_ptr<Connection> closing(std::move(conn));
+                dec.throw_error();
+            }
+            default:
+                throw error_consistency("unexpected reply from the server");
+        }
+    }
+}
+
+template<typename Interface>
+void Base<Interface>::discard()
+{
+    // Closing the connection tells the server to stop sending results
+    conn.reset();
+    valid = false;
+    fetched = count;
+}
+
+template class Base<impl::CursorStation>;
+template class Base<impl::CursorStationData>;
+template class Base<impl::CursorData>;
+template class Base<impl::CursorSummary>;
+
+void Stations::decode_row(Decoder& dec)
+{
+    values.clear();
+    unsigned size = dec.decode_uint32();
+    for (unsigned i = 0; i < size; ++i)
+    {
+        int data_id = dec.decode_int();
+        values.set(DBValue(data_id, dec.decode_var()));
+    }
+}
+
+void StationData::decode_row(Decoder& dec)
+{
+    int data_id = dec.decode_int();
+    value = DBValue(data_id, dec.decode_var());
+}
+
+void Data::decode_row(Decoder& dec)
+{
+    datetime = dec.decode_datetime();
+    level = dec.decode_level();
+    trange = dec.decode_trange();
+    int data_id = dec.decode_int();
+    value = DBValue(data_id, dec.decode_var());
+}
+
+void Summary::decode_row(Decoder& dec)
+{
+    level = dec.decode_level();
+    trange = dec.decode_trange();
+    code = dec.decode_uint16();
+    dtrange.min = dec.decode_datetime();
+    dtrange.max = dec.decode_datetime();
+    entry_count = dec.decode_uint32();
+}
+
+}
+
+
+/*
+ * Transaction
+ */
+
+Transaction::Transaction(std::shared_ptr<remote::DB> db)
+    : db(db)
+{
+}
+
+Transaction::~Transaction()
+{
+    if (!fired)
+        rollback_nothrow();
+}
+
+void Transaction::commit()
+{
+    if (fired) return;
+    if (import_count)
+    {
+        Encoder req;
+        req.start((uint8_t)Command::IMPORT_MESSAGES);
+        req.append_uint32(import_count);
+        req.buf.insert(req.buf.end(), imports.buf.begin(), imports.buf.end());
+        req.finish();
+
+        auto conn = db->open_connection();
+        conn->send(req);
+        Decoder dec(nullptr, 0);
+        switch ((Reply)conn->read(dec))
+        {
+            case Reply::END: break;
+            case Reply::ERROR: dec.throw_error();
+            default: throw error_consistency("unexpected reply from the server");
+        }
+    }
+    rollback_nothrow();
+}
+
+void Transaction::rollback()
+{
+    rollback_nothrow();
+}
+
+void Transaction::rollback_nothrow() noexcept
+{
+    imports.buf.clear();
+    import_count = 0;
+    fired = true;
+}
+
+template<typename Cursor>
+std::shared_ptr<Cursor> Transaction::run_query(Command command, const Query& query)
+{
+    Encoder req;
+    req.start((uint8_t)command);
+    req.append_query(query);
+    req.finish();
+
+    auto conn = db->open_connection();
+    conn->send(req);
+    return std::make_shared<Cursor>(std::move(conn));
+}
+
+std::shared_ptr<dballe::CursorStation> Transaction::query_stations(const Query& query)
+{
+    return run_query<cursor::Stations>(Command::QUERY_STATIONS, query);
+}
+
+std::shared_ptr<dballe::CursorStationData> Transaction::query_station_data(const Query& query)
+{
+    return run_query<cursor::StationData>(Command::QUERY_STATION_DATA, query);
+}
+
+std::shared_ptr<dballe::CursorData> Transaction::query_data(const Query& query)
+{
+    return run_query<cursor::Data>(Command::QUERY_DATA, query);
+}
+
+std::shared_ptr<dballe::CursorSummary> Transaction::query_summary(const Query& query)
+{
+    return run_query<cursor::Summary>(Command::QUERY_SUMMARY, query);
+}
+
+std::shared_ptr<dballe::CursorMessage> Transaction::query_messages(const Query& query)
+{
+    throw error_unimplemented("querying messages is not supported through a dballe server");
+}
+
+void Transaction::remove_all()
+{
+    throw error_unimplemented("removing data is not supported through a dballe server");
+}
+
+void Transaction::remove_station_data(const Query& query)
+{
+    throw error_unimplemented("removing data is not supported through a dballe server");
+}
+
+void Transaction::remove_data(const Query& query)
+{
+    throw error_unimplemented("removing data is not supported through a dballe server");
+}
+
+void Transaction::import_message(const Message& message, const DBImportOptions& opts)
+{
+    imports.append_import_options(opts);
+    imports.append_uint32(1);
+    imports.append_message(message);
+    ++import_count;
+}
+
+void Transaction::import_messages(const std::vector<std::shared_ptr<Message>>& messages, const DBImportOptions& opts)
+{
+    imports.append_import_options(opts);
+    imports.append_uint32(messages.size());
+    for (const auto& msg: messages)
+        imports.append_message(*msg);
+    ++import_count;
+}
+
+void Transaction::insert_station_data(dballe::Data& data, const DBInsertOptions& opts)
+{
+    throw error_unimplemented("inserting data is not supported through a dballe server: use import_messages instead");
+}
+
+void Transaction::insert_data(dballe::Data& data, const DBInsertOptions& opts)
+{
+    throw error_unimplemented("inserting data is not supported through a dballe server: use import_messages instead");
+}
+
+
+/*
+ * DB
+ */
+
+DB::DB(const std::string& path)
+    : path(path)
+{
+}
+
+std::shared_ptr<dballe::Transaction> DB::transaction(bool readonly)
+{
+    return std::make_shared<remote::Transaction>(std::dynamic_pointer_cast<remote::DB>(shared_from_this()));
+}
+
+std::unique_ptr<Connection> DB::open_connection() const
+{
+    return std::unique_ptr<Connection>(new Connection(path));
+}
+
+std::shared_ptr<DB> DB::connect(const std::string& path)
+{
+    auto res = std::make_shared<DB>(path);
+
+    Encoder req;
+    req.start((uint8_t)Command::PING);
+    req.finish();
+    auto conn = res->open_connection();
+    conn->send(req);
+    Decoder dec(nullptr, 0);
+    switch ((Reply)conn->read(dec))
+    {
+        case Reply::END: break;
+        case Reply::ERROR: dec.throw_error();
+        default: throw error_consistency("unexpected reply from the server");
+    }
+    return res;
+}
+
+}
+}
+}
@@ -0,0 +1,343 @@
+#ifndef DBALLE_DB_REMOTE_H
+#define DBALLE_DB_REMOTE_H
+
+/** @file
+ * @ingroup db
+ * Client for a database shared by a dballe::db::Server over a Unix socket.
+ *
+ * The protocol is a sequence of frames, each made of a 32 bit length in
+ * network byte order, followed by a one byte frame type and its payload.
+ *
+ * A client sends one request frame for each connection, and the server
+ * answers with a Reply::COUNT frame with the number of rows, followed by a
+ * stream of Reply::STATION and Reply::ROW frames, and a final Reply::END
+ * frame. Any failure is sent as a Reply::ERROR frame, which ends the reply.
+ *
+ * Rows refer to the station in the last Reply::STATION frame, which is sent
+ * only when the station changes.
+ */
+
+#include <dballe/db.h>
+#include <dballe/core/values.h>
+#include <dballe/core/query.h>
+#include <dballe/core/cursor.h>
+#include <dballe/types.h>
+#include <dballe/values.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dballe {
+namespace db {
+namespace remote {
+
+/**
+ * Maximum size of a frame, larger frames are rejected without reading them.
+ *
+ * It bounds the memory that a peer can make the other side allocate.
+ */
+const size_t max_frame_size = 256 * 1024 * 1024;
+
+/// Types of request frames
+enum class Command : uint8_t
+{
+    /// Check that the server is responding
+    PING = 'p',
+    QUERY_STATIONS = 's',
+    QUERY_STATION_DATA = 't',
+    QUERY_DATA = 'd',
+    QUERY_SUMMARY = 'u',
+    IMPORT_MESSAGES = 'i',
+};
+
+/// Types of reply frames
+enum class Reply : uint8_t
+{
+    /// Number of rows in the reply
+    COUNT = 'c',
+    /// Station used by the rows that follow
+    STATION = 'S',
+    ROW = 'r',
+    END = 'e',
+    /// Error code and message
+    ERROR = 'x',
+};
+
+/**
+ * Encoder for the payload of protocol frames
+ */
+struct Encoder : public core::value::Encoder
+{
+    /// Offset in buf of the frame being encoded
+    size_t frame_start = 0;
+
+    /// Start a new frame of the given type, after the existing ones
+    void start(uint8_t type);
+    void append_uint8(uint8_t val);
+    void append_int(int val);
+    void append_string(const std::string& val);
+    void append_station(const DBStation& station, int priority);
+    void append_datetime(const Datetime& dt);
+    void append_level(const Level& level);
+    void append_trange(const Trange& trange);
+    /// Append a variable and its attributes
+    void append_var(const wreport::Var& var);
+    void append_query(const Query& query);
+    void append_message(const Message& message);
+    void append_import_options(const DBImportOptions& opts);
+    /// Set the length of the frame being encoded, checking it against max_frame_size
+    void finish();
+};
+
+/**
+ * Decoder for the payload of protocol frames
+ */
+struct Decoder : public core::value::Decoder
+{
+    using core::value::Decoder::Decoder;
+
+    uint8_t decode_uint8();
+    int decode_int();
+    std::string decode_string();
+    DBStation decode_station(int& priority);
+    Datetime decode_datetime();
+    Level decode_level();
+    Trange decode_trange();
+    std::unique_ptr<wreport::Var> decode_var();
+    core::Query decode_query();
+    std::shared_ptr<Message> decode_message();
+    std::unique_ptr<DBImportOptions> decode_import_options();
+
+    /// Throw the exception sent in a Reply::ERROR frame
+    [[noreturn]] void throw_error();
+};
+
+/**
+ * Stream socket exchanging protocol frames
+ */
+class Connection
+{
+protected:
+    int sock = -1;
+    /// Data read from the socket
+    std::vector<uint8_t> buf;
+    /// Position of the next unread byte in buf
+    size_t pos = 0;
+
+    /// Read at least \a size bytes in buf starting from pos
+    bool fill(size_t size);
+
+public:
+    /// Take ownership of an open socket
+    explicit Connection(int sock);
+    /// Connect to the Unix socket at \a path
+    explicit Connection(const std::string& path);
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+    ~Connection();
+
+    /// Send all the frames encoded in \a enc
+    void send(const Encoder& enc);
+
+    /**
+     * Read the next frame.
+     *
+     * Returns false if the peer closed the connection cleanly before a new
+     * frame. On success, \a type is set to the frame type and \a payload to
+     * its contents, which remain valid until the next call.
+     */
+    bool read(uint8_t& type, Decoder& payload);
+
+    /// Read the next frame, failing if the connection was closed
+    uint8_t read(Decoder& payload);
+};
+
+namespace cursor {
+
+/// Common implementation of cursors reading their rows from the server
+template<typename Interface>
+class Base : public Interface
+{
+protected:
+    /// Connection with the rows not yet read, or nullptr when done
+    std::unique_ptr<Connection> conn;
+    /// Number of rows in the results
+    int count = 0;
+    /// Number of rows read so far
+    int fetched = 0;
+    /// True if the cursor points to a valid row
+    bool valid = false;
+    DBStation station;
+    /// Priority of the report of the current station
+    int priority = MISSING_INT;
+
+    /// Decode the contents of a Reply::ROW frame
+    virtual void decode_row(Decoder& dec) = 0;
+
+public:
+    /// Read the start of the reply to a query sent on \a conn
+    Base(std::unique_ptr<Connection> conn);
+
+    bool has_value() const override { return valid; }
+    int remaining() const override { return count - fetched; }
+    bool next() override;
+    void discard() override;
+    DBStation get_station() const override { return station; }
+};
+
+struct Stations : public Base<impl::CursorStation>
+{
+    DBValues values;
+
+    using Base::Base;
+
+    DBValues get_values() const override { return values; }
+    void enq(impl::Enq& enq) const override;
+
+protected:
+    void decode_row(Decoder& dec) override;
+};
+
+struct StationData : public Base<impl::CursorStationData>
+{
+    DBValue value;
+
+    using Base::Base;
+
+    wreport::Varcode get_varcode() const override { return value.code(); }
+    wreport::Var get_var() const override { return *value; }
+    void enq(impl::Enq& enq) const override;
+
+protected:
+    void decode_row(Decoder& dec) override;
+};
+
+struct Data : public Base<impl::CursorData>
+{
+    Datetime datetime;
+    Level level;
+    Trange trange;
+    DBValue value;
+
+    using Base::Base;
+
+    wreport::Varcode get_varcode() const override { return value.code(); }
+    wreport::Var get_var() const override { return *value; }
+    Level get_level() const override { return level; }
+    Trange get_trange() const override { return trange; }
+    Datetime get_datetime() const override { return datetime; }
+    void enq(impl::Enq& enq) const override;
+
+protected:
+    void decode_row(Decoder& dec) override;
+};
+
+struct Summary : public Base<impl::CursorSummary>
+{
+    Level level;
+    Trange trange;
+    wreport::Varcode code = 0;
+    DatetimeRange dtrange;
+    /// Number of values summarised by this entry
+    size_t entry_count = 0;
+
+    using Base::Base;
+
+    Level get_level() const override { return level; }
+    Trange get_trange() const override { return trange; }
+    wreport::Varcode get_varcode() const override { return code; }
+    DatetimeRange get_datetimerange() const override { return dtrange; }
+    size_t get_count() const override { return entry_count; }
+    void enq(impl::Enq& enq) const override;
+
+protected:
+    void decode_row(Decoder& dec) override;
+};
+
+extern template class Base<impl::CursorStation>;
+extern template class Base<impl::CursorStationData>;
+extern template class Base<impl::CursorData>;
+extern template class Base<impl::CursorSummary>;
+
+}
+
+class DB;
+
+/**
+ * Transaction on a database accessed through a dballe::db::Server.
+ *
+ * Queries are run by the server as soon as they are requested, and do not see
+ * the messages imported by this transaction before it is committed.
+ */
+class Transaction : public dballe::Transaction
+{
+protected:
+    /// Import requests queued until commit
+    Encoder imports;
+    /// Number of import requests in imports
+    unsigned import_count = 0;
+    /// True if commit or rollback have already been called
+    bool fired = false;
+
+    template<typename Cursor>
+    std::shared_ptr<Cursor> run_query(Command command, const Query& query);
+
+public:
+    std::shared_ptr<remote::DB> db;
+
+    Transaction(std::shared_ptr<remote::DB> db);
+    ~Transaction();
+
+    void commit() override;
+    void rollback() override;
+    void rollback_nothrow() noexcept override;
+
+    std::shared_ptr<dballe::CursorStation> query_stations(const Query& query) override;
+    std::shared_ptr<dballe::CursorStationData> query_station_data(const Query& query) override;
+    std::shared_ptr<dballe::CursorData> query_data(const Query& query) override;
+    std::shared_ptr<dballe::CursorSummary> query_summary(const Query& query) override;
+    std::shared_ptr<dballe::CursorMessage> query_messages(const Query& query) override;
+
+    void remove_all() override;
+    void remove_station_data(const Query& query) override;
+    void remove_data(const Query& query) override;
+
+    void import_message(const Message& message, const DBImportOptions& opts=DBImportOptions::defaults) override;
+    void import_messages(const std::vector<std::shared_ptr<Message>>& messages, const DBImportOptions& opts=DBImportOptions::defaults) override;
+
+    void insert_station_data(dballe::Data& data, const DBInsertOptions& opts=DBInsertOptions::defaults) override;
+    void insert_data(dballe::Data& data, const DBInsertOptions& opts=DBInsertOptions::defaults) override;
+};
+
+/**
+ * Thin client accessing a database through a dballe::db::Server.
+ *
+ * Each query opens its own connection to the server, and its results are
+ * read from the socket as the cursor advances.
+ *
+ * Messages imported in a transaction are sent to the server when the
+ * transaction is committed, and are imported there in a single server-side
+ * transaction. Other write operations are not supported.
+ */
+class DB : public dballe::DB
+{
+public:
+    /// Pathname of the server socket
+    std::string path;
+
+    DB(const std::string& path);
+
+    std::shared_ptr<dballe::Transaction> transaction(bool readonly=false) override;
+
+    /// Open a new connection to the server
+    std::unique_ptr<Connection> open_connection() const;
+
+    /// Connect to the server listening at \a path, checking that it responds
+    static std::shared_ptr<DB> connect(const std::string& path);
+};
+
+}
+}
+}
+
+#endif
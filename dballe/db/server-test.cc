@@ -0,0 +1,248 @@
+#include "dballe/db/tests.h"
+#include "dballe/db/v7/db.h"
+#include "dballe/db/v7/cursor.h"
+#include "server.h"
+#include "remote.h"
+#include "config.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <arpa/inet.h>
+
+using namespace dballe;
+using namespace dballe::db;
+using namespace dballe::tests;
+using namespace wreport;
+using namespace std;
+
+namespace {
+
+/// Run a Server on the test database in a background thread
+struct RunningServer
+{
+    db::Server server;
+    std::thread thread;
+
+    RunningServer(const std::string& backend, unsigned max_clients=64)
+        : server(*DBConnectOptions::test_create(backend.c_str()), 2, 1024, max_clients)
+    {
+        server.listen("test-server.sock");
+        thread = std::thread([this] { server.serve_forever(); });
+    }
+
+    ~RunningServer()
+    {
+        server.stop();
+        thread.join();
+    }
+};
+
+template<typename DB>
+class Tests : public FixtureTestCase<DBFixture<DB>>
+{
+    typedef DBFixture<DB> Fixture;
+    using FixtureTestCase<Fixture>::FixtureTestCase;
+
+    void register_tests() override;
+};
+
+Tests<V7DB> tg1("db_server_v7_sqlite", "SQLITE");
+#ifdef HAVE_LIBPQ
+Tests<V7DB> tg2("db_server_v7_postgresql", "POSTGRESQL");
+#endif
+#ifdef HAVE_MYSQL
+Tests<V7DB> tg3("db_server_v7_mysql", "MYSQL");
+#endif
+
+template<typename DB>
+void Tests<DB>::register_tests()
+{
+
+this->add_method("query", [](Fixture& f) {
+    OldDballeTestDataSet data;
+    wassert(f.populate_database(data));
+
+    RunningServer running(f.backend);
+    auto client = dballe::DB::connect(*DBConnectOptions::create("unix://test-server.sock"));
+    wassert(actual((bool)dynamic_pointer_cast<remote::DB>(client)).istrue());
+
+    // Stations are sent with their station values
+    auto stations = client->query_stations(core::Query());
+    wassert(actual(stations->remaining()) == 2);
+    vector<string> reports;
+    while (stations->next())
+    {
+        reports.push_back(stations->get_station().report);
+        if (stations->get_station().report == "synop")
+            wassert(actual(stations->get_values().var("B01019").enq<std::string>()) == "Cippo Lippo");
+    }
+    std::sort(reports.begin(), reports.end());
+    wassert(actual(reports.size()) == 2u);
+    wassert(actual(reports[0]) == "metar");
+    wassert(actual(reports[1]) == "synop");
+
+    // Data rows match the ones read directly from the database
+    core::Query query;
+    query.report = "synop";
+    auto cur = client->query_data(query);
+    auto expected = f.db->query_data(query);
+    wassert(actual(cur->remaining()) == expected->remaining());
+    while (expected->next())
+    {
+        wassert(actual(cur->next()).istrue());
+        wassert(actual(cur->get_station()) == expected->get_station());
+        wassert(actual(cur->get_datetime()) == expected->get_datetime());
+        wassert(actual(cur->get_level()) == expected->get_level());
+        wassert(actual(cur->get_trange()) == expected->get_trange());
+        wassert(actual(cur->get_varcode()) == expected->get_varcode());
+        wassert(actual(cur->get_var().format()) == expected->get_var().format());
+
+        impl::Enqi enq("context_id", 10);
+        impl::CursorData::downcast(expected)->enq(enq);
+        impl::Enqi remote_enq("context_id", 10);
+        impl::CursorData::downcast(cur)->enq(remote_enq);
+        wassert(actual(remote_enq.res) == enq.res);
+    }
+    wassert(actual(cur->next()).isfalse());
+    wassert(actual(cur->remaining()) == 0);
+
+    auto summary = client->query_summary(core::Query());
+    auto expected_summary = f.db->query_summary(core::Query());
+    wassert(actual(summary->remaining()) == expected_summary->remaining());
+    size_t count = 0, expected_count = 0;
+    while (summary->next())
+        count += summary->get_count();
+    while (expected_summary->next())
+        expected_count += expected_summary->get_count();
+    wassert(actual(count) == expected_count);
+
+    // Errors are sent back to the client
+    core::Query invalid;
+    invalid.data_filter = "B12101>>>>>1";
+    wassert_throws(wreport::error_consistency, client->query_data(invalid));
+});
+
+this->add_method("query_large", [](Fixture& f) {
+    // Results larger than a chunk are sent while they are read
+    std::vector<core::Data> records(3000);
+    std::vector<dballe::Data*> data;
+    for (unsigned i = 0; i < records.size(); ++i)
+    {
+        core::Data& vals = records[i];
+        vals.station.report = "synop";
+        vals.station.coords = Coords(44.5 + (i % 3), 11.3);
+        vals.level = Level(1);
+        vals.trange = Trange::instant();
+        vals.datetime = Datetime::from_julian(2458000 + i / 24, i % 24);
+        vals.values.set("B12101", 250.0 + (i % 100));
+        data.push_back(&vals);
+    }
+    f.db->insert_data_many(data);
+
+    RunningServer running(f.backend);
+    auto client = dballe::DB::connect(*DBConnectOptions::create("unix://test-server.sock"));
+
+    auto cur = client->query_data(core::Query());
+    wassert(actual(cur->remaining()) == 3000);
+    unsigned count = 0;
+    while (cur->next())
+    {
+        wassert(actual(cur->get_level()) == Level(1));
+        wassert(actual(cur->get_var().enqd()) >= 250.0);
+        ++count;
+    }
+    wassert(actual(count) == 3000u);
+
+    // A cursor left unread does not keep a pooled connection busy
+    auto pending1 = client->query_data(core::Query());
+    auto pending2 = client->query_data(core::Query());
+    auto pending3 = client->query_data(core::Query());
+    wassert(actual(pending3->remaining()) == 3000);
+});
+
+this->add_method("discard", [](Fixture& f) {
+    OldDballeTestDataSet data;
+    wassert(f.populate_database(data));
+
+    RunningServer running(f.backend);
+    auto client = dballe::DB::connect(*DBConnectOptions::create("unix://test-server.sock"));
+
+    // Cursors can be discarded before reading all their results
+    auto cur = client->query_data(core::Query());
+    wassert(actual(cur->next()).istrue());
+    cur->discard();
+    wassert(actual(cur->next()).isfalse());
+
+    // More queries than pooled connections can be open at the same time
+    auto count = f.db->query_data(core::Query())->remaining();
+    auto station_count = f.db->query_station_data(core::Query())->remaining();
+    auto cur1 = client->query_data(core::Query());
+    auto cur2 = client->query_data(core::Query());
+    auto cur3 = client->query_station_data(core::Query());
+    wassert(actual(cur1->remaining()) == count);
+    wassert(actual(cur2->remaining()) == count);
+    wassert(actual(cur3->remaining()) == station_count);
+});
+
+this->add_method("limits", [](Fixture& f) {
+    OldDballeTestDataSet data;
+    wassert(f.populate_database(data));
+    auto count = f.db->query_data(core::Query())->remaining();
+
+    // Clients beyond the maximum wait until the previous ones are served
+    RunningServer running(f.backend, 1);
+    auto client = dballe::DB::connect(*DBConnectOptions::create("unix://test-server.sock"));
+    auto cur1 = client->query_data(core::Query());
+    auto cur2 = client->query_stations(core::Query());
+    auto cur3 = client->query_data(core::Query());
+    wassert(actual(cur1->remaining()) == count);
+    wassert(actual(cur2->remaining()) == 2);
+    wassert(actual(cur3->remaining()) == count);
+
+    // Frames larger than the maximum are rejected before reading them
+    remote::Connection conn("test-server.sock");
+    remote::Encoder req;
+    uint32_t len = htonl(remote::max_frame_size + 1);
+    req.buf.resize(4);
+    memcpy(req.buf.data(), &len, 4);
+    req.buf.push_back((uint8_t)remote::Command::PING);
+    conn.send(req);
+    remote::Decoder reply(nullptr, 0);
+    wassert(actual(conn.read(reply)) == (uint8_t)remote::Reply::ERROR);
+    wassert_throws(wreport::error_consistency, reply.throw_error());
+});
+
+this->add_method("import", [](Fixture& f) {
+    RunningServer running(f.backend);
+    auto client = dballe::DB::connect(*DBConnectOptions::create("unix://test-server.sock"));
+
+    auto msgs = read_msgs("bufr/obs0-1.22.bufr", Encoding::BUFR);
+    {
+        auto tr = client->transaction();
+        tr->import_messages(msgs);
+        // Imported messages are sent on commit
+        wassert(actual(f.db->query_data(core::Query())->remaining()) == 0);
+        tr->commit();
+    }
+
+    auto expected = f.db->query_data(core::Query())->remaining();
+    wassert(actual(expected) > 0);
+    wassert(actual(client->query_data(core::Query())->remaining()) == expected);
+
+    // Rolled back imports are not sent
+    {
+        auto tr = client->transaction();
+        auto opts = DBImportOptions::create();
+        opts->report = "temp";
+        tr->import_messages(msgs, *opts);
+        tr->rollback();
+    }
+    wassert(actual(f.db->query_data(core::Query())->remaining()) == expected);
+
+    // Write operations other than imports are not supported
+    wassert_throws(wreport::error_unimplemented, client->remove_all());
+});
+
+}
+
+}
@@ -0,0 +1,507 @@
+#include "server.h"
+#include "dballe/db/v7/db.h"
+#include "dballe/db/v7/cursor.h"
+#include "dballe/db/v7/transaction.h"
+#include "dballe/db/v7/repinfo.h"
+#include "dballe/db/v7/levtr.h"
+#include "dballe/db/v7/cache.h"
+#include "dballe/core/cursor.h"
+#include "dballe/var.h"
+#include <wreport/error.h>
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace wreport;
+using dballe::db::remote::Command;
+using dballe::db::remote::Reply;
+
+namespace dballe {
+namespace db {
+
+namespace {
+
+/// Read the priority of the report of the current row
+template<typename Cursor>
+int get_priority(const Cursor& cur)
+{
+    impl::Enqi enq("priority", 8);
+    cur.enq(enq);
+    return enq.missing ? MISSING_INT : enq.res;
+}
+
+/// Size of the encoded frames that are sent to the client at a time
+const size_t chunk_size = 65536;
+
+/// Send the frames encoded so far, if they have grown beyond chunk_size
+void send_chunk(remote::Connection& conn, remote::Encoder& out)
+{
+    if (out.buf.size() < chunk_size)
+        return;
+    conn.send(out);
+    out.buf.clear();
+}
+
+/**
+ * Rows buffered by a v7 cursor, with what is needed to encode them after its
+ * transaction has ended and its database connection is back in the pool
+ */
+template<typename Row>
+struct BufferedRows
+{
+    v7::cursor::Results<Row> results;
+    /// Priority of the report of each station, by station ID
+    std::unordered_map<int, int> priorities;
+    /// Level and time range of the rows, by ID
+    std::unordered_map<int, v7::LevTrEntry> levtrs;
+
+    template<typename Cursor>
+    BufferedRows(Cursor& cur)
+        : results(cur.tr->db->cursor_memory)
+    {
+        auto storage = cur.results.shared();
+        for (const auto& i: storage->stations)
+            priorities[i.first] = cur.tr->repinfo().get_priority(i.second.report);
+        results.ready(storage);
+    }
+
+    /// Copy the levels and time ranges of the rows from the cursor cache
+    template<typename Cursor>
+    void copy_levtrs(Cursor& cur)
+    {
+        auto storage = results.shared();
+        for (size_t i = 0; i < storage->rows.size(); ++i)
+        {
+            int id = storage->rows[i].id_levtr;
+            if (levtrs.find(id) == levtrs.end())
+                levtrs.emplace(id, cur.tr->levtr().lookup_cache(id));
+        }
+    }
+
+    const v7::LevTrEntry& levtr(const Row& row) const { return levtrs.at(row.id_levtr); }
+};
+
+/// Bytes written to stop_pipe
+const char wake_stop = 's';
+const char wake_client_done = 'c';
+
+/**
+ * Encode all the rows of a cursor, adding a Reply::STATION frame each time
+ * the station changes
+ */
+template<typename Cursor>
+void encode_rows(Cursor& cur, remote::Encoder& out, std::function<void(const Cursor&)> encode_row)
+{
+    out.start((uint8_t)Reply::COUNT);
+    out.append_int(cur.remaining());
+    out.finish();
+
+    bool first = true;
+    DBStation last;
+    while (cur.next())
+    {
+        DBStation station = cur.get_station();
+        if (first || station != last)
+        {
+            out.start((uint8_t)Reply::STATION);
+            out.append_station(station, get_priority(cur));
+            out.finish();
+            last = station;
+            first = false;
+        }
+
+        out.start((uint8_t)Reply::ROW);
+        encode_row(cur);
+        out.finish();
+    }
+}
+
+/**
+ * Send buffered rows, sending a Reply::STATION frame each time the station
+ * changes.
+ *
+ * Frames are sent in chunks as they are encoded.
+ */
+template<typename Row>
+void send_buffered_rows(remote::Connection& conn, BufferedRows<Row>& rows, remote::Encoder& out, std::function<void(const Row&)> encode_row)
+{
+    out.start((uint8_t)Reply::COUNT);
+    out.append_int(rows.results.size());
+    out.finish();
+
+    bool first = true;
+    DBStation last;
+    for ( ; !rows.results.empty(); rows.results.pop_front())
+    {
+        const Row& row = rows.results.front();
+        if (first || row.station != last)
+        {
+            out.start((uint8_t)Reply::STATION);
+            out.append_station(row.station, rows.priorities.at(row.station.id));
+            out.finish();
+            last = row.station;
+            first = false;
+        }
+
+        out.start((uint8_t)Reply::ROW);
+        encode_row(row);
+        out.finish();
+        send_chunk(conn, out);
+    }
+}
+
+}
+
+/// Take a connection from the pool for the duration of a request
+struct Server::Lease
+{
+    Server& server;
+    std::shared_ptr<dballe::DB> db;
+
+    Lease(Server& server)
+        : server(server)
+    {
+        std::unique_lock<std::mutex> lock(server.mutex);
+        server.pool_changed.wait(lock, [&] { return !server.pool.empty(); });
+        db = server.pool.back();
+        server.pool.pop_back();
+    }
+
+    ~Lease()
+    {
+        std::lock_guard<std::mutex> lock(server.mutex);
+        server.pool.push_back(db);
+        server.pool_changed.notify_one();
+    }
+};
+
+Server::Server(const DBConnectOptions& opts, unsigned pool_size, unsigned query_cache_size, unsigned max_clients)
+    : max_clients(max_clients ? max_clients : 1)
+{
+    // Each connection to an in-memory database would see a different database
+    if (opts.url == "mem:" || pool_size == 0)
+        pool_size = 1;
+
+    std::shared_ptr<v7::cursor::QueryCache> query_cache;
+    if (query_cache_size)
+        query_cache = std::make_shared<v7::cursor::QueryCache>(query_cache_size);
+
+    // Wipe the database only once, if requested
+    auto others = DBConnectOptions::create(opts.url);
+    others->reset_actions();
+    for (unsigned i = 0; i < pool_size; ++i)
+    {
+        auto db = dballe::DB::connect(i == 0 ? opts : *others);
+        if (query_cache)
+            if (auto v7db = std::dynamic_pointer_cast<v7::DB>(db))
+                v7db->query_cache = query_cache;
+        pool.push_back(db);
+    }
+
+    if (::pipe2(stop_pipe, O_CLOEXEC) == -1)
+        throw error_system("cannot create a pipe");
+
+    // Load the variable tables before clients are served by multiple
+    // threads, since their initialisation is not thread safe
+    varinfo(WR_VAR(0, 1, 1));
+}
+
+Server::~Server()
+{
+    if (sock != -1)
+    {
+        ::close(sock);
+        ::unlink(path.c_str());
+    }
+    ::close(stop_pipe[0]);
+    ::close(stop_pipe[1]);
+}
+
+void Server::listen(const std::string& path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        error_consistency::throwf("socket pathname %s is too long", path.c_str());
+    memcpy(addr.sun_path, path.data(), path.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        throw error_system("cannot create a Unix socket");
+
+    // Replace the socket left behind by a server that did not shut down
+    // cleanly
+    if (::unlink(path.c_str()) == -1 && errno != ENOENT)
+    {
+        int e = errno;
+        ::close(fd);
+        throw error_system("cannot remove " + path, e);
+    }
+
+    if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+    {
+        int e = errno;
+        ::close(fd);
+        throw error_system("cannot bind to " + path, e);
+    }
+
+    if (::listen(fd, 64) == -1)
+    {
+        int e = errno;
+        ::close(fd);
+        ::unlink(path.c_str());
+        throw error_system("cannot listen on " + path, e);
+    }
+
+    sock = fd;
+    this->path = path;
+}
+
+void Server::serve_forever()
+{
+    if (sock == -1)
+        throw error_consistency("serve_forever called before listen");
+
+    while (true)
+    {
+        // When serving max_clients clients, leave new ones in the listen
+        // backlog until a client thread wakes us up
+        bool full;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            full = clients.size() >= max_clients;
+        }
+
+        struct pollfd fds[2];
+        fds[0].fd = full ? -1 : sock;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = stop_pipe[0];
+        fds[1].events = POLLIN;
+        if (::poll(fds, 2, -1) == -1)
+        {
+            if (errno == EINTR) continue;
+            throw error_system("cannot wait for clients");
+        }
+        if (fds[1].revents)
+        {
+            char c;
+            if (::read(stop_pipe[0], &c, 1) == -1)
+            {
+                if (errno == EINTR) continue;
+                throw error_system("cannot read from the stop pipe");
+            }
+            if (c == wake_stop)
+                break;
+            continue;
+        }
+        if (!fds[0].revents)
+            continue;
+
+        int client = ::accept4(sock, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN)
+                continue;
+            throw error_system("cannot accept a client connection");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            clients.insert(client);
+        }
+
+        std::thread([this, client] {
+            remote::Connection conn(client);
+            serve_client(conn);
+            // Stop tracking the socket before it is closed, so that stop
+            // cannot shut down a reused file descriptor
+            std::lock_guard<std::mutex> lock(mutex);
+            if (clients.size() == max_clients)
+            {
+                // serve_forever stopped accepting clients: wake it up
+                char c = wake_client_done;
+                if (::write(stop_pipe[1], &c, 1) == -1)
+                {
+                    // Nothing else to do: accepting new clients is delayed
+                    // until another one is served
+                }
+            }
+            clients.erase(client);
+            clients_changed.notify_all();
+        }).detach();
+    }
+
+    // Interrupt the clients still connected, and wait for them to finish
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int client: clients)
+        ::shutdown(client, SHUT_RDWR);
+    clients_changed.wait(lock, [&] { return clients.empty(); });
+}
+
+void Server::stop()
+{
+    char c = wake_stop;
+    if (::write(stop_pipe[1], &c, 1) == -1)
+        return;
+}
+
+void Server::serve_client(remote::Connection& conn)
+{
+    remote::Encoder reply;
+    try {
+        uint8_t type;
+        remote::Decoder req(nullptr, 0);
+        if (!conn.read(type, req))
+            return;
+        handle(type, req, conn, reply);
+        reply.start((uint8_t)Reply::END);
+        reply.finish();
+    } catch (wreport::error& e) {
+        reply.buf.clear();
+        reply.start((uint8_t)Reply::ERROR);
+        reply.append_uint8(e.code());
+        reply.append_string(e.what());
+        reply.finish();
+    } catch (std::exception& e) {
+        reply.buf.clear();
+        reply.start((uint8_t)Reply::ERROR);
+        reply.append_uint8(WR_ERR_CONSISTENCY);
+        reply.append_string(e.what());
+        reply.finish();
+    }
+
+    try {
+        conn.send(reply);
+    } catch (std::exception& e) {
+        // The client has gone away, or has discarded the results
+    }
+}
+
+void Server::handle(uint8_t type, remote::Decoder& req, remote::Connection& conn, remote::Encoder& reply)
+{
+    switch ((Command)type)
+    {
+        case Command::PING:
+            break;
+        case Command::QUERY_STATIONS:
+        {
+            // Station values are read from the database as the rows are
+            // iterated, so the whole reply is encoded before returning the
+            // connection, and sent afterwards
+            core::Query query = req.decode_query();
+            Lease lease(*this);
+            auto tr = lease.db->transaction(true);
+            auto cur = impl::CursorStation::downcast(tr->query_stations(query));
+            encode_rows<impl::CursorStation>(*cur, reply, [&](const impl::CursorStation& row) {
+                DBValues values = row.get_values();
+                reply.append_uint32(values.size());
+                for (const auto& val: values)
+                {
+                    reply.append_int(val.data_id);
+                    reply.append_var(*val);
+                }
+            });
+            tr->rollback();
+            break;
+        }
+        case Command::QUERY_STATION_DATA:
+        {
+            core::Query query = req.decode_query();
+            std::unique_ptr<BufferedRows<v7::cursor::StationDataRow>> rows;
+            {
+                Lease lease(*this);
+                auto tr = lease.db->transaction(true);
+                auto cur = v7::cursor::StationData::downcast(tr->query_station_data(query));
+                rows.reset(new BufferedRows<v7::cursor::StationDataRow>(*cur));
+                tr->rollback();
+            }
+            send_buffered_rows<v7::cursor::StationDataRow>(conn, *rows, reply, [&](const v7::cursor::StationDataRow& row) {
+                reply.append_int(row.value.data_id);
+                reply.append_var(*row.value);
+            });
+            break;
+        }
+        case Command::QUERY_DATA:
+        {
+            core::Query query = req.decode_query();
+            std::unique_ptr<BufferedRows<v7::cursor::DataRow>> rows;
+            {
+                Lease lease(*this);
+                auto tr = lease.db->transaction(true);
+                auto cur = v7::cursor::Data::downcast(tr->query_data(query));
+                rows.reset(new BufferedRows<v7::cursor::DataRow>(*cur));
+                rows->copy_levtrs(*cur);
+                tr->rollback();
+            }
+            send_buffered_rows<v7::cursor::DataRow>(conn, *rows, reply, [&](const v7::cursor::DataRow& row) {
+                const v7::LevTrEntry& levtr = rows->levtr(row);
+                reply.append_datetime(row.datetime);
+                reply.append_level(levtr.level);
+                reply.append_trange(levtr.trange);
+                reply.append_int(row.value.data_id);
+                reply.append_var(*row.value);
+            });
+            break;
+        }
+        case Command::QUERY_SUMMARY:
+        {
+            core::Query query = req.decode_query();
+            std::unique_ptr<BufferedRows<v7::cursor::SummaryRow>> rows;
+            {
+                Lease lease(*this);
+                auto tr = lease.db->transaction(true);
+                auto cur = v7::cursor::Summary::downcast(tr->query_summary(query));
+                rows.reset(new BufferedRows<v7::cursor::SummaryRow>(*cur));
+                rows->copy_levtrs(*cur);
+                tr->rollback();
+            }
+            send_buffered_rows<v7::cursor::SummaryRow>(conn, *rows, reply, [&](const v7::cursor::SummaryRow& row) {
+                const v7::LevTrEntry& levtr = rows->levtr(row);
+                reply.append_level(levtr.level);
+                reply.append_trange(levtr.trange);
+                reply.append_uint16(row.code);
+                reply.append_datetime(row.dtrange.min);
+                reply.append_datetime(row.dtrange.max);
+                reply.append_uint32(row.count);
+            });
+            break;
+        }
+        case Command::IMPORT_MESSAGES:
+        {
+            // Decode everything before taking database locks
+            std::vector<std::unique_ptr<DBImportOptions>> options;
+            std::vector<std::vector<std::shared_ptr<Message>>> batches;
+            unsigned count = req.decode_uint32();
+            for (unsigned i = 0; i < count; ++i)
+            {
+                options.emplace_back(req.decode_import_options());
+                batches.emplace_back();
+                unsigned msg_count = req.decode_uint32();
+                for (unsigned j = 0; j < msg_count; ++j)
+                    batches.back().emplace_back(req.decode_message());
+            }
+
+            std::lock_guard<std::mutex> lock(import_mutex);
+            Lease lease(*this);
+            auto tr = lease.db->transaction();
+            for (unsigned i = 0; i < count; ++i)
+                tr->import_messages(batches[i], *options[i]);
+            tr->commit();
+            break;
+        }
+        default:
+            error_consistency::throwf("unsupported request type %d", (int)type);
+    }
+}
+
+}
+}
@@ -0,0 +1,112 @@
+#ifndef DBALLE_DB_SERVER_H
+#define DBALLE_DB_SERVER_H
+
+/** @file
+ * @ingroup db
+ * Share a database with local clients through a Unix socket.
+ */
+
+#include <dballe/db.h>
+#include <dballe/db/remote.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace dballe {
+namespace db {
+
+/**
+ * Serve queries and imports to dballe::db::remote::DB clients connecting to a
+ * Unix socket.
+ *
+ * The server keeps a pool of open connections to the database, so that
+ * clients do not need to connect and load the repinfo table each time, and
+ * can share the same cache of station and summary query results.
+ *
+ * Each client connection is served by its own thread, up to a maximum number
+ * of clients served at the same time: further clients wait in the listen
+ * backlog until one has been served. Results are sent in chunks as they are
+ * encoded. Query results are buffered by the database cursor, and the pooled
+ * connection is returned to the pool before they are sent, so that slow
+ * clients do not keep database connections busy; station query results are
+ * encoded in full before returning the connection, since station values are
+ * read as rows are iterated. Imports are run one at a time, to avoid
+ * contention on database locks.
+ */
+class Server
+{
+protected:
+    struct Lease;
+
+    /// Database connections not currently in use
+    std::vector<std::shared_ptr<dballe::DB>> pool;
+    /// Sockets of the clients being served
+    std::set<int> clients;
+    /// Protects pool and clients
+    std::mutex mutex;
+    /// Notified when a connection is returned to the pool
+    std::condition_variable pool_changed;
+    /// Notified when a client has been served
+    std::condition_variable clients_changed;
+    /// Serialises imports
+    std::mutex import_mutex;
+    /// Listening socket
+    int sock = -1;
+    /// Pathname of the listening socket
+    std::string path;
+    /// Maximum number of clients served at the same time
+    unsigned max_clients;
+    /**
+     * Pipe used to wake up serve_forever(), by stop() and by client threads
+     * when they make room for a new client
+     */
+    int stop_pipe[2] = { -1, -1 };
+
+    /// Serve the request sent by a client
+    void serve_client(remote::Connection& conn);
+
+    /**
+     * Handle a request, encoding the reply in \a reply.
+     *
+     * Long replies are sent to \a conn in chunks, and \a reply contains the
+     * part that has not been sent yet.
+     */
+    void handle(uint8_t type, remote::Decoder& req, remote::Connection& conn, remote::Encoder& reply);
+
+public:
+    /**
+     * Open \a pool_size connections to the database in \a opts.
+     *
+     * If \a query_cache_size is not 0, the connections share a cache of
+     * station and summary query results of that size (see
+     * db::v7::cursor::QueryCache).
+     *
+     * At most \a max_clients clients are served at the same time.
+     */
+    Server(const DBConnectOptions& opts, unsigned pool_size=4, unsigned query_cache_size=1024, unsigned max_clients=64);
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+    ~Server();
+
+    /// Listen on the Unix socket at \a path, replacing an existing socket
+    void listen(const std::string& path);
+
+    /// Serve clients until stop() is called
+    void serve_forever();
+
+    /**
+     * Make serve_forever() return, after interrupting the clients being
+     * served.
+     *
+     * It is safe to call it from a signal handler.
+     */
+    void stop();
+};
+
+}
+}
+
+#endif
@@ -239,6 +239,43 @@ this->add_method("merge_entries", [](Fixture& f) {
     wassert(actual(summary.data_count()) == 36u + 24u);
 });
 
+this->add_method("remove_entries", [](Fixture& f) {
+    typename BACKEND::station_type station;
+    station.report = "test";
+    station.coords = Coords(44.5, 11.5);
+    summary::VarDesc vd(Level(1), Trange::instant(), WR_VAR(0, 1, 112));
+    summary::VarDesc vd1(Level(1), Trange::instant(), WR_VAR(0, 1, 113));
+    DatetimeRange dtrange(Datetime(2018, 1, 1), Datetime(2018, 7, 1));
+
+    BACKEND summary;
+    summary.add(station, vd, dtrange, 12u);
+    summary.add(station, vd1, dtrange, 3u);
+
+    auto count_entries = [&]() -> unsigned {
+        unsigned res = 0;
+        summary.iter([&](const typename BACKEND::station_type&, const summary::VarDesc&, const DatetimeRange&, size_t) { ++res; return true; });
+        return res;
+    };
+
+    // Removing some values only changes the count
+    summary.remove(station, vd, 5u);
+    wassert(actual(summary.data_count()) == 10u);
+    wassert(actual(count_entries()) == 2u);
+
+    // Removing all the values removes the entry
+    summary.remove(station, vd1, 3u);
+    wassert(actual(summary.data_count()) == 7u);
+    wassert(actual(count_entries()) == 1u);
+
+    // Removing entries that do not exist does nothing
+    summary.remove(station, vd1, 3u);
+    wassert(actual(summary.data_count()) == 7u);
+
+    summary.remove(station, vd, 7u);
+    wassert(actual(summary.data_count()) == 0u);
+    wassert(actual(count_entries()) == 0u);
+});
+
 this->add_method("merge_summaries", [](Fixture& f) {
     BACKEND summary;
 
@@ -1,6 +1,7 @@
 #define _DBALLE_LIBRARY_CODE
 #include "summary.h"
 #include "summary_utils.h"
+#include "summary_memory.h"
 #include "dballe/core/var.h"
 #include "dballe/core/query.h"
 #include "dballe/core/json.h"
@@ -127,6 +128,16 @@ void BaseSummary<Station>::add_summary(const BaseSummary<dballe::DBStation>& sum
     });
 }
 
+template<typename Station>
+void BaseSummary<Station>::add_delta(const summary::Delta& delta)
+{
+    add_summary(delta.added);
+    delta.removed.iter([&](const dballe::DBStation& station, const summary::VarDesc& var, const DatetimeRange& dtrange, size_t count) {
+        remove(summary::convert_station<Station, dballe::DBStation>(station), var, count);
+        return true;
+    });
+}
+
 namespace {
 
 // This class is used to disentangle code a bit to try and workaround an
@@ -11,6 +11,8 @@ namespace dballe {
 namespace db {
 namespace summary {
 
+struct Delta;
+
 /**
  * Description of a variable, independent of where and when it was measured
  */
@@ -89,6 +91,15 @@ public:
     /// Add an entry to the summary
     virtual void add(const Station& station, const summary::VarDesc& vd, const dballe::DatetimeRange& dtrange, size_t count) = 0;
 
+    /**
+     * Subtract \a count values from an entry of the summary, removing the
+     * entry when no values are left.
+     *
+     * The datetime range of the entry is left as it is, since narrowing it
+     * would need to look at the values that are left.
+     */
+    virtual void remove(const Station& station, const summary::VarDesc& vd, size_t count) = 0;
+
     /// Add an entry to the summary taken from the current status of \a cur
     virtual void add_cursor(const dballe::CursorSummary& cur);
 
@@ -107,6 +118,9 @@ public:
     /// Merge the copy of another summary into this one
     virtual void add_filtered(const BaseSummary<Station>& summary, const dballe::Query& query);
 
+    /// Add and remove the values recorded in a summary::Delta
+    virtual void add_delta(const summary::Delta& delta);
+
     /// Write changes to disk
     virtual void commit() = 0;
 
@@ -29,8 +29,8 @@ BaseSummaryMemory<Station>::BaseSummaryMemory(const std::string& pathname)
     using namespace wreport;
     if (sys::exists(pathname))
     {
-        std::stringstream in(sys::read_file(pathname));
-        core::json::Stream json(in);
+        std::string buf = sys::read_file(pathname);
+        core::json::Stream json(buf);
         load_json(json);
     }
 }
@@ -111,6 +111,11 @@ bool BaseSummaryMemory<Station>::iter_filtered(const dballe::Query& query, std::
 template<typename Station>
 void BaseSummaryMemory<Station>::recompute_summaries() const
 {
+    // Start from scratch, since entries may also have been removed
+    m_reports.clear();
+    m_levels.clear();
+    m_tranges.clear();
+    m_varcodes.clear();
     bool first = true;
     for (const auto& station_entry: entries)
     {
@@ -159,6 +164,13 @@ void BaseSummaryMemory<Station>::add(const Station& station, const summary::VarD
     dirty = true;
 }
 
+template<typename Station>
+void BaseSummaryMemory<Station>::remove(const Station& station, const summary::VarDesc& vd, size_t count)
+{
+    entries.remove(station, vd, count);
+    dirty = true;
+}
+
 template<typename Station>
 void BaseSummaryMemory<Station>::add_filtered(const BaseSummary<Station>& summary, const dballe::Query& query)
 {
@@ -273,5 +285,26 @@ void BaseSummaryMemory<Station>::dump(FILE* out) const
 template class BaseSummaryMemory<dballe::Station>;
 template class BaseSummaryMemory<dballe::DBStation>;
 
+namespace summary {
+
+bool Delta::empty() const
+{
+    return added._entries().empty() && removed._entries().empty();
+}
+
+void Delta::clear()
+{
+    added.clear();
+    removed.clear();
+}
+
+void Delta::add(const Delta& delta)
+{
+    added.add_summary(delta.added);
+    removed.add_summary(delta.removed);
+}
+
+}
+
 }
 }
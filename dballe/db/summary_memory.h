@@ -67,6 +67,9 @@ public:
     /// Add an entry to the summary
     void add(const Station& station, const summary::VarDesc& vd, const dballe::DatetimeRange& dtrange, size_t count) override;
 
+    /// Subtract values from an entry of the summary
+    void remove(const Station& station, const summary::VarDesc& vd, size_t count) override;
+
     /// Merge the copy of another summary into this one
     void add_summary(const BaseSummary<dballe::Station>& summary) override;
 
@@ -100,6 +103,34 @@ typedef BaseSummaryMemory<dballe::DBStation> DBSummaryMemory;
 extern template class BaseSummaryMemory<dballe::Station>;
 extern template class BaseSummaryMemory<dballe::DBStation>;
 
+namespace summary {
+
+/**
+ * Summary of the data added to and removed from a database, that can be
+ * merged into an existing summary to keep it up to date without querying the
+ * whole database.
+ *
+ * See db::Transaction::set_summary_delta.
+ */
+struct Delta
+{
+    /// Summary of the values added
+    DBSummaryMemory added;
+    /// Summary of the values removed
+    DBSummaryMemory removed;
+
+    /// Check if no changes have been recorded
+    bool empty() const;
+
+    /// Forget all recorded changes
+    void clear();
+
+    /// Add the changes recorded in another Delta
+    void add(const Delta& delta);
+};
+
+}
+
 }
 }
 
@@ -68,6 +68,18 @@ void StationEntry<Station>::add(const StationEntry<OStation>& entries)
         add(entry.var, entry.dtrange, entry.count);
 }
 
+template<typename Station>
+void StationEntry<Station>::remove(const VarDesc& vd, size_t count)
+{
+    iterator i = find(vd);
+    if (i == end())
+        return;
+    if (i->count > count)
+        i->count -= count;
+    else
+        SmallSet::erase(vd);
+}
+
 template<typename Station>
 void StationEntry<Station>::add_filtered(const StationEntry& entries, const dballe::Query& query)
 {
@@ -203,6 +215,17 @@ void StationEntries<Station>::add(const StationEntries<OStation>& entries)
     }
 }
 
+template<typename Station>
+void StationEntries<Station>::remove(const Station& station, const VarDesc& vd, size_t count)
+{
+    iterator cur = this->find(station);
+    if (cur == end())
+        return;
+    cur->remove(vd, count);
+    if (cur->empty())
+        Parent::erase(station);
+}
+
 template<typename Station>
 void StationEntries<Station>::add_filtered(const StationEntries& entries, const dballe::Query& query)
 {
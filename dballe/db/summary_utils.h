@@ -100,6 +100,8 @@ struct StationEntry : protected core::SmallSet<VarEntry, VarDesc, station_entry_
     void add(const VarDesc& vd, const dballe::DatetimeRange& dtrange, size_t count);
     template<typename OStation>
     void add(const StationEntry<OStation>& entries);
+    /// Subtract \a count from the entry for \a vd, removing it if it drops to zero
+    void remove(const VarDesc& vd, size_t count);
     void add_filtered(const StationEntry& entries, const dballe::Query& query);
     bool iter_filtered(const dballe::Query& query, std::function<bool(const Station&, const summary::VarDesc&, const DatetimeRange& dtrange, size_t count)> dest) const;
 
@@ -148,6 +150,12 @@ struct StationEntries : protected core::SmallSet<StationEntry<Station>, Station,
     /// Merge the given entry
     void add(const StationEntry<Station>& entry);
 
+    /**
+     * Subtract \a count from the given entry, removing the entry, and the
+     * station if it has no more entries, when it drops to zero
+     */
+    void remove(const Station& station, const VarDesc& vd, size_t count);
+
     void add_filtered(const StationEntries& entry, const dballe::Query& query);
 
     bool has(const Station& station) const { return this->find(station) != this->end(); }
@@ -355,6 +355,38 @@ void BaseSummaryXapian<Station>::add(const Station& station, const summary::VarD
     }
 }
 
+template<typename Station>
+void BaseSummaryXapian<Station>::remove(const Station& station, const summary::VarDesc& vd, size_t count)
+{
+    try {
+        auto writer = this->db->writer();
+        std::array<std::string, 4> terms;
+        terms[0] = to_term(station);
+        terms[1] = to_term(vd.level);
+        terms[2] = to_term(vd.trange);
+        terms[3] = to_term(vd.varcode);
+
+        Xapian::Query query(Xapian::Query::OP_AND, terms.begin(), terms.end());
+
+        Xapian::Enquire enq(writer);
+        enq.set_query(query);
+
+        Xapian::MSet mset = enq.get_mset(0, 1);
+        if (mset.empty())
+            return;
+
+        Xapian::Document doc = mset[0].get_document();
+        size_t old_count = Xapian::sortable_unserialise(doc.get_value(2));
+        if (old_count > count)
+        {
+            doc.add_value(2, Xapian::sortable_serialise(old_count - count));
+            writer.replace_document(doc.get_docid(), doc);
+        } else
+            writer.delete_document(doc.get_docid());
+    CATCH_XAPIAN_RETHROW_WREPORT
+    }
+}
+
 template<typename Station>
 void BaseSummaryXapian<Station>::commit()
 {
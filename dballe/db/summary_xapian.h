@@ -47,6 +47,7 @@ public:
 
     void clear() override;
     void add(const Station& station, const summary::VarDesc& vd, const dballe::DatetimeRange& dtrange, size_t count) override;
+    void remove(const Station& station, const summary::VarDesc& vd, size_t count) override;
     void commit() override;
 
     bool iter(std::function<bool(const Station&, const summary::VarDesc&, const DatetimeRange&, size_t)>) const override;
@@ -153,6 +153,56 @@ add_method("from_db", [](Fixture& f) {
     }
 });
 
+add_method("prefetch", [](Fixture& f) {
+    using namespace dballe::db::v7;
+    db::v7::Tracer<> trc;
+
+    Coords coords(44.5008, 11.3288);
+
+    TestDataSet ds;
+    ds.data["synop"].station.coords = coords;
+    ds.data["synop"].station.report = "synop";
+    ds.data["synop"].datetime = Datetime(2013, 10, 16, 10);
+    ds.data["synop"].level = Level(1, 0, 0);
+    ds.data["synop"].trange = Trange::instant();
+    ds.data["synop"].values.set(WR_VAR(0, 12, 101), 16.5);
+    wassert(f.populate(ds));
+
+    Batch& batch = f.tr->batch;
+    batch.clear();
+
+    std::vector<std::pair<dballe::DBStation, Datetime>> keys;
+    dballe::DBStation st;
+    st.report = "synop";
+    st.coords = coords;
+    keys.emplace_back(st, Datetime(2013, 10, 16, 10));
+    keys.emplace_back(st, Datetime(2013, 10, 16, 11));
+    st.coords = Coords(45.0, 11.0);
+    keys.emplace_back(st, Datetime(2013, 10, 16, 10));
+    wassert(batch.prefetch(trc, keys));
+
+    batch::Station* station = wcallchecked(batch.get_station(trc, "synop", coords, Ident()));
+    wassert(actual(station->id) != MISSING_INT);
+    wassert_false(station->is_new);
+
+    auto& md1 = station->get_measured_data(trc, Datetime(2013, 10, 16, 10));
+    wassert(actual(md1.ids_on_db.size()) == 1u);
+    wassert(actual(md1.ids_on_db.begin()->id_varcode.varcode) == WR_VAR(0, 12, 101));
+    auto& md2 = station->get_measured_data(trc, Datetime(2013, 10, 16, 11));
+    wassert(actual(md2.ids_on_db.size()) == 0u);
+    wassert(actual(batch.count_select_data) == 0u);
+
+    station = wcallchecked(batch.get_station(trc, "synop", Coords(45.0, 11.0), Ident()));
+    wassert(actual(station->id) == MISSING_INT);
+    wassert_true(station->is_new);
+
+    // Prefetched IDs are used only once
+    station = wcallchecked(batch.get_station(trc, "synop", coords, Ident()));
+    wassert(actual(station->id) != MISSING_INT);
+    station->get_measured_data(trc, Datetime(2013, 10, 16, 10));
+    wassert(actual(batch.count_select_data) == 1u);
+});
+
 add_method("import", [](Fixture& f) {
     db::v7::Tracer<> trc;
     impl::Messages msgs1 = read_msgs("bufr/test-airep1.bufr", Encoding::BUFR);
@@ -1,6 +1,9 @@
 #include "batch.h"
 #include "transaction.h"
 #include "station.h"
+#include "data.h"
+#include "levtr.h"
+#include "dballe/db/summary_memory.h"
 #include <algorithm>
 
 namespace dballe {
@@ -46,6 +49,27 @@ void Batch::new_station(Tracer<>& trc, const std::string& report, const Coords&
     last_station->ident = ident;
 }
 
+int Batch::last_station_id(Tracer<>& trc)
+{
+    if (!prefetched_stations.empty())
+    {
+        dballe::DBStation key;
+        key.report = last_station->report;
+        key.coords = last_station->coords;
+        key.ident = last_station->ident;
+        auto i = prefetched_stations.find(key);
+        if (i != prefetched_stations.end())
+        {
+            // Use the prefetched ID only once: if the station is not in the
+            // database, it will be after this batch writes it
+            int id = i->second;
+            prefetched_stations.erase(i);
+            return id;
+        }
+    }
+    return transaction.station().maybe_get_id(trc, *last_station);
+}
+
 batch::Station* Batch::get_station(Tracer<>& trc, const dballe::DBStation& station, bool station_can_add)
 {
     v7::Station& st = transaction.station();
@@ -65,7 +89,7 @@ batch::Station* Batch::get_station(Tracer<>& trc, const dballe::DBStation& stati
             return last_station;
         new_station(trc, station.report, station.coords, station.ident);
         ++count_select_stations;
-        last_station->id = st.maybe_get_id(trc, *last_station);
+        last_station->id = last_station_id(trc);
     }
 
     if (last_station->id == MISSING_INT)
@@ -88,11 +112,9 @@ batch::Station* Batch::get_station(Tracer<>& trc, const std::string& report, con
     if (have_station(report, coords, ident))
         return last_station;
 
-    v7::Station& st = transaction.station();
-
     new_station(trc, report, coords, ident);
 
-    last_station->id = st.maybe_get_id(trc, *last_station);
+    last_station->id = last_station_id(trc);
     ++count_select_stations;
     if (last_station->id == MISSING_INT)
     {
@@ -107,8 +129,67 @@ batch::Station* Batch::get_station(Tracer<>& trc, const std::string& report, con
     return last_station;
 }
 
+void Batch::prefetch(Tracer<>& trc, const std::vector<std::pair<dballe::DBStation, Datetime>>& keys)
+{
+    // Look up all the stations
+    std::vector<dballe::DBStation> stations;
+    for (const auto& key: keys)
+    {
+        if (prefetched_stations.find(key.first) != prefetched_stations.end())
+            continue;
+        prefetched_stations.insert(std::make_pair(key.first, MISSING_INT));
+        stations.push_back(key.first);
+    }
+    if (stations.empty())
+        return;
+    transaction.station().maybe_get_ids(trc, stations);
+    for (const auto& st: stations)
+    {
+        dballe::DBStation key(st);
+        key.id = MISSING_INT;
+        prefetched_stations[key] = st.id;
+    }
+
+    // Look up the data of the stations that are already in the database
+    std::vector<std::pair<int, Datetime>> data_keys;
+    for (const auto& key: keys)
+    {
+        if (key.second.is_missing())
+            continue;
+        int id_station = prefetched_stations[key.first];
+        if (id_station == MISSING_INT)
+            continue;
+        auto data_key = std::make_pair(id_station, key.second);
+        if (prefetched_data.find(data_key) != prefetched_data.end())
+            continue;
+        // Also record lookups with no results, to know that there is no data
+        prefetched_data.insert(std::make_pair(data_key, batch::MeasuredDataIDs()));
+        data_keys.push_back(data_key);
+    }
+    if (data_keys.empty())
+        return;
+    transaction.data().query_many(trc, data_keys, [&](size_t idx, int data_id, int id_levtr, wreport::Varcode code) {
+        prefetched_data[data_keys[idx]].add(batch::MeasuredDataID(IdVarcode(id_levtr, code), data_id));
+    });
+}
+
+bool Batch::take_prefetched(int id_station, batch::MeasuredData& md)
+{
+    if (prefetched_data.empty())
+        return false;
+    auto i = prefetched_data.find(std::make_pair(id_station, md.datetime));
+    if (i == prefetched_data.end())
+        return false;
+    md.ids_on_db = std::move(i->second);
+    prefetched_data.erase(i);
+    return true;
+}
+
 void Batch::write_pending(Tracer<>& trc)
 {
+    // Prefetched IDs would be out of date after the batch is written
+    prefetched_stations.clear();
+    prefetched_data.clear();
     if (!last_station)
         return;
     last_station->write_pending(trc, write_attrs);
@@ -118,6 +199,8 @@ void Batch::clear()
 {
     delete last_station;
     last_station = nullptr;
+    prefetched_stations.clear();
+    prefetched_data.clear();
 }
 
 void Batch::dump(FILE* out) const
@@ -213,6 +296,17 @@ void MeasuredData::add(int id_levtr, const wreport::Var* var, UpdateMode on_conf
     }
 }
 
+bool MeasuredData::has_pending(int id_levtr, wreport::Varcode code) const
+{
+    for (const auto& d: to_insert)
+        if (d.id_levtr == id_levtr && d.var->code() == code)
+            return true;
+    for (const auto& d: to_update)
+        if (d.id_levtr == id_levtr && d.var->code() == code)
+            return true;
+    return false;
+}
+
 void MeasuredData::write_pending(Tracer<>& trc, Transaction& tr, int station_id, bool with_attrs)
 {
     if (!to_insert.empty())
@@ -269,7 +363,7 @@ MeasuredData& Station::get_measured_data(Tracer<>& trc, const Datetime& datetime
 
     MeasuredData* md = measured_data.add(new MeasuredData(datetime));
 
-    if (!is_new)
+    if (!is_new && !batch.take_prefetched(id, *md))
     {
         v7::Data& d = batch.transaction.data();
         d.query(trc, id, datetime, [&](int data_id, int id_levtr, wreport::Varcode code) {
@@ -286,6 +380,18 @@ void Station::write_pending(Tracer<>& trc, bool with_attrs)
     if (id == MISSING_INT)
         id = batch.transaction.station().insert_new(trc, *this);
 
+    // Values updated in place do not change the summary, only new ones do
+    if (summary::Delta* delta = batch.transaction.pending_summary_delta())
+        for (auto md: measured_data)
+        {
+            DatetimeRange dtrange(md->datetime, md->datetime);
+            for (const auto& d: md->to_insert)
+            {
+                const LevTrEntry* lt = batch.transaction.levtr().lookup_id(trc, d.id_levtr);
+                delta->added.add(*this, summary::VarDesc(lt->level, lt->trange, d.var->code()), dtrange, 1);
+            }
+        }
+
     station_data.write_pending(trc, batch.transaction, id, with_attrs);
     for (auto md: measured_data)
         md->write_pending(trc, batch.transaction, id, with_attrs);
@@ -7,6 +7,7 @@
 #include <dballe/db/v7/fwd.h>
 #include <dballe/db/v7/utils.h>
 #include <vector>
+#include <map>
 #include <tuple>
 #include <memory>
 
@@ -15,34 +16,7 @@ namespace db {
 namespace v7 {
 struct Transaction;
 
-class Batch
-{
-protected:
-    bool write_attrs = true;
-    batch::Station* last_station = nullptr;
-
-    bool have_station(const std::string& report, const Coords& coords, const Ident& ident);
-    void new_station(Tracer<>& trc, const std::string& report, const Coords& coords, const Ident& ident);
-
-public:
-    Transaction& transaction;
-    unsigned count_select_stations = 0;
-    unsigned count_select_station_data = 0;
-    unsigned count_select_data = 0;
-
-    Batch(Transaction& transaction) : transaction(transaction) {}
-    ~Batch();
-
-    void set_write_attrs(bool write_attrs);
-
-    batch::Station* get_station(Tracer<>& trc, const dballe::DBStation& station, bool station_can_add);
-    batch::Station* get_station(Tracer<>& trc, const std::string& report, const Coords& coords, const Ident& ident);
-
-    void write_pending(Tracer<>& trc);
-    void clear();
-    void dump(FILE* out) const;
-};
-
+class Batch;
 
 namespace batch {
 
@@ -130,6 +104,8 @@ struct MeasuredData
     }
 
     void add(int id_levtr, const wreport::Var* var, UpdateMode on_conflict);
+    /// Check if a value for id_levtr and code is waiting to be written
+    bool has_pending(int id_levtr, wreport::Varcode code) const;
     void write_pending(Tracer<>& trc, Transaction& tr, int station_id, bool with_attrs);
 };
 
@@ -163,6 +139,61 @@ struct Station : public dballe::DBStation
 };
 
 }
+
+class Batch
+{
+protected:
+    bool write_attrs = true;
+    batch::Station* last_station = nullptr;
+
+    /// Station IDs looked up in advance by prefetch, each used at most once
+    std::map<dballe::DBStation, int> prefetched_stations;
+    /// Data IDs looked up in advance by prefetch, each used at most once
+    std::map<std::pair<int, Datetime>, batch::MeasuredDataIDs> prefetched_data;
+
+    bool have_station(const std::string& report, const Coords& coords, const Ident& ident);
+    void new_station(Tracer<>& trc, const std::string& report, const Coords& coords, const Ident& ident);
+    /// Look up the ID of last_station, using prefetched IDs if available
+    int last_station_id(Tracer<>& trc);
+
+public:
+    Transaction& transaction;
+    unsigned count_select_stations = 0;
+    unsigned count_select_station_data = 0;
+    unsigned count_select_data = 0;
+
+    Batch(Transaction& transaction) : transaction(transaction) {}
+    ~Batch();
+
+    void set_write_attrs(bool write_attrs);
+
+    batch::Station* get_station(Tracer<>& trc, const dballe::DBStation& station, bool station_can_add);
+    batch::Station* get_station(Tracer<>& trc, const std::string& report, const Coords& coords, const Ident& ident);
+
+    /**
+     * Look up in advance, all together, the IDs of the given stations and the
+     * data already in the database for the given stations and datetimes.
+     *
+     * Stations are given without their ID, and keys with a missing datetime
+     * only look up the station.
+     *
+     * This lets backends use fewer round trips to the database than when
+     * get_station and get_measured_data look them up one at a time.
+     */
+    void prefetch(Tracer<>& trc, const std::vector<std::pair<dballe::DBStation, Datetime>>& keys);
+
+    /**
+     * Fill md with the data IDs looked up by prefetch for the given station.
+     *
+     * Returns false if they have not been prefetched.
+     */
+    bool take_prefetched(int id_station, batch::MeasuredData& md);
+
+    void write_pending(Tracer<>& trc);
+    void clear();
+    void dump(FILE* out) const;
+};
+
 }
 }
 }
@@ -12,9 +12,13 @@
 #include "dballe/var.h"
 #include "dballe/core/var.h"
 #include "dballe/core/data.h"
+#include "dballe/core/values.h"
 #include "dballe/core/query.h"
+#include "dballe/core/json.h"
+#include "dballe/db/summary_memory.h"
 #include "wreport/var.h"
 #include <unordered_map>
+#include <sstream>
 #include <cstring>
 #include <cassert>
 
@@ -62,6 +66,27 @@ template class Base<Data>;
 template class Base<Summary>;
 
 
+size_t ValuePool::append(const wreport::Var& var, unsigned& size)
+{
+    core::value::Encoder enc;
+    enc.append(var);
+    enc.append_attributes(var);
+    size_t pos = buf.size();
+    buf.append(enc.buf.data(), enc.buf.size());
+    size = enc.buf.size();
+    return pos;
+}
+
+std::unique_ptr<wreport::Var> ValuePool::get(size_t pos, unsigned size) const
+{
+    core::value::Decoder dec(&buf[pos], size);
+    auto res = dec.decode_var();
+    while (dec.size)
+        res->seta(dec.decode_var());
+    return res;
+}
+
+
 void StationRow::dump(FILE* out) const
 {
     fprintf(out, "%02d %8.8s %02.4f %02.4f %-10s\n", station.id, station.report.c_str(), station.coords.dlat(), station.coords.dlon(), station.ident.get());
@@ -95,6 +120,7 @@ void Stations::load(Tracer<>& trc, const StationQueryBuilder& qb)
     tr->station().run_station_query(trc, qb, [&](const dballe::DBStation& desc) {
         results.emplace_back(desc);
     });
+    results.ready();
     at_start = true;
 }
 
@@ -135,6 +161,7 @@ void StationData::load(Tracer<>& trc, const DataQueryBuilder& qb)
     tr->station_data().run_station_data_query(trc, qb, [&](const dballe::DBStation& station, int id_data, std::unique_ptr<wreport::Var> var) {
         results.emplace_back(station, id_data, std::move(var));
     });
+    results.ready();
     at_start = true;
 }
 
@@ -166,6 +193,7 @@ void Data::load(Tracer<>& trc, const DataQueryBuilder& qb)
         results.emplace_back(station, id_levtr, datetime, id_data, std::move(var));
         ids.insert(id_levtr);
     });
+    results.ready();
     at_start = true;
 
     tr->levtr().prefetch_ids(trc, ids);
@@ -204,6 +232,7 @@ void Data::load_best(Tracer<>& trc, const DataQueryBuilder& qb)
         if (add_to_best_results(station, id_levtr, datetime, id_data, move(var)))
             ids.insert(id_levtr);
     });
+    results.ready();
     at_start = true;
 
     tr->levtr().prefetch_ids(trc, ids);
@@ -240,6 +269,7 @@ void Data::load_last(Tracer<>& trc, const DataQueryBuilder& qb)
         if (add_to_last_results(station, id_levtr, datetime, id_data, move(var)))
             ids.insert(id_levtr);
     });
+    results.ready();
     at_start = true;
 
     tr->levtr().prefetch_ids(trc, ids);
@@ -259,20 +289,26 @@ void Data::query_attrs(std::function<void(std::unique_ptr<wreport::Var>)> dest,
 void Data::remove()
 {
     tr->remove_data_by_id(row().value.data_id);
+    if (summary::Delta* delta = tr->pending_summary_delta())
+    {
+        Datetime dt = row().datetime;
+        delta->removed.add(row().station, summary::VarDesc(get_level(), get_trange(), get_varcode()), DatetimeRange(dt, dt), 1);
+    }
 }
 
 
-void Summary::load(Tracer<>& trc, const SummaryQueryBuilder& qb)
+void Summary::load(Tracer<>& trc, const SummaryQueryBuilder& qb, std::set<int>& levtr_ids)
 {
     results.clear();
-    set<int> ids;
+    levtr_ids.clear();
     tr->data().run_summary_query(trc, qb, [&](const dballe::DBStation& station, int id_levtr, wreport::Varcode code, const DatetimeRange& datetime, size_t count) {
         results.emplace_back(station, id_levtr, code, datetime, count);
-        ids.insert(id_levtr);
+        levtr_ids.insert(id_levtr);
     });
+    results.ready();
     at_start = true;
 
-    tr->levtr().prefetch_ids(trc, ids);
+    tr->levtr().prefetch_ids(trc, levtr_ids);
 }
 
 void Summary::remove()
@@ -286,20 +322,135 @@ void Summary::remove()
     tr->remove_data(query);
 }
 
+QueryCache::Key::Key(const core::Query& query, const std::string& generation)
+    : generation(generation)
+{
+    std::stringstream buf;
+    buf << query.want_missing;
+    core::JSONWriter writer(buf);
+    writer.start_mapping();
+    query.serialize(writer);
+    writer.end_mapping();
+    this->query = buf.str();
+}
+
+template<typename Row>
+const QueryCache::Entry<Row>* QueryCache::find(const std::map<std::string, Entry<Row>>& entries, const Key& key)
+{
+    auto i = entries.find(key.query);
+    if (i == entries.end() || i->second.generation != key.generation)
+        return nullptr;
+    return &i->second;
+}
+
+template<typename Row>
+void QueryCache::add(std::map<std::string, Entry<Row>>& entries, const Key& key, Entry<Row>&& entry)
+{
+    entry.generation = key.generation;
+    auto i = entries.find(key.query);
+    if (i != entries.end())
+    {
+        i->second = std::move(entry);
+        return;
+    }
+    // Start again when full, instead of tracking which entries are in use
+    if (entries.size() >= max_size)
+        entries.clear();
+    entries.insert(std::make_pair(key.query, std::move(entry)));
+}
+
+std::shared_ptr<const Results<StationRow>::Storage> QueryCache::find_stations(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (const Entry<StationRow>* entry = find(stations, key))
+        return entry->storage;
+    return nullptr;
+}
+
+void QueryCache::add_stations(const Key& key, std::shared_ptr<const Results<StationRow>::Storage> storage)
+{
+    Entry<StationRow> entry;
+    entry.storage = storage;
+    std::lock_guard<std::mutex> lock(mutex);
+    add(stations, key, std::move(entry));
+}
+
+std::shared_ptr<const Results<SummaryRow>::Storage> QueryCache::find_summary(const Key& key, std::set<int>& levtr_ids)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (const Entry<SummaryRow>* entry = find(summaries, key))
+    {
+        levtr_ids = entry->levtr_ids;
+        return entry->storage;
+    }
+    return nullptr;
+}
+
+void QueryCache::add_summary(const Key& key, std::shared_ptr<const Results<SummaryRow>::Storage> storage, const std::set<int>& levtr_ids)
+{
+    Entry<SummaryRow> entry;
+    entry.storage = storage;
+    entry.levtr_ids = levtr_ids;
+    std::lock_guard<std::mutex> lock(mutex);
+    add(summaries, key, std::move(entry));
+}
+
+void QueryCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    stations.clear();
+    summaries.clear();
+}
+
+namespace {
+
+/**
+ * Return the cache for the results of queries run by tr, or nullptr if they
+ * cannot be cached
+ */
+QueryCache* query_cache(const v7::Transaction& tr)
+{
+    // Results that include changes not yet committed cannot be shared
+    if (tr.modified)
+        return nullptr;
+    return tr.db->query_cache.get();
+}
+
+}
+
 std::shared_ptr<dballe::CursorStation> run_station_query(Tracer<>& trc, std::shared_ptr<v7::Transaction> tr, const core::Query& q, bool explain)
 {
+    auto res = std::make_shared<Stations>(tr);
+
     unsigned int modifiers = q.get_modifiers();
     StationQueryBuilder qb(tr, q, modifiers);
-    qb.build();
 
+    // Explain queries also when their results come from the cache
     if (explain)
     {
+        qb.build();
         fprintf(stderr, "EXPLAIN "); q.print(stderr);
-        tr->db->conn->explain(qb.sql_query, stderr);
+        qb.explain(stderr);
     }
 
-    auto res = std::make_shared<Stations>(tr);
+    QueryCache* cache = query_cache(*tr);
+    std::unique_ptr<QueryCache::Key> key;
+    if (cache)
+    {
+        key.reset(new QueryCache::Key(q, tr->db->driver().write_generation()));
+        if (auto storage = cache->find_stations(*key))
+        {
+            res->results.ready(storage);
+            return res;
+        }
+    }
+
+    if (!explain)
+        qb.build();
+
     res->load(trc, qb);
+    if (cache)
+        cache->add_stations(*key, res->results.shared());
     return res;
 }
 
@@ -312,7 +463,7 @@ std::shared_ptr<dballe::CursorStationData> run_station_data_query(Tracer<>& trc,
     if (explain)
     {
         fprintf(stderr, "EXPLAIN "); q.print(stderr);
-        tr->db->conn->explain(qb.sql_query, stderr);
+        qb.explain(stderr);
     }
 
     if (modifiers & (DBA_DB_MODIFIER_BEST | DBA_DB_MODIFIER_LAST))
@@ -337,7 +488,7 @@ std::shared_ptr<dballe::CursorData> run_data_query(Tracer<>& trc, std::shared_pt
     if (explain)
     {
         fprintf(stderr, "EXPLAIN "); q.print(stderr);
-        tr->db->conn->explain(qb.sql_query, stderr);
+        qb.explain(stderr);
     }
 
     auto res = std::make_shared<Data>(qb, modifiers & DBA_DB_MODIFIER_WITH_ATTRIBUTES);
@@ -356,17 +507,38 @@ std::shared_ptr<dballe::CursorSummary> run_summary_query(Tracer<>& trc, std::sha
     if (modifiers & (DBA_DB_MODIFIER_BEST | DBA_DB_MODIFIER_LAST))
         throw error_consistency("cannot use query=best or query=last on summary queries");
 
+    auto res = std::make_shared<Summary>(tr);
+    std::set<int> levtr_ids;
+
     SummaryQueryBuilder qb(tr, q, modifiers, false);
-    qb.build();
 
+    // Explain queries also when their results come from the cache
     if (explain)
     {
+        qb.build();
         fprintf(stderr, "EXPLAIN "); q.print(stderr);
-        tr->db->conn->explain(qb.sql_query, stderr);
+        qb.explain(stderr);
     }
 
-    auto res = std::make_shared<Summary>(tr);
-    res->load(trc, qb);
+    QueryCache* cache = query_cache(*tr);
+    std::unique_ptr<QueryCache::Key> key;
+    if (cache)
+    {
+        key.reset(new QueryCache::Key(q, tr->db->driver().write_generation()));
+        if (auto storage = cache->find_summary(*key, levtr_ids))
+        {
+            res->results.ready(storage);
+            tr->levtr().prefetch_ids(trc, levtr_ids);
+            return res;
+        }
+    }
+
+    if (!explain)
+        qb.build();
+
+    res->load(trc, qb, levtr_ids);
+    if (cache)
+        cache->add_summary(*key, res->results.shared(), levtr_ids);
     return res;
 }
 
@@ -382,7 +554,7 @@ void run_delete_query(Tracer<>& trc, std::shared_ptr<v7::Transaction> tr, const
     if (explain)
     {
         fprintf(stderr, "EXPLAIN "); q.print(stderr);
-        tr->db->conn->explain(qb.sql_query, stderr);
+        qb.explain(stderr);
     }
 
     if (station_vars)
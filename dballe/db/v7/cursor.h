@@ -3,12 +3,18 @@
 
 #include <dballe/types.h>
 #include <dballe/db/db.h>
+#include <dballe/db/v7/db.h>
 #include <dballe/db/v7/transaction.h>
 #include <dballe/db/v7/repinfo.h>
 #include <dballe/db/v7/levtr.h>
 #include <dballe/values.h>
+#include <dballe/core/structbuf.h>
+#include <map>
 #include <memory>
-#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
 
 namespace dballe {
 namespace db {
@@ -20,49 +26,134 @@ struct StationData;
 struct Data;
 struct Summary;
 
+/**
+ * Storage for the variable-length part of buffered rows.
+ *
+ * It keeps the most recent values in memory, and becomes file-backed when
+ * it grows.
+ */
+class ValuePool
+{
+protected:
+    Structbuf<uint8_t> buf;
+
+public:
+    /// Create a pool keeping up to max_memory bytes in memory
+    explicit ValuePool(size_t max_memory) : buf(max_memory) {}
+
+    /**
+     * Append a variable and its attributes, returning its position in the
+     * pool and setting size to its encoded size
+     */
+    size_t append(const wreport::Var& var, unsigned& size);
+
+    /// Stop appending and get ready to read back the values
+    void ready_to_read() { buf.ready_to_read(); }
+
+    /// Read back a variable and its attributes
+    std::unique_ptr<wreport::Var> get(size_t pos, unsigned size) const;
+};
+
 /**
  * Row resulting from a station query
  */
 struct StationRow
 {
+    /// Fixed-size representation used to buffer query results
+    struct Compact
+    {
+        int id_station;
+    };
+
     dballe::DBStation station;
     mutable std::unique_ptr<DBValues> values;
 
     StationRow(const dballe::DBStation& station) : station(station) {}
+    StationRow(const Compact& c, const dballe::DBStation& station, const ValuePool& pool) : station(station) {}
+
+    void to_compact(Compact& c, ValuePool& pool) const { c.id_station = station.id; }
 
     void dump(FILE* out) const;
 };
 
 struct StationDataRow
 {
+    /// Fixed-size representation used to buffer query results
+    struct Compact
+    {
+        int id_station;
+        int id_data;
+        size_t value_pos;
+        unsigned value_size;
+    };
+
     dballe::DBStation station;
     DBValue value;
 
     StationDataRow(const dballe::DBStation& station, int id_data, std::unique_ptr<wreport::Var> var) : station(station), value(id_data, std::move(var)) {}
+    StationDataRow(const Compact& c, const dballe::DBStation& station, const ValuePool& pool)
+        : station(station), value(c.id_data, pool.get(c.value_pos, c.value_size)) {}
     StationDataRow(const StationDataRow&) = delete;
     StationDataRow(StationDataRow&& o) = default;
     StationDataRow& operator=(const StationDataRow&) = delete;
     StationDataRow& operator=(StationDataRow&& o) = default;
     ~StationDataRow() {}
 
+    void to_compact(Compact& c, ValuePool& pool) const
+    {
+        c.id_station = station.id;
+        c.id_data = value.data_id;
+        c.value_pos = pool.append(*value, c.value_size);
+    }
+
     void dump(FILE* out) const;
 };
 
 struct DataRow : public StationDataRow
 {
+    /// Fixed-size representation used to buffer query results
+    struct Compact
+    {
+        int id_station;
+        int id_data;
+        size_t value_pos;
+        unsigned value_size;
+        int id_levtr;
+        Datetime datetime;
+    };
+
     int id_levtr;
     Datetime datetime;
 
-    using StationDataRow::StationDataRow;
-
     DataRow(const dballe::DBStation& station, int id_levtr, const Datetime& datetime, int id_data, std::unique_ptr<wreport::Var> var)
         : StationDataRow(station, id_data, std::move(var)), id_levtr(id_levtr), datetime(datetime) {}
+    DataRow(const Compact& c, const dballe::DBStation& station, const ValuePool& pool)
+        : StationDataRow(station, c.id_data, pool.get(c.value_pos, c.value_size)), id_levtr(c.id_levtr), datetime(c.datetime) {}
+
+    void to_compact(Compact& c, ValuePool& pool) const
+    {
+        c.id_station = station.id;
+        c.id_data = value.data_id;
+        c.value_pos = pool.append(*value, c.value_size);
+        c.id_levtr = id_levtr;
+        c.datetime = datetime;
+    }
 
     void dump(FILE* out) const;
 };
 
 struct SummaryRow
 {
+    /// Fixed-size representation used to buffer query results
+    struct Compact
+    {
+        int id_station;
+        int id_levtr;
+        wreport::Varcode code;
+        DatetimeRange dtrange;
+        size_t count;
+    };
+
     dballe::DBStation station;
     int id_levtr;
     wreport::Varcode code;
@@ -71,11 +162,176 @@ struct SummaryRow
 
     SummaryRow(const dballe::DBStation& station, int id_levtr, wreport::Varcode code, const DatetimeRange& dtrange, size_t count)
         : station(station), id_levtr(id_levtr), code(code), dtrange(dtrange), count(count) {}
+    SummaryRow(const Compact& c, const dballe::DBStation& station, const ValuePool& pool)
+        : station(station), id_levtr(c.id_levtr), code(c.code), dtrange(c.dtrange), count(c.count) {}
+
+    void to_compact(Compact& c, ValuePool& pool) const
+    {
+        c.id_station = station.id;
+        c.id_levtr = id_levtr;
+        c.code = code;
+        c.dtrange = dtrange;
+        c.count = count;
+    }
 
     void dump(FILE* out) const;
 };
 
 
+/**
+ * Buffer of query results.
+ *
+ * Rows are stored in their fixed-size Compact representation in a
+ * Structbuf, with their values in a ValuePool and each station stored only
+ * once, so that the buffer becomes file-backed instead of growing in memory
+ * when a query returns many results.
+ *
+ * Rows are appended first, then ready() is called and they are read back in
+ * order with front() and pop_front(). The last appended row is kept as a
+ * Row until the next one is appended, so that back() can be used to replace
+ * it while loading best and last queries.
+ *
+ * After ready(), the stored rows are not modified anymore, and can be shared
+ * with other Results that read them independently.
+ */
+template<typename Row>
+class Results
+{
+public:
+    typedef typename Row::Compact Compact;
+
+    /// Stored rows, with their values and stations
+    struct Storage
+    {
+        Structbuf<Compact> rows;
+        ValuePool pool;
+        std::unordered_map<int, dballe::DBStation> stations;
+
+        /**
+         * Create storage that keeps up to max_memory bytes of rows, and as
+         * many of values, in memory before becoming file-backed
+         */
+        explicit Storage(size_t max_memory)
+            : rows(max_memory / sizeof(Compact)), pool(max_memory) {}
+    };
+
+protected:
+    /// Maximum amount of memory used by each of rows and values
+    size_t max_memory;
+    /// Rows being appended, until ready() is called
+    std::shared_ptr<Storage> appending;
+    /// Rows being read, after ready() is called
+    std::shared_ptr<const Storage> reading;
+    /// Last row appended, not yet stored in rows
+    std::unique_ptr<Row> last;
+    /// Row at the current reading position
+    std::unique_ptr<Row> current;
+    /// Current reading position
+    size_t pos = 0;
+
+    void flush_last()
+    {
+        if (!last) return;
+        Compact c;
+        last->to_compact(c, appending->pool);
+        if (appending->stations.find(last->station.id) == appending->stations.end())
+            appending->stations.emplace(last->station.id, last->station);
+        appending->rows.append(c);
+        last.reset();
+    }
+
+    void load_current()
+    {
+        if (pos < reading->rows.size())
+        {
+            const Compact& c = reading->rows[pos];
+            current.reset(new Row(c, reading->stations.at(c.id_station), reading->pool));
+        } else
+            current.reset();
+    }
+
+public:
+    explicit Results(size_t max_memory)
+        : max_memory(max_memory), appending(std::make_shared<Storage>(max_memory)) {}
+
+    /// Number of rows appended, or number of rows left to read
+    size_t size() const
+    {
+        if (reading)
+            return reading->rows.size() - pos;
+        return appending->rows.size() + (last ? 1 : 0);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /// Append a row
+    template<typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        flush_last();
+        last.reset(new Row(std::forward<Args>(args)...));
+    }
+
+    /// Access the last appended row
+    Row& back() { return *last; }
+
+    /// Stop appending and get ready to read rows back
+    void ready()
+    {
+        flush_last();
+        appending->rows.ready_to_read();
+        appending->pool.ready_to_read();
+        reading = std::move(appending);
+        pos = 0;
+        load_current();
+    }
+
+    /**
+     * Read rows stored by another Results, instead of appending.
+     *
+     * storage is not modified, and can be read by several Results at the
+     * same time.
+     */
+    void ready(std::shared_ptr<const Storage> storage)
+    {
+        appending.reset();
+        reading = storage;
+        last.reset();
+        pos = 0;
+        load_current();
+    }
+
+    /// Access the stored rows, after ready() has been called
+    std::shared_ptr<const Storage> shared() const { return reading; }
+
+    /// Access the row at the current reading position
+    const Row& front() const { return *current; }
+
+    /// Move to the next row
+    void pop_front()
+    {
+        ++pos;
+        load_current();
+    }
+
+    /// Discard all rows
+    void clear()
+    {
+        if (!appending || appending->rows.size())
+            appending = std::make_shared<Storage>(max_memory);
+        else
+            appending->stations.clear();
+        reading.reset();
+        last.reset();
+        current.reset();
+        pos = 0;
+    }
+
+    /// Check if the buffer has become file-backed
+    bool is_file_backed() const { return reading ? reading->rows.is_file_backed() : appending->rows.is_file_backed(); }
+};
+
+
 template<typename Cursor>
 struct ImplTraits
 {
@@ -128,13 +384,13 @@ struct Base : public ImplTraits<Impl>::Parent
     std::shared_ptr<v7::Transaction> tr;
 
     /// Storage for the raw database results
-    std::deque<Row> results;
+    Results<Row> results;
 
     /// True if we are at the start of the iteration
     bool at_start = true;
 
     Base(std::shared_ptr<v7::Transaction> tr)
-        : tr(tr)
+        : tr(tr), results(tr->db->cursor_memory)
     {
     }
 
@@ -305,12 +561,75 @@ struct Summary : public LevTrBase<Summary>
     void enq(impl::Enq& enq) const override;
 
 protected:
-    void load(Tracer<>& trc, const SummaryQueryBuilder& qb);
+    /// Run the query, setting levtr_ids to the LevTr IDs used by the results
+    void load(Tracer<>& trc, const SummaryQueryBuilder& qb, std::set<int>& levtr_ids);
 
     friend std::shared_ptr<dballe::CursorSummary> run_summary_query(Tracer<>& trc, std::shared_ptr<v7::Transaction> tr, const core::Query& query, bool explain);
 };
 
 
+/**
+ * Results of station and summary queries, shared by the transactions of a
+ * v7::DB.
+ *
+ * Results are looked up by query and by the write generation of the
+ * database, which is incremented after each commit that changed data, also
+ * by other processes, so that they are reused until the database changes.
+ */
+class QueryCache
+{
+public:
+    /// Query and database state that identify cached results
+    struct Key
+    {
+        /// Normalized form of the query
+        std::string query;
+        /// Write generation of the database the query ran on
+        std::string generation;
+
+        Key(const core::Query& query, const std::string& generation);
+    };
+
+    /// Maximum number of results kept for each kind of query
+    const unsigned max_size;
+
+    explicit QueryCache(unsigned max_size) : max_size(max_size) {}
+
+    /// Look up the results of a station query, returning nullptr if not found
+    std::shared_ptr<const Results<StationRow>::Storage> find_stations(const Key& key);
+    /// Store the results of a station query
+    void add_stations(const Key& key, std::shared_ptr<const Results<StationRow>::Storage> storage);
+    /**
+     * Look up the results of a summary query, returning nullptr if not
+     * found, and setting levtr_ids to the LevTr IDs they use
+     */
+    std::shared_ptr<const Results<SummaryRow>::Storage> find_summary(const Key& key, std::set<int>& levtr_ids);
+    /// Store the results of a summary query, and the LevTr IDs they use
+    void add_summary(const Key& key, std::shared_ptr<const Results<SummaryRow>::Storage> storage, const std::set<int>& levtr_ids);
+
+    /// Discard all cached results
+    void clear();
+
+protected:
+    template<typename Row>
+    struct Entry
+    {
+        std::string generation;
+        std::shared_ptr<const typename Results<Row>::Storage> storage;
+        std::set<int> levtr_ids;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, Entry<StationRow>> stations;
+    std::map<std::string, Entry<SummaryRow>> summaries;
+
+    template<typename Row>
+    static const Entry<Row>* find(const std::map<std::string, Entry<Row>>& entries, const Key& key);
+    template<typename Row>
+    void add(std::map<std::string, Entry<Row>>& entries, const Key& key, Entry<Row>&& entry);
+};
+
+
 std::shared_ptr<dballe::CursorStation> run_station_query(Tracer<>& trc, std::shared_ptr<v7::Transaction> tr, const core::Query& query, bool explain);
 std::shared_ptr<dballe::CursorStationData> run_station_data_query(Tracer<>& trc, std::shared_ptr<v7::Transaction> tr, const core::Query& query, bool explain);
 std::shared_ptr<dballe::CursorData> run_data_query(Tracer<>& trc, std::shared_ptr<v7::Transaction> tr, const core::Query& query, bool explain);
@@ -66,6 +66,14 @@ void DataCommon<Traits>::remove_attrs(Tracer<>& trc, int id_data, const db::Attr
 template class DataCommon<StationDataTraits>;
 template class DataCommon<DataTraits>;
 
+void Data::query_many(Tracer<>& trc, const std::vector<std::pair<int, Datetime>>& keys, std::function<void(size_t idx, int id, int id_levtr, wreport::Varcode code)> dest)
+{
+    for (size_t idx = 0; idx < keys.size(); ++idx)
+        query(trc, keys[idx].first, keys[idx].second, [&](int id, int id_levtr, wreport::Varcode code) {
+            dest(idx, id, id_levtr, code);
+        });
+}
+
 
 StationDataDumper::StationDataDumper(FILE* out)
     : out(out)
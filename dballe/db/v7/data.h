@@ -14,6 +14,7 @@
 #include <list>
 #include <cstdio>
 #include <functional>
+#include <utility>
 
 namespace dballe {
 namespace db {
@@ -162,6 +163,16 @@ struct Data : public DataCommon<DataTraits>
     /// Query contents of the data table
     virtual void query(Tracer<>& trc, int id_station, const Datetime& datetime, std::function<void(int id, int id_levtr, wreport::Varcode code)> dest) = 0;
 
+    /**
+     * Query contents of the data table for many station and datetime pairs
+     * at once.
+     *
+     * dest is called with the position in keys of the pair that matched.
+     *
+     * The default implementation calls query for each pair.
+     */
+    virtual void query_many(Tracer<>& trc, const std::vector<std::pair<int, Datetime>>& keys, std::function<void(size_t idx, int id, int id_levtr, wreport::Varcode code)> dest);
+
     /**
      * Run a data query, iterating on the resulting variables
      */
@@ -13,6 +13,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include <chrono>
 #include <limits.h>
 #include <unistd.h>
 
@@ -36,9 +37,19 @@ DB::DB(shared_ptr<Connection> conn)
         trace = new CollectTrace(logdir);
     else if (Trace::in_test_suite())
         trace = new QuietCollectTrace;
+    else if (getenv("DBA_METRICS") && strcmp(getenv("DBA_METRICS"), "0") != 0)
+        trace = new MetricsTrace;
     else
         trace = new NullTrace;
 
+    if (const char* size = getenv("DBA_DB_QUERY_CACHE"))
+        if (unsigned max_size = strtoul(size, nullptr, 10))
+            query_cache.reset(new cursor::QueryCache(max_size));
+
+    if (const char* size = getenv("DBA_DB_CURSOR_MEMORY"))
+        if (size_t mb = strtoul(size, nullptr, 10))
+            cursor_memory = mb * 1024 * 1024;
+
     auto trc = trace->trace_connect(this->conn->get_url());
 
     /* Set the connection timeout */
@@ -84,8 +95,19 @@ void DB::disappear()
 void DB::reset(const char* repinfo_file)
 {
     auto trc = trace->trace_reset(repinfo_file);
+    // The write generation must never go back, or results cached by other
+    // processes could be reused: keep it, and increment it. A database
+    // without one, like after disappear(), starts from the current time in
+    // microseconds, beyond what any earlier database can have reached
+    std::string generation = m_driver->write_generation();
     disappear();
     m_driver->create_tables_v7();
+    if (generation.empty())
+        generation = std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count());
+    conn->set_setting("write_generation", generation);
+    m_driver->bump_write_generation();
+    data_changed();
 
     // Populate the tables with values
     auto tr = dynamic_pointer_cast<db::Transaction>(transaction());
@@ -99,7 +121,25 @@ void DB::vacuum()
     auto trc = trace->trace_vacuum();
     auto t = conn->transaction();
     driver().vacuum_v7();
+    driver().bump_write_generation();
+    t->commit();
+    data_changed();
+}
+
+void DB::remove_data_before(const Datetime& before)
+{
+    auto trc = trace->trace_remove_data_before();
+    auto t = conn->transaction();
+    driver().remove_data_before_v7(before);
+    driver().bump_write_generation();
     t->commit();
+    data_changed();
+}
+
+void DB::data_changed()
+{
+    if (query_cache)
+        query_cache->clear();
 }
 
 }
@@ -26,6 +26,22 @@ public:
     Trace* trace = nullptr;
     /// True if we print an EXPLAIN trace of all queries to stderr
     bool explain_queries = false;
+    /**
+     * Cache of station and summary query results, or nullptr if query
+     * results are not cached.
+     *
+     * It is enabled by setting DBA_DB_QUERY_CACHE to the maximum number of
+     * results to keep for each kind of query, and it can be shared by
+     * connections to the same database, like those pooled by db::Server.
+     */
+    std::shared_ptr<cursor::QueryCache> query_cache;
+    /**
+     * Number of bytes of query results that each cursor keeps in memory
+     * before moving them to a temporary file.
+     *
+     * It can be set with DBA_DB_CURSOR_MEMORY, in megabytes.
+     */
+    size_t cursor_memory = 64 * 1024 * 1024;
 
 protected:
     /// SQL driver backend
@@ -76,6 +92,17 @@ public:
      */
     void vacuum();
 
+    void remove_data_before(const Datetime& before) override;
+
+    /**
+     * Notify that the contents of the database have changed, after the
+     * changes have been committed.
+     *
+     * This discards cached query results. The write generation of the
+     * database has already been incremented by the committed transaction.
+     */
+    void data_changed();
+
     friend class dballe::DB;
     friend class dballe::db::v7::Transaction;
 };
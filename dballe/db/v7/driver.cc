@@ -2,6 +2,8 @@
 #include "config.h"
 #include "dballe/db/v7/sqlite/driver.h"
 #include "dballe/sql/sqlite.h"
+#include "dballe/sql/querybuf.h"
+#include "dballe/core/query.h"
 #ifdef HAVE_LIBPQ
 #include "dballe/db/v7/postgresql/driver.h"
 #include "dballe/sql/postgresql.h"
@@ -64,6 +66,49 @@ void Driver::remove_all_v7()
     connection.execute("DELETE FROM station");
 }
 
+void Driver::remove_data_before_v7(const Datetime& before)
+{
+    dballe::sql::Querybuf q;
+    q.append("DELETE FROM data WHERE datetime < ");
+    connection.add_datetime(q, before);
+    connection.execute(q);
+}
+
+std::string Driver::write_generation()
+{
+    return connection.get_setting("write_generation");
+}
+
+void Driver::bump_write_generation()
+{
+    std::string cur = connection.get_setting("write_generation");
+    connection.set_setting("write_generation", std::to_string(cur.empty() ? 1 : std::stoull(cur) + 1));
+}
+
+void Driver::add_station_area_where(v7::QueryBuilder& qb, const char* tbl)
+{
+}
+
+bool Driver::station_area(const core::Query& query, int& latmin, int& latmax, int& lonmin, int& lonmax)
+{
+    if (query.latrange.is_missing() && query.lonrange.is_missing())
+        return false;
+
+    latmin = query.latrange.imin;
+    latmax = query.latrange.imax;
+    if (query.lonrange.is_missing())
+    {
+        lonmin = -18000000;
+        lonmax = 18000000;
+    } else {
+        if (query.lonrange.imin > query.lonrange.imax)
+            return false;
+        lonmin = query.lonrange.imin;
+        lonmax = query.lonrange.imax;
+    }
+    return true;
+}
+
 std::unique_ptr<Driver> Driver::create(dballe::sql::Connection& conn)
 {
     using namespace dballe::sql;
@@ -9,6 +9,7 @@
 #include <wreport/var.h>
 #include <memory>
 #include <functional>
+#include <string>
 #include <vector>
 #include <cstdio>
 
@@ -60,8 +61,48 @@ public:
     /// Perform database cleanup/maintenance on v7 databases
     virtual void vacuum_v7() = 0;
 
+    /// Delete all the data with datetime before the given one
+    virtual void remove_data_before_v7(const Datetime& before);
+
+    /**
+     * Read the write generation of the database, which changes every time
+     * that changes to its contents are committed.
+     *
+     * Returns an empty string if the database has never been written to.
+     */
+    virtual std::string write_generation();
+
+    /**
+     * Increment the write generation of the database.
+     *
+     * This is called in the transaction that changes the data, just before
+     * committing it, so that the new generation becomes visible together
+     * with the changes.
+     */
+    virtual void bump_write_generation();
+
+    /**
+     * If the database has a spatial index on stations, add to the WHERE
+     * clause of qb a condition on the station table tbl that uses it to look
+     * up the area selected by the query.
+     *
+     * The exact latitude and longitude conditions are still added by the
+     * query builder: this only helps the database find candidate stations.
+     */
+    virtual void add_station_area_where(v7::QueryBuilder& qb, const char* tbl);
+
     /// Create a Driver for this connection
     static std::unique_ptr<Driver> create(dballe::sql::Connection& conn);
+
+protected:
+    /**
+     * Compute the latitude and longitude area selected by query, in the
+     * integer units used by the station table.
+     *
+     * Returns false if query does not select an area, or if the longitude
+     * range wraps around the antimeridian.
+     */
+    static bool station_area(const core::Query& query, int& latmin, int& latmax, int& lonmin, int& lonmax);
 };
 
 }
@@ -110,6 +110,7 @@ struct Cursor : public impl::CursorMessage
 
 std::shared_ptr<dballe::CursorMessage> Transaction::query_messages(const Query& query)
 {
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_export_msgs(query) : nullptr);
     v7::LevTr& lt = levtr();
 
@@ -126,7 +127,7 @@ std::shared_ptr<dballe::CursorMessage> Transaction::query_messages(const Query&
     if (db->explain_queries)
     {
         fprintf(stderr, "EXPLAIN "); query.print(stderr);
-        db->conn->explain(qb.sql_query, stderr);
+        qb.explain(stderr);
     }
 
     // Retrieve results, buffering them locally to avoid performing concurrent
@@ -165,9 +166,10 @@ std::shared_ptr<dballe::CursorMessage> Transaction::query_messages(const Query&
             // Fill in station information
             msg.msg->station_data.merge(station_values);
 
-            // Move variables to contexts
+            // Move variables to contexts, sorting them once at the end
             int last_id_levtr = -1;
             impl::msg::Context* ctx = nullptr;
+            msg.msg->data.defer_sorting();
             for (auto& pvar: msg.vars)
             {
                 if (pvar.id_levtr != last_id_levtr)
@@ -177,6 +179,7 @@ std::shared_ptr<dballe::CursorMessage> Transaction::query_messages(const Query&
                 }
                 ctx->values.set(std::move(pvar.var));
             }
+            msg.msg->data.sort();
             msg.vars.clear();
 
             // Send message to consumer
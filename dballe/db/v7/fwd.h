@@ -24,6 +24,7 @@ struct Stations;
 struct StationData;
 struct Data;
 struct Summary;
+class QueryCache;
 }
 
 namespace batch {
@@ -39,7 +40,9 @@ struct Transaction;
 
 /**
  * Smart pointer for trace::Step objects, which calls done() when going out of
- * scope
+ * scope.
+ *
+ * If the step is not retained by its parent, it is also deleted.
  */
 template<typename Step=trace::Step>
 class Tracer
@@ -47,6 +50,15 @@ class Tracer
 protected:
     Step* step;
 
+    void release()
+    {
+        if (!step) return;
+        step->done();
+        if (!step->is_retained())
+            delete step;
+        step = nullptr;
+    }
+
 public:
     Tracer() : step(nullptr) {}
     Tracer(Step* step) : step(step) {}
@@ -60,16 +72,16 @@ public:
     Tracer& operator=(Tracer&&) = delete;
     ~Tracer()
     {
-        if (step) step->done();
+        release();
     }
     void reset(Step* step)
     {
+        release();
         this->step = step;
     }
     void done()
     {
-        if (step) step->done();
-        step = nullptr;
+        release();
     }
     Step* operator->() { return step; }
     operator bool() const { return step; }
@@ -93,6 +93,9 @@ void Transaction::add_msg_to_batch(Tracer<>& trc, const Message& message, const
 
 void Transaction::import_message(const dballe::Message& message, const dballe::DBImportOptions& opts)
 {
+    modified = true;
+    write_deferred();
+
     Tracer<> trc(this->trc ? this->trc->trace_import(1) : nullptr);
 
     batch.set_write_attrs(opts.import_attributes);
@@ -105,10 +108,33 @@ void Transaction::import_message(const dballe::Message& message, const dballe::D
 
 void Transaction::import_messages(const std::vector<std::shared_ptr<dballe::Message>>& messages, const dballe::DBImportOptions& opts)
 {
+    modified = true;
+    write_deferred();
+
     Tracer<> trc(this->trc ? this->trc->trace_import(messages.size()) : nullptr);
 
     batch.set_write_attrs(opts.import_attributes);
 
+    // Look up all the stations and datetimes together, so that backends can
+    // avoid one round trip to the database for each
+    if (messages.size() > 1)
+    {
+        std::vector<std::pair<dballe::DBStation, Datetime>> keys;
+        keys.reserve(messages.size());
+        for (const auto& i: messages)
+        {
+            const impl::Message& msg = impl::Message::downcast(*i);
+            dballe::DBStation station;
+            station.coords = msg.get_coords();
+            if (station.coords.is_missing())
+                continue;
+            station.report = opts.report.empty() ? msg.get_report() : opts.report;
+            station.ident = msg.get_ident();
+            keys.emplace_back(station, msg.data.empty() ? Datetime() : msg.get_datetime());
+        }
+        batch.prefetch(trc, keys);
+    }
+
     for (const auto& i: messages)
         add_msg_to_batch(trc, *i, opts);
 
@@ -86,7 +86,7 @@ bool match_attrs(const Varmatch& match, const std::vector<uint8_t>& attrs)
 template<typename Parent>
 void MySQLDataCommon<Parent>::remove(Tracer<>& trc, const v7::IdQueryBuilder& qb)
 {
-    if (qb.bind_in_ident)
+    if (!qb.bind_in.empty())
         throw error_unimplemented("binding in MySQL driver is not implemented");
 
     std::unique_ptr<Varmatch> attr_filter;
@@ -206,7 +206,7 @@ void MySQLStationData::insert(Tracer<>& trc, int id_station, std::vector<batch::
 
 void MySQLStationData::run_station_data_query(Tracer<>& trc, const v7::DataQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_data, std::unique_ptr<wreport::Var> var)> dest)
 {
-    if (qb.bind_in_ident)
+    if (!qb.bind_in.empty())
         throw error_unimplemented("binding in MySQL driver is not implemented");
 
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
@@ -318,7 +318,7 @@ void MySQLData::insert(Tracer<>& trc, int id_station, const Datetime& datetime,
 
 void MySQLData::run_data_query(Tracer<>& trc, const v7::DataQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_levtr, const Datetime& datetime, int id_data, std::unique_ptr<wreport::Var> var)> dest)
 {
-    if (qb.bind_in_ident)
+    if (!qb.bind_in.empty())
         throw error_unimplemented("binding in MySQL driver is not implemented");
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
 
@@ -358,7 +358,7 @@ void MySQLData::run_data_query(Tracer<>& trc, const v7::DataQueryBuilder& qb, st
 
 void MySQLData::run_summary_query(Tracer<>& trc, const v7::SummaryQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_levtr, wreport::Varcode code, const DatetimeRange& datetime, size_t size)> dest)
 {
-    if (qb.bind_in_ident)
+    if (!qb.bind_in.empty())
         throw error_unimplemented("binding in MySQL driver is not implemented");
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
 
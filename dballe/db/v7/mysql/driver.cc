@@ -147,6 +147,15 @@ void Driver::vacuum_v7()
     conn.exec_no_data("DELETE s FROM station s LEFT JOIN data d ON d.id_station = s.id WHERE d.id IS NULL");
 }
 
+void Driver::bump_write_generation()
+{
+    // Increment atomically, since other processes may be doing the same
+    conn.exec_no_data(R"(
+        INSERT INTO dballe_settings (`key`, value) VALUES ('write_generation', '1')
+            ON DUPLICATE KEY UPDATE value=CAST(value AS UNSIGNED) + 1
+    )");
+}
+
 }
 }
 }
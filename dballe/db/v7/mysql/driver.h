@@ -24,6 +24,7 @@ struct Driver : public v7::Driver
     void create_tables_v7() override;
     void delete_tables_v7() override;
     void vacuum_v7() override;
+    void bump_write_generation() override;
 };
 
 }
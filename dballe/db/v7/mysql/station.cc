@@ -198,7 +198,7 @@ void MySQLStation::add_station_vars(Tracer<>& trc, int id_station, DBValues& val
 
 void MySQLStation::run_station_query(Tracer<>& trc, const v7::StationQueryBuilder& qb, std::function<void(const dballe::DBStation&)> dest)
 {
-    if (qb.bind_in_ident)
+    if (!qb.bind_in.empty())
         throw error_unimplemented("binding in MySQL driver is not implemented");
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
 
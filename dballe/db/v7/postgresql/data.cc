@@ -1,4 +1,5 @@
 #include "data.h"
+#include "driver.h"
 #include "dballe/db/v7/transaction.h"
 #include "dballe/db/v7/trace.h"
 #include "dballe/db/v7/batch.h"
@@ -24,6 +25,13 @@ namespace db {
 namespace v7 {
 namespace postgresql {
 
+namespace {
+
+/// First key of the advisory locks serializing the creation of partitions
+const int partition_lock = 0x64626102;
+
+}
+
 template class PostgreSQLDataCommon<StationData>;
 template class PostgreSQLDataCommon<Data>;
 
@@ -114,11 +122,7 @@ void PostgreSQLDataCommon<Parent>::remove(Tracer<>& trc, const v7::IdQueryBuilde
         }
 
         Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
-        Result to_remove;
-        if (qb.bind_in_ident)
-            to_remove = conn.exec(qb.sql_query, qb.bind_in_ident);
-        else
-            to_remove = conn.exec(qb.sql_query);
+        Result to_remove(conn.exec(qb.sql_query, qb.bind_in_strings()));
         if (trc_sel) trc_sel->add_row(to_remove.rowcount());
         trc_sel.done();
         for (unsigned row = 0; row < to_remove.rowcount(); ++row)
@@ -135,12 +139,7 @@ void PostgreSQLDataCommon<Parent>::remove(Tracer<>& trc, const v7::IdQueryBuilde
         dq.append(qb.sql_query);
         dq.append(")");
         Tracer<> trc_del(trc ? trc->trace_delete(dq) : nullptr);
-        if (qb.bind_in_ident)
-        {
-            conn.exec_no_data(dq.c_str(), qb.bind_in_ident);
-        } else {
-            conn.exec_no_data(dq.c_str());
-        }
+        conn.exec_no_data(dq, qb.bind_in_strings());
     }
 }
 
@@ -286,20 +285,8 @@ void PostgreSQLStationData::run_station_data_query(Tracer<>& trc, const v7::Data
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
     using namespace dballe::sql::postgresql;
 
-    // Start the query asynchronously
-    int res;
-    if (qb.bind_in_ident)
-    {
-        const char* args[1] = { qb.bind_in_ident };
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 1, nullptr, args, nullptr, nullptr, 1);
-    } else {
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
-    }
-    if (!res)
-        throw error_postgresql(conn, "executing " + qb.sql_query);
-
     dballe::DBStation station;
-    conn.run_single_row_mode(qb.sql_query, [&](const Result& res) {
+    conn.run_chunked(qb.sql_query, qb.bind_in_strings(), [&](const Result& res) {
         if (trc_sel) trc_sel->add_row(res.rowcount());
         for (unsigned row = 0; row < res.rowcount(); ++row)
         {
@@ -311,7 +298,7 @@ void PostgreSQLStationData::run_station_data_query(Tracer<>& trc, const v7::Data
 
             // Postprocessing filter of attr_filter
             if (qb.attr_filter && !qb.match_attrs(*var))
-                return;
+                continue;
 
             int id_station = res.get_int4(row, 0);
             if (id_station != station.id)
@@ -348,12 +335,38 @@ void PostgreSQLStationData::dump(FILE* out)
 }
 
 
-PostgreSQLData::PostgreSQLData(v7::Transaction& tr, PostgreSQLConnection& conn)
-    : PostgreSQLDataCommon(tr, conn)
+PostgreSQLData::PostgreSQLData(v7::Transaction& tr, PostgreSQLConnection& conn, const std::string& partitioning)
+    : PostgreSQLDataCommon(tr, conn), partitioning(partitioning)
 {
     conn.prepare("datav7_select", "SELECT id, id_levtr, code FROM data WHERE id_station=$1::int4 AND datetime=$2::timestamp");
 }
 
+void PostgreSQLData::ensure_partition(const Datetime& datetime)
+{
+    Datetime begin, end;
+    std::string name = data_partition(partitioning, datetime, begin, end);
+    if (partitions.find(name) != partitions.end())
+        return;
+
+    // Concurrent transactions creating the same partition would both pass
+    // the IF NOT EXISTS check and one would fail on the catalog unique
+    // index: serialize them until the end of the transaction, after which
+    // the partition is visible to the others
+    Querybuf q;
+    q.appendf("SELECT pg_advisory_xact_lock(%d, %d)", partition_lock, begin.year * 100 + begin.month);
+    conn.exec_one_row(q);
+
+    q.clear();
+    q.appendf("CREATE TABLE IF NOT EXISTS %s PARTITION OF data FOR VALUES FROM (", name.c_str());
+    conn.add_datetime(q, begin);
+    q.append(") TO (");
+    conn.add_datetime(q, end);
+    q.append(")");
+
+    conn.exec_no_data(q);
+    partitions.insert(name);
+}
+
 void PostgreSQLData::query(Tracer<>& trc, int id_station, const Datetime& datetime, std::function<void(int id, int id_levtr, wreport::Varcode code)> dest)
 {
     Tracer<> trc_sel(trc ? trc->trace_select("datav7_select") : nullptr);
@@ -368,10 +381,31 @@ void PostgreSQLData::query(Tracer<>& trc, int id_station, const Datetime& dateti
     }
 }
 
+void PostgreSQLData::query_many(Tracer<>& trc, const std::vector<std::pair<int, Datetime>>& keys, std::function<void(size_t idx, int id, int id_levtr, wreport::Varcode code)> dest)
+{
+    Tracer<> trc_sel(trc ? trc->trace_select("datav7_select") : nullptr);
+    Pipeline pipeline(conn, [&](unsigned idx, const Result& existing) {
+        if (trc_sel) trc_sel->add_row(existing.rowcount());
+        for (unsigned row = 0; row < existing.rowcount(); ++row)
+        {
+            int id = existing.get_int4(row, 0);
+            int id_levtr = existing.get_int4(row, 1);
+            wreport::Varcode code = (Varcode)existing.get_int4(row, 2);
+            dest(idx, id, id_levtr, code);
+        }
+    });
+    for (const auto& key: keys)
+        pipeline.send_prepared("datav7_select", key.first, key.second);
+    pipeline.flush();
+}
+
 void PostgreSQLData::insert(Tracer<>& trc, int id_station, const Datetime& datetime, std::vector<batch::MeasuredDatum>& vars, bool with_attrs)
 {
     std::sort(vars.begin(), vars.end());
 
+    if (!partitioning.empty())
+        ensure_partition(datetime);
+
     const Datetime& dt = datetime;
     char val_lead[64];
     snprintf(val_lead, 64, "(DEFAULT,%d,'%04d-%02d-%02d %02d:%02d:%02d',",
@@ -431,20 +465,8 @@ void PostgreSQLData::run_data_query(Tracer<>& trc, const v7::DataQueryBuilder& q
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
     using namespace dballe::sql::postgresql;
 
-    // Start the query asynchronously
-    int res;
-    if (qb.bind_in_ident)
-    {
-        const char* args[1] = { qb.bind_in_ident };
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 1, nullptr, args, nullptr, nullptr, 1);
-    } else {
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
-    }
-    if (!res)
-        throw error_postgresql(conn, "executing " + qb.sql_query);
-
     dballe::DBStation station;
-    conn.run_single_row_mode(qb.sql_query, [&](const Result& res) {
+    conn.run_chunked(qb.sql_query, qb.bind_in_strings(), [&](const Result& res) {
         if (trc_sel) trc_sel->add_row(res.rowcount());
         for (unsigned row = 0; row < res.rowcount(); ++row)
         {
@@ -456,7 +478,7 @@ void PostgreSQLData::run_data_query(Tracer<>& trc, const v7::DataQueryBuilder& q
 
             // Postprocessing filter of attr_filter
             if (qb.attr_filter && !qb.match_attrs(*var))
-                return;
+                continue;
 
             int id_station = res.get_int4(row, 0);
             if (id_station != station.id)
@@ -485,20 +507,8 @@ void PostgreSQLData::run_summary_query(Tracer<>& trc, const v7::SummaryQueryBuil
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
     using namespace dballe::sql::postgresql;
 
-    // Start the query asynchronously
-    int res;
-    if (qb.bind_in_ident)
-    {
-        const char* args[1] = { qb.bind_in_ident };
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 1, nullptr, args, nullptr, nullptr, 1);
-    } else {
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
-    }
-    if (!res)
-        throw error_postgresql(conn, "executing " + qb.sql_query);
-
     dballe::DBStation station;
-    conn.run_single_row_mode(qb.sql_query, [&](const Result& res) {
+    conn.run_chunked(qb.sql_query, qb.bind_in_strings(), [&](const Result& res) {
         if (trc_sel) trc_sel->add_row(res.rowcount());
         // fprintf(stderr, "ST %d vi %d did %d d %d sd %d\n", qb.select_station, qb.select_varinfo, qb.select_data_id, qb.select_data, qb.select_summary_details);
         for (unsigned row = 0; row < res.rowcount(); ++row)
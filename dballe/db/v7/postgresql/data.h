@@ -4,6 +4,8 @@
 #include <dballe/db/v7/data.h>
 #include <dballe/db/v7/cache.h>
 #include <dballe/sql/fwd.h>
+#include <string>
+#include <unordered_set>
 
 namespace dballe {
 namespace db {
@@ -56,12 +58,22 @@ public:
 
 class PostgreSQLData : public PostgreSQLDataCommon<Data>
 {
+protected:
+    /// How the data table is partitioned, or empty if it is not
+    std::string partitioning;
+    /// Partitions known to exist in this transaction
+    std::unordered_set<std::string> partitions;
+
+    /// Make sure that the data table has a partition for datetime
+    void ensure_partition(const Datetime& datetime);
+
 public:
     using PostgreSQLDataCommon::PostgreSQLDataCommon;
 
-    PostgreSQLData(v7::Transaction& tr, dballe::sql::PostgreSQLConnection& conn);
+    PostgreSQLData(v7::Transaction& tr, dballe::sql::PostgreSQLConnection& conn, const std::string& partitioning=std::string());
 
     void query(Tracer<>& trc, int id_station, const Datetime& datetime, std::function<void(int id, int id_levtr, wreport::Varcode code)> dest) override;
+    void query_many(Tracer<>& trc, const std::vector<std::pair<int, Datetime>>& keys, std::function<void(size_t idx, int id, int id_levtr, wreport::Varcode code)> dest) override;
     void insert(Tracer<>& trc, int id_station, const Datetime& datetime, std::vector<batch::MeasuredDatum>& vars, bool with_attrs) override;
     void run_data_query(Tracer<>& trc, const v7::DataQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_levtr, const Datetime& datetime, int id_data, std::unique_ptr<wreport::Var> var)>) override;
     void run_summary_query(Tracer<>& trc, const v7::SummaryQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_levtr, wreport::Varcode code, const DatetimeRange& datetime, size_t size)>) override;
@@ -0,0 +1,194 @@
+#include "dballe/db/tests.h"
+#include "dballe/db/v7/db.h"
+#include "dballe/db/v7/transaction.h"
+#include "dballe/db/v7/postgresql/driver.h"
+#include "dballe/sql/postgresql.h"
+#include "config.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace dballe;
+using namespace dballe::db;
+using namespace dballe::tests;
+using namespace wreport;
+using namespace std;
+
+namespace {
+
+/// Database with the data table partitioned by month
+struct Fixture : public DBFixture<V7DB>
+{
+    using DBFixture::DBFixture;
+
+    void create_db() override
+    {
+        setenv("DBA_DB_PARTITIONING", "month", 1);
+        try {
+            DBFixture::create_db();
+        } catch (...) {
+            unsetenv("DBA_DB_PARTITIONING");
+            throw;
+        }
+        unsetenv("DBA_DB_PARTITIONING");
+    }
+
+    v7::postgresql::Driver& driver()
+    {
+        return dynamic_cast<v7::postgresql::Driver&>(db->driver());
+    }
+
+    /// List the partitions of the data table
+    std::vector<std::string> partitions()
+    {
+        using namespace dballe::sql::postgresql;
+        Result res(driver().conn.exec(R"(
+            SELECT c.relname
+              FROM pg_inherits i
+              JOIN pg_class c ON c.oid = i.inhrelid
+             WHERE i.inhparent = 'data'::regclass
+          ORDER BY c.relname
+        )"));
+        std::vector<std::string> names;
+        for (unsigned row = 0; row < res.rowcount(); ++row)
+            names.push_back(res.get_string(row, 0));
+        return names;
+    }
+
+    /// Insert a temperature value for a synop station at the given time
+    void insert(const Datetime& dt, double val=280.0)
+    {
+        core::Data vals;
+        vals.station.report = "synop";
+        vals.station.coords = Coords(44.5, 11.3);
+        vals.level = Level(1);
+        vals.trange = Trange::instant();
+        vals.datetime = dt;
+        vals.values.set("B12101", val);
+        db->insert_data(vals);
+    }
+
+    /// Count the values in the given datetime range
+    int count(const Datetime& min=Datetime(), const Datetime& max=Datetime())
+    {
+        core::Query q;
+        q.datetime = DatetimeRange(min, max);
+        return db->query_data(q)->remaining();
+    }
+};
+
+class Tests : public FixtureTestCase<Fixture>
+{
+    using FixtureTestCase::FixtureTestCase;
+
+    void register_tests() override
+    {
+        add_method("data_partition", [](Fixture& f) {
+            Datetime begin, end;
+            wassert(actual(v7::postgresql::data_partition("year", Datetime(2017, 6, 15, 12), begin, end)) == "data_y2017");
+            wassert(actual(begin) == Datetime(2017));
+            wassert(actual(end) == Datetime(2018));
+
+            wassert(actual(v7::postgresql::data_partition("month", Datetime(2017, 6, 15, 12), begin, end)) == "data_m201706");
+            wassert(actual(begin) == Datetime(2017, 6));
+            wassert(actual(end) == Datetime(2017, 7));
+
+            wassert(actual(v7::postgresql::data_partition("month", Datetime(2017, 12, 31, 23, 59, 59), begin, end)) == "data_m201712");
+            wassert(actual(begin) == Datetime(2017, 12));
+            wassert(actual(end) == Datetime(2018));
+
+            wassert_throws(wreport::error_consistency, v7::postgresql::data_partition("week", Datetime(2017), begin, end));
+        });
+
+        add_method("setting", [](Fixture& f) {
+            // The partitioning chosen at creation is stored in the database
+            wassert(actual(f.driver().data_partitioning()) == "month");
+            wassert(actual(f.driver().conn.get_setting("partitioning")) == "month");
+
+            // It is read back by new connections, regardless of the
+            // environment
+            auto db = V7DB::create_db(f.backend, false);
+            wassert(actual(dynamic_cast<v7::postgresql::Driver&>(db->driver()).data_partitioning()) == "month");
+        });
+
+        add_method("insert", [](Fixture& f) {
+            // Partitions are created as data is inserted
+            wassert(f.insert(Datetime(2017, 1, 15, 12)));
+            wassert(f.insert(Datetime(2017, 6, 30, 23, 59, 59)));
+            wassert(f.insert(Datetime(2017, 7, 1)));
+            auto names = f.partitions();
+            wassert_true(std::find(names.begin(), names.end(), "data_m201701") != names.end());
+            wassert_true(std::find(names.begin(), names.end(), "data_m201706") != names.end());
+            wassert_true(std::find(names.begin(), names.end(), "data_m201707") != names.end());
+
+            // Inserting again in an existing partition works, also from a
+            // new transaction that has not seen it yet
+            wassert(f.insert(Datetime(2017, 1, 20, 12)));
+            wassert(actual(f.count()) == 4);
+        });
+
+        add_method("query", [](Fixture& f) {
+            // Queries can span multiple partitions
+            wassert(f.insert(Datetime(2016, 12, 31, 12), 270.0));
+            wassert(f.insert(Datetime(2017, 1, 1, 0), 271.0));
+            wassert(f.insert(Datetime(2017, 2, 15, 12), 272.0));
+            wassert(f.insert(Datetime(2017, 3, 15, 12), 273.0));
+
+            wassert(actual(f.count()) == 4);
+            wassert(actual(f.count(Datetime(2016, 12, 31), Datetime(2017, 2, 28))) == 3);
+            wassert(actual(f.count(Datetime(2017, 1, 1), Datetime(2017, 1, 1))) == 1);
+            wassert(actual(f.count(Datetime(2017, 4, 1), Datetime(2017, 12, 31))) == 0);
+
+            // Values and rows match the partition they come from
+            core::Query q;
+            q.datetime = DatetimeRange(Datetime(2017, 2, 1), Datetime(2017, 2, 28));
+            auto cur = f.db->query_data(q);
+            wassert(actual(cur->next()).istrue());
+            wassert(actual(cur->get_datetime()) == Datetime(2017, 2, 15, 12));
+            wassert(actual(cur->get_var().enqd()) == 272.0);
+            wassert(actual(cur->next()).isfalse());
+
+            // Summaries include all partitions
+            auto summary = f.db->query_summary(core::Query());
+            wassert(actual(summary->next()).istrue());
+            wassert(actual(summary->get_count()) == 4u);
+            wassert(actual(summary->get_datetimerange().min) == Datetime(2016, 12, 31, 12));
+            wassert(actual(summary->get_datetimerange().max) == Datetime(2017, 3, 15, 12));
+        });
+
+        add_method("remove_data_before", [](Fixture& f) {
+            wassert(f.insert(Datetime(2017, 1, 15, 12)));
+            wassert(f.insert(Datetime(2017, 5, 31, 23, 59, 59)));
+            wassert(f.insert(Datetime(2017, 6, 10, 12)));
+            wassert(f.insert(Datetime(2017, 6, 15)));
+            wassert(f.insert(Datetime(2017, 6, 20, 12)));
+            wassert(f.insert(Datetime(2017, 7, 15, 12)));
+
+            // Partitions entirely before the cutoff are dropped, and the one
+            // containing the cutoff is only partly deleted
+            wassert(f.db->remove_data_before(Datetime(2017, 6, 15)));
+            auto names = f.partitions();
+            wassert_true(std::find(names.begin(), names.end(), "data_m201701") == names.end());
+            wassert_true(std::find(names.begin(), names.end(), "data_m201705") == names.end());
+            wassert_true(std::find(names.begin(), names.end(), "data_m201706") != names.end());
+            wassert_true(std::find(names.begin(), names.end(), "data_m201707") != names.end());
+            wassert(actual(f.count()) == 3);
+            wassert(actual(f.count(Datetime(2017, 6, 1), Datetime(2017, 6, 30))) == 2);
+            wassert(actual(f.count(Datetime(2017, 6, 15), Datetime(2017, 6, 15))) == 1);
+
+            // A cutoff at the end of a partition drops it entirely
+            wassert(f.db->remove_data_before(Datetime(2017, 7, 1)));
+            names = f.partitions();
+            wassert_true(std::find(names.begin(), names.end(), "data_m201706") == names.end());
+            wassert_true(std::find(names.begin(), names.end(), "data_m201707") != names.end());
+            wassert(actual(f.count()) == 1);
+
+            // Data can be inserted again in the period of a dropped partition
+            wassert(f.insert(Datetime(2017, 6, 20, 12)));
+            wassert(actual(f.count()) == 2);
+        });
+    }
+};
+
+Tests tg("db_v7_postgresql_driver", "POSTGRESQL");
+
+}
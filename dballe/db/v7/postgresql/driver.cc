@@ -10,17 +10,59 @@
 #include "dballe/var.h"
 #include <algorithm>
 #include <cstring>
+#include <cstdlib>
+#include <cstdio>
 
 using namespace std;
 using namespace wreport;
 using dballe::sql::PostgreSQLConnection;
 using dballe::sql::error_postgresql;
+using dballe::sql::postgresql::Result;
+using dballe::sql::Querybuf;
 
 namespace dballe {
 namespace db {
 namespace v7 {
 namespace postgresql {
 
+namespace {
+
+/// First key of the advisory locks owning write generation counters
+const int write_slot_lock = 0x64626101;
+
+/// Read the partitioning to use for new databases from the environment
+std::string partitioning_from_env()
+{
+    const char* val = getenv("DBA_DB_PARTITIONING");
+    if (!val || !*val)
+        return std::string();
+    if (strcmp(val, "year") == 0 || strcmp(val, "month") == 0)
+        return val;
+    error_consistency::throwf("DBA_DB_PARTITIONING is %s but it should be year or month", val);
+}
+
+}
+
+std::string data_partition(const std::string& partitioning, const Datetime& dt, Datetime& begin, Datetime& end)
+{
+    char name[32];
+    if (partitioning == "year")
+    {
+        begin = Datetime(dt.year);
+        end = Datetime(dt.year + 1);
+        snprintf(name, 32, "data_y%04hu", dt.year);
+    } else if (partitioning == "month") {
+        begin = Datetime(dt.year, dt.month);
+        if (dt.month == 12)
+            end = Datetime(dt.year + 1);
+        else
+            end = Datetime(dt.year, dt.month + 1);
+        snprintf(name, 32, "data_m%04hu%02hhu", dt.year, dt.month);
+    } else
+        error_consistency::throwf("unsupported data partitioning '%s'", partitioning.c_str());
+    return name;
+}
+
 Driver::Driver(PostgreSQLConnection& conn)
     : v7::Driver(conn), conn(conn)
 {
@@ -52,7 +94,17 @@ std::unique_ptr<v7::StationData> Driver::create_station_data(v7::Transaction& tr
 
 std::unique_ptr<v7::Data> Driver::create_data(v7::Transaction& tr)
 {
-    return unique_ptr<v7::Data>(new PostgreSQLData(tr, conn));
+    return unique_ptr<v7::Data>(new PostgreSQLData(tr, conn, data_partitioning()));
+}
+
+const std::string& Driver::data_partitioning()
+{
+    if (!partitioning_loaded)
+    {
+        partitioning = conn.get_setting("partitioning");
+        partitioning_loaded = true;
+    }
+    return partitioning;
 }
 
 void Driver::create_tables_v7()
@@ -81,6 +133,8 @@ void Driver::create_tables_v7()
     )");
     conn.exec_no_data("CREATE UNIQUE INDEX pa_uniq ON station(rep, lat, lon, ident);");
     conn.exec_no_data("CREATE INDEX pa_lon ON station(lon);");
+    conn.exec_no_data("CREATE INDEX pa_geo ON station USING GIST (point(lon, lat));");
+    station_gist = 1;
 
     conn.exec_no_data(R"(
         CREATE TABLE levtr (
@@ -107,22 +161,46 @@ void Driver::create_tables_v7()
     )");
     conn.exec_no_data("CREATE UNIQUE INDEX station_data_uniq on station_data(id_station, code);");
 
-    conn.exec_no_data(R"(
-        CREATE TABLE data (
-           id          SERIAL PRIMARY KEY,
-           id_station  INTEGER NOT NULL REFERENCES station (id) ON DELETE CASCADE,
-           id_levtr    INTEGER NOT NULL REFERENCES levtr(id) ON DELETE CASCADE,
-           datetime    TIMESTAMP NOT NULL,
-           code        INTEGER NOT NULL,
-           value       VARCHAR(255) NOT NULL,
-           attrs       BYTEA
-        );
-    )");
+    std::string new_partitioning = partitioning_from_env();
+    if (new_partitioning.empty())
+    {
+        conn.exec_no_data(R"(
+            CREATE TABLE data (
+               id          SERIAL PRIMARY KEY,
+               id_station  INTEGER NOT NULL REFERENCES station (id) ON DELETE CASCADE,
+               id_levtr    INTEGER NOT NULL REFERENCES levtr(id) ON DELETE CASCADE,
+               datetime    TIMESTAMP NOT NULL,
+               code        INTEGER NOT NULL,
+               value       VARCHAR(255) NOT NULL,
+               attrs       BYTEA
+            );
+        )");
+    } else {
+        // Partitions are created by PostgreSQLData::insert when needed. The
+        // primary key of a partitioned table needs to include the partition
+        // key: ids are still unique, since they come from a single sequence
+        conn.exec_no_data(R"(
+            CREATE TABLE data (
+               id          SERIAL,
+               id_station  INTEGER NOT NULL REFERENCES station (id) ON DELETE CASCADE,
+               id_levtr    INTEGER NOT NULL REFERENCES levtr(id) ON DELETE CASCADE,
+               datetime    TIMESTAMP NOT NULL,
+               code        INTEGER NOT NULL,
+               value       VARCHAR(255) NOT NULL,
+               attrs       BYTEA,
+               PRIMARY KEY (id, datetime)
+            ) PARTITION BY RANGE (datetime);
+        )");
+    }
     conn.exec_no_data("CREATE UNIQUE INDEX data_uniq on data(id_station, datetime, id_levtr, code);");
     // When possible, replace with a postgresql 9.5 BRIN index
     conn.exec_no_data("CREATE INDEX data_dt ON data(datetime);");
 
     conn.set_setting("version", "V7");
+    if (!new_partitioning.empty())
+        conn.set_setting("partitioning", new_partitioning);
+    partitioning = new_partitioning;
+    partitioning_loaded = true;
 }
 void Driver::delete_tables_v7()
 {
@@ -132,6 +210,10 @@ void Driver::delete_tables_v7()
     conn.drop_table_if_exists("station");
     conn.drop_table_if_exists("repinfo");
     conn.drop_settings();
+    partitioning.clear();
+    partitioning_loaded = false;
+    station_gist = -1;
+    has_settings = false;
 }
 void Driver::vacuum_v7()
 {
@@ -158,6 +240,106 @@ void Driver::vacuum_v7()
     )");
 }
 
+std::string Driver::write_generation()
+{
+    if (!has_settings)
+    {
+        if (!conn.has_table("dballe_settings"))
+            return std::string();
+        has_settings = true;
+    }
+    auto res = conn.exec_one_row(R"(
+        SELECT SUM(value::bigint) FROM dballe_settings WHERE "key" LIKE 'write_generation%'
+    )");
+    if (res.is_null(0, 0))
+        return std::string();
+    return res.get_string(0, 0);
+}
+
+void Driver::bump_write_generation()
+{
+    // Under REPEATABLE READ, concurrent transactions updating the same row
+    // would fail to serialize, so each connection increments a counter of
+    // its own, and the generation is their sum. Counters are owned through
+    // session advisory locks and reused by later connections, so there are
+    // at most as many as the connections that ever wrote at the same time,
+    // and each of them only grows.
+    if (write_slot == -1)
+    {
+        for (int slot = 0; ; ++slot)
+        {
+            auto res = conn.exec_one_row("SELECT pg_try_advisory_lock(" + std::to_string(write_slot_lock) + ", " + std::to_string(slot) + ")");
+            if (res.get_bool(0, 0))
+            {
+                write_slot = slot;
+                break;
+            }
+        }
+    }
+    conn.exec_no_data(R"(
+        INSERT INTO dballe_settings ("key", value) VALUES ('write_generation/)" + std::to_string(write_slot) + R"(', '1')
+            ON CONFLICT ("key") DO UPDATE SET value=(dballe_settings.value::bigint + 1)::text
+    )");
+}
+
+bool Driver::has_station_gist()
+{
+    if (station_gist == -1)
+        station_gist = conn.has_table("pa_geo");
+    return station_gist;
+}
+
+void Driver::add_station_area_where(v7::QueryBuilder& qb, const char* tbl)
+{
+    int latmin, latmax, lonmin, lonmax;
+    if (!station_area(qb.query, latmin, latmax, lonmin, lonmax))
+        return;
+    if (!has_station_gist())
+        return;
+    Querybuf& q = qb.sql_where;
+    q.append_listf("point(%s.lon, %s.lat) <@ box(point(", tbl, tbl);
+    qb.append_param(q, lonmin);
+    q.append(", ");
+    qb.append_param(q, latmin);
+    q.append("), point(");
+    qb.append_param(q, lonmax);
+    q.append(", ");
+    qb.append_param(q, latmax);
+    q.append("))");
+}
+
+void Driver::remove_data_before_v7(const Datetime& before)
+{
+    if (!data_partitioning().empty())
+    {
+        // Drop all the partitions that only contain data before the cutoff
+        Result res(conn.exec(R"(
+            SELECT c.relname
+              FROM pg_inherits i
+              JOIN pg_class c ON c.oid = i.inhrelid
+             WHERE i.inhparent = 'data'::regclass
+        )"));
+        for (unsigned row = 0; row < res.rowcount(); ++row)
+        {
+            std::string name = res.get_string(row, 0);
+            unsigned short year;
+            unsigned char month = 1;
+            if (sscanf(name.c_str(), "data_y%4hu", &year) != 1
+             && sscanf(name.c_str(), "data_m%4hu%2hhu", &year, &month) != 2)
+                continue;
+            Datetime begin, end;
+            if (data_partition(partitioning, Datetime(year, month), begin, end) != name)
+                continue;
+            if (before < end)
+                continue;
+            conn.exec_no_data("DROP TABLE " + name);
+        }
+    }
+
+    // Delete what is left, which is at most one partition
+    v7::Driver::remove_data_before_v7(before);
+}
+
 }
 }
 }
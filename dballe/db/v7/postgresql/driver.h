@@ -3,14 +3,42 @@
 
 #include <dballe/db/v7/driver.h>
 #include <dballe/sql/fwd.h>
+#include <string>
 
 namespace dballe {
 namespace db {
 namespace v7 {
 namespace postgresql {
 
+/**
+ * Compute the name of the data table partition that contains dt, and the
+ * range of datetimes it holds, as [begin, end).
+ *
+ * partitioning is "year" or "month".
+ */
+std::string data_partition(const std::string& partitioning, const Datetime& dt, Datetime& begin, Datetime& end);
+
 struct Driver : public v7::Driver
 {
+protected:
+    /// Cached value of the "partitioning" setting
+    std::string partitioning;
+    /// True if partitioning has been read from the database
+    bool partitioning_loaded = false;
+    /// Cached result of has_station_gist: -1 if not yet checked
+    int station_gist = -1;
+    /// True if the dballe_settings table is known to exist
+    bool has_settings = false;
+    /**
+     * Write generation counter owned by this connection, or -1 if none has
+     * been acquired yet
+     */
+    int write_slot = -1;
+
+    /// Check if the database has the pa_geo spatial index
+    bool has_station_gist();
+
+public:
     dballe::sql::PostgreSQLConnection& conn;
 
     Driver(dballe::sql::PostgreSQLConnection& conn);
@@ -24,6 +52,16 @@ struct Driver : public v7::Driver
     void create_tables_v7() override;
     void delete_tables_v7() override;
     void vacuum_v7() override;
+    std::string write_generation() override;
+    void bump_write_generation() override;
+    void remove_data_before_v7(const Datetime& before) override;
+    void add_station_area_where(v7::QueryBuilder& qb, const char* tbl) override;
+
+    /**
+     * Return how the data table is partitioned by datetime: "year", "month",
+     * or an empty string if it is not partitioned
+     */
+    const std::string& data_partitioning();
 };
 
 }
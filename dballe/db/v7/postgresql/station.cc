@@ -106,6 +106,39 @@ int PostgreSQLStation::maybe_get_id(Tracer<>& trc, const dballe::DBStation& st)
     }
 }
 
+void PostgreSQLStation::maybe_get_ids(Tracer<>& trc, std::vector<dballe::DBStation>& stations)
+{
+    using namespace dballe::sql::postgresql;
+
+    Tracer<> trc_sel(trc ? trc->trace_select("v7_station_select_many") : nullptr);
+
+    // Resolve report codes first, as it may need to run queries
+    std::vector<int> reps;
+    reps.reserve(stations.size());
+    for (const auto& st: stations)
+        reps.push_back(tr.repinfo().obtain_id(st.report.c_str()));
+
+    Pipeline pipeline(conn, [&](unsigned idx, const Result& res) {
+        unsigned rows = res.rowcount();
+        if (trc_sel) trc_sel->add_row(rows);
+        switch (rows)
+        {
+            case 0: stations[idx].id = MISSING_INT; break;
+            case 1: stations[idx].id = res.get_int4(0, 0); break;
+            default: error_consistency::throwf("select station ID query returned %u results", rows);
+        }
+    });
+    for (unsigned i = 0; i < stations.size(); ++i)
+    {
+        const auto& st = stations[i];
+        if (st.ident.get())
+            pipeline.send_prepared("v7_station_select_mobile", reps[i], st.coords.lat, st.coords.lon, st.ident.get());
+        else
+            pipeline.send_prepared("v7_station_select_fixed", reps[i], st.coords.lat, st.coords.lon);
+    }
+    pipeline.flush();
+}
+
 int PostgreSQLStation::insert_new(Tracer<>& trc, const dballe::DBStation& desc)
 {
     // If no station was found, insert a new one
@@ -155,20 +188,8 @@ void PostgreSQLStation::run_station_query(Tracer<>& trc, const v7::StationQueryB
     using namespace dballe::sql::postgresql;
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
 
-    // Start the query asynchronously
-    int res;
-    if (qb.bind_in_ident)
-    {
-        const char* args[1] = { qb.bind_in_ident };
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 1, nullptr, args, nullptr, nullptr, 1);
-    } else {
-        res = PQsendQueryParams(conn, qb.sql_query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
-    }
-    if (!res)
-        throw sql::error_postgresql(conn, "executing " + qb.sql_query);
-
     dballe::DBStation station;
-    conn.run_single_row_mode(qb.sql_query, [&](const Result& res) {
+    conn.run_chunked(qb.sql_query, qb.bind_in_strings(), [&](const Result& res) {
         if (trc_sel) trc_sel->add_row(res.rowcount());
         for (unsigned row = 0; row < res.rowcount(); ++row)
         {
@@ -36,6 +36,7 @@ public:
 
     DBStation lookup(Tracer<>& trc, int id_station) override;
     int maybe_get_id(Tracer<>& trc, const dballe::DBStation& st) override;
+    void maybe_get_ids(Tracer<>& trc, std::vector<dballe::DBStation>& stations) override;
     int insert_new(Tracer<>& trc, const dballe::DBStation& desc) override;
     void get_station_vars(Tracer<>& trc, int id_station, std::function<void(std::unique_ptr<wreport::Var>)> dest) override;
     void add_station_vars(Tracer<>& trc, int id_station, DBValues& values) override;
@@ -1,5 +1,6 @@
 #include "qbuilder.h"
 #include "transaction.h"
+#include "driver.h"
 #include "dballe/core/defs.h"
 #include "dballe/core/aliases.h"
 #include "dballe/core/query.h"
@@ -7,6 +8,7 @@
 #include "dballe/var.h"
 #include "dballe/db/v7/repinfo.h"
 #include "dballe/sql/sql.h"
+#include "dballe/sql/sqlite.h"
 #include <wreport/var.h>
 #include <regex.h>
 #include <cstring>
@@ -80,35 +82,33 @@ static void parse_value(const char* str, regmatch_t pos, Varinfo info, char* val
     }
 }
 
+static regex_t* compile_filter_regex(const char* pattern, const char* context)
+{
+    regex_t* res = new regex_t;
+    if (int err = regcomp(res, pattern, REG_EXTENDED))
+        throw error_regexp(err, res, context);
+    return res;
+}
+
 static Varinfo decode_data_filter(const std::string& filter, const char** op, const char** val, const char** val1)
 {
-    static regex_t* re_normal = NULL;
-    static regex_t* re_between = NULL;
+    // Compiled the first time they are needed; initialisation of local
+    // statics is thread safe, and so is regexec
+    static regex_t* re_normal = compile_filter_regex("^([^<=>]+)([<=>]+)([^<=>]+)$", "compiling regular expression to match normal filters");
+    static regex_t* re_between = compile_filter_regex("^([^<=>]+)<=([^<=>]+)<=([^<=>]+)$", "compiling regular expression to match 'between' filters");
     regmatch_t matches[4];
 
-    static char oper[5];
-    static char value[255];
-    static char value1[255];
+    // Results are returned in per-thread buffers, so that queries can be
+    // built concurrently by different connections
+    static thread_local char oper[5];
+    static thread_local char value[255];
+    static thread_local char value1[255];
 #if 0
     size_t len = strcspn(filter, "<=>");
     const char* s = filter + len;
 #endif
     Varcode code;
 
-    /* Compile the regular expression if it has not yet been done */
-    if (re_normal == NULL)
-    {
-        re_normal = new regex_t;
-        if (int res = regcomp(re_normal, "^([^<=>]+)([<=>]+)([^<=>]+)$", REG_EXTENDED))
-            throw error_regexp(res, re_normal, "compiling regular expression to match normal filters");
-    }
-    if (re_between == NULL)
-    {
-        re_between = new regex_t;
-        if (int res = regcomp(re_between, "^([^<=>]+)<=([^<=>]+)<=([^<=>]+)$", REG_EXTENDED))
-            throw error_regexp(res, re_between, "compiling regular expression to match 'between' filters");
-    }
-
     int res = regexec(re_normal, filter.c_str(), 4, matches, 0);
     if (res != 0 && res != REG_NOMATCH)
         error_regexp::throwf(res, re_normal, "Trying to parse '%s' as a 'normal' filter", filter.c_str());
@@ -170,24 +170,33 @@ static Varinfo decode_data_filter(const std::string& filter, const char** op, co
 
 struct Constraints
 {
+    QueryBuilder& qb;
     const core::Query& query;
     const char* tbl;
     Querybuf& q;
     bool found;
 
-    Constraints(const core::Query& query, const char* tbl, Querybuf& q)
-        : query(query), tbl(tbl), q(q), found(false) {}
+    Constraints(QueryBuilder& qb, const char* tbl, Querybuf& q)
+        : qb(qb), query(qb.query), tbl(tbl), q(q), found(false) {}
 
     void add_lat()
     {
         if (query.latrange.is_missing()) return;
         if (query.latrange.imin == query.latrange.imax)
-            q.append_listf("%s.lat=%d", tbl, query.latrange.imin);
-        else {
+        {
+            q.append_listf("%s.lat=", tbl);
+            qb.append_param(q, query.latrange.imin);
+        } else {
             if (query.latrange.imin != LatRange::IMIN)
-                q.append_listf("%s.lat>=%d", tbl, query.latrange.imin);
+            {
+                q.append_listf("%s.lat>=", tbl);
+                qb.append_param(q, query.latrange.imin);
+            }
             if (query.latrange.imax != LatRange::IMAX)
-                q.append_listf("%s.lat<=%d", tbl, query.latrange.imax);
+            {
+                q.append_listf("%s.lat<=", tbl);
+                qb.append_param(q, query.latrange.imax);
+            }
         }
         found = true;
     }
@@ -197,12 +206,21 @@ struct Constraints
         if (query.lonrange.is_missing()) return;
 
         if (query.lonrange.imin == query.lonrange.imax)
-            q.append_listf("%s.lon=%d", tbl, query.lonrange.imin);
-        else if (query.lonrange.imin < query.lonrange.imax)
-            q.append_listf("%s.lon>=%d AND %s.lon<=%d", tbl, query.lonrange.imin, tbl, query.lonrange.imax);
-        else
-            q.append_listf("((%s.lon>=%d AND %s.lon<=18000000) OR (%s.lon>=-18000000 AND %s.lon<=%d))",
-                    tbl, query.lonrange.imin, tbl, tbl, tbl, query.lonrange.imax);
+        {
+            q.append_listf("%s.lon=", tbl);
+            qb.append_param(q, query.lonrange.imin);
+        } else if (query.lonrange.imin < query.lonrange.imax) {
+            q.append_listf("%s.lon>=", tbl);
+            qb.append_param(q, query.lonrange.imin);
+            q.appendf(" AND %s.lon<=", tbl);
+            qb.append_param(q, query.lonrange.imax);
+        } else {
+            q.append_listf("((%s.lon>=", tbl);
+            qb.append_param(q, query.lonrange.imin);
+            q.appendf(" AND %s.lon<=18000000) OR (%s.lon>=-18000000 AND %s.lon<=", tbl, tbl, tbl);
+            qb.append_param(q, query.lonrange.imax);
+            q.append("))");
+        }
         found = true;
     }
 
@@ -239,6 +257,121 @@ DataQueryBuilder::~DataQueryBuilder()
     delete attr_filter;
 }
 
+std::string QueryParam::to_string() const
+{
+    switch (type)
+    {
+        case INT: return std::to_string(int_val);
+        case DATETIME: {
+            char buf[32];
+            snprintf(buf, 32, "%04hu-%02hhu-%02hhu %02hhu:%02hhu:%02hhu",
+                    datetime_val.year, datetime_val.month, datetime_val.day,
+                    datetime_val.hour, datetime_val.minute, datetime_val.second);
+            return buf;
+        }
+        case STRING: return string_val;
+    }
+    throw error_consistency("unsupported query parameter type");
+}
+
+void QueryBuilder::bind_in_sqlite(dballe::sql::SQLiteStatement& stm) const
+{
+    for (unsigned i = 0; i < bind_in.size(); ++i)
+    {
+        const QueryParam& p = bind_in[i];
+        switch (p.type)
+        {
+            case QueryParam::INT: stm.bind_val(i + 1, p.int_val); break;
+            case QueryParam::DATETIME: stm.bind_val(i + 1, p.datetime_val); break;
+            case QueryParam::STRING: stm.bind_val(i + 1, p.string_val); break;
+        }
+    }
+}
+
+std::vector<std::string> QueryBuilder::bind_in_strings() const
+{
+    std::vector<std::string> res;
+    res.reserve(bind_in.size());
+    for (const auto& p: bind_in)
+        res.push_back(p.to_string());
+    return res;
+}
+
+void QueryBuilder::explain(FILE* out) const
+{
+#ifdef HAVE_LIBPQ
+    if (dballe::sql::PostgreSQLConnection* c = dynamic_cast<dballe::sql::PostgreSQLConnection*>(&conn))
+    {
+        c->explain(sql_query, bind_in_strings(), out);
+        return;
+    }
+#endif
+    conn.explain(sql_query, out);
+}
+
+void QueryBuilder::append_param(Querybuf& q, int val)
+{
+    switch (conn.server_type)
+    {
+        case ServerType::POSTGRES:
+            bind_in.emplace_back(val);
+            q.appendf("$%u::int4", (unsigned)bind_in.size());
+            break;
+        case ServerType::SQLITE:
+            bind_in.emplace_back(val);
+            q.append("?");
+            break;
+        default:
+            q.append_int(val);
+            break;
+    }
+}
+
+void QueryBuilder::append_param(Querybuf& q, const Datetime& val)
+{
+    switch (conn.server_type)
+    {
+        case ServerType::POSTGRES:
+            bind_in.emplace_back(val);
+            q.appendf("$%u::timestamp", (unsigned)bind_in.size());
+            break;
+        case ServerType::SQLITE:
+            bind_in.emplace_back(val);
+            q.append("?");
+            break;
+        default:
+            conn.add_datetime(q, val);
+            break;
+    }
+}
+
+void QueryBuilder::append_param(Querybuf& q, const char* val)
+{
+    switch (conn.server_type)
+    {
+        case ServerType::POSTGRES:
+            bind_in.emplace_back(val);
+            q.appendf("$%u::text", (unsigned)bind_in.size());
+            break;
+        case ServerType::SQLITE:
+            bind_in.emplace_back(val);
+            q.append("?");
+            break;
+        default:
+#ifdef HAVE_MYSQL
+            if (dballe::sql::MySQLConnection* c = dynamic_cast<dballe::sql::MySQLConnection*>(&conn))
+            {
+                string escaped = c->escape(val);
+                q.append("'");
+                q.append(escaped);
+                q.append("'");
+                break;
+            }
+#endif
+            error_unimplemented::throwf("cannot add string values to %s queries", format_server_type(conn.server_type));
+    }
+}
+
 void QueryBuilder::build()
 {
     build_select();
@@ -299,7 +432,9 @@ bool StationQueryBuilder::build_where()
         case 1:
             sql_where.append_listf("EXISTS(SELECT id FROM data s_stvar"
                                    " WHERE s_stvar.id_station=s.id"
-                                   "   AND s_stvar.code=%d)", *query.varcodes.begin());
+                                   "   AND s_stvar.code=");
+            append_param(sql_where, (int)*query.varcodes.begin());
+            sql_where.append(")");
             has_where = true;
             break;
         default:
@@ -320,7 +455,8 @@ bool StationQueryBuilder::build_where()
             sql_where.append_listf("1=0");
             TRACE("rep_memo %s not found: adding AND 1=0\n", query.report.c_str());
         } else {
-            sql_where.append_listf("s.rep=%d", src_val);
+            sql_where.append_list("s.rep=");
+            append_param(sql_where, src_val);
             TRACE("found rep_memo %s: adding AND s.rep=%d\n", query.report.c_str(), src_val);
         }
         has_where = true;
@@ -523,38 +659,22 @@ void SummaryQueryBuilder::build_order_by()
 
 bool QueryBuilder::add_pa_where(const char* tbl)
 {
-    Constraints c(query, tbl, sql_where);
+    Constraints c(*this, tbl, sql_where);
     if (query.ana_id != MISSING_INT)
     {
-        sql_where.append_listf("%s.id=%d", tbl, query.ana_id);
+        sql_where.append_listf("%s.id=", tbl);
+        append_param(sql_where, query.ana_id);
         c.found = true;
     }
     c.add_lat();
     c.add_lon();
+    tr->db->driver().add_station_area_where(*this, tbl);
     c.add_mobile();
     if (!query.ident.is_missing())
     {
-        if (false) {
-            // This is only here to move the other optional bits into else ifs
-            // that can be compiled out
-            ;
-#ifdef HAVE_LIBPQ
-        } else if (dynamic_cast<dballe::sql::PostgreSQLConnection*>(&conn)) {
-            sql_where.append_listf("%s.ident=$1::text", tbl);
-            bind_in_ident = query.ident.get();
-            TRACE("found ident: adding AND %s.ident=$1::text.  val is %s\n", tbl, query.ident.get());
-#endif
-#ifdef HAVE_MYSQL
-        } else if (dballe::sql::MySQLConnection* c = dynamic_cast<dballe::sql::MySQLConnection*>(&conn)) {
-            string escaped = c->escape(query.ident.get());
-            sql_where.append_listf("%s.ident='%s'", tbl, escaped.c_str());
-            TRACE("found ident: adding AND %s.ident='%s'.  val is %s\n", tbl, escaped.c_str(), query.ident.get());
-#endif
-        } else {
-            sql_where.append_listf("%s.ident=?", tbl);
-            bind_in_ident = query.ident.get();
-            TRACE("found ident: adding AND %s.ident = ?.  val is %s\n", tbl, query.ident.get());
-        }
+        sql_where.append_listf("%s.ident=", tbl);
+        append_param(sql_where, query.ident.get());
+        TRACE("found ident: adding AND %s.ident=(param).  val is %s\n", tbl, query.ident.get());
         c.found = true;
     }
     if (query.block != MISSING_INT)
@@ -613,7 +733,7 @@ bool QueryBuilder::add_dt_where(const char* tbl)
         {
             // Add constraint on the exact date interval
             sql_where.append_listf("%s.datetime=", tbl);
-            conn.add_datetime(sql_where, dtmin);
+            append_param(sql_where, dtmin);
             TRACE("found exact time: adding AND %s.datetime=%04hu-%02hhu-%02hhu%c%02hhu:%02hhu:%02hhu\n",
                     tbl, dtmin.year, dtmin.month, dtmin.day, dtmin.hour, dtmin.minute, dtmin.second);
             found = true;
@@ -624,7 +744,7 @@ bool QueryBuilder::add_dt_where(const char* tbl)
             {
                 // Add constraint on the minimum date interval
                 sql_where.append_listf("%s.datetime>=", tbl);
-                conn.add_datetime(sql_where, dtmin);
+                append_param(sql_where, dtmin);
                 TRACE("found min time: adding AND %s.datetime>=%04hu-%02hhu-%02hhu%c%02hhu:%02hhu:%02hhu\n",
                     tbl, dtmin.year, dtmin.month, dtmin.day, dtmin.hour, dtmin.minute, dtmin.second);
                 found = true;
@@ -632,7 +752,7 @@ bool QueryBuilder::add_dt_where(const char* tbl)
             if (!dtmax.is_missing())
             {
                 sql_where.append_listf("%s.datetime<=", tbl);
-                conn.add_datetime(sql_where, dtmax);
+                append_param(sql_where, dtmax);
                 TRACE("found max time: adding AND %s.datetime<=%04hu-%02hhu-%02hhu%c%02hhu:%02hhu:%02hhu\n",
                     tbl, dtmax.year, dtmax.month, dtmax.day, dtmax.hour, dtmax.minute, dtmax.second);
                 found = true;
@@ -650,37 +770,44 @@ bool QueryBuilder::add_ltr_where(const char* tbl)
     bool found = false;
     if (query.level.ltype1 != MISSING_INT)
     {
-        sql_where.append_listf("%s.ltype1=%d", tbl, query.level.ltype1);
+        sql_where.append_listf("%s.ltype1=", tbl);
+        append_param(sql_where, query.level.ltype1);
         found = true;
     }
     if (query.level.l1 != MISSING_INT)
     {
-        sql_where.append_listf("%s.l1=%d", tbl, query.level.l1);
+        sql_where.append_listf("%s.l1=", tbl);
+        append_param(sql_where, query.level.l1);
         found = true;
     }
     if (query.level.ltype2 != MISSING_INT)
     {
-        sql_where.append_listf("%s.ltype2=%d", tbl, query.level.ltype2);
+        sql_where.append_listf("%s.ltype2=", tbl);
+        append_param(sql_where, query.level.ltype2);
         found = true;
     }
     if (query.level.l2 != MISSING_INT)
     {
-        sql_where.append_listf("%s.l2=%d", tbl, query.level.l2);
+        sql_where.append_listf("%s.l2=", tbl);
+        append_param(sql_where, query.level.l2);
         found = true;
     }
     if (query.trange.pind != MISSING_INT)
     {
-        sql_where.append_listf("%s.pind=%d", tbl, query.trange.pind);
+        sql_where.append_listf("%s.pind=", tbl);
+        append_param(sql_where, query.trange.pind);
         found = true;
     }
     if (query.trange.p1 != MISSING_INT)
     {
-        sql_where.append_listf("%s.p1=%d", tbl, query.trange.p1);
+        sql_where.append_listf("%s.p1=", tbl);
+        append_param(sql_where, query.trange.p1);
         found = true;
     }
     if (query.trange.p2 != MISSING_INT)
     {
-        sql_where.append_listf("%s.p2=%d", tbl, query.trange.p2);
+        sql_where.append_listf("%s.p2=", tbl);
+        append_param(sql_where, query.trange.p2);
         found = true;
     }
     return found;
@@ -694,7 +821,8 @@ bool QueryBuilder::add_varcode_where(const char* tbl)
     {
         case 0: break;
         case 1:
-            sql_where.append_listf("%s.code=%d", tbl, (int)*query.varcodes.begin());
+            sql_where.append_listf("%s.code=", tbl);
+            append_param(sql_where, (int)*query.varcodes.begin());
             TRACE("found b: adding AND %s.code=%d\n", tbl, (int)*query.varcodes.begin());
             found = true;
             break;
@@ -744,7 +872,8 @@ bool QueryBuilder::add_repinfo_where(const char* tbl)
             sql_where.append_listf("1=0");
             TRACE("rep_memo %s not found: adding AND 1=0\n", query.report.c_str());
         } else {
-            sql_where.append_listf("%s.rep=%d", tbl, src_val);
+            sql_where.append_listf("%s.rep=", tbl);
+            append_param(sql_where, src_val);
             TRACE("found rep_memo %s: adding AND %s.rep=%d\n", query.report.c_str(), tbl, (int)src_val);
         }
         found = true;
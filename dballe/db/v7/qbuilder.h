@@ -5,13 +5,41 @@
 #include <dballe/db/v7/db.h>
 #include <dballe/core/query.h>
 #include <regex.h>
+#include <string>
+#include <vector>
 
 namespace dballe {
 struct Varmatch;
 
+namespace sql {
+struct SQLiteStatement;
+}
+
 namespace db {
 namespace v7 {
 
+/// Value bound to an input parameter of a query
+struct QueryParam
+{
+    enum Type {
+        INT,
+        DATETIME,
+        STRING,
+    };
+
+    Type type;
+    int int_val = 0;
+    Datetime datetime_val;
+    std::string string_val;
+
+    QueryParam(int val) : type(INT), int_val(val) {}
+    QueryParam(const Datetime& val) : type(DATETIME), datetime_val(val) {}
+    QueryParam(const char* val) : type(STRING), string_val(val) {}
+
+    /// Format the value as text
+    std::string to_string() const;
+};
+
 /// Build SQL queries for V7 databases
 struct QueryBuilder
 {
@@ -21,12 +49,14 @@ struct QueryBuilder
     std::shared_ptr<v7::Transaction> tr;
 
     /**
-     * If defined, it need to point to the identifier to be used as the only
-     * bound input parameter.
+     * Values bound to the input parameters of the query, in the order in
+     * which they appear in sql_query.
      *
-     * If not defined, there are no bound input parameters in this query
+     * Literal values in the query are added as parameters where the database
+     * connector supports it, so that queries that differ only in their values
+     * have the same SQL text, and can reuse compiled statements.
      */
-    const char* bind_in_ident = nullptr;
+    std::vector<QueryParam> bind_in;
 
     bool select_station = false; // ana_id, lat, lon, ident
 
@@ -64,6 +94,25 @@ struct QueryBuilder
 
     void build();
 
+    /// Bind the values of bind_in to a SQLite statement
+    void bind_in_sqlite(dballe::sql::SQLiteStatement& stm) const;
+
+    /// Format the values of bind_in as text, as PostgreSQL parameters
+    std::vector<std::string> bind_in_strings() const;
+
+    /// Print the query plan of the query to out
+    void explain(FILE* out) const;
+
+    /**
+     * Append to q a placeholder for an input parameter with value val.
+     *
+     * If the database connector does not support input parameters, append
+     * val as a literal instead.
+     */
+    void append_param(dballe::sql::Querybuf& q, int val);
+    void append_param(dballe::sql::Querybuf& q, const Datetime& val);
+    void append_param(dballe::sql::Querybuf& q, const char* val);
+
 protected:
     // Add WHERE conditions
     bool add_pa_where(const char* tbl);
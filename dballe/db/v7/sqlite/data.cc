@@ -113,8 +113,8 @@ void SQLiteDataCommon<Parent>::remove(Tracer<>& trc, const v7::IdQueryBuilder& q
     char query[64];
     snprintf(query, 64, "DELETE FROM %s WHERE id=?", Parent::table_name);
     auto stmd = conn.sqlitestatement(query);
-    auto stm = conn.sqlitestatement(qb.sql_query);
-    if (qb.bind_in_ident) stm->bind_val(1, qb.bind_in_ident);
+    auto stm = conn.cached_sqlitestatement(qb.sql_query);
+    qb.bind_in_sqlite(*stm);
 
     std::unique_ptr<Varmatch> attr_filter;
     if (!qb.query.attr_filter.empty())
@@ -131,6 +131,7 @@ void SQLiteDataCommon<Parent>::remove(Tracer<>& trc, const v7::IdQueryBuilder& q
         stmd->bind_val(1, stm->column_int(0));
         stmd->execute();
     });
+    conn.release_sqlitestatement(move(stm));
 }
 
 template<typename Parent>
@@ -216,9 +217,9 @@ void SQLiteStationData::insert(Tracer<>& trc, int id_station, std::vector<batch:
 void SQLiteStationData::run_station_data_query(Tracer<>& trc, const v7::DataQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_data, std::unique_ptr<wreport::Var> var)> dest)
 {
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
-    auto stm = conn.sqlitestatement(qb.sql_query);
+    auto stm = conn.cached_sqlitestatement(qb.sql_query);
 
-    if (qb.bind_in_ident) stm->bind_val(1, qb.bind_in_ident);
+    qb.bind_in_sqlite(*stm);
 
     dballe::DBStation station;
     stm->execute([&]() {
@@ -250,6 +251,7 @@ void SQLiteStationData::run_station_data_query(Tracer<>& trc, const v7::DataQuer
 
         dest(station, id_data, move(var));
     });
+    conn.release_sqlitestatement(move(stm));
 }
 
 void SQLiteStationData::dump(FILE* out)
@@ -322,9 +324,9 @@ void SQLiteData::insert(Tracer<>& trc, int id_station, const Datetime& datetime,
 void SQLiteData::run_data_query(Tracer<>& trc, const v7::DataQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_levtr, const Datetime& datetime, int id_data, std::unique_ptr<wreport::Var> var)> dest)
 {
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
-    auto stm = conn.sqlitestatement(qb.sql_query);
+    auto stm = conn.cached_sqlitestatement(qb.sql_query);
 
-    if (qb.bind_in_ident) stm->bind_val(1, qb.bind_in_ident);
+    qb.bind_in_sqlite(*stm);
 
     dballe::DBStation station;
     stm->execute([&]() {
@@ -358,14 +360,15 @@ void SQLiteData::run_data_query(Tracer<>& trc, const v7::DataQueryBuilder& qb, s
 
         dest(station, id_levtr, datetime, id_data, move(var));
     });
+    conn.release_sqlitestatement(move(stm));
 }
 
 void SQLiteData::run_summary_query(Tracer<>& trc, const v7::SummaryQueryBuilder& qb, std::function<void(const dballe::DBStation& station, int id_levtr, wreport::Varcode code, const DatetimeRange& datetime, size_t size)> dest)
 {
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
-    auto stm = conn.sqlitestatement(qb.sql_query);
+    auto stm = conn.cached_sqlitestatement(qb.sql_query);
 
-    if (qb.bind_in_ident) stm->bind_val(1, qb.bind_in_ident);
+    qb.bind_in_sqlite(*stm);
 
     dballe::DBStation station;
     stm->execute([&]() {
@@ -396,6 +399,7 @@ void SQLiteData::run_summary_query(Tracer<>& trc, const v7::SummaryQueryBuilder&
 
         dest(station, id_levtr, code, datetime, count);
     });
+    conn.release_sqlitestatement(move(stm));
 }
 
 
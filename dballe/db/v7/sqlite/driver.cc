@@ -83,6 +83,21 @@ void Driver::create_tables_v7()
         CREATE INDEX pa_rep ON station(rep);
         CREATE INDEX pa_lon ON station(lon);
     )");
+    // Index station coordinates, if SQLite has been built with R*Tree
+    // support. Station coordinates never change, so the index only needs
+    // maintaining on insert and delete. The R*Tree stores 32 bit floats, and
+    // rounds bounding boxes outwards, so it can be used as a prefilter
+    station_rtree = sqlite3_compileoption_used("ENABLE_RTREE");
+    if (station_rtree)
+        conn.exec(R"(
+            CREATE VIRTUAL TABLE station_rtree USING rtree(id, minlat, maxlat, minlon, maxlon);
+            CREATE TRIGGER station_rtree_insert AFTER INSERT ON station BEGIN
+                INSERT INTO station_rtree VALUES (new.id, new.lat, new.lat, new.lon, new.lon);
+            END;
+            CREATE TRIGGER station_rtree_delete AFTER DELETE ON station BEGIN
+                DELETE FROM station_rtree WHERE id=old.id;
+            END;
+        )");
     conn.exec(R"(
         CREATE TABLE levtr (
            id         INTEGER PRIMARY KEY,
@@ -129,7 +144,35 @@ void Driver::delete_tables_v7()
     conn.drop_table_if_exists("levtr");
     conn.drop_table_if_exists("repinfo");
     conn.drop_table_if_exists("station");
+    conn.drop_table_if_exists("station_rtree");
     conn.drop_settings();
+    station_rtree = -1;
+}
+
+bool Driver::has_station_rtree()
+{
+    if (station_rtree == -1)
+        station_rtree = conn.has_table("station_rtree");
+    return station_rtree;
+}
+
+void Driver::add_station_area_where(v7::QueryBuilder& qb, const char* tbl)
+{
+    int latmin, latmax, lonmin, lonmax;
+    if (!station_area(qb.query, latmin, latmax, lonmin, lonmax))
+        return;
+    if (!has_station_rtree())
+        return;
+    Querybuf& q = qb.sql_where;
+    q.append_listf("%s.id IN (SELECT id FROM station_rtree WHERE minlat<=", tbl);
+    qb.append_param(q, latmax);
+    q.append(" AND maxlat>=");
+    qb.append_param(q, latmin);
+    q.append(" AND minlon<=");
+    qb.append_param(q, lonmax);
+    q.append(" AND maxlon>=");
+    qb.append_param(q, lonmin);
+    q.append(")");
 }
 void Driver::vacuum_v7()
 {
@@ -156,6 +199,14 @@ void Driver::vacuum_v7()
     )");
 }
 
+void Driver::bump_write_generation()
+{
+    conn.exec(R"(
+        INSERT OR IGNORE INTO dballe_settings ("key", value) VALUES ('write_generation', '0');
+        UPDATE dballe_settings SET value=CAST(value AS INTEGER) + 1 WHERE "key"='write_generation';
+    )");
+}
+
 }
 }
 }
@@ -11,6 +11,14 @@ namespace sqlite {
 
 struct Driver : public v7::Driver
 {
+protected:
+    /// Cached result of has_station_rtree: -1 if not yet checked
+    int station_rtree = -1;
+
+    /// Check if the database has the station_rtree spatial index
+    bool has_station_rtree();
+
+public:
     dballe::sql::SQLiteConnection& conn;
 
     Driver(dballe::sql::SQLiteConnection& conn);
@@ -24,6 +32,8 @@ struct Driver : public v7::Driver
     void create_tables_v7() override;
     void delete_tables_v7() override;
     void vacuum_v7() override;
+    void bump_write_generation() override;
+    void add_station_area_where(v7::QueryBuilder& qb, const char* tbl) override;
 };
 
 }
@@ -129,8 +129,8 @@ int SQLiteStation::insert_new(Tracer<>& trc, const dballe::DBStation& desc)
         istm->bind_val(4, desc.ident.get());
     else
         istm->bind_null_val(4);
+    Tracer<> trc_ins(trc ? trc->trace_insert(insert_query, 1) : nullptr);
     istm->execute();
-    if (trc) trc->trace_insert(insert_query, 1);
     return conn.get_last_insert_id();
 }
 
@@ -186,9 +186,9 @@ void SQLiteStation::add_station_vars(Tracer<>& trc, int id_station, DBValues& va
 void SQLiteStation::run_station_query(Tracer<>& trc, const v7::StationQueryBuilder& qb, std::function<void(const dballe::DBStation&)> dest)
 {
     Tracer<> trc_sel(trc ? trc->trace_select(qb.sql_query) : nullptr);
-    auto stm = conn.sqlitestatement(qb.sql_query);
+    auto stm = conn.cached_sqlitestatement(qb.sql_query);
 
-    if (qb.bind_in_ident) stm->bind_val(1, qb.bind_in_ident);
+    qb.bind_in_sqlite(*stm);
 
     dballe::DBStation station;
     stm->execute([&]() {
@@ -205,6 +205,7 @@ void SQLiteStation::run_station_query(Tracer<>& trc, const v7::StationQueryBuild
 
         dest(station);
     });
+    conn.release_sqlitestatement(move(stm));
 }
 
 void SQLiteStation::_dump(std::function<void(int, int, const Coords& coords, const char* ident)> out)
@@ -19,6 +19,12 @@ Station::~Station()
 {
 }
 
+void Station::maybe_get_ids(Tracer<>& trc, std::vector<dballe::DBStation>& stations)
+{
+    for (auto& st: stations)
+        st.id = maybe_get_id(trc, st);
+}
+
 void Station::dump(FILE* out)
 {
     int count = 0;
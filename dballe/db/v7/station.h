@@ -41,6 +41,14 @@ public:
      */
     virtual int maybe_get_id(Tracer<>& trc, const dballe::DBStation& st) = 0;
 
+    /**
+     * Get the IDs of many stations at once, setting the id of each station to
+     * its database ID, or to MISSING_INT if it does not exist.
+     *
+     * The default implementation calls maybe_get_id for each station.
+     */
+    virtual void maybe_get_ids(Tracer<>& trc, std::vector<dballe::DBStation>& stations);
+
     /**
      * Insert a new station in the database, without checking if it already exists.
      *
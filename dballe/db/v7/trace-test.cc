@@ -1,8 +1,10 @@
 #include "dballe/db/tests.h"
+#include "dballe/db/v7/trace.h"
 
 using namespace std;
 using namespace dballe;
 using namespace dballe::tests;
+using namespace dballe::db::v7;
 
 namespace {
 
@@ -15,6 +17,123 @@ class Tests : public TestCase
 
 void Tests::register_tests()
 {
+
+add_method("histogram", []() {
+    trace::Histogram h;
+    h.add(0);
+    h.add(1);
+    h.add(3);
+    h.add(1000000000000ull);
+    wassert(actual(h.buckets[0].load()) == 1u);
+    wassert(actual(h.buckets[1].load()) == 1u);
+    wassert(actual(h.buckets[2].load()) == 1u);
+    wassert(actual(h.buckets[trace::Histogram::size - 1].load()) == 1u);
+});
+
+add_method("metrics", []() {
+    // Metrics is too big to be allocated on the stack
+    std::unique_ptr<trace::Metrics> pmetrics(new trace::Metrics);
+    trace::Metrics& metrics = *pmetrics;
+    trace::Counter& c = metrics.counter("select", "SELECT 1");
+    wassert(actual(&metrics.counter("select", "SELECT 1")) == &c);
+    wassert(actual(&metrics.counter("select", "SELECT 2")) != &c);
+    wassert(actual(&metrics.counter("select")) != &c);
+
+    c.record(10, 2);
+    c.record(30, 1);
+    wassert(actual(c.count.load()) == 2u);
+    wassert(actual(c.rows.load()) == 3u);
+    wassert(actual(c.usecs.load()) == 40u);
+    wassert(actual(c.max_usecs.load()) == 30u);
+
+    std::stringstream buf;
+    core::JSONWriter writer(buf);
+    metrics.to_json(writer);
+    wassert(actual(buf.str()).contains("SELECT 1"));
+});
+
+add_method("statement_shape", []() {
+    auto shape = [](const std::string& sql) {
+        std::string res;
+        trace::Metrics::statement_shape(sql, res);
+        return res;
+    };
+    wassert(actual(shape("SELECT id FROM station WHERE lat=4450000 AND lon=-1130000 AND ident='a''b'"))
+            == "SELECT id FROM station WHERE lat=? AND lon=? AND ident=?");
+    wassert(actual(shape("SELECT * FROM data WHERE id_var IN (1, 2,3)  LIMIT 100"))
+            == "SELECT * FROM data WHERE id_var IN (?) LIMIT ?");
+    wassert(actual(shape("SELECT * FROM data WHERE id_var IN (1) LIMIT 5"))
+            == "SELECT * FROM data WHERE id_var IN (?) LIMIT ?");
+    wassert(actual(shape("INSERT INTO data (a, b) VALUES (1, 'x'), (2, 'y'),(3, 'z')"))
+            == "INSERT INTO data (a, b) VALUES (?)");
+    wassert(actual(shape("SELECT * FROM data_m201706 WHERE a=$1 AND b=$2 AND c=?"))
+            == "SELECT * FROM data_m201706 WHERE a=? AND b=? AND c=?");
+    wassert(actual(shape("datav7_select")) == "datav7_select");
+
+    // Statements differing only in their values are accounted together
+    std::unique_ptr<trace::Metrics> pmetrics(new trace::Metrics);
+    trace::Metrics& metrics = *pmetrics;
+    trace::Counter& c = metrics.statement("select", "SELECT * FROM data WHERE id IN (1, 2) LIMIT 10");
+    wassert(actual(&metrics.statement("select", "SELECT * FROM data WHERE id IN (3) LIMIT 20")) == &c);
+    wassert(actual(&metrics.statement("select", "SELECT * FROM station WHERE id IN (3) LIMIT 20")) != &c);
+});
+
+add_method("metrics_full", []() {
+    // Metrics is too big to be allocated on the stack
+    std::unique_ptr<trace::Metrics> pmetrics(new trace::Metrics);
+    trace::Metrics& metrics = *pmetrics;
+    for (unsigned i = 0; i < trace::Metrics::max_entries; ++i)
+        metrics.counter("select", std::to_string(i));
+    trace::Counter& c = metrics.counter("select", "overflow");
+    c.record(1, 1);
+    wassert(actual(c.count.load()) == 1u);
+    // Existing entries are still found
+    wassert(actual(&metrics.counter("select", "0")) != &c);
+});
+
+add_method("steps", []() {
+    trace::Counter& c = trace::Metrics::get().counter("select", "trace-test steps");
+    uint64_t count = c.count.load();
+
+    trace::Transaction tr;
+    {
+        Tracer<> sel(tr.trace_select("trace-test steps"));
+        sel->add_row(3);
+    }
+    {
+        Tracer<> sel(tr.trace_select("trace-test steps"));
+        sel->add_row(2);
+    }
+    wassert(actual(c.count.load()) == count + 2);
+
+    // Retained steps are kept in the transaction
+    trace::Aggregate agg = tr.aggregate("select");
+    wassert(actual(agg.count) == 2u);
+    wassert(actual(agg.rows) == 5u);
+
+    tr.clear();
+    wassert(actual(tr.aggregate("select").count) == 0u);
+});
+
+add_method("unretained", []() {
+    trace::Counter& c = trace::Metrics::get().counter("select", "trace-test unretained");
+    uint64_t count = c.count.load();
+
+    MetricsTrace trace;
+    {
+        Tracer<trace::Transaction> tr(trace.trace_transaction());
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            Tracer<> sel(tr->trace_select("trace-test unretained"));
+            sel->add_row();
+        }
+        // Steps are only accounted in metrics
+        wassert(actual(tr->aggregate("select").count) == 0u);
+    }
+    wassert(actual(c.count.load()) == count + 10);
+    wassert(actual(c.rows.load()) >= 10u);
+});
+
 }
 
 }
@@ -2,6 +2,7 @@
 #include "dballe/core/query.h"
 #include <wreport/error.h>
 #include <unistd.h>
+#include <cctype>
 
 using namespace wreport;
 
@@ -68,30 +69,290 @@ std::string format_time_fname(time_t time)
 
 namespace trace {
 
+Histogram::Histogram()
+{
+    for (unsigned i = 0; i < size; ++i)
+        buckets[i] = 0;
+}
+
+void Histogram::add(uint64_t usecs)
+{
+    unsigned idx = 0;
+    while (idx < size - 1 && usecs >= ((uint64_t)1 << idx))
+        ++idx;
+    buckets[idx].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Histogram::to_json(core::JSONWriter& writer) const
+{
+    // Only output up to the last nonempty bucket
+    unsigned last = 0;
+    for (unsigned i = 0; i < size; ++i)
+        if (buckets[i].load(std::memory_order_relaxed))
+            last = i + 1;
+
+    writer.start_list();
+    for (unsigned i = 0; i < last; ++i)
+        writer.add((size_t)buckets[i].load(std::memory_order_relaxed));
+    writer.end_list();
+}
+
+Counter::Counter()
+    : count(0), rows(0), usecs(0), max_usecs(0)
+{
+}
+
+void Counter::record(uint64_t usecs, unsigned rows)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    this->rows.fetch_add(rows, std::memory_order_relaxed);
+    this->usecs.fetch_add(usecs, std::memory_order_relaxed);
+    uint64_t cur_max = max_usecs.load(std::memory_order_relaxed);
+    while (usecs > cur_max && !max_usecs.compare_exchange_weak(cur_max, usecs, std::memory_order_relaxed))
+        ;
+    latency.add(usecs);
+}
+
+void Counter::to_json(core::JSONWriter& writer) const
+{
+    writer.add("count", (size_t)count.load(std::memory_order_relaxed));
+    writer.add("rows", (size_t)rows.load(std::memory_order_relaxed));
+    writer.add("usecs", (size_t)usecs.load(std::memory_order_relaxed));
+    writer.add("max_usecs", (size_t)max_usecs.load(std::memory_order_relaxed));
+    writer.add("latency");
+    latency.to_json(writer);
+}
+
+Metrics::Entry::Entry()
+    : key(0), label(nullptr)
+{
+}
+
+Metrics::~Metrics()
+{
+    for (unsigned i = 0; i < max_entries; ++i)
+        delete entries[i].label.load();
+}
+
+Counter& Metrics::counter(const char* name, const std::string& detail)
+{
+    // FNV-1a hash of name, a separator, and detail
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* c = name; *c; ++c)
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+    hash *= 1099511628211ull;
+    for (char c: detail)
+        hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+    // 0 marks unused entries
+    if (hash == 0) hash = 1;
+
+    unsigned pos = hash % max_entries;
+    for (unsigned i = 0; i < max_entries; ++i, pos = (pos + 1) % max_entries)
+    {
+        Entry& e = entries[pos];
+        uint64_t key = e.key.load(std::memory_order_acquire);
+        if (key == hash)
+            return e.counter;
+        if (key != 0)
+            continue;
+        if (e.key.compare_exchange_strong(key, hash, std::memory_order_acq_rel))
+        {
+            std::string* label = new std::string(name);
+            if (!detail.empty())
+            {
+                *label += " ";
+                *label += detail;
+            }
+            e.label.store(label, std::memory_order_release);
+            return e.counter;
+        }
+        // Another thread claimed the entry in the meantime: check if it
+        // claimed it for the same operation
+        if (key == hash)
+            return e.counter;
+    }
+
+    return other;
+}
+
+Counter& Metrics::statement(const char* name, const std::string& sql)
+{
+    // Reuse the buffer, to avoid allocating memory for each statement
+    thread_local std::string shape;
+    statement_shape(sql, shape);
+    return counter(name, shape);
+}
+
+void Metrics::statement_shape(const std::string& sql, std::string& out)
+{
+    out.clear();
+    // Positions in out of the open parentheses; deeper nesting is not
+    // collapsed
+    static const unsigned max_depth = 16;
+    size_t parens[max_depth];
+    unsigned depth = 0;
+    auto is_ident = [](char c) { return isalnum((unsigned char)c) || c == '_'; };
+    auto add_value = [&]() {
+        // Collapse lists of values into a single placeholder
+        size_t size = out.size();
+        if (size && out[size - 1] == ' ') --size;
+        if (size >= 2 && out[size - 1] == ',' && out[size - 2] == '?')
+        {
+            out.resize(size - 1);
+            return;
+        }
+        out += '?';
+    };
+
+    for (size_t i = 0; i < sql.size(); ++i)
+    {
+        char c = sql[i];
+        if (isspace((unsigned char)c))
+        {
+            // Collapse whitespace into a single space
+            if (!out.empty() && out.back() != ' ' && out.back() != '(')
+                out += ' ';
+        } else if (c == '\'') {
+            // String literal, with '' as escaped quote
+            for (++i; i < sql.size(); ++i)
+                if (sql[i] == '\'')
+                {
+                    if (i + 1 < sql.size() && sql[i + 1] == '\'')
+                        ++i;
+                    else
+                        break;
+                }
+            add_value();
+        } else if ((isdigit((unsigned char)c) || ((c == '$' || c == '.') && i + 1 < sql.size() && isdigit((unsigned char)sql[i + 1])))
+                   && (out.empty() || !is_ident(out.back()))) {
+            // Number or positional placeholder
+            for (++i; i < sql.size() && (isalnum((unsigned char)sql[i]) || sql[i] == '.'); ++i)
+                ;
+            --i;
+            // Fold the sign of negative numbers
+            if (!out.empty() && out.back() == '-')
+            {
+                size_t size = out.size() - 1;
+                if (size && out[size - 1] == ' ') --size;
+                if (size == 0 || (!is_ident(out[size - 1]) && out[size - 1] != ')' && out[size - 1] != '?'))
+                    out.pop_back();
+            }
+            add_value();
+        } else if (c == '?') {
+            add_value();
+        } else if (c == '(') {
+            if (depth < max_depth)
+                parens[depth] = out.size();
+            ++depth;
+            out += c;
+        } else if (c == ')') {
+            if (!out.empty() && out.back() == ' ') out.pop_back();
+            out += c;
+            if (depth == 0) continue;
+            if (--depth >= max_depth) continue;
+            size_t open = parens[depth];
+            // Collapse repeated tuples, as in multi-row VALUES lists
+            size_t len = out.size() - open;
+            size_t sep = open;
+            if (sep && out[sep - 1] == ' ') --sep;
+            if (sep && out[sep - 1] == ',') --sep;
+            else continue;
+            if (sep >= len && out.compare(sep - len, len, out, open, len) == 0)
+                out.resize(sep);
+        } else {
+            if (c == ',' && !out.empty() && out.back() == ' ') out.pop_back();
+            out += c;
+        }
+    }
+    if (!out.empty() && out.back() == ' ') out.pop_back();
+}
+
+void Metrics::to_json(core::JSONWriter& writer) const
+{
+    writer.start_mapping();
+    writer.add("ops");
+    writer.start_list();
+    for (unsigned i = 0; i < max_entries; ++i)
+    {
+        const Entry& e = entries[i];
+        const std::string* label = e.label.load(std::memory_order_acquire);
+        if (!label) continue;
+        writer.start_mapping();
+        writer.add("name", *label);
+        e.counter.to_json(writer);
+        writer.end_mapping();
+    }
+    writer.end_list();
+    if (other.count.load(std::memory_order_relaxed))
+    {
+        writer.add("other");
+        writer.start_mapping();
+        other.to_json(writer);
+        writer.end_mapping();
+    }
+    writer.end_mapping();
+}
+
+void Metrics::print(FILE* out) const
+{
+    std::stringstream json_buf;
+    core::JSONWriter writer(json_buf);
+    to_json(writer);
+    fwrite(json_buf.str().data(), json_buf.str().size(), 1, out);
+    putc('\n', out);
+}
+
+Metrics& Metrics::get()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+
 Step::Step(const std::string& name)
-    : name(name), start(clock())
+    : name(name), start(std::chrono::steady_clock::now())
 {
 }
 
 Step::Step(const std::string& name, const std::string& detail)
-    : name(name), detail(detail), start(clock())
+    : name(name), detail(detail), start(std::chrono::steady_clock::now())
 {
 }
 
 Step::~Step()
 {
-    delete child;
-    delete sibling;
+    clear();
+}
+
+void Step::clear()
+{
+    // Delete children iteratively, to avoid deep recursion on long lists of
+    // siblings
+    Step* s = child;
+    while (s)
+    {
+        Step* next = s->sibling;
+        s->sibling = nullptr;
+        delete s;
+        s = next;
+    }
+    child = nullptr;
+    child_tail = nullptr;
 }
 
 void Step::done()
 {
-    end = clock();
+    end = std::chrono::steady_clock::now();
+    Metrics& metrics = Metrics::get();
+    if (is_statement())
+        metrics.statement(name.c_str(), detail).record(elapsed_usec(), rows);
+    else
+        metrics.counter(name.c_str()).record(elapsed_usec(), rows);
 }
 
 unsigned Step::elapsed_usec() const
 {
-    return (end - start) * 1000000 / CLOCKS_PER_SEC;
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
 }
 
 void Step::to_json(core::JSONWriter& writer) const
@@ -114,22 +375,22 @@ void Step::to_json(core::JSONWriter& writer) const
 
 Tracer<> Transaction::trace_query_stations(const Query& query)
 {
-    return Tracer<>(add_child(new trace::Step("query_stations", query_to_string(query))));
+    return Tracer<>(add_child(new trace::Step("query_stations", retained ? query_to_string(query) : std::string())));
 }
 
 Tracer<> Transaction::trace_query_station_data(const Query& query)
 {
-    return Tracer<>(add_child(new trace::Step("query_station_data", query_to_string(query))));
+    return Tracer<>(add_child(new trace::Step("query_station_data", retained ? query_to_string(query) : std::string())));
 }
 
 Tracer<> Transaction::trace_query_data(const Query& query)
 {
-    return Tracer<>(add_child(new trace::Step("query_data", query_to_string(query))));
+    return Tracer<>(add_child(new trace::Step("query_data", retained ? query_to_string(query) : std::string())));
 }
 
 Tracer<> Transaction::trace_query_summary(const Query& query)
 {
-    return Tracer<>(add_child(new trace::Step("query_summary", query_to_string(query))));
+    return Tracer<>(add_child(new trace::Step("query_summary", retained ? query_to_string(query) : std::string())));
 }
 
 Tracer<> Transaction::trace_import(unsigned count)
@@ -139,7 +400,7 @@ Tracer<> Transaction::trace_import(unsigned count)
 
 Tracer<> Transaction::trace_export_msgs(const Query& query)
 {
-    return Tracer<>(add_child(new trace::Step("export_msgs", query_to_string(query))));
+    return Tracer<>(add_child(new trace::Step("export_msgs", retained ? query_to_string(query) : std::string())));
 }
 
 Tracer<> Transaction::trace_insert_station_data()
@@ -152,6 +413,11 @@ Tracer<> Transaction::trace_insert_data()
     return Tracer<>(add_child(new trace::Step("insert_data")));
 }
 
+Tracer<> Transaction::trace_insert_data_many(unsigned count)
+{
+    return Tracer<>(add_child(new trace::Step("insert_data_many", std::to_string(count))));
+}
+
 Tracer<> Transaction::trace_add_station_vars()
 {
     return Tracer<>(add_child(new trace::Step("insert_data")));
@@ -164,12 +430,12 @@ Tracer<> Transaction::trace_func(const std::string& name)
 
 Tracer<> Transaction::trace_remove_station_data(const Query& query)
 {
-    return Tracer<>(add_child(new trace::Step("remove_station_data", query_to_string(query))));
+    return Tracer<>(add_child(new trace::Step("remove_station_data", retained ? query_to_string(query) : std::string())));
 }
 
 Tracer<> Transaction::trace_remove_data(const Query& query)
 {
-    return Tracer<>(add_child(new trace::Step("remove_data", query_to_string(query))));
+    return Tracer<>(add_child(new trace::Step("remove_data", retained ? query_to_string(query) : std::string())));
 }
 
 Tracer<> Transaction::trace_remove_station_data_by_id(int id)
@@ -185,6 +451,48 @@ Tracer<> Transaction::trace_remove_data_by_id(int id)
 }
 
 
+namespace {
+
+template<typename T>
+T* unretained(T* step)
+{
+    step->set_retained(false);
+    return step;
+}
+
+}
+
+Tracer<> MetricsTrace::trace_connect(const std::string& url)
+{
+    return Tracer<>(unretained(new trace::Step("connect")));
+}
+
+Tracer<> MetricsTrace::trace_reset(const char* repinfo_file)
+{
+    return Tracer<>(unretained(new trace::Step("reset")));
+}
+
+Tracer<trace::Transaction> MetricsTrace::trace_transaction()
+{
+    return Tracer<trace::Transaction>(unretained(new trace::Transaction));
+}
+
+Tracer<> MetricsTrace::trace_remove_all()
+{
+    return Tracer<>(unretained(new trace::Step("remove_all")));
+}
+
+Tracer<> MetricsTrace::trace_vacuum()
+{
+    return Tracer<>(unretained(new trace::Step("vacuum")));
+}
+
+Tracer<> MetricsTrace::trace_remove_data_before()
+{
+    return Tracer<>(unretained(new trace::Step("remove_data_before")));
+}
+
+
 QuietCollectTrace::~QuietCollectTrace()
 {
     for (auto& i: steps)
@@ -222,6 +530,12 @@ Tracer<> QuietCollectTrace::trace_vacuum()
     return Tracer<>(steps.back());
 }
 
+Tracer<> QuietCollectTrace::trace_remove_data_before()
+{
+    steps.push_back(new trace::Step("remove_data_before"));
+    return Tracer<>(steps.back());
+}
+
 
 CollectTrace::CollectTrace(const std::string& logdir)
     : logdir(logdir), start(time(nullptr))
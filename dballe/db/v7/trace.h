@@ -7,6 +7,10 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 
 namespace dballe {
 namespace db {
@@ -18,7 +22,114 @@ struct Aggregate
 {
     unsigned count = 0;
     unsigned rows = 0;
-    clock_t ticks = 0;
+    uint64_t usecs = 0;
+};
+
+
+/**
+ * Histogram of operation latencies.
+ *
+ * Bucket i counts operations that took less than 2**i microseconds; the last
+ * bucket also counts all slower operations.
+ */
+struct Histogram
+{
+    static const unsigned size = 32;
+    std::atomic<uint64_t> buckets[size];
+
+    Histogram();
+
+    void add(uint64_t usecs);
+    void to_json(core::JSONWriter& writer) const;
+};
+
+
+/**
+ * Counters for one kind of operation.
+ *
+ * All counters can be updated concurrently without locking.
+ */
+struct Counter
+{
+    /// Number of times the operation was run
+    std::atomic<uint64_t> count;
+    /// Number of database rows affected
+    std::atomic<uint64_t> rows;
+    /// Total time spent running the operation
+    std::atomic<uint64_t> usecs;
+    /// Longest time spent running the operation
+    std::atomic<uint64_t> max_usecs;
+    /// Latency distribution
+    Histogram latency;
+
+    Counter();
+
+    void record(uint64_t usecs, unsigned rows);
+    void to_json(core::JSONWriter& writer) const;
+};
+
+
+/**
+ * Process-wide aggregated metrics of database operations.
+ *
+ * Operations are identified by the name of their trace Step and, for SQL
+ * statements, by the shape of the statement text, with literal values
+ * replaced by placeholders. They are stored in a fixed-size table,
+ * so that recording is lock-free and does not allocate memory after the first
+ * time an operation is seen. When the table is full, further operations are
+ * accounted together as "other".
+ */
+class Metrics
+{
+public:
+    static const unsigned max_entries = 1024;
+
+    struct Entry
+    {
+        /// Hash of name and detail, or 0 if the entry is unused
+        std::atomic<uint64_t> key;
+        /// Name and detail of the operation, set after key has been claimed
+        std::atomic<const std::string*> label;
+        Counter counter;
+
+        Entry();
+    };
+
+protected:
+    Entry entries[max_entries];
+    Counter other;
+
+public:
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics(Metrics&&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics& operator=(Metrics&&) = delete;
+    ~Metrics();
+
+    /// Get the counter for the given operation, creating it if needed
+    Counter& counter(const char* name, const std::string& detail=std::string());
+
+    /// Get the counter for the given SQL statement, identified by its shape
+    Counter& statement(const char* name, const std::string& sql);
+
+    /**
+     * Compute the shape of a SQL statement, replacing literal values and
+     * placeholders with '?', collapsing lists of values and repeated tuples,
+     * and normalising whitespace.
+     *
+     * Statements that differ only in the values they use have the same shape.
+     */
+    static void statement_shape(const std::string& sql, std::string& out);
+
+    /// Serialize all metrics collected so far
+    void to_json(core::JSONWriter& writer) const;
+
+    /// Print all metrics collected so far as JSON
+    void print(FILE* out) const;
+
+    /// Access the process-wide metrics
+    static Metrics& get();
 };
 
 
@@ -32,6 +143,8 @@ protected:
     Step* parent = nullptr;
     /// First child operation in the operation stack
     Step* child = nullptr;
+    /// Last child operation in the operation stack
+    Step* child_tail = nullptr;
     /// Next sibling operation in the operation stack
     Step* sibling = nullptr;
     /// Operation name
@@ -40,51 +153,49 @@ protected:
     std::string detail;
     /// Number of database rows affected
     unsigned rows = 0;
+    /**
+     * True if the step is kept in its parent after it is done, false if it
+     * is only accounted in Metrics and then deleted by its Tracer
+     */
+    bool retained = true;
     /// Timing start
-    clock_t start = 0;
+    std::chrono::steady_clock::time_point start;
     /// Timing end
-    clock_t end = 0;
+    std::chrono::steady_clock::time_point end;
 
-    template<typename T>
-    void add_sibling(T* step)
+    Step* first_sibling(const std::string& name)
     {
-        if (!sibling)
-        {
-            sibling = step;
-            step->parent = parent;
-        }
-        else
-            sibling->add_sibling(step);
+        for (Step* s = this; s; s = s->sibling)
+            if (s->name == name) return s;
+        return nullptr;
     }
 
-    Step* first_sibling(const std::string& name)
+    Step* last_sibling(const std::string& name)
     {
-        if (this->name == name) return this;
-        if (!sibling) return nullptr;
-        return sibling->first_sibling(name);
+        Step* last = nullptr;
+        for (Step* s = this; s; s = s->sibling)
+            if (s->name == name) last = s;
+        return last;
     }
 
-    Step* last_sibling(const std::string& name, Step* last=nullptr)
+    void _aggregate(const std::string& name, Aggregate& agg)
     {
-        if (this->name == name)
+        for (Step* s = this; s; s = s->sibling)
         {
-            if (!sibling) return this;
-            return sibling->last_sibling(name, this);
+            if (s->name == name)
+            {
+                ++agg.count;
+                agg.rows += s->rows;
+                agg.usecs += s->elapsed_usec();
+            }
+            if (s->child) s->child->_aggregate(name, agg);
         }
-        if (!sibling) return last;
-        return sibling->last_sibling(name, last);
     }
 
-    void _aggregate(const std::string& name, Aggregate& agg)
+    /// Identify SQL statements, which are accounted in Metrics by their shape
+    bool is_statement() const
     {
-        if (this->name == name)
-        {
-            ++agg.count;
-            agg.rows += rows;
-            agg.ticks += end - start;
-        }
-        if (sibling) sibling->_aggregate(name, agg);
-        if (child) child->_aggregate(name, agg);
+        return name == "select" || name == "insert" || name == "update" || name == "delete";
     }
 
 public:
@@ -95,14 +206,26 @@ public:
     void done();
     unsigned elapsed_usec() const;
 
+    /**
+     * Return true if the step is kept in the trace after it is done.
+     *
+     * Steps that are not retained are only accounted in Metrics, and are
+     * deleted by the Tracer that holds them.
+     */
+    bool is_retained() const { return retained; }
+
+    /**
+     * Set whether this step and its children are kept after they are done.
+     *
+     * If set to false, the step and its children are only accounted in
+     * Metrics, and are deleted by their Tracer when done.
+     */
+    void set_retained(bool val) { retained = val; }
+
     void to_json(core::JSONWriter& writer) const;
 
     // Remove all children accumulated so far
-    void clear()
-    {
-        delete child;
-        child = nullptr;
-    }
+    void clear();
 
     Aggregate aggregate(const std::string& name)
     {
@@ -128,13 +251,19 @@ public:
     template<typename T>
     T* add_child(T* step)
     {
-        if (!child)
+        step->parent = this;
+        if (!retained)
         {
-            child = step;
-            step->parent = this;
+            // Children of steps that are not retained are not retained
+            // either, and they are owned by their Tracer
+            step->retained = false;
+            return step;
         }
+        if (!child)
+            child = step;
         else
-            child->add_sibling(step);
+            child_tail->sibling = step;
+        child_tail = step;
         return step;
     }
 
@@ -181,6 +310,7 @@ public:
     Tracer<> trace_export_msgs(const Query& query);
     Tracer<> trace_insert_station_data();
     Tracer<> trace_insert_data();
+    Tracer<> trace_insert_data_many(unsigned count);
     Tracer<> trace_add_station_vars();
     Tracer<> trace_func(const std::string& name);
     Tracer<> trace_remove_station_data(const Query& query);
@@ -200,6 +330,7 @@ struct Trace
     virtual Tracer<trace::Transaction> trace_transaction() = 0;
     virtual Tracer<> trace_remove_all() = 0;
     virtual Tracer<> trace_vacuum() = 0;
+    virtual Tracer<> trace_remove_data_before() = 0;
     virtual void save() = 0;
 
     static bool in_test_suite();
@@ -213,6 +344,22 @@ struct NullTrace : public Trace
     Tracer<trace::Transaction> trace_transaction() override { return Tracer<trace::Transaction>(nullptr); }
     Tracer<> trace_remove_all() override { return Tracer<>(nullptr); }
     Tracer<> trace_vacuum() override { return Tracer<>(nullptr); }
+    Tracer<> trace_remove_data_before() override { return Tracer<>(nullptr); }
+    void save() override {}
+};
+
+/**
+ * Trace that only accounts operations in trace::Metrics, without keeping
+ * them in memory
+ */
+struct MetricsTrace : public Trace
+{
+    Tracer<> trace_connect(const std::string& url) override;
+    Tracer<> trace_reset(const char* repinfo_file=0) override;
+    Tracer<trace::Transaction> trace_transaction() override;
+    Tracer<> trace_remove_all() override;
+    Tracer<> trace_vacuum() override;
+    Tracer<> trace_remove_data_before() override;
     void save() override {}
 };
 
@@ -234,6 +381,7 @@ public:
     Tracer<trace::Transaction> trace_transaction() override;
     Tracer<> trace_remove_all() override;
     Tracer<> trace_vacuum() override;
+    Tracer<> trace_remove_data_before() override;
 
     void save() override {}
 };
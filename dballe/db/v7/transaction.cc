@@ -9,7 +9,9 @@
 #include "trace.h"
 #include "dballe/core/query.h"
 #include "dballe/core/data.h"
+#include "dballe/db/summary_memory.h"
 #include "dballe/sql/sql.h"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
@@ -20,6 +22,23 @@ namespace dballe {
 namespace db {
 namespace v7 {
 
+namespace {
+
+/**
+ * Check if two stations are looked up in the same way by Batch::get_station,
+ * and resolve to the same batch station
+ */
+bool same_batch_station(const dballe::DBStation& a, const dballe::DBStation& b)
+{
+    if (a.coords.is_missing() != b.coords.is_missing())
+        return false;
+    if (a.coords.is_missing())
+        return a.id == b.id;
+    return static_cast<const dballe::Station&>(a) == static_cast<const dballe::Station&>(b);
+}
+
+}
+
 Transaction::Transaction(std::shared_ptr<v7::DB> db, std::unique_ptr<dballe::sql::Transaction> sql_transaction)
     : db(db), sql_transaction(std::move(sql_transaction)), batch(*this), trc(db->trace->trace_transaction())
 {
@@ -68,9 +87,19 @@ v7::Data& Transaction::data()
 void Transaction::commit()
 {
     if (fired) return;
+    write_deferred();
+    if (modified)
+        db->driver().bump_write_generation();
     sql_transaction->commit();
     clear_cached_state();
     fired = true;
+    if (modified)
+        db->data_changed();
+    if (pending_delta)
+    {
+        summary_delta->add(*pending_delta);
+        pending_delta->clear();
+    }
     trc.done();
 }
 
@@ -80,6 +109,8 @@ void Transaction::rollback()
     sql_transaction->rollback();
     clear_cached_state();
     fired = true;
+    if (pending_delta)
+        pending_delta->clear();
     trc.done();
 }
 
@@ -89,6 +120,8 @@ void Transaction::rollback_nothrow() noexcept
     sql_transaction->rollback_nothrow();
     clear_cached_state();
     fired = true;
+    if (pending_delta)
+        pending_delta->clear();
     trc.done();
 }
 
@@ -101,6 +134,8 @@ void Transaction::clear_cached_state()
     station_data().clear_cache();
     data().clear_cache();
     batch.clear();
+    deferred.clear();
+    deferred_count = 0;
 
     // Invalidate all active cursors
     for (auto& c: tracked_cursors)
@@ -117,13 +152,25 @@ Transaction& Transaction::downcast(dballe::db::Transaction& transaction)
 
 void Transaction::remove_all()
 {
+    modified = true;
+    write_deferred();
     auto trc = db->trace->trace_remove_all();
+    std::unique_ptr<summary::Delta> removed;
+    if (pending_delta)
+    {
+        removed.reset(new summary::Delta);
+        record_removed(core::Query(), *removed);
+    }
     db->driver().remove_all_v7(); // TODO: pass trace step
     clear_cached_state();
+    if (removed)
+        pending_delta->add(*removed);
 }
 
 void Transaction::insert_station_data(dballe::Data& vals, const dballe::DBInsertOptions& opts)
 {
+    modified = true;
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_insert_station_data() : nullptr);
     core::Data& data = core::Data::downcast(vals);
     batch::Station* st = batch.get_station(trc, data.station, opts.can_add_stations);
@@ -149,10 +196,13 @@ void Transaction::insert_station_data(dballe::Data& vals, const dballe::DBInsert
 
 void Transaction::insert_data(dballe::Data& vals, const dballe::DBInsertOptions& opts)
 {
+    modified = true;
     core::Data& data = core::Data::downcast(vals);
     if (data.values.empty())
         throw error_notfound("no variables found in input record");
 
+    write_deferred();
+
     Tracer<> trc(this->trc ? this->trc->trace_insert_data() : nullptr);
     batch::Station* st = batch.get_station(trc, data.station, opts.can_add_stations);
 
@@ -184,8 +234,168 @@ void Transaction::insert_data(dballe::Data& vals, const dballe::DBInsertOptions&
     }
 }
 
+void Transaction::insert_data_many(const std::vector<dballe::Data*>& data, const dballe::DBInsertOptions& opts, bool with_ids)
+{
+    modified = true;
+    if (data.empty())
+        return;
+
+    write_deferred();
+
+    Tracer<> trc(this->trc ? this->trc->trace_insert_data_many(data.size()) : nullptr);
+
+    std::vector<core::Data*> records;
+    records.reserve(data.size());
+    bool all_coords = true;
+    for (auto d: data)
+    {
+        core::Data& rec = core::Data::downcast(*d);
+        if (rec.values.empty())
+            throw error_notfound("no variables found in input record");
+        if (rec.level.is_missing())
+            throw std::runtime_error("cannot access measured data with undefined level");
+        if (rec.trange.is_missing())
+            throw std::runtime_error("cannot access measured data with undefined trange");
+        if (rec.station.coords.is_missing())
+            all_coords = false;
+        records.push_back(&rec);
+    }
+
+    // Group records by station, so that each station is written only once.
+    // The sort is stable, so values given more than once for the same
+    // station are still written in order. Stations given by ID cannot be
+    // compared with stations given by coordinates, so in that case the input
+    // order is kept
+    if (all_coords)
+        std::stable_sort(records.begin(), records.end(), [](const core::Data* a, const core::Data* b) {
+            return static_cast<const dballe::Station&>(a->station) < static_cast<const dballe::Station&>(b->station);
+        });
+
+    std::vector<int> levtr_ids(records.size());
+    batch::Station* st = nullptr;
+    size_t group_start = 0;
+
+    // Write the pending values of the current station, and read their IDs
+    auto write_group = [&](size_t group_end) {
+        batch.write_pending(trc);
+        if (!with_ids)
+            return;
+        for (size_t i = group_start; i < group_end; ++i)
+        {
+            core::Data& rec = *records[i];
+            batch::MeasuredData& md = st->get_measured_data(trc, rec.datetime);
+            rec.station.id = st->id;
+            for (auto& v: rec.values)
+            {
+                auto id = md.ids_on_db.find(IdVarcode(levtr_ids[i], v.code()));
+                if (id != md.ids_on_db.end())
+                    v.data_id = id->id;
+            }
+        }
+    };
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        core::Data& rec = *records[i];
+
+        if (i > 0 && !same_batch_station(records[i - 1]->station, rec.station))
+        {
+            write_group(i);
+            group_start = i;
+        }
+
+        st = batch.get_station(trc, rec.station, opts.can_add_stations);
+        batch::MeasuredData& md = st->get_measured_data(trc, rec.datetime);
+        int id_levtr = levtr_ids[i] = levtr().obtain_id(trc, LevTrEntry(rec.level, rec.trange));
+
+        // A value given again for the same variable replaces the previous
+        // one, as it would do with separate calls to insert_data
+        for (auto& v: rec.values)
+            if (md.has_pending(id_levtr, v.code()))
+            {
+                batch.write_pending(trc);
+                break;
+            }
+
+        for (auto& v: rec.values)
+            md.add(id_levtr, v.get(), opts.can_replace ? batch::UPDATE : batch::ERROR);
+    }
+
+    write_group(records.size());
+}
+
+void Transaction::insert_data_deferred(dballe::Data& vals, const dballe::DBInsertOptions& opts)
+{
+    modified = true;
+    core::Data& data = core::Data::downcast(vals);
+    if (data.values.empty())
+        throw error_notfound("no variables found in input record");
+
+    Tracer<> trc(this->trc ? this->trc->trace_func("insert_data_deferred") : nullptr);
+    batch::Station* st = batch.get_station(trc, data.station, opts.can_add_stations);
+
+    batch::MeasuredData& md = st->get_measured_data(trc, data.datetime);
+
+    if (data.level.is_missing())
+        throw std::runtime_error("cannot access measured data with undefined level");
+    if (data.trange.is_missing())
+        throw std::runtime_error("cannot access measured data with undefined trange");
+
+    int id_levtr = levtr().obtain_id(trc, LevTrEntry(data.level, data.trange));
+
+    // If a value is already queued for the same variable, write the queue
+    // first, so that the new value is handled as an update, as it would be
+    // if it had been inserted with insert_data
+    for (auto& i: data.values)
+        if (md.has_pending(id_levtr, i.code()))
+        {
+            write_deferred();
+            break;
+        }
+
+    // Take ownership of the values, so that they outlive the batch entries
+    // that point to them
+    deferred.emplace_back(std::move(data.values));
+    data.values.clear();
+    for (auto& i: deferred.back())
+        md.add(id_levtr, i.get(), opts.can_replace ? batch::UPDATE : batch::ERROR);
+    deferred_count += deferred.back().size();
+}
+
+void Transaction::write_deferred()
+{
+    if (deferred.empty())
+        return;
+    Tracer<> trc(this->trc ? this->trc->trace_func("write_deferred") : nullptr);
+    batch.write_pending(trc);
+    deferred.clear();
+    deferred_count = 0;
+}
+
+void Transaction::read_data_ids(dballe::Data& vals)
+{
+    write_deferred();
+
+    core::Data& data = core::Data::downcast(vals);
+    Tracer<> trc(this->trc ? this->trc->trace_func("read_data_ids") : nullptr);
+    batch::Station* st = batch.get_station(trc, data.station, false);
+    batch::MeasuredData& md = st->get_measured_data(trc, data.datetime);
+    int id_levtr = levtr().obtain_id(trc, LevTrEntry(data.level, data.trange));
+
+    data.station.id = st->id;
+    for (auto& v: data.values)
+    {
+        auto i = md.ids_on_db.find(IdVarcode(id_levtr, v.code()));
+        if (i == md.ids_on_db.end())
+            continue;
+        v.data_id = i->id;
+    }
+}
+
 void Transaction::remove_station_data(const Query& query)
 {
+    modified = true;
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_remove_station_data(query) : nullptr);
     cursor::run_delete_query(trc, dynamic_pointer_cast<v7::Transaction>(shared_from_this()), core::Query::downcast(query), true, db->explain_queries);
     batch.clear();
@@ -193,13 +403,26 @@ void Transaction::remove_station_data(const Query& query)
 
 void Transaction::remove_data(const Query& query)
 {
+    modified = true;
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_remove_data(query) : nullptr);
+    // Record the removed data only once it has been removed successfully
+    std::unique_ptr<summary::Delta> removed;
+    if (pending_delta)
+    {
+        removed.reset(new summary::Delta);
+        record_removed(core::Query::downcast(query), *removed);
+    }
     cursor::run_delete_query(trc, dynamic_pointer_cast<v7::Transaction>(shared_from_this()), core::Query::downcast(query), false, db->explain_queries);
     batch.clear();
+    if (removed)
+        pending_delta->add(*removed);
 }
 
 void Transaction::remove_station_data_by_id(int id)
 {
+    modified = true;
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_remove_station_data_by_id(id) : nullptr);
     station_data().remove_by_id(trc, id);
     batch.clear();
@@ -207,11 +430,34 @@ void Transaction::remove_station_data_by_id(int id)
 
 void Transaction::remove_data_by_id(int id)
 {
+    modified = true;
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_remove_data_by_id(id) : nullptr);
     data().remove_by_id(trc, id);
     batch.clear();
 }
 
+void Transaction::record_removed(const core::Query& query, summary::Delta& dest)
+{
+    if (query.empty())
+    {
+        // Summarise the whole database, instead of going through all the data
+        core::Query details;
+        details.query = "details";
+        auto cur = query_summary(details);
+        while (cur->next())
+            dest.removed.add_cursor(*cur);
+        return;
+    }
+
+    auto cur = query_data(query);
+    while (cur->next())
+    {
+        Datetime dt = cur->get_datetime();
+        dest.removed.add(cur->get_station(), summary::VarDesc(cur->get_level(), cur->get_trange(), cur->get_varcode()), DatetimeRange(dt, dt), 1);
+    }
+}
+
 void Transaction::track_cursor(std::weak_ptr<dballe::Cursor> cursor)
 {
     tracked_cursors.emplace_back(cursor);
@@ -219,6 +465,7 @@ void Transaction::track_cursor(std::weak_ptr<dballe::Cursor> cursor)
 
 std::shared_ptr<dballe::CursorStation> Transaction::query_stations(const Query& query)
 {
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_query_stations(query) : nullptr);
     auto res = cursor::run_station_query(trc, dynamic_pointer_cast<v7::Transaction>(shared_from_this()), core::Query::downcast(query), db->explain_queries);
     track_cursor(res);
@@ -227,6 +474,7 @@ std::shared_ptr<dballe::CursorStation> Transaction::query_stations(const Query&
 
 std::shared_ptr<dballe::CursorStationData> Transaction::query_station_data(const Query& query)
 {
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_query_station_data(query) : nullptr);
     auto res = cursor::run_station_data_query(trc, dynamic_pointer_cast<v7::Transaction>(shared_from_this()), core::Query::downcast(query), db->explain_queries);
     track_cursor(res);
@@ -235,6 +483,7 @@ std::shared_ptr<dballe::CursorStationData> Transaction::query_station_data(const
 
 std::shared_ptr<dballe::CursorData> Transaction::query_data(const Query& query)
 {
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_query_data(query) : nullptr);
     auto res = cursor::run_data_query(trc, dynamic_pointer_cast<v7::Transaction>(shared_from_this()), core::Query::downcast(query), db->explain_queries);
     track_cursor(res);
@@ -243,6 +492,7 @@ std::shared_ptr<dballe::CursorData> Transaction::query_data(const Query& query)
 
 std::shared_ptr<dballe::CursorSummary> Transaction::query_summary(const Query& query)
 {
+    write_deferred();
     Tracer<> trc(this->trc ? this->trc->trace_query_summary(query) : nullptr);
     auto res = cursor::run_summary_query(trc, dynamic_pointer_cast<v7::Transaction>(shared_from_this()), core::Query::downcast(query), db->explain_queries);
     track_cursor(res);
@@ -267,6 +517,7 @@ void Transaction::attr_query_data(int data_id, std::function<void(std::unique_pt
 
 void Transaction::attr_insert_station(int data_id, const Values& attrs)
 {
+    modified = true;
     Tracer<> trc(this->trc ? this->trc->trace_func("attr_insert_station") : nullptr);
     auto& d = station_data();
     d.merge_attrs(trc, data_id, attrs);
@@ -274,6 +525,7 @@ void Transaction::attr_insert_station(int data_id, const Values& attrs)
 
 void Transaction::attr_insert_data(int data_id, const Values& attrs)
 {
+    modified = true;
     Tracer<> trc(this->trc ? this->trc->trace_func("attr_insert_data") : nullptr);
     auto& d = data();
     d.merge_attrs(trc, data_id, attrs);
@@ -281,6 +533,7 @@ void Transaction::attr_insert_data(int data_id, const Values& attrs)
 
 void Transaction::attr_remove_station(int data_id, const db::AttrList& attrs)
 {
+    modified = true;
     Tracer<> trc(this->trc ? this->trc->trace_func("attr_remove_station") : nullptr);
     if (attrs.empty())
     {
@@ -297,6 +550,7 @@ void Transaction::attr_remove_station(int data_id, const db::AttrList& attrs)
 
 void Transaction::attr_remove_data(int data_id, const db::AttrList& attrs)
 {
+    modified = true;
     Tracer<> trc(this->trc ? this->trc->trace_func("attr_remove_data") : nullptr);
     if (attrs.empty())
     {
@@ -313,9 +567,19 @@ void Transaction::attr_remove_data(int data_id, const db::AttrList& attrs)
 
 void Transaction::update_repinfo(const char* repinfo_file, int* added, int* deleted, int* updated)
 { // TODO: tracing
+    modified = true;
     repinfo().update(repinfo_file, added, deleted, updated);
 }
 
+void Transaction::set_summary_delta(std::shared_ptr<summary::Delta> delta)
+{
+    summary_delta = delta;
+    if (!summary_delta)
+        pending_delta.reset();
+    else if (!pending_delta)
+        pending_delta.reset(new summary::Delta);
+}
+
 void Transaction::dump(FILE* out)
 {
     repinfo().dump(out);
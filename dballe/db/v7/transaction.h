@@ -2,6 +2,7 @@
 #define DBALLE_DB_V7_TRANSACTION_H
 
 #include <dballe/db/db.h>
+#include <dballe/values.h>
 #include <dballe/db/v7/fwd.h>
 #include <dballe/db/v7/data.h>
 #include <dballe/db/v7/batch.h>
@@ -29,6 +30,19 @@ protected:
     /// Track active cursors to invalidate them on commit/rollback
     std::vector<std::weak_ptr<dballe::Cursor>> tracked_cursors;
 
+    /// Values queued by insert_data_deferred, referenced by the batch
+    std::vector<DBValues> deferred;
+    /// Number of values in deferred
+    size_t deferred_count = 0;
+
+    /// Where changes are recorded on commit, if set_summary_delta was called
+    std::shared_ptr<summary::Delta> summary_delta;
+    /// Changes made by this transaction, recorded for summary_delta
+    std::unique_ptr<summary::Delta> pending_delta;
+
+    /// Record in dest.removed the data matched by \a query
+    void record_removed(const core::Query& query, summary::Delta& dest);
+
     void add_msg_to_batch(Tracer<>& trc, const Message& message, const dballe::DBImportOptions& opts);
     void track_cursor(std::weak_ptr<dballe::Cursor> cursor);
 
@@ -40,6 +54,8 @@ public:
     std::shared_ptr<dballe::sql::Transaction> sql_transaction;
     /// True if commit or rollback have already been called on this transaction
     bool fired = false;
+    /// True if this transaction has changed the contents of the database
+    bool modified = false;
     /// Batch importer
     v7::Batch batch;
     /// Tracing system
@@ -78,6 +94,33 @@ public:
 
     void insert_station_data(dballe::Data& vals, const dballe::DBInsertOptions& opts=dballe::DBInsertOptions::defaults) override;
     void insert_data(dballe::Data& vals, const dballe::DBInsertOptions& opts=dballe::DBInsertOptions::defaults) override;
+    void insert_data_many(const std::vector<dballe::Data*>& data, const dballe::DBInsertOptions& opts=dballe::DBInsertOptions::defaults, bool with_ids=true) override;
+
+    /**
+     * Queue data for insertion, without writing it to the database yet.
+     *
+     * The values are moved out of vals and kept by the transaction until they
+     * are written, and their database IDs are not set: use read_data_ids
+     * after write_deferred if they are needed.
+     *
+     * Queued data is written by write_deferred, and by all other operations
+     * that read or modify the database, including commit.
+     */
+    void insert_data_deferred(dballe::Data& vals, const dballe::DBInsertOptions& opts=dballe::DBInsertOptions::defaults);
+
+    /// Write all data queued by insert_data_deferred
+    void write_deferred();
+
+    /// Number of values queued by insert_data_deferred and not yet written
+    size_t count_deferred() const { return deferred_count; }
+
+    /**
+     * Set the station ID and the data IDs of the values in vals, looking them
+     * up from data previously inserted with the same station, datetime,
+     * level and time range
+     */
+    void read_data_ids(dballe::Data& vals);
+
     void remove_station_data(const Query& query) override;
     void remove_data(const Query& query) override;
     void remove_station_data_by_id(int id);
@@ -91,6 +134,15 @@ public:
     void import_message(const Message& message, const dballe::DBImportOptions& opts) override;
     void import_messages(const std::vector<std::shared_ptr<Message>>& msgs, const dballe::DBImportOptions& opts) override;
     void update_repinfo(const char* repinfo_file, int* added, int* deleted, int* updated) override;
+    void set_summary_delta(std::shared_ptr<summary::Delta> delta) override;
+
+    /**
+     * Changes made by this transaction and not yet committed, where
+     * additions and removals are recorded when set_summary_delta is used.
+     *
+     * Returns nullptr if changes are not being recorded.
+     */
+    summary::Delta* pending_summary_delta() { return pending_delta.get(); }
 
     static Transaction& downcast(dballe::db::Transaction& transaction);
 
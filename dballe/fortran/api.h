@@ -7,6 +7,39 @@
 namespace dballe {
 namespace fortran {
 
+/**
+ * Caller-supplied arrays filled by API::next_data_many.
+ *
+ * Each array has room for the number of rows requested, and row \a i is
+ * stored at index \a i, or at index \a i * N for arrays with N values per
+ * row. Arrays set to nullptr are not filled.
+ *
+ * Missing values are set to API::missing_int or API::missing_double.
+ */
+struct DataArrays
+{
+    /// Station ID
+    int* ana_id = nullptr;
+    /// Station latitude
+    double* lat = nullptr;
+    /// Station longitude
+    double* lon = nullptr;
+    /// Year, month, day, hour, minute, second
+    int* datetime = nullptr;
+    /// ltype1, l1, ltype2, l2
+    int* level = nullptr;
+    /// pind, p1, p2
+    int* trange = nullptr;
+    /// Varcode, as the integer FXXYYY (for example, 12101 for B12101)
+    int* varcode = nullptr;
+    /// Value, left missing for string variables
+    double* value = nullptr;
+    /// Attribute to read into attr
+    wreport::Varcode attr_code = 0;
+    /// Value of the attribute attr_code
+    double* attr = nullptr;
+};
+
 /**
  * C++ implementation for the Fortran API.
  *
@@ -49,6 +82,15 @@ struct API
     virtual void next_station() = 0;
     virtual int query_data() = 0;
     virtual wreport::Varcode next_data() = 0;
+    /**
+     * Read up to \a size values from the results of query_data into \a out,
+     * returning the number of values read, which is less than \a size only
+     * at the end of the results.
+     *
+     * Afterwards, the current value is the last one read, as if read by
+     * next_data.
+     */
+    virtual unsigned next_data_many(unsigned size, DataArrays& out) = 0;
     virtual void insert_data() = 0;
     virtual void remove_data() = 0;
     virtual int query_attributes() = 0;
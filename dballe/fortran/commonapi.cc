@@ -43,6 +43,7 @@ Operation::~Operation() {}
 void Operation::set_varcode(wreport::Varcode varcode) {}
 bool Operation::next_station() { throw error_consistency("next_station called without a previous query_stations"); }
 wreport::Varcode Operation::next_data() { throw error_consistency("next_data called without a previous query_data"); }
+unsigned Operation::next_data_many(unsigned size, DataArrays& out) { throw error_consistency("next_data_many called without a previous query_data"); }
 
 signed char Operation::enqb(const char* param) const
 {
@@ -441,6 +442,13 @@ wreport::Varcode CommonAPIImplementation::next_data()
     return operation->next_data();
 }
 
+unsigned CommonAPIImplementation::next_data_many(unsigned size, DataArrays& out)
+{
+    if (!operation) throw error_consistency("next_data_many called without a previous query_data");
+    qcoutput.invalidate();
+    return operation->next_data_many(size, out);
+}
+
 int CommonAPIImplementation::query_attributes()
 {
     // Query attributes
@@ -51,6 +51,7 @@ public:
     virtual void remove_attributes() = 0;
     virtual bool next_station();
     virtual wreport::Varcode next_data();
+    virtual unsigned next_data_many(unsigned size, DataArrays& out);
 
     virtual int enqi(const char* param) const = 0;
     virtual signed char enqb(const char* param) const;
@@ -143,6 +144,56 @@ struct CursorOperation : public Operation
         min = dt.minute != 0xff ? dt.minute : API::missing_int;
         sec = dt.second != 0xff ? dt.second : API::missing_int;
     }
+
+    /**
+     * Store the current row at position \a pos of the arrays in \a out.
+     *
+     * \a var is the value of the current row, and \a attr its attribute
+     * out.attr_code, or nullptr if it is not set.
+     */
+    void fill_arrays(unsigned pos, const DBStation& station, const wreport::Var& var, const wreport::Var* attr, DataArrays& out) const
+    {
+        if (out.ana_id)
+            out.ana_id[pos] = station.id != MISSING_INT ? station.id : API::missing_int;
+        if (out.lat)
+            out.lat[pos] = station.coords.lat != MISSING_INT ? station.coords.dlat() : API::missing_double;
+        if (out.lon)
+            out.lon[pos] = station.coords.lon != MISSING_INT ? station.coords.dlon() : API::missing_double;
+        if (out.datetime)
+        {
+            int* o = out.datetime + pos * 6;
+            enqdate(o[0], o[1], o[2], o[3], o[4], o[5]);
+        }
+        if (out.level)
+        {
+            int* o = out.level + pos * 4;
+            enqlevel(o[0], o[1], o[2], o[3]);
+        }
+        if (out.trange)
+        {
+            int* o = out.trange + pos * 3;
+            enqtimerange(o[0], o[1], o[2]);
+        }
+        if (out.varcode)
+        {
+            wreport::Varcode code = var.code();
+            out.varcode[pos] = WR_VAR_F(code) * 100000 + WR_VAR_X(code) * 1000 + WR_VAR_Y(code);
+        }
+        if (out.value)
+        {
+            if (var.isset() && var.info()->type != wreport::Vartype::String)
+                out.value[pos] = var.enqd();
+            else
+                out.value[pos] = API::missing_double;
+        }
+        if (out.attr)
+        {
+            if (attr && attr->isset() && attr->info()->type != wreport::Vartype::String)
+                out.attr[pos] = attr->enqd();
+            else
+                out.attr[pos] = API::missing_double;
+        }
+    }
 };
 
 /**
@@ -254,6 +305,7 @@ public:
     const char* describe_var(const char* varcode, const char* value) override;
     void next_station() override;
     wreport::Varcode next_data() override;
+    unsigned next_data_many(unsigned size, DataArrays& out) override;
     int query_attributes() override;
     const char* next_attribute() override;
     void insert_attributes() override;
@@ -153,6 +153,90 @@ this->add_method("query_basic", [](Fixture& f) {
     wassert(actual(api.query_data()) == 0);
 });
 
+this->add_method("query_many", [](Fixture& f) {
+    fortran::DbAPI api(f.tr, "write", "write", "write");
+    populate_variables(api);
+
+    // Add an attribute to the temperature
+    api.setc("var", "B12101");
+    wassert(actual(api.query_data()) == 1);
+    wassert(actual(api.next_data()) == WR_VAR(0, 12, 101));
+    api.seti("*B33007", 50);
+    wassert(api.insert_attributes());
+    api.unsetall();
+
+    for (const char* query: { "", "attrs" })
+    {
+        WREPORT_TEST_INFO(locinfo);
+        locinfo() << "Query: " << query;
+
+        int ana_id[2], datetime[12], level[8], trange[6], varcode[2];
+        double lat[2], lon[2], value[2], attr[2];
+        fortran::DataArrays arrays;
+        arrays.ana_id = ana_id;
+        arrays.lat = lat;
+        arrays.lon = lon;
+        arrays.datetime = datetime;
+        arrays.level = level;
+        arrays.trange = trange;
+        arrays.varcode = varcode;
+        arrays.value = value;
+        arrays.attr_code = WR_VAR(0, 33, 7);
+        arrays.attr = attr;
+
+        // Read one value at a time
+        api.unsetall();
+        api.setc("query", query);
+        wassert(actual(api.query_data()) == 2);
+        wassert(actual(api.next_data_many(1, arrays)) == 1u);
+        wassert(actual(lat[0]) == 44.5);
+        wassert(actual(lon[0]) == 11.5);
+        wassert(actual(ana_id[0]) == api.enqi("ana_id"));
+        wassert(actual(datetime[0]) == 2013);
+        wassert(actual(datetime[1]) == 4);
+        wassert(actual(datetime[2]) == 25);
+        wassert(actual(datetime[3]) == 12);
+        wassert(actual(level[0]) == 103);
+        wassert(actual(level[1]) == 2000);
+        wassert(actual(level[2]) == fortran::API::missing_int);
+        wassert(actual(level[3]) == fortran::API::missing_int);
+        wassert(actual(trange[0]) == 254);
+        wassert(actual(trange[1]) == 0);
+        wassert(actual(trange[2]) == 0);
+        wassert(actual(varcode[0]) == 12101);
+        wassert(actual(value[0]) == 21.5);
+        wassert(actual(attr[0]) == 50);
+
+        // The last value read is the current one
+        wassert(actual(api.enqd("B12101")) == 21.5);
+        wassert(actual(api.query_attributes()) == 1);
+
+        wassert(actual(api.next_data_many(2, arrays)) == 1u);
+        wassert(actual(level[1]) == 10000);
+        wassert(actual(varcode[0]) == 11002);
+        wassert(actual(value[0]) == 2.4);
+        wassert(actual(attr[0]) == fortran::API::missing_double);
+        wassert(actual(api.next_data_many(2, arrays)) == 0u);
+        wassert(actual(api.next_data()) == 0);
+
+        // Read all values at once, skipping the arrays that are not needed
+        fortran::DataArrays values;
+        values.value = value;
+        api.unsetall();
+        api.setc("query", query);
+        wassert(actual(api.query_data()) == 2);
+        wassert(actual(api.next_data_many(2, values)) == 2u);
+        wassert(actual(value[0]) == 21.5);
+        wassert(actual(value[1]) == 2.4);
+        wassert(actual(api.enqd("B11002")) == 2.4);
+    }
+
+    // Values can only be read after a query
+    fortran::DbAPI api1(f.tr, "read", "read", "read");
+    fortran::DataArrays arrays;
+    wassert_throws(wreport::error_consistency, api1.next_data_many(1, arrays));
+});
+
 this->add_method("query_attrs", [](Fixture& f) {
     // Test attrs
     fortran::DbAPI api(f.tr, "write", "write", "write");
@@ -283,6 +367,66 @@ this->add_method("insert_attrs_insert_data", [](Fixture& f) {
     wassert(actual(api.next_data()) == 0);
 });
 
+this->add_method("bulk_insert", [](Fixture& f) {
+    fortran::DbAPI api(f.tr, "write", "write", "write");
+    api.bulk_insert_size = 5;
+    auto& tr = db::v7::Transaction::downcast(*f.tr);
+
+    api.setd("lat", 44.5);
+    api.setd("lon", 11.5);
+    api.setc("rep_memo", "synop");
+    api.settimerange(254, 0, 0);
+    api.setlevel(103, 2000, MISSING_INT, MISSING_INT);
+    for (int hour = 0; hour < 12; ++hour)
+    {
+        api.setdate(2013, 4, 25, hour, 0, 0);
+        api.setd("B12101", 280.0 + hour);
+        api.insert_data();
+    }
+
+    // Values are written in groups of bulk_insert_size
+    wassert(actual(tr.count_deferred()) == 2u);
+
+    // Inserting again a queued value updates it
+    api.setdate(2013, 4, 25, 11, 0, 0);
+    api.setd("B12101", 300.0);
+    api.insert_data();
+
+    // Asking for IDs writes all pending data
+    int data_id = api.enqi("context_id");
+    wassert(actual(data_id) != MISSING_INT);
+    wassert(actual(api.enqi("ana_id")) != MISSING_INT);
+    wassert(actual(tr.count_deferred()) == 0u);
+
+    // Attributes can be set on the last inserted value
+    api.seti("*B33007", 60);
+    api.insert_attributes();
+
+    // Queries see queued data
+    api.setdate(2013, 4, 26, 0, 0, 0);
+    api.setd("B12101", 290.0);
+    api.insert_data();
+    wassert(actual(tr.count_deferred()) == 1u);
+
+    api.unsetall();
+    api.setc("var", "B12101");
+    wassert(actual(api.query_data()) == 13);
+    wassert(actual(tr.count_deferred()) == 0u);
+
+    api.unsetall();
+    api.seti("*context_id", data_id);
+    api.setc("*var_related", "B12101");
+    wassert(actual(api.query_attributes()) == 1);
+    wassert(actual(api.enqi("*B33007")) == 60);
+
+    api.unsetall();
+    api.setdate(2013, 4, 25, 11, 0, 0);
+    api.setc("var", "B12101");
+    wassert(actual(api.query_data()) == 1);
+    api.next_data();
+    wassert(actual(api.enqd("B12101")) == 300.0);
+});
+
 this->add_method("insert_auto_repmemo", [](Fixture& f) {
     // Check that an unknown rep_memo is correctly handled on insert
     fortran::DbAPI api(f.tr, "write", "write", "write");
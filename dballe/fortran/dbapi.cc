@@ -8,8 +8,10 @@
 #include "dballe/core/data.h"
 #include "dballe/db/db.h"
 #include "dballe/db/v7/cursor.h"
+#include "dballe/db/v7/transaction.h"
 #include "dballe/msg/msg.h"
 #include <cstring>
+#include <cstdlib>
 
 using namespace wreport;
 using namespace std;
@@ -187,6 +189,42 @@ struct VoglioquestoOperation : public CursorOperation<Cursor>
             return 0;
         }
     }
+    unsigned next_data_many(unsigned size, DataArrays& out) override
+    {
+        unsigned count = 0;
+        unique_ptr<Var> attr;
+        function<void(unique_ptr<Var>&&)> consumer = [&](unique_ptr<Var>&& var) {
+            if (var->code() == out.attr_code)
+                attr = std::move(var);
+        };
+        while (count < size && !next_data_ended)
+        {
+            // Only move past the last value read once more values are needed,
+            // so that it remains the current one afterwards
+            if (!this->cursor->next())
+            {
+                next_data_ended = true;
+                break;
+            }
+            valid_cached_attrs = true;
+
+            const auto& row = this->cursor->row();
+            const wreport::Var* row_attr = nullptr;
+            if (out.attr)
+            {
+                if (this->cursor->with_attributes)
+                    row_attr = row.value->enqa(out.attr_code);
+                else {
+                    attr.reset();
+                    this->cursor->query_attrs(consumer, true);
+                    row_attr = attr.get();
+                }
+            }
+            this->fill_arrays(count, row.station, *row.value, row_attr, out);
+            ++count;
+        }
+        return count;
+    }
     void query_attributes(Attributes& dest) override
     {
         if (next_data_ended) throw error_consistency("query_attributes called after next_data returned end of data");
@@ -238,11 +276,16 @@ struct PrendiloOperation : public Operation
 {
     /// Store database variable IDs for all last inserted variables
     DbAPI& api;
-    std::vector<VarID> last_inserted_varids;
+    // In bulk insert mode, IDs are only looked up when they are requested
+    mutable std::vector<VarID> last_inserted_varids;
     wreport::Varcode varcode = 0;
-    int last_inserted_station_id = API::missing_int;
-    int last_inserted_data_id = API::missing_int;
+    mutable int last_inserted_station_id = API::missing_int;
+    mutable int last_inserted_data_id = API::missing_int;
     impl::DBInsertOptions opts;
+    /// Context of the last bulk insert, to look up its IDs if needed
+    core::Data deferred_context;
+    /// True if the IDs of the last inserted variables have not been looked up yet
+    mutable bool ids_pending = false;
 
     PrendiloOperation(DbAPI& api)
         : api(api)
@@ -262,6 +305,9 @@ struct PrendiloOperation : public Operation
             api.tr->insert_station_data(api.input_data, opts);
             for (const auto& v: api.input_data.values)
                 last_inserted_varids.push_back(VarID(v.code(), true, v.data_id));
+        } else if (api.bulk_insert_size) {
+            run_deferred();
+            return;
         } else {
             api.tr->insert_data(api.input_data, opts);
             for (const auto& v: api.input_data.values)
@@ -273,12 +319,49 @@ struct PrendiloOperation : public Operation
         else
             last_inserted_data_id = API::missing_int;
     }
+
+    void run_deferred()
+    {
+        auto& tr = db::v7::Transaction::downcast(*api.tr);
+        for (const auto& v: api.input_data.values)
+            last_inserted_varids.push_back(VarID(v.code(), false, MISSING_INT));
+        deferred_context.station = api.input_data.station;
+        deferred_context.datetime = api.input_data.datetime;
+        deferred_context.level = api.input_data.level;
+        deferred_context.trange = api.input_data.trange;
+        tr.insert_data_deferred(api.input_data, opts);
+        if (tr.count_deferred() >= api.bulk_insert_size)
+            tr.write_deferred();
+        ids_pending = true;
+    }
+
+    /// Write queued data and look up the IDs of the last inserted variables
+    void read_ids() const
+    {
+        if (!ids_pending) return;
+        core::Data data(deferred_context);
+        for (const auto& v: last_inserted_varids)
+            data.values.set(newvar(v.code));
+        db::v7::Transaction::downcast(*api.tr).read_data_ids(data);
+
+        for (auto& v: last_inserted_varids)
+            if (const DBValue* val = data.values.maybe_value(v.code))
+                v.id = val->data_id;
+        last_inserted_station_id = data.station.id;
+        if (last_inserted_varids.size() == 1)
+            last_inserted_data_id = last_inserted_varids[0].id;
+        else
+            last_inserted_data_id = API::missing_int;
+        ids_pending = false;
+    }
+
     void query_attributes(Attributes& dest) override
     {
         throw error_consistency("query_attributes cannot be called after a insert_data");
     }
     void insert_attributes(Values& qcinput) override
     {
+        read_ids();
         int data_id = MISSING_INT;
         bool is_station = false;
         // Lookup the variable we act on from the results of last insert_data
@@ -312,8 +395,10 @@ struct PrendiloOperation : public Operation
     {
         if (strcmp(param, "ana_id") == 0)
         {
+            read_ids();
             return last_inserted_station_id;
         } else if (strcmp(param, "context_id") == 0) {
+            read_ids();
             return last_inserted_data_id;
         } else
             wreport::error_consistency::throwf("enqi %s cannot be called after a insert_data", param);
@@ -391,6 +476,12 @@ DbAPI::DbAPI(std::shared_ptr<db::Transaction> tr, unsigned perms)
     : tr(tr)
 {
     this->perms = perms;
+    if (const char* val = getenv("DBA_FORTRAN_BULK_INSERT"))
+    {
+        int size = atoi(val);
+        if (size > 0)
+            bulk_insert_size = size;
+    }
 }
 
 DbAPI::~DbAPI()
@@ -572,7 +663,11 @@ std::unique_ptr<API> DbAPI::fortran_connect(const DBConnectOptions& options, con
 {
     unsigned perms = DbAPI::compute_permissions(anaflag, dataflag, attrflag);
     bool readonly = !(perms & (fortran::DbAPI::PERM_ANA_WRITE | fortran::DbAPI::PERM_DATA_ADD | fortran::DbAPI::PERM_DATA_WRITE | fortran::DbAPI::PERM_ATTR_WRITE));
-    auto db = DB::connect(options);
+    auto db = dynamic_pointer_cast<db::DB>(DB::connect(options));
+    // The Fortran API needs the database cursors and transactions, which
+    // are not available when going through a dballe server
+    if (!db)
+        throw error_unimplemented("the Fortran API cannot use a database shared by a dballe server");
     auto tr = dynamic_pointer_cast<db::Transaction>(db->transaction(readonly));
     return std::unique_ptr<API>(new fortran::DbAPI(tr, perms));
 }
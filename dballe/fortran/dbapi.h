@@ -26,6 +26,14 @@ public:
     std::shared_ptr<db::Transaction> tr;
     InputFile* input_file = nullptr;
     OutputFile* output_file = nullptr;
+    /**
+     * If nonzero, insert_data queues values to be written in bulk, writing
+     * them when this many are pending, when IDs of inserted data are
+     * requested, or before any other database operation.
+     *
+     * Defaults to the value of DBA_FORTRAN_BULK_INSERT, or 0 if unset.
+     */
+    unsigned bulk_insert_size = 0;
 
     DbAPI(std::shared_ptr<db::Transaction> tr, const char* anaflag, const char* dataflag, const char* attrflag);
     DbAPI(std::shared_ptr<db::Transaction> tr, unsigned perms);
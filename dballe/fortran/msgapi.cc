@@ -116,6 +116,25 @@ struct VoglioquestoOperation : public CursorOperation<Cursor>
         }
     }
 
+    unsigned next_data_many(unsigned size, DataArrays& out) override
+    {
+        unsigned count = 0;
+        while (count < size && !next_data_ended)
+        {
+            if (!this->cursor->next())
+            {
+                next_data_ended = true;
+                break;
+            }
+            valid_cached_attrs = true;
+
+            wreport::Var var = this->cursor->get_var();
+            this->fill_arrays(count, this->cursor->get_station(), var, out.attr ? var.enqa(out.attr_code) : nullptr, out);
+            ++count;
+        }
+        return count;
+    }
+
     void query_attributes(Attributes& dest) override
     {
         if (next_data_ended) throw error_consistency("query_attributes called after next_data returned end of data");
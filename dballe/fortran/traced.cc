@@ -523,6 +523,25 @@ wreport::Varcode TracedAPI::next_data()
     return RUN(next_data);
 }
 
+unsigned TracedAPI::next_data_many(unsigned size, DataArrays& arrays)
+{
+    // The replay only moves through the results, without storing them
+    FILE*& out = tracer.trace_file;
+    fputs("{\n", out);
+    fputs("    DataArrays arrays;\n", out);
+    unsigned res;
+    try {
+        res = api->next_data_many(size, arrays);
+    } catch (std::exception& e) {
+        fprintf(out, "    wassert_throws(std::exception, %s.next_data_many(%u, arrays)); // %s\n", name.c_str(), size, e.what());
+        fputs("}\n", out);
+        throw;
+    }
+    fprintf(out, "    wassert(actual(%s.next_data_many(%u, arrays)) == %uu);\n", name.c_str(), size, res);
+    fputs("}\n", out);
+    return res;
+}
+
 void TracedAPI::insert_data()
 {
     RUN(insert_data);
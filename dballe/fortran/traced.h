@@ -62,6 +62,7 @@ struct TracedAPI : public API
     void next_station() override;
     int query_data() override;
     wreport::Varcode next_data() override;
+    unsigned next_data_many(unsigned size, DataArrays& out) override;
     void insert_data() override;
     void remove_data() override;
     int query_attributes() override;
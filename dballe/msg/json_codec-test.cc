@@ -1,5 +1,7 @@
 #include "tests.h"
 #include "json_codec.h"
+#include "msg.h"
+#include "dballe/core/json.h"
 #include <wreport/options.h>
 #include <cstring>
 
@@ -32,6 +34,36 @@ add_method("read", []() {
     wassert(actual(count) == 5);
 });
 
+add_method("roundtrip", []() {
+    auto file = File::create(Encoding::JSON, tests::datafile("json/issue134.json"), "r");
+    auto importer = Importer::create(Encoding::JSON);
+    auto exporter = Exporter::create(Encoding::JSON);
+    impl::Messages msgs;
+    wassert_true(file->foreach([&](const BinaryMessage& bmsg) {
+        return importer->foreach_decoded(bmsg, [&](std::shared_ptr<Message> dest) {
+            msgs.emplace_back(dest);
+            return true;
+        });
+    }));
+    wassert(actual(msgs.size()) == 5u);
+
+    const wreport::Var* var = impl::Message::downcast(msgs[0])->get(Level(103, 2000), Trange(254, 0, 0), WR_VAR(0, 12, 101));
+    wassert_true(var);
+    wassert(actual(*var) == 238.45);
+    wassert_true(var->enqa(WR_VAR(0, 33, 7)));
+    wassert(actual(var->enqa(WR_VAR(0, 33, 7))->enqi()) == 0);
+
+    // All messages encoded in a single buffer decode to the same messages
+    BinaryMessage raw(Encoding::JSON);
+    raw.data = wcallchecked(exporter->to_binary(msgs));
+    impl::Messages msgs1 = wcallchecked(importer->from_binary(raw));
+    wassert(actual(impl::msg::messages_diff(msgs, msgs1)) == 0u);
+
+    // Truncated input is an error
+    raw.data.resize(raw.data.find('\n') + 10);
+    wassert_throws(core::JSONParseException, importer->from_binary(raw));
+});
+
 add_method("domain_throw", []() {
     auto file = File::create(Encoding::JSON, tests::datafile("json/issue241.json"), "r");
     auto options = ImporterOptions::create();
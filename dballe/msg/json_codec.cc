@@ -6,7 +6,6 @@
 #include <wreport/error.h>
 #include <wreport/options.h>
 #include <sstream>
-#include <stack>
 
 namespace dballe {
 namespace impl {
@@ -15,416 +14,242 @@ namespace msg {
 using core::JSONParseException;
 
 
-struct JSONMsgReader : public core::JSONReader
+/**
+ * Parser for the dballe JSON message schema.
+ *
+ * It walks the JSON data directly instead of going through the generic
+ * JSONReader events, so that there is no need to track the parser state
+ * separately, and variables are moved into the message instead of copied.
+ */
+struct JSONMsgParser
 {
-    std::shared_ptr<impl::Message> msg;
-    std::unique_ptr<impl::msg::Context> ctx;
-    std::unique_ptr<wreport::Var> var;
-    std::unique_ptr<wreport::Var> attr;
+    core::json::Stream& in;
 
-    enum State {
-        MSG,
-        MSG_IDENT_KEY,
-        MSG_VERSION_KEY,
-        MSG_NETWORK_KEY,
-        MSG_LON_KEY,
-        MSG_LAT_KEY,
-        MSG_DATE_KEY,
-        MSG_DATA_KEY,
-        MSG_DATA_LIST,
-        MSG_DATA_LIST_ITEM,
-        MSG_DATA_LIST_ITEM_VARS_KEY,
-        MSG_DATA_LIST_ITEM_LEVEL_KEY,
-        MSG_DATA_LIST_ITEM_TRANGE_KEY,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING_KEY,
-        MSG_DATA_LIST_ITEM_LEVEL_LIST,
-        MSG_DATA_LIST_ITEM_TRANGE_LIST,
-        MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE1,
-        MSG_DATA_LIST_ITEM_LEVEL_LIST_L1,
-        MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE2,
-        MSG_DATA_LIST_ITEM_LEVEL_LIST_L2,
-        MSG_DATA_LIST_ITEM_TRANGE_LIST_PIND,
-        MSG_DATA_LIST_ITEM_TRANGE_LIST_P1,
-        MSG_DATA_LIST_ITEM_TRANGE_LIST_P2,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_KEY,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_MAPPING,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_KEY,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING,
-        MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING_VAR_KEY,
-        MSG_END,
-    };
+    JSONMsgParser(core::json::Stream& in) : in(in) {}
 
-    std::stack<State> state;
-
-    JSONMsgReader() {}
-
-    bool parse_msgs(const std::string& buf, std::function<bool(std::shared_ptr<impl::Message>)> cb)
+    bool parse_msgs(std::function<bool(std::shared_ptr<impl::Message>)> cb)
     {
-        std::stringstream in(buf);
-        while (!in.eof())
-        {
-            parse(in);
-            if (not state.empty() && state.top() == MSG_END) {
-                state.pop();
-                if (!cb(std::move(msg)))
-                    return false;
-            }
-            msg.reset();
-        }
-        if (not state.empty())
-            throw JSONParseException("Incomplete JSON");
+        do {
+            if (in.identify_next() != core::json::JSON_OBJECT)
+                throw JSONParseException("Invalid JSON value");
+            if (!cb(parse_msg()))
+                return false;
+        } while (!in.at_end());
         return true;
     }
 
-    void throw_error_if_empty_state()
+    int parse_int()
     {
-        if (state.empty())
-            throw JSONParseException("Invalid JSON value");
+        if (in.identify_next() != core::json::JSON_NUMBER)
+            throw JSONParseException("Invalid JSON value: integer expected");
+        std::string val;
+        bool is_double;
+        std::tie(val, is_double) = in.parse_number();
+        if (is_double)
+            throw JSONParseException("Invalid JSON value add_double");
+        return std::stoi(val);
     }
 
-    void on_start_list() override
+    std::string parse_string()
     {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG_DATA_KEY:
-                state.pop();
-                state.push(MSG_DATA_LIST);
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_KEY:
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST);
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE1);
-                break;
-            case MSG_DATA_LIST_ITEM_TRANGE_KEY:
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_TRANGE_LIST);
-                state.push(MSG_DATA_LIST_ITEM_TRANGE_LIST_PIND);
-                break;
-            default: throw JSONParseException("Invalid JSON value start_list");
-        }
+        if (in.identify_next() != core::json::JSON_STRING)
+            throw JSONParseException("Invalid JSON value: string expected");
+        return in.parse_string();
     }
 
-    void on_end_list() override
+    /// Parse an int or null, into a Level or Trange field
+    void parse_int_or_null(int& dest)
     {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG_DATA_LIST: state.pop(); break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST: state.pop(); break;
-            case MSG_DATA_LIST_ITEM_TRANGE_LIST: state.pop(); break;
-            default: throw JSONParseException("Invalid JSON value end_list");
-        }
+        if (in.identify_next() == core::json::JSON_NULL)
+        {
+            in.expect_token("null");
+            in.skip_spaces();
+            dest = MISSING_INT;
+        } else
+            dest = parse_int();
     }
 
-    void on_start_mapping() override
+    void parse_level(Level& level)
     {
-        if (state.empty())
-        {
-            msg = std::make_shared<impl::Message>();
-            state.push(MSG);
-        }
-        else
-        {
-            State s = state.top();
-            switch (s) {
-                case MSG_DATA_LIST:
-                    state.push(MSG_DATA_LIST_ITEM);
-                    ctx.reset(new impl::msg::Context(Level(), Trange()));
-                    break;
-                case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR:
-                    state.pop();
-                    state.push(MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_MAPPING);
-                    break;
-                case MSG_DATA_LIST_ITEM_VARS_KEY:
-                    state.pop();
-                    state.push(MSG_DATA_LIST_ITEM_VARS_MAPPING);
-                    break;
-                case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_KEY:
-                    state.pop();
-                    state.push(MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING);
-                    break;
-                default: throw JSONParseException("Invalid JSON value start_mapping");
+        unsigned idx = 0;
+        in.parse_array([&]{
+            switch (idx++)
+            {
+                case 0: parse_int_or_null(level.ltype1); break;
+                case 1: parse_int_or_null(level.l1); break;
+                case 2: parse_int_or_null(level.ltype2); break;
+                case 3: parse_int_or_null(level.l2); break;
+                default: throw JSONParseException("Invalid JSON value: extra element in level");
             }
-        }
+        });
     }
 
-    void on_end_mapping() override
+    void parse_trange(Trange& trange)
     {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG:
+        unsigned idx = 0;
+        in.parse_array([&]{
+            switch (idx++)
             {
-                state.pop();
-                state.push(MSG_END);
-                break;
-            }
-            case MSG_DATA_LIST_ITEM:
-            {
-                // NOTE: station context could be already created, because
-                // of "lon", "lat", "ident", "network".
-                // Then, context overwrite is allowed.
-                // msg.add_context(std::move(ctx));
-                if (ctx->level.is_missing() && ctx->trange.is_missing())
-                {
-                    msg->station_data.merge(ctx->values);
-                } else {
-                    impl::msg::Context& ctx2 = msg->obtain_context(ctx->level, ctx->trange);
-                    ctx2.values.merge(ctx->values);
-                }
-                state.pop();
-                break;
+                case 0: parse_int_or_null(trange.pind); break;
+                case 1: parse_int_or_null(trange.p1); break;
+                case 2: parse_int_or_null(trange.p2); break;
+                default: throw JSONParseException("Invalid JSON value: extra element in timerange");
             }
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING:
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING:
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_MAPPING:
-                state.pop();
-                break;
-            default: throw JSONParseException("Invalid JSON value end_mapping");
-        }
+        });
     }
 
-    void on_add_null() override
+    /**
+     * Set the value of a variable or attribute from the next JSON value.
+     *
+     * Variable integer values are set with setf, since Var::seti on decimal
+     * vars is considered as the value with the scale already applied.
+     */
+    void parse_value(wreport::Var& var, bool is_attr)
     {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG_IDENT_KEY:
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE1:
-                ctx->level.ltype1 = MISSING_INT;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST_L1);
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_L1:
-                ctx->level.l1 = MISSING_INT;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE2);
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE2:
-                ctx->level.ltype2 = MISSING_INT;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST_L2);
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_L2:
-                ctx->level.l2 = MISSING_INT;
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_TRANGE_LIST_PIND:
-                ctx->trange.pind = MISSING_INT;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_TRANGE_LIST_P1);
+        switch (in.identify_next())
+        {
+            case core::json::JSON_NULL:
+                in.expect_token("null");
+                in.skip_spaces();
+                if (is_attr)
+                    var.set(MISSING_INT);
+                else
+                    var.unset();
                 break;
-            case MSG_DATA_LIST_ITEM_TRANGE_LIST_P1:
-                ctx->trange.p1 = MISSING_INT;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_TRANGE_LIST_P2);
+            case core::json::JSON_TRUE:
+                in.expect_token("true");
+                in.skip_spaces();
+                var.set(true);
                 break;
-            case MSG_DATA_LIST_ITEM_TRANGE_LIST_P2:
-                ctx->trange.p2 = MISSING_INT;
-                state.pop();
+            case core::json::JSON_FALSE:
+                in.expect_token("false");
+                in.skip_spaces();
+                var.set(false);
                 break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_KEY:
-                var->unset();
-                ctx->values.set(*var);
-                state.pop();
+            case core::json::JSON_NUMBER:
+            {
+                std::string val;
+                bool is_double;
+                std::tie(val, is_double) = in.parse_number();
+                if (is_double)
+                    var.set(std::stod(val));
+                else if (is_attr)
+                    var.set(std::stoi(val));
+                else
+                    var.setf(std::to_string(std::stoi(val)).c_str());
                 break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING_VAR_KEY:
-                state.pop();
-                attr->set(MISSING_INT);
-                var->seta(*attr);
-                ctx->values.set(*var);
+            }
+            case core::json::JSON_STRING:
+                var.set(in.parse_string());
                 break;
-            default: throw JSONParseException("Invalid JSON value add_null");
+            default:
+                throw JSONParseException("Invalid JSON value for variable");
         }
     }
 
-    void on_add_bool(bool val) override
+    void parse_vars(Values& values)
     {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_KEY:
-                var->set(val);
-                ctx->values.set(*var);
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING_VAR_KEY:
-                state.pop();
-                attr->set(val);
-                var->seta(*attr);
-                ctx->values.set(*var);
-                break;
-            default: throw JSONParseException("Invalid JSON value add_bool");
-        }
+        if (in.identify_next() != core::json::JSON_OBJECT)
+            throw JSONParseException("Invalid JSON value: vars mapping expected");
+        in.parse_object([&](const std::string& code) {
+            if (in.identify_next() != core::json::JSON_OBJECT)
+                throw JSONParseException("Invalid JSON value: variable mapping expected");
+            auto var = newvar(code);
+            bool changed = false;
+            in.parse_object([&](const std::string& key) {
+                if (key == "v")
+                {
+                    parse_value(*var, false);
+                    changed = true;
+                } else if (key == "a") {
+                    if (in.identify_next() != core::json::JSON_OBJECT)
+                        throw JSONParseException("Invalid JSON value: attribute mapping expected");
+                    in.parse_object([&](const std::string& acode) {
+                        auto attr = newvar(acode);
+                        parse_value(*attr, true);
+                        var->seta(std::move(attr));
+                        changed = true;
+                    });
+                } else
+                    throw JSONParseException("Invalid JSON value");
+            });
+            if (changed)
+                values.set(std::move(var));
+        });
     }
 
-    void on_add_int(int val) override
+    void parse_data_item(impl::Message& msg)
     {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG_LON_KEY:
-                msg->set_longitude_var(dballe::var("B06001", val));
-                state.pop();
-                break;
-            case MSG_LAT_KEY:
-                msg->set_latitude_var(dballe::var("B05001", val));
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE1:
-                ctx->level.ltype1 = val;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST_L1);
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_L1:
-                ctx->level.l1 = val;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE2);
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_LTYPE2:
-                ctx->level.ltype2 = val;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_LEVEL_LIST_L2);
-                break;
-            case MSG_DATA_LIST_ITEM_LEVEL_LIST_L2:
-                ctx->level.l2 = val;
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_TRANGE_LIST_PIND:
-                ctx->trange.pind = val;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_TRANGE_LIST_P1);
-                break;
-            case MSG_DATA_LIST_ITEM_TRANGE_LIST_P1:
-                ctx->trange.p1 = val;
-                state.pop();
-                state.push(MSG_DATA_LIST_ITEM_TRANGE_LIST_P2);
-                break;
-            case MSG_DATA_LIST_ITEM_TRANGE_LIST_P2:
-                ctx->trange.p2 = val;
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_KEY:
-                // Var::seti on decimal vars is considered as the value
-                // with the scale already applied
-                var->setf(std::to_string(val).c_str());
-                ctx->values.set(*var);
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING_VAR_KEY:
-                state.pop();
-                attr->set(val);
-                var->seta(*attr);
-                ctx->values.set(*var);
-                break;
-            default: throw JSONParseException("Invalid JSON value add_int");
-        }
-    }
+        if (in.identify_next() != core::json::JSON_OBJECT)
+            throw JSONParseException("Invalid JSON value: data item mapping expected");
+        Level level;
+        Trange trange;
+        Values values;
+        in.parse_object([&](const std::string& key) {
+            if (key == "vars")
+                parse_vars(values);
+            else if (key == "level")
+            {
+                if (in.identify_next() != core::json::JSON_ARRAY)
+                    throw JSONParseException("Invalid JSON value: level list expected");
+                parse_level(level);
+            }
+            else if (key == "timerange")
+            {
+                if (in.identify_next() != core::json::JSON_ARRAY)
+                    throw JSONParseException("Invalid JSON value: timerange list expected");
+                parse_trange(trange);
+            }
+            else
+                throw JSONParseException("Invalid JSON value");
+        });
 
-    void on_add_double(double val) override
-    {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_KEY:
-                var->set(val);
-                ctx->values.set(*var);
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING_VAR_KEY:
-                state.pop();
-                attr->set(val);
-                var->seta(*attr);
-                ctx->values.set(*var);
-                break;
-            default: throw JSONParseException("Invalid JSON value add_double");
-        }
+        // NOTE: station context could be already created, because
+        // of "lon", "lat", "ident", "network".
+        // Then, context overwrite is allowed.
+        if (level.is_missing() && trange.is_missing())
+            msg.station_data.merge(std::move(values));
+        else
+            msg.obtain_context(level, trange).values.merge(std::move(values));
     }
 
-    void on_add_string(const std::string& val) override
+    std::shared_ptr<impl::Message> parse_msg()
     {
-        throw_error_if_empty_state();
-        State s = state.top();
-        switch (s) {
-            case MSG:
-                if (val == "ident")
-                    state.push(MSG_IDENT_KEY);
-                else if (val == "version")
-                    state.push(MSG_VERSION_KEY);
-                else if (val == "network")
-                    state.push(MSG_NETWORK_KEY);
-                else if (val == "lon")
-                    state.push(MSG_LON_KEY);
-                else if (val == "lat")
-                    state.push(MSG_LAT_KEY);
-                else if (val == "date")
-                    state.push(MSG_DATE_KEY);
-                else if (val == "data")
-                    state.push(MSG_DATA_KEY);
-                else
-                    throw JSONParseException("Invalid JSON value");
-                break;
-            case MSG_IDENT_KEY:
-                msg->set_ident(val.c_str());
-                state.pop();
-                break;
-            case MSG_VERSION_KEY:
+        auto msg = std::make_shared<impl::Message>();
+        in.parse_object([&](const std::string& key) {
+            if (key == "ident")
+            {
+                if (in.identify_next() == core::json::JSON_NULL)
+                {
+                    in.expect_token("null");
+                    in.skip_spaces();
+                } else
+                    msg->set_ident(parse_string().c_str());
+            }
+            else if (key == "version")
+            {
+                std::string val = parse_string();
                 if (val != DBALLE_JSON_VERSION)
                     throw JSONParseException("Invalid JSON version " + val);
-                state.pop();
-                break;
-            case MSG_NETWORK_KEY:
-                msg->set_rep_memo(val.c_str());
-                state.pop();
-                break;
-            case MSG_DATE_KEY:
-                msg->set_datetime(Datetime::from_iso8601(val.c_str()));
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM:
-                if (val == "vars")
-                    state.push(MSG_DATA_LIST_ITEM_VARS_KEY);
-                else if (val == "level")
-                    state.push(MSG_DATA_LIST_ITEM_LEVEL_KEY);
-                else if (val == "timerange")
-                    state.push(MSG_DATA_LIST_ITEM_TRANGE_KEY);
-                else
-                    throw JSONParseException("Invalid JSON value");
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING:
-                state.push(MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR);
-                var = newvar(val);
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_MAPPING:
-                if (val == "v")
-                    state.push(MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_KEY);
-                else if (val == "a")
-                    state.push(MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_KEY);
-                else
-                    throw JSONParseException("Invalid JSON value");
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_VAR_KEY:
-                var->set(val);
-                ctx->values.set(*var);
-                state.pop();
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING:
-                state.push(MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING_VAR_KEY);
-                attr = newvar(val);
-                break;
-            case MSG_DATA_LIST_ITEM_VARS_MAPPING_ATTR_MAPPING_VAR_KEY:
-                state.pop();
-                attr->set(val);
-                var->seta(*attr);
-                ctx->values.set(*var);
-                break;
-            default: throw JSONParseException("Invalid JSON value add_string");
-        }
+            }
+            else if (key == "network")
+                msg->set_rep_memo(parse_string().c_str());
+            else if (key == "lon")
+                msg->set_longitude_var(dballe::var("B06001", parse_int()));
+            else if (key == "lat")
+                msg->set_latitude_var(dballe::var("B05001", parse_int()));
+            else if (key == "date")
+                msg->set_datetime(Datetime::from_iso8601(parse_string().c_str()));
+            else if (key == "data")
+            {
+                if (in.identify_next() != core::json::JSON_ARRAY)
+                    throw JSONParseException("Invalid JSON value: data list expected");
+                in.parse_array([&]{ parse_data_item(*msg); });
+            }
+            else
+                throw JSONParseException("Invalid JSON value");
+        });
+        return msg;
     }
 };
 
@@ -438,8 +263,9 @@ bool JsonImporter::foreach_decoded(const BinaryMessage& msg, std::function<bool(
 {
     WreportVarOptionsForImport wreport_config(opts.domain_errors);
 
-    JSONMsgReader jsonreader;
-    return jsonreader.parse_msgs(msg.data, dest);
+    core::json::Stream in(msg.data);
+    JSONMsgParser parser(in);
+    return parser.parse_msgs(dest);
 }
 
 
@@ -79,6 +79,89 @@ add_method("ordering", []() {
     wassert(actual(msg.get(lev1, Trange(3, 3, 3), WR_VAR(0, 1, 1))) == (Var*)0);
 });
 
+add_method("contexts_sorted", []() {
+    // Contexts added out of order are kept sorted
+    impl::msg::Contexts contexts;
+    Trange tr(254, 0, 0);
+    for (int l = 100; l > 0; --l)
+        contexts.obtain(Level(100, l * 100), tr)->values.set("B12101", (double)l);
+    wassert(actual(contexts.size()) == 100u);
+
+    int expected = 1;
+    for (const auto& ctx: contexts)
+    {
+        wassert(actual(ctx.level.l1) == expected * 100);
+        ++expected;
+    }
+    wassert(actual(expected) == 101);
+
+    auto i = contexts.find(Level(100, 5000), tr);
+    wassert_true(i != contexts.end());
+    wassert(actual(i->values.enq("B12101", 0.0)) == 50.0);
+    wassert_true(contexts.find(Level(100, 5001), tr) == contexts.end());
+
+    wassert_true(contexts.drop(Level(100, 100), tr));
+    wassert_false(contexts.drop(Level(100, 100), tr));
+    wassert(actual(contexts.size()) == 99u);
+    wassert(actual(contexts.begin()->level.l1) == 200);
+});
+
+add_method("contexts_deferred_sort", []() {
+    // Contexts are appended out of order and sorted on request
+    impl::msg::Contexts contexts;
+    contexts.defer_sorting();
+    Trange tr(254, 0, 0);
+    for (int l = 1000; l > 0; --l)
+        contexts.obtain(Level(100, l * 100), tr)->values.set("B12101", (double)l);
+    wassert(actual(contexts.size()) == 1000u);
+
+    // Iteration follows insertion order
+    wassert(actual(contexts.begin()->level.l1) == 100000);
+
+    // Lookups work before sorting
+    auto i = contexts.find(Level(100, 50000), tr);
+    wassert_true(i != contexts.end());
+    wassert(actual(i->values.enq("B12101", 0.0)) == 500.0);
+    wassert_true(contexts.find(Level(100, 50001), tr) == contexts.end());
+
+    // Obtaining an existing context does not add a new one
+    contexts.obtain(Level(100, 100000), tr);
+    wassert(actual(contexts.size()) == 1000u);
+
+    wassert_true(contexts.drop(Level(100, 100), tr));
+    wassert_false(contexts.drop(Level(100, 100), tr));
+    wassert(actual(contexts.size()) == 999u);
+
+    // Erasing while iterating keeps the index consistent
+    for (auto j = contexts.begin(); j != contexts.end(); )
+        if (j->level.l1 % 200 == 0)
+            j = contexts.erase(j);
+        else
+            ++j;
+    wassert(actual(contexts.size()) == 499u);
+    wassert_true(contexts.find(Level(100, 50000), tr) == contexts.end());
+    i = contexts.find(Level(100, 50100), tr);
+    wassert_true(i != contexts.end());
+    wassert(actual(i->values.enq("B12101", 0.0)) == 501.0);
+
+    // Iteration is sorted after sort()
+    contexts.sort();
+    int expected = 3;
+    for (const auto& ctx: contexts)
+    {
+        wassert(actual(ctx.level.l1) == expected * 100);
+        expected += 2;
+    }
+    wassert(actual(expected) == 1001);
+
+    // Lookups and insertions keep working after sorting
+    i = contexts.find(Level(100, 50100), tr);
+    wassert_true(i != contexts.end());
+    wassert(actual(i->values.enq("B12101", 0.0)) == 501.0);
+    contexts.obtain(Level(100, 200), tr);
+    wassert(actual(contexts.begin()->level.l1) == 200);
+});
+
 add_method("compose", []() {
     // Try to write a generic message from scratch
     auto msg = make_shared<impl::Message>();
@@ -10,6 +10,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <cctype>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
@@ -22,82 +23,114 @@ namespace impl {
 
 namespace msg {
 
-Contexts::const_iterator Contexts::find(const Level& level, const Trange& trange) const
+size_t Contexts::KeyHash::operator()(const Key& key) const noexcept
 {
-    /* Binary search */
-    if (m_contexts.empty())
-        return m_contexts.end();
-
-    const_iterator low = m_contexts.begin(), high = (m_contexts.end() - 1);
-    while (low <= high)
-    {
-        const_iterator middle = low + (high - low) / 2;
-        int cmp = middle->compare(level, trange);
-        if (cmp > 0)
-            high = middle - 1;
-        else if (cmp < 0)
-            low = middle + 1;
-        else
-            return middle;
-    }
-    return m_contexts.end();
+    return std::hash<Level>()(key.first) * 31 + std::hash<Trange>()(key.second);
 }
 
-Contexts::iterator Contexts::find(const Level& level, const Trange& trange)
+void Contexts::reindex()
 {
-    /* Binary search */
-    if (m_contexts.empty())
-        return m_contexts.end();
+    m_index.clear();
+    m_index.reserve(m_contexts.size());
+    for (size_t i = 0; i < m_contexts.size(); ++i)
+        m_index.emplace(Key(m_contexts[i].level, m_contexts[i].trange), i);
+}
 
-    iterator low = m_contexts.begin(), high = (m_contexts.end() - 1);
-    while (low <= high)
+size_t Contexts::lookup(const Level& level, const Trange& trange) const
+{
+    if (m_deferred)
     {
-        iterator middle = low + (high - low) / 2;
-        int cmp = middle->compare(level, trange);
-        if (cmp > 0)
-            high = middle - 1;
-        else if (cmp < 0)
-            low = middle + 1;
-        else
-            return middle;
+        auto i = m_index.find(Key(level, trange));
+        if (i == m_index.end())
+            return m_contexts.size();
+        return i->second;
     }
-    return m_contexts.end();
+
+    auto i = std::lower_bound(m_contexts.begin(), m_contexts.end(), Key(level, trange), [](const Context& c, const Key& key) {
+        return c.compare(key.first, key.second) < 0;
+    });
+    if (i == m_contexts.end() || i->compare(level, trange) != 0)
+        return m_contexts.size();
+    return i - m_contexts.begin();
 }
 
-Contexts::iterator Contexts::insert_new(const Level& level, const Trange& trange)
+Contexts::const_iterator Contexts::find(const Level& level, const Trange& trange) const
 {
-    // Enlarge the buffer
-    m_contexts.emplace_back(level, trange);
+    return m_contexts.cbegin() + lookup(level, trange);
+}
 
-    // Insertionsort
-    iterator pos;
-    for (pos = m_contexts.end() - 1; pos > m_contexts.begin(); --pos)
-    {
-        if ((pos - 1)->compare(*pos) > 0)
-            std::swap(*pos, *(pos - 1));
-        else
-            break;
-    }
-    return pos;
+Contexts::iterator Contexts::find(const Level& level, const Trange& trange)
+{
+    return m_contexts.begin() + lookup(level, trange);
 }
 
 Contexts::iterator Contexts::obtain(const Level& level, const Trange& trange)
 {
-    iterator pos = find(level, trange);
-    if (pos != end())
-        return pos;
-    return insert_new(level, trange);
+    if (m_deferred)
+    {
+        size_t pos = lookup(level, trange);
+        if (pos != m_contexts.size())
+            return m_contexts.begin() + pos;
+        m_contexts.emplace_back(level, trange);
+        m_index.emplace(Key(level, trange), pos);
+        return m_contexts.begin() + pos;
+    }
+
+    auto i = std::lower_bound(m_contexts.begin(), m_contexts.end(), Key(level, trange), [](const Context& c, const Key& key) {
+        return c.compare(key.first, key.second) < 0;
+    });
+    if (i != m_contexts.end() && i->compare(level, trange) == 0)
+        return i;
+    return m_contexts.emplace(i, level, trange);
 }
 
 bool Contexts::drop(const Level& level, const Trange& trange)
 {
-    iterator pos = find(level, trange);
-    if (pos == end())
+    size_t pos = lookup(level, trange);
+    if (pos == m_contexts.size())
         return false;
-    m_contexts.erase(pos);
+    erase(m_contexts.begin() + pos);
     return true;
 }
 
+void Contexts::defer_sorting()
+{
+    if (m_deferred)
+        return;
+    m_deferred = true;
+    reindex();
+}
+
+void Contexts::sort()
+{
+    if (!m_deferred)
+        return;
+    std::sort(m_contexts.begin(), m_contexts.end(), [](const Context& a, const Context& b) { return a.compare(b) < 0; });
+    m_deferred = false;
+    m_index.clear();
+}
+
+void Contexts::clear()
+{
+    m_contexts.clear();
+    m_index.clear();
+}
+
+void Contexts::reserve(typename std::vector<Value>::size_type size)
+{
+    m_contexts.reserve(size);
+    if (m_deferred)
+        m_index.reserve(size);
+}
+
+Contexts::iterator Contexts::erase(iterator pos)
+{
+    auto res = m_contexts.erase(pos);
+    if (m_deferred)
+        reindex();
+    return res;
+}
+
 
 Messages messages_from_csv(CSVReader& in)
 {
@@ -812,6 +845,24 @@ void Message::set(const Shortcut& shortcut, const wreport::Var& var)
         set(shortcut.level, shortcut.trange, shortcut.code, var);
 }
 
+void Message::set(const Shortcut& shortcut, wreport::Var&& var)
+{
+    if (shortcut.station_data)
+    {
+        if (shortcut.code == var.code())
+            station_data.set(unique_ptr<Var>(new Var(std::move(var))));
+        else
+            station_data.set(var_move_without_unset_attrs(std::move(var), shortcut.code));
+    }
+    else
+        set(shortcut.level, shortcut.trange, shortcut.code, std::move(var));
+}
+
+void Message::set(const Level& lev, const Trange& tr, wreport::Varcode code, wreport::Var&& var)
+{
+    set_impl(lev, tr, var_move_without_unset_attrs(std::move(var), code));
+}
+
 void Message::set_impl(const Level& lev, const Trange& tr, std::unique_ptr<Var> var)
 {
     if (lev.is_missing() && tr.is_missing())
@@ -12,6 +12,7 @@
 #include <dballe/exporter.h>
 #include <stdio.h>
 #include <vector>
+#include <unordered_map>
 #include <memory>
 #include <iosfwd>
 
@@ -78,6 +79,17 @@ unsigned messages_diff(const Messages& msgs1, const Messages& msgs2);
 void messages_print(const Messages& msgs, FILE* out);
 
 
+/**
+ * Collection of Context objects, indexed by Level and Trange.
+ *
+ * Contexts are kept sorted. Inserting or removing a context invalidates
+ * pointers and references to the contexts that follow it.
+ *
+ * To build messages with thousands of contexts (like TEMP soundings) without
+ * moving contexts around at each insertion, call defer_sorting() before
+ * adding them, and sort() when done. In between, contexts are looked up
+ * through a hash index, and iteration follows insertion order.
+ */
 class Contexts
 {
 public:
@@ -87,9 +99,24 @@ public:
     typedef std::vector<msg::Context>::reverse_iterator reverse_iterator;
 
 protected:
+    typedef std::pair<Level, Trange> Key;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    /// Contexts, sorted unless sorting is deferred
     std::vector<msg::Context> m_contexts;
+    /// Position of each context in m_contexts, while sorting is deferred
+    std::unordered_map<Key, size_t, KeyHash> m_index;
+    /// True if sorting is deferred
+    bool m_deferred = false;
 
-    iterator insert_new(const Level& level, const Trange& trange);
+    /// Rebuild m_index after contexts have moved
+    void reindex();
+    /// Position of the context in m_contexts, or m_contexts.size() if missing
+    size_t lookup(const Level& level, const Trange& trange) const;
 
 public:
     Contexts() = default;
@@ -113,11 +140,17 @@ public:
     iterator obtain(const Level& level, const Trange& trange);
     bool drop(const Level& level, const Trange& trange);
 
+    /// Append new contexts in insertion order until sort() is called
+    void defer_sorting();
+
+    /// Sort the contexts, and keep them sorted from now on
+    void sort();
+
     size_t size() const { return m_contexts.size(); }
     bool empty() const { return m_contexts.empty(); }
-    void clear() { return m_contexts.clear(); }
-    void reserve(typename std::vector<Value>::size_type size) { m_contexts.reserve(size); }
-    iterator erase(iterator pos) { return m_contexts.erase(pos); }
+    void clear();
+    void reserve(typename std::vector<Value>::size_type size);
+    iterator erase(iterator pos);
     // iterator erase(const_iterator pos) { return m_contexts.erase(pos); }
 };
 
@@ -213,6 +246,22 @@ public:
      */
     void set(const Shortcut& shortcut, const wreport::Var& var);
 
+    /**
+     * Add or replace a value, taking the contents of \a var instead of
+     * copying them when possible.
+     *
+     * \a var is left in an unspecified state.
+     */
+    void set(const Shortcut& shortcut, wreport::Var&& var);
+
+    /**
+     * Add or replace a value with code \a code, taking the contents of \a var
+     * instead of copying them when possible.
+     *
+     * \a var is left in an unspecified state.
+     */
+    void set(const Level& lev, const Trange& tr, wreport::Varcode code, wreport::Var&& var);
+
     /**
      * Shortcut to set year...second variables in a single call
      */
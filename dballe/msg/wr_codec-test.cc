@@ -2,6 +2,7 @@
 #include "wr_codec.h"
 #include "dballe/file.h"
 #include <wreport/options.h>
+#include <wreport/bulletin.h>
 #include <cstring>
 
 using namespace std;
@@ -51,6 +52,41 @@ add_method("issue239", []() {
     wassert(actual(var->enqi()) == 12);
 });
 
+add_method("consume_bulletin", []() {
+    // Importing a temporary bulletin gives the same results as importing a
+    // bulletin that is kept
+    impl::msg::BufrImporter importer;
+    const char* fnames[] = {
+        "bufr/gen-generic.bufr",
+        "bufr/generic-bug20140403.bufr",
+        "bufr/synop-cloudbelow.bufr",
+        "bufr/ecmwf-ship-1-11.bufr",
+        "bufr/obs0-3.504.bufr",
+        "bufr/gts-acars1.bufr",
+        "bufr/temp-gts1.bufr",
+    };
+    for (auto fname: fnames)
+    {
+        WREPORT_TEST_INFO(info);
+        info() << fname;
+        auto file = File::create(Encoding::BUFR, tests::datafile(fname), "r");
+        file->foreach([&](const BinaryMessage& bmsg) {
+            auto kept = wreport::BufrBulletin::decode(bmsg.data);
+            impl::Messages copied = importer.from_bulletin(*kept);
+
+            impl::Messages moved;
+            auto consumed = wreport::BufrBulletin::decode(bmsg.data);
+            importer.foreach_decoded_bulletin(std::move(*consumed), [&](std::shared_ptr<Message> msg) {
+                moved.emplace_back(msg);
+                return true;
+            });
+
+            wassert(actual(impl::msg::messages_diff(copied, moved)) == 0u);
+            return true;
+        });
+    }
+});
+
 add_method("domain_throw", []() {
     auto file = File::create(Encoding::BUFR, tests::datafile("bufr/interpreted-range.bufr"), "r");
     auto options = ImporterOptions::create();
@@ -26,7 +26,7 @@ BufrImporter::~BufrImporter() {}
 bool BufrImporter::foreach_decoded(const BinaryMessage& msg, std::function<bool(std::shared_ptr<dballe::Message>)> dest) const
 {
     unique_ptr<BufrBulletin> bulletin(BufrBulletin::decode(msg.data));
-    return foreach_decoded_bulletin(*bulletin, dest);
+    return foreach_decoded_bulletin(std::move(*bulletin), dest);
 }
 
 CrexImporter::CrexImporter(const dballe::ImporterOptions& opts)
@@ -36,7 +36,7 @@ CrexImporter::~CrexImporter() {}
 bool CrexImporter::foreach_decoded(const BinaryMessage& msg, std::function<bool(std::shared_ptr<dballe::Message>)> dest) const
 {
     unique_ptr<CrexBulletin> bulletin(CrexBulletin::decode(msg.data));
-    return foreach_decoded_bulletin(*bulletin, dest);
+    return foreach_decoded_bulletin(std::move(*bulletin), dest);
 }
 
 Messages WRImporter::from_bulletin(const wreport::Bulletin& msg) const
@@ -46,10 +46,8 @@ Messages WRImporter::from_bulletin(const wreport::Bulletin& msg) const
     return res;
 }
 
-bool WRImporter::foreach_decoded_bulletin(const wreport::Bulletin& msg, std::function<bool(std::shared_ptr<dballe::Message>)> dest) const
+std::unique_ptr<wr::Importer> WRImporter::create_importer(const wreport::Bulletin& msg) const
 {
-    WreportVarOptionsForImport wreport_config(opts.domain_errors);
-
     // Infer the right importer. See Common Code Table C-13
     std::unique_ptr<wr::Importer> importer;
     switch (msg.data_category)
@@ -91,7 +89,13 @@ bool WRImporter::foreach_decoded_bulletin(const wreport::Bulletin& msg, std::fun
         case 8: importer = wr::Importer::createPollution(opts); break;
         default: importer = wr::Importer::createGeneric(opts); break;
     }
+    return importer;
+}
 
+bool WRImporter::foreach_decoded_bulletin(const wreport::Bulletin& msg, std::function<bool(std::shared_ptr<dballe::Message>)> dest) const
+{
+    WreportVarOptionsForImport wreport_config(opts.domain_errors);
+    auto importer = create_importer(msg);
     MessageType type = importer->scanType(msg);
     for (unsigned i = 0; i < msg.subsets.size(); ++i)
     {
@@ -104,6 +108,22 @@ bool WRImporter::foreach_decoded_bulletin(const wreport::Bulletin& msg, std::fun
     return true;
 }
 
+bool WRImporter::foreach_decoded_bulletin(wreport::Bulletin&& msg, std::function<bool(std::shared_ptr<dballe::Message>)> dest) const
+{
+    WreportVarOptionsForImport wreport_config(opts.domain_errors);
+    auto importer = create_importer(msg);
+    MessageType type = importer->scanType(msg);
+    for (unsigned i = 0; i < msg.subsets.size(); ++i)
+    {
+        auto newmsg = std::make_shared<Message>();
+        newmsg->type = type;
+        importer->import(std::move(msg.subsets[i]), *newmsg);
+        if (!dest(newmsg))
+            return false;
+    }
+    return true;
+}
+
 
 WRExporter::WRExporter(const dballe::ExporterOptions& opts)
     : BulletinExporter(opts) {}
@@ -20,8 +20,16 @@ namespace dballe {
 namespace impl {
 namespace msg {
 
+namespace wr {
+class Importer;
+}
+
 class WRImporter : public BulletinImporter
 {
+protected:
+    /// Create the importer for the data category of \a msg
+    std::unique_ptr<wr::Importer> create_importer(const wreport::Bulletin& msg) const;
+
 public:
     WRImporter(const dballe::ImporterOptions& opts);
 
@@ -43,6 +51,14 @@ public:
      * @returns true if it got to the end of decoding, false if dest returned false.
      */
     bool foreach_decoded_bulletin(const wreport::Bulletin& msg, std::function<bool(std::shared_ptr<dballe::Message>)> dest) const;
+
+    /**
+     * Same as foreach_decoded_bulletin(const wreport::Bulletin&), but move
+     * variables out of \a msg instead of copying them, when possible.
+     *
+     * The subsets of \a msg are left in an unspecified state.
+     */
+    bool foreach_decoded_bulletin(wreport::Bulletin&& msg, std::function<bool(std::shared_ptr<dballe::Message>)> dest) const;
 };
 
 class BufrImporter : public WRImporter
@@ -162,6 +178,15 @@ public:
     virtual const char* name() const = 0;
     virtual const char* description() const = 0;
     virtual void to_bulletin(wreport::Bulletin& bulletin);
+
+    /**
+     * Check if messages using this template can be encoded as subsets of the
+     * same bulletin.
+     *
+     * This is false for templates whose data descriptor section depends on
+     * the contents of each message.
+     */
+    virtual bool supports_multiple_subsets() const { return true; }
 };
 
 struct TemplateFactory
@@ -167,6 +167,38 @@ class Tests : public TestCase
             }
         });
 
+        add_method("unsorted_contexts", []() {
+            // Exporting gives the same results regardless of the order in
+            // which contexts were added to the message
+            struct Case { const char* fname; const char* template_name; };
+            Case cases[] = {
+                { "bufr/obs0-1.22.bufr", "synop-wmo" },
+                { "bufr/temp-gts1.bufr", "temp-wmo" },
+            };
+            for (const auto& c: cases)
+            {
+                WREPORT_TEST_INFO(info);
+                info() << c.fname;
+                impl::Messages msgs = read_msgs(c.fname, Encoding::BUFR);
+                const impl::Message& orig = impl::Message::downcast(*msgs[0]);
+
+                auto reversed = std::make_shared<impl::Message>();
+                reversed->type = orig.type;
+                reversed->station_data = orig.station_data;
+                for (auto i = orig.data.rbegin(); i != orig.data.rend(); ++i)
+                    reversed->obtain_context(i->level, i->trange).values = i->values;
+
+                auto export_opts = ExporterOptions::create();
+                export_opts->template_name = c.template_name;
+                auto exporter = get_exporter(Encoding::BUFR, *export_opts);
+                impl::Messages expected_msgs { msgs[0] };
+                impl::Messages reversed_msgs { reversed };
+                unique_ptr<Bulletin> expected = exporter->to_bulletin(expected_msgs);
+                unique_ptr<Bulletin> exported = exporter->to_bulletin(reversed_msgs);
+                wassert(actual(exported->encode()) == expected->encode());
+            }
+        });
+
         // Re-export tests for old style synops
         add_testcodec("obs0-1.22.bufr", [](TestCodec& test) {
             test.expected_min_vars = 34;
@@ -26,6 +26,7 @@ struct Generic : public Template
 
     virtual const char* name() const { return GENERIC_NAME; }
     virtual const char* description() const { return GENERIC_DESC; }
+    virtual bool supports_multiple_subsets() const { return false; }
 
     void add_var_and_attrs(const Var& var)
     {
@@ -32,19 +32,50 @@ void Importer::init()
 void Importer::import(const wreport::Subset& subset, Message& msg)
 {
     this->subset = &subset;
+    this->consumable_subset = nullptr;
     this->msg = &msg;
+    msg.data.defer_sorting();
     init();
     run();
+    msg.data.sort();
+}
+
+void Importer::import(wreport::Subset&& subset, Message& msg)
+{
+    this->subset = &subset;
+    this->consumable_subset = &subset;
+    this->msg = &msg;
+    msg.data.defer_sorting();
+    init();
+    run();
+    msg.data.sort();
+    this->consumable_subset = nullptr;
+}
+
+wreport::Var* Importer::consumable(const wreport::Var& var) const
+{
+    if (!consumable_subset || consumable_subset->empty())
+        return nullptr;
+    const Var* begin = consumable_subset->data();
+    if (&var < begin || &var >= begin + consumable_subset->size())
+        return nullptr;
+    return consumable_subset->data() + (&var - begin);
 }
 
 void Importer::set(const wreport::Var& var, const Shortcut& shortcut)
 {
-    msg->set(shortcut, var);
+    if (Var* v = consumable(var))
+        msg->set(shortcut, std::move(*v));
+    else
+        msg->set(shortcut, var);
 }
 
 void Importer::set(const wreport::Var& var, wreport::Varcode code, const Level& level, const Trange& trange)
 {
-    msg->set(level, trange, code, var);
+    if (Var* v = consumable(var))
+        msg->set(level, trange, code, std::move(*v));
+    else
+        msg->set(level, trange, code, var);
 }
 
 std::unique_ptr<Importer> Importer::createSat(const dballe::ImporterOptions&) { throw error_unimplemented("WB sat Importers"); }
@@ -22,11 +22,19 @@ class Importer
 protected:
     const dballe::ImporterOptions& opts;
     const wreport::Subset* subset;
+    /// Subset being imported, if its variables can be moved into msg
+    wreport::Subset* consumable_subset = nullptr;
     impl::Message* msg;
 
     virtual void init();
     virtual void run() = 0;
 
+    /**
+     * Return a non-const pointer to \a var if it is a variable of a subset
+     * that can be consumed during import, nullptr otherwise.
+     */
+    wreport::Var* consumable(const wreport::Var& var) const;
+
     void set(const wreport::Var& var, const Shortcut& shortcut);
     void set(const wreport::Var& var, wreport::Varcode code, const Level& level, const Trange& trange);
 
@@ -38,6 +46,14 @@ public:
 
     void import(const wreport::Subset& subset, impl::Message& msg);
 
+    /**
+     * Import \a subset, moving its variables into \a msg instead of copying
+     * them when possible.
+     *
+     * The variables of \a subset are left in an unspecified state.
+     */
+    void import(wreport::Subset&& subset, impl::Message& msg);
+
     static std::unique_ptr<Importer> createSynop(const dballe::ImporterOptions&);
     static std::unique_ptr<Importer> createShip(const dballe::ImporterOptions&);
     static std::unique_ptr<Importer> createMetar(const dballe::ImporterOptions&);
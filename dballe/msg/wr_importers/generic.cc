@@ -61,11 +61,21 @@ public:
                 if (pos + 1 < subset->size() &&
                         WR_VAR_X((*subset)[pos + 1].code()) == 33)
                 {
-                    Var copy(var);
-                    for ( ; pos + 1 < subset->size() &&
-                            WR_VAR_X((*subset)[pos + 1].code()) == 33; ++pos)
-                        copy.seta((*subset)[pos + 1]);
-                    import_defined(copy);
+                    if (Var* target = consumable(var))
+                    {
+                        // Add attributes in place, if we can consume the
+                        // subset
+                        for ( ; pos + 1 < subset->size() &&
+                                WR_VAR_X((*subset)[pos + 1].code()) == 33; ++pos)
+                            target->seta((*subset)[pos + 1]);
+                        import_defined(*target);
+                    } else {
+                        Var copy(var);
+                        for ( ; pos + 1 < subset->size() &&
+                                WR_VAR_X((*subset)[pos + 1].code()) == 33; ++pos)
+                            copy.seta((*subset)[pos + 1]);
+                        import_defined(copy);
+                    }
                 } else
                     import_defined(var);
         }
@@ -149,7 +159,10 @@ void GenericImporter::import_var(const Var& var)
         case WR_VAR(0,  4,  6): msg->set_second_var(var); break;
         // Anything else
         default:
-            msg->set(lev, tr, map_code_to_dballe(var.code()), var);
+            if (Var* v = consumable(var))
+                msg->set(lev, tr, map_code_to_dballe(var.code()), std::move(*v));
+            else
+                msg->set(lev, tr, map_code_to_dballe(var.code()), var);
             break;
     }
 }
@@ -248,6 +248,121 @@ class Tests : public FixtureTestCase<ConnectorFixture>
             wassert(actual(res4.rowcount()) == 1);
             wassert(actual(res4.get_timestamp(0, 0)) == Datetime(1945, 4, 25, 8, 10, 20));
         });
+
+        add_method("run_chunked", [](Fixture& f) {
+            // Test fetching query results in batches
+            auto& conn = f.conn;
+            conn->exec_no_data("INSERT INTO dballe_test SELECT generate_series(1, 2500)");
+            unsigned orig_fetch_size = conn->fetch_size;
+
+            auto check = [&](unsigned fetch_size, bool in_transaction) {
+                conn->fetch_size = fetch_size;
+                unique_ptr<Transaction> t;
+                if (in_transaction) t = conn->transaction();
+                const char* args[1] = { "100" };
+                unsigned count = 0;
+                unsigned max_batch = 0;
+                long sum = 0;
+                conn->run_chunked("SELECT val FROM dballe_test WHERE val > $1::int4 ORDER BY val", 1, args, [&](const postgresql::Result& res) {
+                    max_batch = max(max_batch, res.rowcount());
+                    for (unsigned row = 0; row < res.rowcount(); ++row)
+                    {
+                        sum += res.get_int4(row, 0);
+                        ++count;
+                    }
+                });
+                if (t) t->commit();
+                wassert(actual(count) == 2400u);
+                wassert(actual(sum) == 2500l * 2501 / 2 - 100 * 101 / 2);
+                wassert(actual(max_batch <= fetch_size).istrue());
+            };
+
+            wassert(check(1, false));
+            wassert(check(1, true));
+            wassert(check(1000, false));
+            wassert(check(1000, true));
+
+            // The connection is still usable after the callback throws
+            conn->fetch_size = 1000;
+            {
+                auto t = conn->transaction();
+                auto e = wassert_throws(std::runtime_error, conn->run_chunked("SELECT val FROM dballe_test", 0, nullptr, [&](const postgresql::Result&) {
+                    throw std::runtime_error("stop");
+                }));
+                wassert(actual(e.what()) == "stop");
+                auto res = conn->exec_one_row("SELECT COUNT(*) FROM dballe_test");
+                wassert(actual(res.get_int8(0, 0)) == 2500u);
+                t->commit();
+            }
+
+            conn->fetch_size = orig_fetch_size;
+        });
+
+        add_method("statement_cache", [](Fixture& f) {
+            // Test reusing prepared statements for queries run more than once
+            auto& conn = f.conn;
+            conn->exec_no_data("INSERT INTO dballe_test SELECT generate_series(1, 10)");
+            unsigned orig_size = conn->statement_cache_size;
+            conn->statement_cache_size = 2;
+
+            auto is_prepared = [&](const std::string& query) {
+                auto res = conn->exec_one_row("SELECT COUNT(*) FROM pg_prepared_statements WHERE statement = '" + query + "'");
+                return res.get_int8(0, 0) > 0;
+            };
+            auto run = [&](const char* query, const char* arg) {
+                const char* args[1] = { arg };
+                unsigned count = 0;
+                conn->run_chunked(query, 1, args, [&](const postgresql::Result& res) {
+                    count += res.rowcount();
+                });
+                return count;
+            };
+            const char* q1 = "SELECT val FROM dballe_test WHERE val > $1::int4";
+            const char* q2 = "SELECT val FROM dballe_test WHERE val < $1::int4";
+            const char* q3 = "SELECT val FROM dballe_test WHERE val = $1::int4";
+
+            // A query is prepared the second time it is run
+            wassert(actual(run(q1, "2")) == 8u);
+            wassert_false(is_prepared(q1));
+            wassert(actual(run(q1, "5")) == 5u);
+            wassert_true(is_prepared(q1));
+            wassert(actual(run(q1, "9")) == 1u);
+            wassert_true(is_prepared(q1));
+
+            // Least recently used statements are deallocated
+            wassert(actual(run(q2, "3")) == 2u);
+            wassert(actual(run(q3, "3")) == 1u);
+            wassert_false(is_prepared(q1));
+
+#ifndef LIBPQ_HAS_CHUNK_MODE
+            {
+                // Queries run through cursors prepare their DECLARE
+                // statement, named by nesting level
+                unsigned orig_fetch_size = conn->fetch_size;
+                conn->fetch_size = 1000;
+                auto t = conn->transaction();
+                std::string declare0 = std::string("DECLARE dballe_fetch_0 NO SCROLL CURSOR FOR ") + q1;
+                std::string declare1 = std::string("DECLARE dballe_fetch_1 NO SCROLL CURSOR FOR ") + q1;
+                wassert(actual(run(q1, "2")) == 8u);
+                wassert_false(is_prepared(declare0));
+                wassert(actual(run(q1, "5")) == 5u);
+                wassert_true(is_prepared(declare0));
+
+                // Nested queries use a different cursor
+                unsigned nested = 0;
+                const char* args[1] = { "8" };
+                conn->run_chunked(q1, 1, args, [&](const postgresql::Result&) {
+                    nested += run(q1, "8") + run(q1, "8");
+                });
+                wassert(actual(nested) == 4u);
+                wassert_true(is_prepared(declare1));
+                t->rollback();
+                conn->fetch_size = orig_fetch_size;
+            }
+#endif
+
+            conn->statement_cache_size = orig_size;
+        });
     }
 } test("db_sql_postgresql", "POSTGRESQL");
 
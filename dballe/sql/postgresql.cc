@@ -6,6 +6,7 @@
 #include "querybuf.h"
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <arpa/inet.h>
 #include <endian.h>
 #include <unistd.h>
@@ -249,6 +250,27 @@ void PostgreSQLConnection::init_after_connect()
     server_type = ServerType::POSTGRES;
     // Hide warning notices, like "table does not exists" in "DROP TABLE ... IF EXISTS"
     exec_no_data("SET client_min_messages = error");
+
+    const char* envsize = getenv("DBA_DB_FETCH_SIZE");
+    if (envsize)
+    {
+        int size = atoi(envsize);
+        if (size > 0)
+            fetch_size = size;
+    }
+}
+
+postgresql::Result PostgreSQLConnection::exec_unchecked(const std::string& query, const std::vector<std::string>& params)
+{
+    check_connection();
+    std::vector<const char*> args;
+    args.reserve(params.size());
+    for (const auto& p: params)
+        args.push_back(p.c_str());
+    auto res = PQexecParams(db, query.c_str(), args.size(), nullptr, args.data(), nullptr, nullptr, 1);
+    if (!res)
+        throw error_postgresql(db, "cannot execute query " + query);
+    return res;
 }
 
 void PostgreSQLConnection::pqexec(const std::string& query)
@@ -371,8 +393,6 @@ void PostgreSQLConnection::discard_all_input_nothrow() noexcept
 
 void PostgreSQLConnection::run_single_row_mode(const std::string& query_desc, std::function<void(const postgresql::Result&)> dest)
 {
-    using namespace dballe::sql::postgresql;
-
     // http://www.postgresql.org/docs/9.4/static/libpq-single-row-mode.html
     if (!PQsetSingleRowMode(db))
     {
@@ -382,6 +402,13 @@ void PostgreSQLConnection::run_single_row_mode(const std::string& query_desc, st
         throw error_postgresql(errmsg, "cannot set single row mode for query " + query_desc);
     }
 
+    fetch_results(query_desc, PGRES_SINGLE_TUPLE, dest);
+}
+
+void PostgreSQLConnection::fetch_results(const std::string& query_desc, ExecStatusType row_status, std::function<void(const postgresql::Result&)> dest)
+{
+    using namespace dballe::sql::postgresql;
+
     while (true)
     {
         Result res(PQgetResult(db));
@@ -393,9 +420,9 @@ void PostgreSQLConnection::run_single_row_mode(const std::string& query_desc, st
         //  (http://www.postgresql.org/docs/9.1/static/libpq-async.html)
 
         // If we get what we don't want, cancel, flush our input and throw
-        if (PQresultStatus(res) == PGRES_SINGLE_TUPLE)
+        if (PQresultStatus(res) == row_status)
         {
-            // Ok, we have a tuple
+            // Ok, we have tuples
         } else if (PQresultStatus(res) == PGRES_TUPLES_OK) {
             // No more rows will arrive
             continue;
@@ -425,6 +452,240 @@ void PostgreSQLConnection::run_single_row_mode(const std::string& query_desc, st
     }
 }
 
+const char* PostgreSQLConnection::cached_statement(const std::string& query)
+{
+    using namespace postgresql;
+
+    if (statement_cache_size == 0)
+        return nullptr;
+
+    auto i = statement_cache_index.find(query);
+    if (i == statement_cache_index.end())
+    {
+        // First time we see this query: remember it, and run it unprepared
+        statement_cache.emplace_front(query, std::string());
+        statement_cache_index[query] = statement_cache.begin();
+        while (statement_cache.size() > statement_cache_size)
+        {
+            const auto& evicted = statement_cache.back();
+            // Deallocating fails in an aborted transaction: in that case the
+            // statement is left on the server until the connection is closed
+            if (!evicted.second.empty() && PQtransactionStatus(db) != PQTRANS_INERROR)
+                pqexec_nothrow("DEALLOCATE " + evicted.second);
+            statement_cache_index.erase(evicted.first);
+            statement_cache.pop_back();
+        }
+        return nullptr;
+    }
+
+    statement_cache.splice(statement_cache.begin(), statement_cache, i->second);
+    std::string& name = i->second->second;
+    if (name.empty())
+    {
+        char buf[32];
+        snprintf(buf, 32, "dballe_stm_%u", ++statement_seq);
+        Result res(PQprepare(db, buf, query.c_str(), 0, nullptr));
+        res.expect_no_data("prepare:" + query);
+        name = buf;
+    }
+    return name.c_str();
+}
+
+void PostgreSQLConnection::send_query(const std::string& query, int nparams, const char* const* params)
+{
+    int sent;
+    if (const char* name = cached_statement(query))
+        sent = PQsendQueryPrepared(db, name, nparams, params, nullptr, nullptr, 1);
+    else
+        sent = PQsendQueryParams(db, query.c_str(), nparams, nullptr, params, nullptr, nullptr, 1);
+    if (!sent)
+        throw error_postgresql(db, "executing " + query);
+}
+
+void PostgreSQLConnection::run_cursor(const std::string& query, int nparams, const char* const* params, std::function<void(const postgresql::Result&)> dest)
+{
+    using namespace dballe::sql::postgresql;
+
+    // Name cursors by nesting level, so that the DECLARE statement of a
+    // query can go through the prepared statement cache
+    char name[32];
+    snprintf(name, 32, "dballe_fetch_%u", cursor_depth);
+
+    string declare = "DECLARE ";
+    declare += name;
+    declare += " NO SCROLL CURSOR FOR ";
+    declare += query;
+    Result res;
+    if (const char* stm = cached_statement(declare))
+        res = PQexecPrepared(db, stm, nparams, params, nullptr, nullptr, 1);
+    else
+        res = PQexecParams(db, declare.c_str(), nparams, nullptr, params, nullptr, nullptr, 1);
+    if (!res)
+        throw error_postgresql(db, "cannot execute query " + declare);
+    res.expect_success(declare);
+
+    ++cursor_depth;
+
+    char fetch[64];
+    snprintf(fetch, 64, "FETCH FORWARD %u FROM %s", fetch_size, name);
+    try {
+        while (true)
+        {
+            Result rows(exec_unchecked(fetch));
+            rows.expect_result(query);
+            if (rows.rowcount() == 0)
+                break;
+            dest(rows);
+        }
+    } catch (std::exception& e) {
+        // Close the cursor, unless the error aborted the transaction and
+        // took the cursor with it
+        if (PQtransactionStatus(db) == PQTRANS_INTRANS)
+            pqexec_nothrow(string("CLOSE ") + name);
+        --cursor_depth;
+        throw;
+    }
+    --cursor_depth;
+    pqexec(string("CLOSE ") + name);
+}
+
+void PostgreSQLConnection::run_chunked(const std::string& query, const std::vector<std::string>& params, std::function<void(const postgresql::Result&)> dest)
+{
+    std::vector<const char*> args;
+    args.reserve(params.size());
+    for (const auto& p: params)
+        args.push_back(p.c_str());
+    run_chunked(query, args.size(), args.data(), dest);
+}
+
+void PostgreSQLConnection::run_chunked(const std::string& query, int nparams, const char* const* params, std::function<void(const postgresql::Result&)> dest)
+{
+    check_connection();
+
+    if (fetch_size > 1)
+    {
+#ifdef LIBPQ_HAS_CHUNK_MODE
+        // libpq 17 can send us rows in batches
+        send_query(query, nparams, params);
+        if (!PQsetChunkedRowsMode(db, fetch_size))
+        {
+            string errmsg(PQerrorMessage(db));
+            cancel_running_query_nothrow();
+            discard_all_input_nothrow();
+            throw error_postgresql(errmsg, "cannot set chunked rows mode for query " + query);
+        }
+        fetch_results(query, PGRES_TUPLES_CHUNK, dest);
+        return;
+#else
+        // Cursors can only be declared inside a transaction
+        if (PQtransactionStatus(db) == PQTRANS_INTRANS)
+        {
+            run_cursor(query, nparams, params, dest);
+            return;
+        }
+#endif
+    }
+
+    send_query(query, nparams, params);
+    run_single_row_mode(query, dest);
+}
+
+namespace postgresql {
+
+Pipeline::Pipeline(PostgreSQLConnection& conn, std::function<void(unsigned idx, const Result& res)> dest, unsigned max_pending)
+    : conn(conn), dest(dest), max_pending(max_pending)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+    if (!PQenterPipelineMode(conn))
+        throw error_postgresql(conn, "cannot enter pipeline mode");
+#endif
+}
+
+Pipeline::~Pipeline()
+{
+#ifdef LIBPQ_HAS_PIPELINING
+    discard_pending_nothrow();
+    if (!PQexitPipelineMode(conn))
+        fprintf(stderr, "cannot exit PostgreSQL pipeline mode: %s\n", PQerrorMessage(conn));
+#endif
+}
+
+void Pipeline::send_prepared_params(const char* name, int count, const char* const* args, const int* lengths, const int* formats)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+    // Read results from time to time, to bound the memory used to buffer
+    // them on both sides of the connection
+    if (pending.size() >= max_pending)
+        flush();
+    if (!PQsendQueryPrepared(conn, name, count, args, lengths, formats, 1))
+        throw error_postgresql(conn, string("cannot queue prepared query ") + name);
+    pending.emplace_back(name);
+#else
+    Result res(PQexecPrepared(conn, name, count, args, lengths, formats, 1));
+    if (!res)
+        throw error_postgresql(conn, string("cannot execute prepared query ") + name);
+    res.expect_result(name);
+    dest(done++, res);
+#endif
+}
+
+void Pipeline::flush()
+{
+#ifdef LIBPQ_HAS_PIPELINING
+    if (pending.empty()) return;
+
+    if (!PQpipelineSync(conn))
+        throw error_postgresql(conn, "cannot synchronize pipeline");
+
+    // Read all the results up to the synchronization point, even after an
+    // error, to leave the connection ready for the next query
+    std::exception_ptr error;
+    for (const auto& name: pending)
+    {
+        Result res(PQgetResult(conn));
+        if (!res)
+        {
+            if (!error)
+                error = std::make_exception_ptr(error_postgresql(conn, "no result returned by pipelined query " + name));
+            continue;
+        }
+        if (!error)
+        {
+            try {
+                res.expect_result(name);
+                dest(done, res);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        ++done;
+        // Skip the null result that follows the results of each query
+        Result end(PQgetResult(conn));
+    }
+    pending.clear();
+
+    Result sync(PQgetResult(conn));
+    if (!error && PQresultStatus(sync) != PGRES_PIPELINE_SYNC)
+        error = std::make_exception_ptr(error_postgresql(sync, "synchronizing pipeline"));
+
+    if (error)
+        std::rethrow_exception(error);
+#endif
+}
+
+void Pipeline::discard_pending_nothrow() noexcept
+{
+    if (pending.empty()) return;
+    try {
+        dest = [](unsigned, const Result&) {};
+        flush();
+    } catch (std::exception& e) {
+        fprintf(stderr, "discarding pipelined query results: %s\n", e.what());
+    }
+}
+
+}
+
 bool PostgreSQLConnection::has_table(const std::string& name)
 {
     using namespace postgresql;
@@ -490,6 +751,11 @@ void PostgreSQLConnection::execute(const std::string& query)
 }
 
 void PostgreSQLConnection::explain(const std::string& query, FILE* out)
+{
+    explain(query, std::vector<std::string>(), out);
+}
+
+void PostgreSQLConnection::explain(const std::string& query, const std::vector<std::string>& params, FILE* out)
 {
     using namespace dballe::sql::postgresql;
 
@@ -497,7 +763,7 @@ void PostgreSQLConnection::explain(const std::string& query, FILE* out)
     explain_query += query;
 
     fprintf(out, "%s\n", explain_query.c_str());
-    Result res = exec(explain_query);
+    Result res = exec(explain_query, params);
     for (unsigned row = 0; row < res.rowcount(); ++row)
         fprintf(out, "  %s\n", res.get_string(row, 0));
 }
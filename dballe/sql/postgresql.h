@@ -9,6 +9,9 @@
 #include <arpa/inet.h>
 #include <vector>
 #include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace dballe {
@@ -246,10 +249,45 @@ protected:
     std::unordered_set<std::string> prepared_names;
     /// Marker to catch attempts to reuse connections in forked processes
     bool forked = false;
+    /**
+     * Number of server-side cursors currently open, used to name them, so
+     * that the DECLARE text of a query is the same each time it is run
+     */
+    unsigned cursor_depth = 0;
+    /**
+     * Queries run by run_chunked, most recently used first, with the name of
+     * their prepared statement, or an empty name if they have not been
+     * prepared yet
+     */
+    std::list<std::pair<std::string, std::string>> statement_cache;
+    /// Index of statement_cache by query text
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::string>>::iterator> statement_cache_index;
+    /// Sequence number used to name cached prepared statements
+    unsigned statement_seq = 0;
 
 protected:
     void init_after_connect();
 
+    /// Read the results of an asynchronous query, whose rows come as \a row_status results
+    void fetch_results(const std::string& query_desc, ExecStatusType row_status, std::function<void(const postgresql::Result&)> dest);
+
+    /**
+     * Return the name of the prepared statement to use to run \a query, or
+     * nullptr to run it as an unnamed statement.
+     *
+     * Queries are prepared the second time they are seen, so that queries
+     * that are run only once do not pay for an extra round trip to the
+     * server. The least recently used statements are deallocated when more
+     * than statement_cache_size queries are tracked.
+     */
+    const char* cached_statement(const std::string& query);
+
+    /// Send a query, using a cached prepared statement if available
+    void send_query(const std::string& query, int nparams, const char* const* params);
+
+    /// Run a query through a server-side cursor, fetching fetch_size rows at a time
+    void run_cursor(const std::string& query, int nparams, const char* const* params, std::function<void(const postgresql::Result&)> dest);
+
     PostgreSQLConnection();
 
     void fork_prepare() override;
@@ -265,6 +303,20 @@ public:
 
     PostgreSQLConnection& operator=(const PostgreSQLConnection&) = delete;
 
+    /**
+     * Number of rows fetched at a time by run_chunked.
+     *
+     * It defaults to the value of the DBA_DB_FETCH_SIZE environment variable,
+     * or 1000 if it is not set. 1 fetches one row at a time.
+     */
+    unsigned fetch_size = 1000;
+
+    /**
+     * Maximum number of queries tracked by the cache of prepared statements
+     * used by run_chunked. 0 disables the cache.
+     */
+    unsigned statement_cache_size = 32;
+
     static std::shared_ptr<PostgreSQLConnection> create();
 
     operator PGconn*() { return db; }
@@ -301,6 +353,9 @@ public:
         return res;
     }
 
+    /// Run a query with any number of text parameters, without checking the result
+    postgresql::Result exec_unchecked(const std::string& query, const std::vector<std::string>& params);
+
     template<typename STRING>
     void exec_no_data(STRING query)
     {
@@ -460,6 +515,9 @@ public:
     void execute(const std::string& query) override;
     void explain(const std::string& query, FILE* out) override;
 
+    /// Print the query plan of a query with text parameters
+    void explain(const std::string& query, const std::vector<std::string>& params, FILE* out);
+
     /**
      * Delete a table in the database if it exists, otherwise do nothing.
      */
@@ -482,6 +540,22 @@ public:
     /// Retrieve query results in single row mode
     void run_single_row_mode(const std::string& query_desc, std::function<void(const postgresql::Result&)> dest);
 
+    /**
+     * Run a query with binary results, calling \a dest with batches of up to
+     * fetch_size rows as they arrive.
+     *
+     * This uses libpq chunked rows mode if available. Otherwise, inside a
+     * transaction, it fetches rows from a server-side cursor; outside a
+     * transaction, or if fetch_size is 1, it uses single row mode.
+     *
+     * Except when using a server-side cursor, queries that are run again are
+     * sent as named prepared statements, kept for the following runs.
+     */
+    void run_chunked(const std::string& query, int nparams, const char* const* params, std::function<void(const postgresql::Result&)> dest);
+
+    /// Same as run_chunked, with any number of text parameters
+    void run_chunked(const std::string& query, const std::vector<std::string>& params, std::function<void(const postgresql::Result&)> dest);
+
     /// Escape the string as a literal value and append it to qb
     void append_escaped(Querybuf& qb, const char* str);
 
@@ -492,6 +566,57 @@ public:
     void append_escaped(Querybuf& qb, const std::vector<uint8_t>& buf);
 };
 
+namespace postgresql {
+
+/**
+ * Send many prepared queries without waiting for the result of each one, and
+ * read their results afterwards.
+ *
+ * This uses libpq pipeline mode if available, so that lookups that would take
+ * one round trip each can share a single round trip. Otherwise, queries are
+ * run as they are sent.
+ *
+ * Results are passed to dest in the order the queries were sent, together
+ * with the position of the query in the sequence. Queries that return no
+ * rows are passed as empty results.
+ */
+class Pipeline
+{
+protected:
+    PostgreSQLConnection& conn;
+    std::function<void(unsigned idx, const Result& res)> dest;
+    /// Names of the queries sent and not yet read, used for error messages
+    std::vector<std::string> pending;
+    /// Number of results already passed to dest
+    unsigned done = 0;
+    /// Number of pending queries after which results are read automatically
+    unsigned max_pending;
+
+    void send_prepared_params(const char* name, int count, const char* const* args, const int* lengths, const int* formats);
+
+    /// Read all pending results, without throwing
+    void discard_pending_nothrow() noexcept;
+
+public:
+    Pipeline(PostgreSQLConnection& conn, std::function<void(unsigned idx, const Result& res)> dest, unsigned max_pending=256);
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+    ~Pipeline();
+
+    /// Queue a prepared query
+    template<typename ...ARGS>
+    void send_prepared(const char* name, ARGS... args)
+    {
+        Params<ARGS...> params(args...);
+        send_prepared_params(name, params.count, params.args, params.lengths, params.formats);
+    }
+
+    /// Read the results of all the queries sent so far
+    void flush();
+};
+
+}
+
 }
 }
 #endif
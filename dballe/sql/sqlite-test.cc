@@ -180,6 +180,44 @@ add_method("auto_increment", [](Fixture& f) {
     wassert(actual(f.conn->get_last_insert_id()) == 2);
 });
 
+add_method("statement_cache", [](Fixture& f) {
+    f.conn->exec("INSERT INTO dballe_test VALUES (1)");
+    f.conn->exec("INSERT INTO dballe_test VALUES (2)");
+    unsigned orig_size = f.conn->statement_cache_size;
+    f.conn->statement_cache_size = 2;
+
+    auto query = [&](const char* sql, int arg) -> sqlite3_stmt* {
+        auto s = f.conn->cached_sqlitestatement(sql);
+        sqlite3_stmt* raw = *s;
+        s->bind(arg);
+        unsigned count = 0;
+        s->execute([&]() { ++count; });
+        f.conn->release_sqlitestatement(std::move(s));
+        wassert(actual(count) == 1u);
+        return raw;
+    };
+
+    // The same query text reuses the same compiled statement
+    sqlite3_stmt* s1 = query("SELECT val FROM dballe_test WHERE val=?", 1);
+    wassert(actual(query("SELECT val FROM dballe_test WHERE val=?", 2) == s1).istrue());
+
+    // Statements in use are not shared with nested queries
+    auto outer = f.conn->cached_sqlitestatement("SELECT val FROM dballe_test WHERE val=?");
+    wassert(actual((sqlite3_stmt*)*outer == s1).istrue());
+    auto inner = f.conn->cached_sqlitestatement("SELECT val FROM dballe_test WHERE val=?");
+    wassert(actual((sqlite3_stmt*)*inner != s1).istrue());
+    f.conn->release_sqlitestatement(std::move(inner));
+    f.conn->release_sqlitestatement(std::move(outer));
+
+    // Evicting the least recently used statements keeps the cache working
+    wassert(query("SELECT val FROM dballe_test WHERE val>=?", 2));
+    wassert(query("SELECT val FROM dballe_test WHERE val<=?", 1));
+    wassert(query("SELECT val FROM dballe_test WHERE val=?", 2));
+    wassert(query("SELECT val FROM dballe_test WHERE val<=?", 1));
+
+    f.conn->statement_cache_size = orig_size;
+});
+
 add_method("connect", [](Fixture& f) {
     auto conn = Connection::create(*DBConnectOptions::create("sqlite:test.sqlite"));
     wassert_true(conn->server_type == sql::ServerType::SQLITE);
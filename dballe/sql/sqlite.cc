@@ -77,6 +77,8 @@ SQLiteConnection::SQLiteConnection()
 
 SQLiteConnection::~SQLiteConnection()
 {
+    // Cached statements need to be finalized before closing the database
+    clear_statement_cache();
     if (db) sqlite3_close(db);
 }
 
@@ -89,6 +91,7 @@ std::shared_ptr<SQLiteConnection> SQLiteConnection::create()
 
 void SQLiteConnection::reopen()
 {
+    clear_statement_cache();
     if (db)
     {
         if (sqlite3_close(db) != SQLITE_OK)
@@ -150,6 +153,10 @@ void SQLiteConnection::fork_child()
     forked = true;
     // TODO: close the underlying file descriptor (how?) instead of leaking it
     db = nullptr;
+    // Leak cached statements together with the database handle
+    for (auto& stm: statement_cache)
+        stm->stm = nullptr;
+    clear_statement_cache();
 }
 
 void SQLiteConnection::check_connection()
@@ -289,6 +296,55 @@ std::unique_ptr<SQLiteStatement> SQLiteConnection::sqlitestatement(const std::st
     return unique_ptr<SQLiteStatement>(new SQLiteStatement(*this, query));
 }
 
+std::unique_ptr<SQLiteStatement> SQLiteConnection::cached_sqlitestatement(const std::string& query)
+{
+    auto i = statement_cache_index.find(query);
+    if (i == statement_cache_index.end())
+        return sqlitestatement(query);
+
+    check_connection();
+    // Take the statement out of the cache while it is in use, so that nested
+    // queries with the same text compile their own
+    std::unique_ptr<SQLiteStatement> res(std::move(*i->second));
+    statement_cache.erase(i->second);
+    statement_cache_index.erase(i);
+    return res;
+}
+
+void SQLiteConnection::release_sqlitestatement(std::unique_ptr<SQLiteStatement>&& stm)
+{
+    if (forked || statement_cache_size == 0)
+        return;
+
+    // Bound strings and blobs are not owned by the statement, and would
+    // become dangling pointers
+    sqlite3_clear_bindings(*stm);
+
+    // If a nested query put back a statement with the same text, keep the
+    // most recent one
+    auto i = statement_cache_index.find(stm->query);
+    if (i != statement_cache_index.end())
+    {
+        statement_cache.erase(i->second);
+        statement_cache_index.erase(i);
+    }
+
+    statement_cache.push_front(std::move(stm));
+    statement_cache_index[statement_cache.front()->query] = statement_cache.begin();
+
+    while (statement_cache.size() > statement_cache_size)
+    {
+        statement_cache_index.erase(statement_cache.back()->query);
+        statement_cache.pop_back();
+    }
+}
+
+void SQLiteConnection::clear_statement_cache()
+{
+    statement_cache_index.clear();
+    statement_cache.clear();
+}
+
 void SQLiteConnection::drop_table_if_exists(const char* name)
 {
     exec(string("DROP TABLE IF EXISTS ") + name);
@@ -9,6 +9,9 @@
 #include <sqlite3.h>
 #include <vector>
 #include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
 
 namespace dballe {
 namespace sql {
@@ -42,6 +45,10 @@ protected:
     sqlite3* db = nullptr;
     /// Marker to catch attempts to reuse connections in forked processes
     bool forked = false;
+    /// Compiled statements kept for reuse, most recently used first
+    std::list<std::unique_ptr<SQLiteStatement>> statement_cache;
+    /// Index of statement_cache by query text
+    std::unordered_map<std::string, std::list<std::unique_ptr<SQLiteStatement>>::iterator> statement_cache_index;
 
     void init_after_connect();
     static void on_sqlite3_profile(void* arg, const char* query, sqlite3_uint64 usecs);
@@ -74,6 +81,27 @@ public:
     std::unique_ptr<Transaction> transaction(bool readonly=false) override;
     std::unique_ptr<SQLiteStatement> sqlitestatement(const std::string& query);
 
+    /// Maximum number of compiled statements kept by the statement cache
+    unsigned statement_cache_size = 32;
+
+    /**
+     * Get a compiled statement for query, reusing one from the statement
+     * cache if available.
+     *
+     * Give the statement back with release_sqlitestatement after use, to make
+     * it available to the next query with the same text.
+     */
+    std::unique_ptr<SQLiteStatement> cached_sqlitestatement(const std::string& query);
+
+    /**
+     * Put a statement in the statement cache, evicting the least recently
+     * used ones if the cache is full.
+     */
+    void release_sqlitestatement(std::unique_ptr<SQLiteStatement>&& stm);
+
+    /// Finalize all the statements in the statement cache
+    void clear_statement_cache();
+
     bool has_table(const std::string& name) override;
     std::string get_setting(const std::string& key) override;
     void set_setting(const std::string& key, const std::string& value) override;
@@ -1098,6 +1098,98 @@ int idba_next_data(int handle, char* parameter, int parameter_len)
     }
 }
 
+/**
+ * Retrieve the data about up to \a size values at a time, storing them in
+ * arrays.
+ *
+ * This is a faster alternative to calling idba_next_data() and reading each
+ * value with idba_enq*(), when reading large numbers of values.
+ *
+ * Each array has room for \a size values, or \a size groups of values for
+ * datetime, level and trange. Arrays passed as NULL are not filled.
+ * Missing values are set to the missing value constants.
+ *
+ * After invocation, the output record refers to the last value read, as
+ * if it had been read by idba_next_data().
+ *
+ * @param handle
+ *   Handle to a DB-All.e session
+ * @param size
+ *   Maximum number of values to read
+ * @retval count
+ *   Number of values read. It is less than \a size only when there are no
+ *   more values to read
+ * @retval ana_id
+ *   Station IDs
+ * @retval lat
+ *   Station latitudes
+ * @retval lon
+ *   Station longitudes
+ * @retval datetime
+ *   Year, month, day, hour, minute and second of each value
+ * @retval level
+ *   ltype1, l1, ltype2 and l2 of each value
+ * @retval trange
+ *   pind, p1 and p2 of each value
+ * @retval varcode
+ *   Variable codes, as the integer FXXYYY (for example, 12101 for B12101)
+ * @retval value
+ *   Values. String values are returned as missing
+ * @param attr
+ *   Code of an attribute to read, like \c "*B33007", or an empty string
+ * @retval attr_value
+ *   Values of the attribute \a attr. When reading from the database, set
+ *   \c query to \c "attrs" before idba_query_data(), to avoid querying the
+ *   attributes of each value separately
+ * @return
+ *   The error indicator for the function
+ */
+int idba_next_data_many(int handle, int size, int* count,
+        int* ana_id, double* lat, double* lon, int* datetime, int* level, int* trange,
+        int* varcode, double* value, const char* attr, double* attr_value)
+{
+    try {
+        HSimple& h = hsimp.get(handle);
+        fortran::DataArrays arrays;
+        arrays.ana_id = ana_id;
+        arrays.lat = lat;
+        arrays.lon = lon;
+        arrays.datetime = datetime;
+        arrays.level = level;
+        arrays.trange = trange;
+        arrays.varcode = varcode;
+        arrays.value = value;
+        if (attr && attr[0])
+        {
+            arrays.attr_code = resolve_varcode(attr[0] == '*' ? attr + 1 : attr);
+            arrays.attr = attr_value;
+        }
+        unsigned res = h.api->next_data_many(size > 0 ? size : 0, arrays);
+        *count = res;
+
+        for (unsigned i = 0; i < res; ++i)
+        {
+            if (ana_id) tofortran(ana_id[i]);
+            if (lat && lat[i] == fortran::API::missing_double) lat[i] = MISSING_DOUBLE;
+            if (lon && lon[i] == fortran::API::missing_double) lon[i] = MISSING_DOUBLE;
+            if (datetime)
+                for (unsigned j = 0; j < 6; ++j)
+                    tofortran(datetime[i * 6 + j]);
+            if (level)
+                for (unsigned j = 0; j < 4; ++j)
+                    tofortran(level[i * 4 + j]);
+            if (trange)
+                for (unsigned j = 0; j < 3; ++j)
+                    tofortran(trange[i * 3 + j]);
+            if (value && value[i] == fortran::API::missing_double) value[i] = MISSING_DOUBLE;
+            if (arrays.attr && arrays.attr[i] == fortran::API::missing_double) arrays.attr[i] = MISSING_DOUBLE;
+        }
+        return fortran::success();
+    } catch (error& e) {
+        return fortran::error(e);
+    }
+}
+
 /**
  * Insert a new value in the database.
  *
@@ -8,6 +8,8 @@
       use dballef
 
       integer :: dbahandle,handle,i,i1,i2,i3,i4,i5,i6,ival,saved_id,ierr
+      integer :: ana_ids(2),datetimes(6,2),levels(4,2),tranges(3,2),varcodes(2)
+      double precision :: lats(2),lons(2),vals(2),attrs(2)
       real :: rval
       double precision :: dval
       character (len=10) :: param
@@ -185,6 +187,33 @@
          i = i - 1
       enddo
 
+!     Read the results of the query again, into arrays
+      ierr = idba_query_data(handle, i)
+      call ensure_no_error("query_data next_data_many")
+      ierr = idba_next_data_many(handle, 2, i, ana_ids, lats, lons, datetimes, &
+                                 levels, tranges, varcodes, vals, "*B33002", attrs)
+      call ensure_no_error("next_data_many")
+      call ensure("next_data_many count", i.eq.1)
+      call ensure("next_data_many ana_id", ana_ids(1).eq.1)
+      call ensure("next_data_many lat", lats(1).eq.30D00)
+      call ensure("next_data_many lon", lons(1).eq.10D00)
+      call ensure("next_data_many year", datetimes(1,1).eq.2006)
+      call ensure("next_data_many min", datetimes(5,1).eq.4)
+      call ensure("next_data_many ltype1", levels(1,1).eq.1)
+      call ensure("next_data_many pind", tranges(1,1).eq.20)
+      call ensure("next_data_many varcode", varcodes(1).eq.1011)
+      call ensure("next_data_many value", vals(1).eq.DBA_MVD)
+      call ensure("next_data_many attr", attrs(1).eq.1D00)
+
+!     Arrays that are not needed can be omitted
+      ierr = idba_query_data(handle, i)
+      call ensure_no_error("query_data next_data_many optional")
+      varcodes(1) = 0
+      ierr = idba_next_data_many(handle, 2, i, varcode=varcodes)
+      call ensure_no_error("next_data_many optional")
+      call ensure("next_data_many optional count", i.eq.1)
+      call ensure("next_data_many optional varcode", varcodes(1).eq.1011)
+
 !     Remove the QC data for saved_data
       ierr = idba_seti(handle, "*context_id", saved_id);
       call ensure_no_error("remove_attributes seti 3")
@@ -440,6 +440,27 @@ INTERFACE
   END FUNCTION idba_next_data_orig
 END INTERFACE
 
+INTERFACE
+  FUNCTION idba_next_data_many_orig(handle, size, count, ana_id, lat, lon, datetime, level, trange, &
+   varcode, val, attr, attr_val) BIND(C,name='idba_next_data_many')
+  IMPORT
+  INTEGER(kind=c_int),VALUE :: handle
+  INTEGER(kind=c_int),VALUE :: size
+  INTEGER(kind=c_int),INTENT(out) :: count
+  INTEGER(kind=c_int),OPTIONAL :: ana_id(*)
+  REAL(kind=c_double),OPTIONAL :: lat(*)
+  REAL(kind=c_double),OPTIONAL :: lon(*)
+  INTEGER(kind=c_int),OPTIONAL :: datetime(6,*)
+  INTEGER(kind=c_int),OPTIONAL :: level(4,*)
+  INTEGER(kind=c_int),OPTIONAL :: trange(3,*)
+  INTEGER(kind=c_int),OPTIONAL :: varcode(*)
+  REAL(kind=c_double),OPTIONAL :: val(*)
+  CHARACTER(kind=c_char),OPTIONAL :: attr(*)
+  REAL(kind=c_double),OPTIONAL :: attr_val(*)
+  INTEGER(kind=c_int) :: idba_next_data_many_orig
+  END FUNCTION idba_next_data_many_orig
+END INTERFACE
+
 INTERFACE
   FUNCTION idba_insert_data(handle) BIND(C,name='idba_insert_data')
   IMPORT
@@ -916,6 +937,34 @@ idba_dammelo = idba_next_data_orig(handle, param, LEN(param))
 
 END FUNCTION idba_dammelo
 
+FUNCTION idba_next_data_many(handle, size, count, ana_id, lat, lon, datetime, level, trange, &
+ varcode, val, attr, attr_val)
+INTEGER(kind=c_int) :: handle
+INTEGER(kind=c_int) :: size
+INTEGER(kind=c_int) :: count
+INTEGER(kind=c_int),OPTIONAL :: ana_id(*)
+REAL(kind=c_double),OPTIONAL :: lat(*)
+REAL(kind=c_double),OPTIONAL :: lon(*)
+INTEGER(kind=c_int),OPTIONAL :: datetime(6,*)
+INTEGER(kind=c_int),OPTIONAL :: level(4,*)
+INTEGER(kind=c_int),OPTIONAL :: trange(3,*)
+INTEGER(kind=c_int),OPTIONAL :: varcode(*)
+REAL(kind=c_double),OPTIONAL :: val(*)
+CHARACTER(kind=c_char,len=*),OPTIONAL :: attr
+REAL(kind=c_double),OPTIONAL :: attr_val(*)
+INTEGER(kind=c_int) :: idba_next_data_many
+
+! Absent arrays are passed on as NULL, and are not filled
+IF (PRESENT(attr)) THEN
+  idba_next_data_many = idba_next_data_many_orig(handle, size, count, ana_id, lat, lon, datetime, &
+   level, trange, varcode, val, fchartrimtostr(attr), attr_val)
+ELSE
+  idba_next_data_many = idba_next_data_many_orig(handle, size, count, ana_id, lat, lon, datetime, &
+   level, trange, varcode, val, attr_val=attr_val)
+ENDIF
+
+END FUNCTION idba_next_data_many
+
 FUNCTION idba_next_attribute(handle, param)
 INTEGER(kind=c_int) :: handle
 CHARACTER(kind=c_char,len=*) :: param
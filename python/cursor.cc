@@ -7,8 +7,12 @@
 #include "common.h"
 #include "dballe/core/enq.h"
 #include "dballe/core/data.h"
+#include "dballe/core/arrow.h"
 #include "dballe/db/v7/cursor.h"
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <unordered_map>
 #include "utils/type.h"
 
 using namespace std;
@@ -52,6 +56,86 @@ void ensure_valid_iterating_cursor(Impl* self)
     }
 }
 
+/**
+ * Enqpy that reuses the Python objects cached in an Interner
+ */
+struct InternedEnqpy : public Enqpy
+{
+    Interner& interner;
+
+    InternedEnqpy(Interner& interner, const char* key, unsigned len)
+        : Enqpy(key, len), interner(interner) {}
+
+    void set_string(const std::string& val) override
+    {
+        res = interner.string(val);
+        missing = false;
+    }
+
+    void set_ident(const Ident& ident) override
+    {
+        if (ident.is_missing())
+        {
+            res = Py_None;
+            Py_INCREF(res);
+        } else
+            res = interner.string(ident.get());
+        missing = false;
+    }
+
+    void set_varcode(wreport::Varcode val) override
+    {
+        res = interner.varcode(val);
+        missing = false;
+    }
+
+    void set_lat(int lat) override
+    {
+        if (lat == MISSING_INT)
+            return;
+        res = interner.lat(lat);
+        missing = false;
+    }
+
+    void set_lon(int lon) override
+    {
+        if (lon == MISSING_INT)
+            return;
+        res = interner.lon(lon);
+        missing = false;
+    }
+
+    void set_station(const Station& s) override
+    {
+        res = interner.station(s);
+        missing = false;
+    }
+
+    void set_dbstation(const DBStation& s) override
+    {
+        res = interner.station(s);
+        missing = false;
+    }
+
+    void set_datetime(const Datetime& dt) override
+    {
+        res = interner.datetime(dt);
+        missing = false;
+    }
+
+    void set_level(const Level& lev) override
+    {
+        res = interner.level(lev);
+        missing = false;
+    }
+
+    void set_trange(const Trange& tr) override
+    {
+        res = interner.trange(tr);
+        missing = false;
+    }
+};
+
 template<typename Impl>
 struct remaining : Getter<remaining<Impl>, Impl>
 {
@@ -66,11 +150,14 @@ struct remaining : Getter<remaining<Impl>, Impl>
     }
 };
 
-void _set_query(PyObject* dict, const DBStation& station)
+void _set_query(PyObject* dict, const DBStation& station, Interner& interner)
 {
-    set_dict(dict, "report", station.report);
-    set_dict(dict, "lat", dballe_int_lat_to_python(station.coords.lat));
-    set_dict(dict, "lon", dballe_int_lon_to_python(station.coords.lon));
+    pyo_unique_ptr report(interner.string(station.report));
+    set_dict(dict, "report", report);
+    pyo_unique_ptr lat(interner.lat(station.coords.lat));
+    set_dict(dict, "lat", lat);
+    pyo_unique_ptr lon(interner.lon(station.coords.lon));
+    set_dict(dict, "lon", lon);
     if (station.ident.is_missing())
     {
         set_dict(dict, "mobile", false);
@@ -80,53 +167,54 @@ void _set_query(PyObject* dict, const DBStation& station)
     }
 }
 
-void _set_query(PyObject* dict, dballe::impl::CursorStation& cur)
+void _set_query(PyObject* dict, const Level& level, const Trange& trange, wreport::Varcode code, Interner& interner)
+{
+    pyo_unique_ptr pylevel(interner.level(level));
+    set_dict(dict, "level", pylevel);
+    pyo_unique_ptr pytrange(interner.trange(trange));
+    set_dict(dict, "trange", pytrange);
+    pyo_unique_ptr pyvar(interner.varcode(code));
+    set_dict(dict, "var", pyvar);
+}
+
+void _set_query(PyObject* dict, dballe::impl::CursorStation& cur, Interner& interner)
 {
-    _set_query(dict, cur.get_station());
+    _set_query(dict, cur.get_station(), interner);
 }
 
-void _set_query(PyObject* dict, dballe::impl::CursorStationData& cur)
+void _set_query(PyObject* dict, dballe::impl::CursorStationData& cur, Interner& interner)
 {
-    _set_query(dict, cur.get_station());
-    set_dict(dict, "level", level_to_python(Level()));
-    set_dict(dict, "trange", trange_to_python(Trange()));
-    set_dict(dict, "var", varcode_to_python(cur.get_varcode()));
+    _set_query(dict, cur.get_station(), interner);
+    _set_query(dict, Level(), Trange(), cur.get_varcode(), interner);
 }
 
-void _set_query(PyObject* dict, dballe::impl::CursorData& cur)
+void _set_query(PyObject* dict, dballe::impl::CursorData& cur, Interner& interner)
 {
-    _set_query(dict, cur.get_station());
-    set_dict(dict, "level", to_python(cur.get_level()));
-    set_dict(dict, "trange", to_python(cur.get_trange()));
-    set_dict(dict, "var", varcode_to_python(cur.get_varcode()));
-    set_dict(dict, "datetime", to_python(cur.get_datetime()));
+    _set_query(dict, cur.get_station(), interner);
+    _set_query(dict, cur.get_level(), cur.get_trange(), cur.get_varcode(), interner);
+    pyo_unique_ptr datetime(interner.datetime(cur.get_datetime()));
+    set_dict(dict, "datetime", datetime);
 }
 
-void _set_query(PyObject* dict, dballe::impl::CursorSummary& cur)
+void _set_query(PyObject* dict, dballe::impl::CursorSummary& cur, Interner& interner)
 {
-    _set_query(dict, cur.get_station());
-    set_dict(dict, "level", to_python(cur.get_level()));
-    set_dict(dict, "trange", to_python(cur.get_trange()));
-    set_dict(dict, "var", varcode_to_python(cur.get_varcode()));
+    _set_query(dict, cur.get_station(), interner);
+    _set_query(dict, cur.get_level(), cur.get_trange(), cur.get_varcode(), interner);
 }
 
-void _set_query(PyObject* dict, dballe::db::summary::Cursor<dballe::Station>& cur)
+void _set_query(PyObject* dict, dballe::db::summary::Cursor<dballe::Station>& cur, Interner& interner)
 {
-    _set_query(dict, cur.get_station());
-    set_dict(dict, "level", to_python(cur.get_level()));
-    set_dict(dict, "trange", to_python(cur.get_trange()));
-    set_dict(dict, "var", varcode_to_python(cur.get_varcode()));
+    _set_query(dict, cur.get_station(), interner);
+    _set_query(dict, cur.get_level(), cur.get_trange(), cur.get_varcode(), interner);
 }
 
-void _set_query(PyObject* dict, dballe::db::summary::Cursor<dballe::DBStation>& cur)
+void _set_query(PyObject* dict, dballe::db::summary::Cursor<dballe::DBStation>& cur, Interner& interner)
 {
-    _set_query(dict, cur.get_station());
-    set_dict(dict, "level", to_python(cur.get_level()));
-    set_dict(dict, "trange", to_python(cur.get_trange()));
-    set_dict(dict, "var", varcode_to_python(cur.get_varcode()));
+    _set_query(dict, cur.get_station(), interner);
+    _set_query(dict, cur.get_level(), cur.get_trange(), cur.get_varcode(), interner);
 }
 
-void _set_query(PyObject* dict, dballe::CursorMessage& cur)
+void _set_query(PyObject* dict, dballe::CursorMessage& cur, Interner& interner)
 {
     PyErr_SetString(PyExc_NotImplementedError, "accessing .query on CursorMessage is not yet implemented");
     throw PythonException();
@@ -137,11 +225,14 @@ void _set_data(core::Data& data, const DBStation& station)
     data.station = station;
 }
 
-void _set_data(PyObject* dict, const DBStation& station)
+void _set_data(PyObject* dict, const DBStation& station, Interner& interner)
 {
-    set_dict(dict, "report", station.report);
-    set_dict(dict, "lat", dballe_int_lat_to_python(station.coords.lat));
-    set_dict(dict, "lon", dballe_int_lon_to_python(station.coords.lon));
+    pyo_unique_ptr report(interner.string(station.report));
+    set_dict(dict, "report", report);
+    pyo_unique_ptr lat(interner.lat(station.coords.lat));
+    set_dict(dict, "lat", lat);
+    pyo_unique_ptr lon(interner.lon(station.coords.lon));
+    set_dict(dict, "lon", lon);
     if (!station.ident.is_missing())
         set_dict(dict, "ident", station.ident.get());
 }
@@ -174,9 +265,9 @@ void _set_data(core::Data& data, dballe::impl::CursorStationData& cur)
     _set_data(data, cur.get_var());
 }
 
-void _set_data(PyObject* dict, dballe::impl::CursorStationData& cur)
+void _set_data(PyObject* dict, dballe::impl::CursorStationData& cur, Interner& interner)
 {
-    _set_data(dict, cur.get_station());
+    _set_data(dict, cur.get_station(), interner);
     _set_data(dict, cur.get_var());
 }
 
@@ -189,12 +280,15 @@ void _set_data(core::Data& data, dballe::impl::CursorData& cur)
     _set_data(data, cur.get_var());
 }
 
-void _set_data(PyObject* dict, dballe::impl::CursorData& cur)
+void _set_data(PyObject* dict, dballe::impl::CursorData& cur, Interner& interner)
 {
-    _set_data(dict, cur.get_station());
-    set_dict(dict, "level", to_python(cur.get_level()));
-    set_dict(dict, "trange", to_python(cur.get_trange()));
-    set_dict(dict, "datetime", to_python(cur.get_datetime()));
+    _set_data(dict, cur.get_station(), interner);
+    pyo_unique_ptr level(interner.level(cur.get_level()));
+    set_dict(dict, "level", level);
+    pyo_unique_ptr trange(interner.trange(cur.get_trange()));
+    set_dict(dict, "trange", trange);
+    pyo_unique_ptr datetime(interner.datetime(cur.get_datetime()));
+    set_dict(dict, "datetime", datetime);
     _set_data(dict, cur.get_var());
 }
 
@@ -209,7 +303,7 @@ struct query : Getter<query<Impl>, Impl>
         try {
             ensure_valid_iterating_cursor(self);
             pyo_unique_ptr result(throw_ifnull(PyDict_New()));
-            _set_query(result, *self->cur);
+            _set_query(result, *self->cur, self->interner);
             return result.release();
         } DBALLE_CATCH_RETURN_PYO
     }
@@ -242,7 +336,7 @@ struct data_dict : Getter<data_dict<Impl>, Impl>
         try {
             ensure_valid_iterating_cursor(self);
             pyo_unique_ptr result(throw_ifnull(PyDict_New()));
-            _set_data(result, *self->cur);
+            _set_data(result, *self->cur, self->interner);
             return result.release();
         } DBALLE_CATCH_RETURN_PYO
     }
@@ -464,14 +558,263 @@ struct __exit__ : MethVarargs<__exit__<Impl>, Impl>
             return nullptr;
 
         try {
-            ReleaseGIL gil;
-            self->cur.reset();
+            {
+                ReleaseGIL gil;
+                self->cur.reset();
+            }
+            self->interner.clear();
         } DBALLE_CATCH_RETURN_PYO
         Py_RETURN_NONE;
     }
 };
 
 
+template<typename Impl>
+struct to_arrow : MethKwargs<to_arrow<Impl>, Impl>
+{
+    constexpr static const char* name = "to_arrow";
+    constexpr static const char* signature = "batch_size: int=65536";
+    constexpr static const char* returns = "pyarrow.Table";
+    constexpr static const char* summary = "Read all remaining rows into a pyarrow.Table";
+    constexpr static const char* doc = R"(
+Rows are read in record batches of at most ``batch_size`` rows. Report, level,
+time range and variable code columns are dictionary encoded, coordinates are
+integer 1/100000 of a degree, and attributes loaded with the variable are in a
+list column. The table can be written as Parquet or Arrow IPC using pyarrow.
+
+This requires pyarrow to be installed.
+)";
+
+    static PyObject* run(Impl* self, PyObject* args, PyObject* kw)
+    {
+        static const char* kwlist[] = { "batch_size", nullptr };
+        unsigned batch_size = 65536;
+        if (!PyArg_ParseTupleAndKeywords(args, kw, "|I", const_cast<char**>(kwlist), &batch_size))
+            return nullptr;
+
+        try {
+            ensure_valid_cursor(self);
+            pyo_unique_ptr pyarrow(throw_ifnull(PyImport_ImportModule("pyarrow")));
+            pyo_unique_ptr reader_type(throw_ifnull(PyObject_GetAttrString(pyarrow, "RecordBatchReader")));
+
+            ArrowArrayStream stream;
+            core::arrow::export_data(self->cur, &stream, batch_size);
+            pyo_unique_ptr address(PyLong_FromVoidPtr(&stream));
+            pyo_unique_ptr reader;
+            if (address)
+                reader.reset(PyObject_CallMethod(reader_type, "_import_from_c", "O", address.get()));
+            if (!reader)
+            {
+                // On failure, pyarrow may not have taken ownership of the stream
+                if (stream.release)
+                    stream.release(&stream);
+                throw PythonException();
+            }
+            return throw_ifnull(PyObject_CallMethod(reader, "read_all", nullptr));
+        } DBALLE_CATCH_RETURN_PYO
+    }
+};
+
+/**
+ * Read all the remaining rows of a data cursor, in the form used by
+ * dballe.volnd to build its arrays.
+ */
+struct volnd_collect : MethKwargs<volnd_collect, dpy_CursorDataDB>
+{
+    constexpr static const char* name = "_volnd_collect";
+    constexpr static const char* signature = "attributes: Union[None, bool, Sequence[str]]=None";
+    constexpr static const char* returns = "Dict[str, Any]";
+    constexpr static const char* summary = "Read all remaining rows for dballe.volnd";
+    constexpr static const char* doc = R"(
+Each row is described by the position of its variable code, station, network,
+level, time range and datetime in lists of distinct values, given as buffers of
+native int32 values. Numeric values are returned as a buffer of native
+doubles, string values and attributes as wreport.Var objects.
+
+This is an implementation detail of :func:`dballe.volnd.read`.
+)";
+
+    /// Assign sequential ids to distinct values, in order of appearance
+    template<typename T, typename Map=std::map<T, int32_t>>
+    struct Keys
+    {
+        Map ids;
+        std::vector<T> values;
+
+        int32_t get(const T& val)
+        {
+            auto i = ids.find(val);
+            if (i != ids.end())
+                return i->second;
+            int32_t id = values.size();
+            ids.insert(std::make_pair(val, id));
+            values.push_back(val);
+            return id;
+        }
+    };
+
+    template<typename T>
+    static PyObject* to_bytes(const std::vector<T>& vals)
+    {
+        return throw_ifnull(PyBytes_FromStringAndSize((const char*)vals.data(), vals.size() * sizeof(T)));
+    }
+
+    template<typename T, typename F>
+    static PyObject* to_list(const std::vector<T>& vals, F convert)
+    {
+        pyo_unique_ptr res(throw_ifnull(PyList_New(vals.size())));
+        for (size_t i = 0; i < vals.size(); ++i)
+            PyList_SET_ITEM(res.get(), i, convert(vals[i]));
+        return res.release();
+    }
+
+    static void set_item(PyObject* dict, const char* key, PyObject* val)
+    {
+        pyo_unique_ptr o(val);
+        if (PyDict_SetItemString(dict, key, o))
+            throw PythonException();
+    }
+
+    static PyObject* run(Impl* self, PyObject* args, PyObject* kw)
+    {
+        static const char* kwlist[] = { "attributes", nullptr };
+        PyObject* py_attributes = Py_None;
+        if (!PyArg_ParseTupleAndKeywords(args, kw, "|O", const_cast<char**>(kwlist), &py_attributes))
+            return nullptr;
+
+        try {
+            ensure_valid_cursor(self);
+            bool with_attrs = py_attributes != Py_None;
+            bool all_attrs = py_attributes == Py_True;
+            std::set<wreport::Varcode> attr_codes;
+            if (with_attrs && !all_attrs)
+                attr_codes = varcodes_from_python(py_attributes);
+
+            Keys<wreport::Varcode> varcodes;
+            Keys<DBStation, std::unordered_map<int, int32_t>> stations;
+            Keys<std::string, std::unordered_map<std::string, int32_t>> networks;
+            std::vector<Level> levels;
+            std::vector<Trange> tranges;
+            Keys<Datetime> datetimes;
+            // Map id_levtr to positions in levels and tranges
+            std::unordered_map<int, std::pair<int32_t, int32_t>> levtrs;
+
+            std::vector<int32_t> var_ids, ana_ids, network_ids, level_ids, trange_ids, datetime_ids;
+            std::vector<double> values;
+            std::vector<int32_t> string_rows;
+            std::vector<wreport::Var> strings;
+            std::map<wreport::Varcode, std::pair<std::vector<int32_t>, std::vector<wreport::Var>>> attrs;
+
+            {
+                ReleaseGIL gil;
+                db::v7::cursor::Data& cur = *self->cur;
+                while (cur.next())
+                {
+                    const db::v7::cursor::DataRow& row = cur.row();
+                    int32_t rowidx = var_ids.size();
+
+                    var_ids.push_back(varcodes.get(row.value.code()));
+
+                    auto si = stations.ids.find(row.station.id);
+                    if (si == stations.ids.end())
+                    {
+                        si = stations.ids.insert(std::make_pair(row.station.id, (int32_t)stations.values.size())).first;
+                        stations.values.push_back(row.station);
+                    }
+                    ana_ids.push_back(si->second);
+                    network_ids.push_back(networks.get(row.station.report));
+
+                    auto li = levtrs.find(row.id_levtr);
+                    if (li == levtrs.end())
+                    {
+                        Level lev = cur.get_level();
+                        Trange tr = cur.get_trange();
+                        auto lpos = std::find(levels.begin(), levels.end(), lev);
+                        if (lpos == levels.end())
+                            lpos = levels.insert(levels.end(), lev);
+                        auto tpos = std::find(tranges.begin(), tranges.end(), tr);
+                        if (tpos == tranges.end())
+                            tpos = tranges.insert(tranges.end(), tr);
+                        li = levtrs.insert(std::make_pair(row.id_levtr, std::make_pair(
+                                        (int32_t)(lpos - levels.begin()), (int32_t)(tpos - tranges.begin())))).first;
+                    }
+                    level_ids.push_back(li->second.first);
+                    trange_ids.push_back(li->second.second);
+                    datetime_ids.push_back(datetimes.get(row.datetime));
+
+                    const wreport::Var& var = *row.value;
+                    switch (var.info()->type)
+                    {
+                        case wreport::Vartype::Integer:
+                        case wreport::Vartype::Decimal:
+                            values.push_back(var.enqd());
+                            break;
+                        default:
+                            values.push_back(NAN);
+                            string_rows.push_back(rowidx);
+                            strings.push_back(var);
+                            break;
+                    }
+
+                    if (with_attrs)
+                        cur.query_attrs([&](std::unique_ptr<wreport::Var>&& attr) {
+                            if (!all_attrs && attr_codes.find(attr->code()) == attr_codes.end())
+                                return;
+                            auto& a = attrs[attr->code()];
+                            a.first.push_back(rowidx);
+                            a.second.push_back(std::move(*attr));
+                        }, false);
+                }
+            }
+
+            pyo_unique_ptr res(throw_ifnull(PyDict_New()));
+            set_item(res, "varcodes", to_list(varcodes.values, varcode_to_python));
+            set_item(res, "var", to_bytes(var_ids));
+            set_item(res, "ana", to_bytes(ana_ids));
+            set_item(res, "ana_keys", to_list(stations.values, [](const DBStation& st) {
+                pyo_unique_ptr entry(throw_ifnull(PyTuple_New(4)));
+                PyTuple_SET_ITEM(entry.get(), 0, throw_ifnull(PyLong_FromLong(st.id)));
+                PyTuple_SET_ITEM(entry.get(), 1, dballe_int_lat_to_python(st.coords.lat));
+                PyTuple_SET_ITEM(entry.get(), 2, dballe_int_lon_to_python(st.coords.lon));
+                PyTuple_SET_ITEM(entry.get(), 3, ident_to_python(st.ident));
+                return entry.release();
+            }));
+            set_item(res, "network", to_bytes(network_ids));
+            set_item(res, "network_keys", to_list(networks.values, [](const std::string& s) {
+                return throw_ifnull(PyUnicode_FromStringAndSize(s.data(), s.size()));
+            }));
+            set_item(res, "level", to_bytes(level_ids));
+            set_item(res, "level_keys", to_list(levels, level_to_python));
+            set_item(res, "trange", to_bytes(trange_ids));
+            set_item(res, "trange_keys", to_list(tranges, trange_to_python));
+            set_item(res, "datetime", to_bytes(datetime_ids));
+            set_item(res, "datetime_keys", to_list(datetimes.values, datetime_to_python));
+            set_item(res, "values", to_bytes(values));
+
+            auto var_to_python = [](const wreport::Var& var) { return (PyObject*)wreport_api.var_create(var); };
+            pyo_unique_ptr py_strings(throw_ifnull(PyTuple_New(2)));
+            PyTuple_SET_ITEM(py_strings.get(), 0, to_bytes(string_rows));
+            PyTuple_SET_ITEM(py_strings.get(), 1, to_list(strings, var_to_python));
+            set_item(res, "strings", py_strings.release());
+
+            pyo_unique_ptr py_attrs(throw_ifnull(PyDict_New()));
+            for (const auto& a: attrs)
+            {
+                pyo_unique_ptr key(varcode_to_python(a.first));
+                pyo_unique_ptr val(throw_ifnull(PyTuple_New(2)));
+                PyTuple_SET_ITEM(val.get(), 0, to_bytes(a.second.first));
+                PyTuple_SET_ITEM(val.get(), 1, to_list(a.second.second, var_to_python));
+                if (PyDict_SetItem(py_attrs, key, val))
+                    throw PythonException();
+            }
+            set_item(res, "attrs", py_attrs.release());
+
+            return res.release();
+        } DBALLE_CATCH_RETURN_PYO
+    }
+};
+
+
 template<typename Definition, typename Impl>
 struct DefinitionBase : public Type<Definition, Impl>
 {
@@ -479,6 +822,7 @@ struct DefinitionBase : public Type<Definition, Impl>
 
     static void _dealloc(Impl* self)
     {
+        self->interner.~Interner();
         self->cur.~shared_ptr();
         Py_TYPE(self)->tp_free(self);
     }
@@ -514,7 +858,7 @@ struct DefinitionBase : public Type<Definition, Impl>
             Py_ssize_t len;
             const char* key = throw_ifnull(PyUnicode_AsUTF8AndSize(pykey, &len));
             // return enqpy(*self->cur, key, len);
-            Enqpy enq(key, len);
+            InternedEnqpy enq(self->interner, key, len);
             self->cur->enq(enq);
             if (enq.missing)
                 Py_RETURN_NONE;
@@ -656,7 +1000,7 @@ For example::
 )";
 
     GetSetters<remaining<Impl>, query<Impl>, data<Impl>, data_dict<Impl>> getsetters;
-    Methods<MethGenericEnter<Impl>, __exit__<Impl>, enqi<Impl>, enqd<Impl>, enqs<Impl>, enqf<Impl>> methods;
+    Methods<MethGenericEnter<Impl>, __exit__<Impl>, enqi<Impl>, enqd<Impl>, enqs<Impl>, enqf<Impl>, to_arrow<Impl>> methods;
 };
 
 
@@ -683,7 +1027,7 @@ For example::
 )";
 
     GetSetters<remaining<Impl>, query<Impl>, data<Impl>, data_dict<Impl>> getsetters;
-    Methods<MethGenericEnter<Impl>, __exit__<Impl>, remove<Impl>, query_attrs<Impl>, insert_attrs<Impl>, remove_attrs<Impl>, enqi<Impl>, enqd<Impl>, enqs<Impl>, enqf<Impl>> methods;
+    Methods<MethGenericEnter<Impl>, __exit__<Impl>, remove<Impl>, query_attrs<Impl>, insert_attrs<Impl>, remove_attrs<Impl>, enqi<Impl>, enqd<Impl>, enqs<Impl>, enqf<Impl>, to_arrow<Impl>, volnd_collect> methods;
 };
 
 
@@ -827,10 +1171,72 @@ DefinitionMessage*           definition_message = nullptr;
 namespace dballe {
 namespace python {
 
+namespace {
+
+template<typename Map>
+void release_all(Map& map)
+{
+    for (auto& i: map)
+        Py_DECREF(i.second);
+    map.clear();
+}
+
+template<typename Map, typename Key, typename Make>
+PyObject* intern(Map& map, const Key& key, Make make)
+{
+    auto i = map.find(key);
+    if (i != map.end())
+    {
+        Py_INCREF(i->second);
+        return i->second;
+    }
+
+    pyo_unique_ptr res(make(key));
+    // Start again when full, instead of tracking usage
+    if (map.size() >= Interner::max_size)
+        release_all(map);
+    map.emplace(key, res.get());
+    Py_INCREF(res.get());
+    return res.release();
+}
+
+PyObject* station_to_python_db(const DBStation& st) { return station_to_python(st); }
+
+}
+
+Interner::~Interner()
+{
+    clear();
+}
+
+void Interner::clear()
+{
+    release_all(levels);
+    release_all(tranges);
+    release_all(datetimes);
+    release_all(stations);
+    release_all(dbstations);
+    release_all(varcodes);
+    release_all(lats);
+    release_all(lons);
+    release_all(strings);
+}
+
+PyObject* Interner::level(const Level& lev) { return intern(levels, lev, level_to_python); }
+PyObject* Interner::trange(const Trange& tr) { return intern(tranges, tr, trange_to_python); }
+PyObject* Interner::datetime(const Datetime& dt) { return intern(datetimes, dt, datetime_to_python); }
+PyObject* Interner::station(const Station& st) { return intern(stations, st, station_to_python); }
+PyObject* Interner::station(const DBStation& st) { return intern(dbstations, st, station_to_python_db); }
+PyObject* Interner::varcode(wreport::Varcode code) { return intern(varcodes, code, varcode_to_python); }
+PyObject* Interner::lat(int lat) { return intern(lats, lat, dballe_int_lat_to_python); }
+PyObject* Interner::lon(int lon) { return intern(lons, lon, dballe_int_lon_to_python); }
+PyObject* Interner::string(const std::string& str) { return intern(strings, str, string_to_python); }
+
 dpy_CursorStation* cursor_create(std::shared_ptr<impl::CursorStation> cur)
 {
     py_unique_ptr<dpy_CursorStation> result(throw_ifnull(PyObject_New(dpy_CursorStation, dpy_CursorStation_Type)));
     new (&(result->cur)) std::shared_ptr<CursorStation>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -838,6 +1244,7 @@ dpy_CursorStationDB* cursor_create(std::shared_ptr<db::v7::cursor::Stations> cur
 {
     py_unique_ptr<dpy_CursorStationDB> result(throw_ifnull(PyObject_New(dpy_CursorStationDB, dpy_CursorStationDB_Type)));
     new (&(result->cur)) std::shared_ptr<CursorStation>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -845,6 +1252,7 @@ dpy_CursorStationData* cursor_create(std::shared_ptr<impl::CursorStationData> cu
 {
     py_unique_ptr<dpy_CursorStationData> result(throw_ifnull(PyObject_New(dpy_CursorStationData, dpy_CursorStationData_Type)));
     new (&(result->cur)) std::shared_ptr<CursorStationData>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -852,6 +1260,7 @@ dpy_CursorStationDataDB* cursor_create(std::shared_ptr<db::v7::cursor::StationDa
 {
     py_unique_ptr<dpy_CursorStationDataDB> result(throw_ifnull(PyObject_New(dpy_CursorStationDataDB, dpy_CursorStationDataDB_Type)));
     new (&(result->cur)) std::shared_ptr<CursorStationData>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -859,6 +1268,7 @@ dpy_CursorData* cursor_create(std::shared_ptr<impl::CursorData> cur)
 {
     py_unique_ptr<dpy_CursorData> result(throw_ifnull(PyObject_New(dpy_CursorData, dpy_CursorData_Type)));
     new (&(result->cur)) std::shared_ptr<CursorData>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -866,6 +1276,7 @@ dpy_CursorDataDB* cursor_create(std::shared_ptr<db::v7::cursor::Data> cur)
 {
     py_unique_ptr<dpy_CursorDataDB> result(throw_ifnull(PyObject_New(dpy_CursorDataDB, dpy_CursorDataDB_Type)));
     new (&(result->cur)) std::shared_ptr<CursorData>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -873,6 +1284,7 @@ dpy_CursorSummaryDB* cursor_create(std::shared_ptr<db::v7::cursor::Summary> cur)
 {
     py_unique_ptr<dpy_CursorSummaryDB> result(throw_ifnull(PyObject_New(dpy_CursorSummaryDB, dpy_CursorSummaryDB_Type)));
     new (&(result->cur)) std::shared_ptr<CursorSummary>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -880,6 +1292,7 @@ dpy_CursorSummarySummary* cursor_create(std::shared_ptr<db::summary::Cursor<Stat
 {
     py_unique_ptr<dpy_CursorSummarySummary> result(throw_ifnull(PyObject_New(dpy_CursorSummarySummary, dpy_CursorSummarySummary_Type)));
     new (&(result->cur)) std::shared_ptr<CursorSummary>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -887,6 +1300,7 @@ dpy_CursorSummaryDBSummary* cursor_create(std::shared_ptr<db::summary::Cursor<DB
 {
     py_unique_ptr<dpy_CursorSummaryDBSummary> result(throw_ifnull(PyObject_New(dpy_CursorSummaryDBSummary, dpy_CursorSummaryDBSummary_Type)));
     new (&(result->cur)) std::shared_ptr<CursorSummary>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -894,6 +1308,7 @@ dpy_CursorMessage* cursor_create(std::shared_ptr<dballe::CursorMessage> cur)
 {
     py_unique_ptr<dpy_CursorMessage> result(throw_ifnull(PyObject_New(dpy_CursorMessage, dpy_CursorMessage_Type)));
     new (&(result->cur)) std::shared_ptr<CursorMessage>(cur);
+    new (&(result->interner)) Interner;
     return result.release();
 }
 
@@ -7,12 +7,65 @@
 #include <dballe/db/summary_utils.h>
 #include <dballe/core/var.h>
 #include "utils/core.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace dballe {
+namespace python {
+
+/**
+ * Cache of the immutable Python objects created when reading values from a
+ * cursor.
+ *
+ * Rows of a query result tend to share a few distinct levels, time ranges,
+ * variable codes and stations: reusing the same Python objects for them
+ * avoids creating new ones for every row.
+ */
+struct Interner
+{
+    /// Maximum number of objects kept for each kind of value
+    static const size_t max_size = 4096;
+
+    std::map<Level, PyObject*> levels;
+    std::map<Trange, PyObject*> tranges;
+    std::map<Datetime, PyObject*> datetimes;
+    std::map<Station, PyObject*> stations;
+    std::map<DBStation, PyObject*> dbstations;
+    std::unordered_map<wreport::Varcode, PyObject*> varcodes;
+    std::unordered_map<int, PyObject*> lats;
+    std::unordered_map<int, PyObject*> lons;
+    std::unordered_map<std::string, PyObject*> strings;
+
+    Interner() = default;
+    Interner(const Interner&) = delete;
+    ~Interner();
+    Interner& operator=(const Interner&) = delete;
+
+    /// Release all the cached objects
+    void clear();
+
+    // All these return a new reference
+    PyObject* level(const Level& lev);
+    PyObject* trange(const Trange& tr);
+    PyObject* datetime(const Datetime& dt);
+    PyObject* station(const Station& st);
+    PyObject* station(const DBStation& st);
+    PyObject* varcode(wreport::Varcode code);
+    PyObject* lat(int lat);
+    PyObject* lon(int lon);
+    PyObject* string(const std::string& str);
+};
+
+}
+}
 
 extern "C" {
 
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::impl::CursorStation> cur;
+    dballe::python::Interner interner;
 } dpy_CursorStation;
 
 extern PyTypeObject* dpy_CursorStation_Type;
@@ -25,6 +78,7 @@ extern PyTypeObject* dpy_CursorStation_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::db::v7::cursor::Stations> cur;
+    dballe::python::Interner interner;
 } dpy_CursorStationDB;
 
 extern PyTypeObject* dpy_CursorStationDB_Type;
@@ -37,6 +91,7 @@ extern PyTypeObject* dpy_CursorStationDB_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::impl::CursorStationData> cur;
+    dballe::python::Interner interner;
 } dpy_CursorStationData;
 
 extern PyTypeObject* dpy_CursorStationData_Type;
@@ -49,6 +104,7 @@ extern PyTypeObject* dpy_CursorStationData_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::db::v7::cursor::StationData> cur;
+    dballe::python::Interner interner;
 } dpy_CursorStationDataDB;
 
 extern PyTypeObject* dpy_CursorStationDataDB_Type;
@@ -61,6 +117,7 @@ extern PyTypeObject* dpy_CursorStationDataDB_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::impl::CursorData> cur;
+    dballe::python::Interner interner;
 } dpy_CursorData;
 
 extern PyTypeObject* dpy_CursorData_Type;
@@ -73,6 +130,7 @@ extern PyTypeObject* dpy_CursorData_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::db::v7::cursor::Data> cur;
+    dballe::python::Interner interner;
 } dpy_CursorDataDB;
 
 extern PyTypeObject* dpy_CursorDataDB_Type;
@@ -85,6 +143,7 @@ extern PyTypeObject* dpy_CursorDataDB_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::db::v7::cursor::Summary> cur;
+    dballe::python::Interner interner;
 } dpy_CursorSummaryDB;
 
 extern PyTypeObject* dpy_CursorSummaryDB_Type;
@@ -97,6 +156,7 @@ extern PyTypeObject* dpy_CursorSummaryDB_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::db::summary::Cursor<dballe::Station>> cur;
+    dballe::python::Interner interner;
 } dpy_CursorSummarySummary;
 
 extern PyTypeObject* dpy_CursorSummarySummary_Type;
@@ -109,6 +169,7 @@ extern PyTypeObject* dpy_CursorSummarySummary_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::db::summary::Cursor<dballe::DBStation>> cur;
+    dballe::python::Interner interner;
 } dpy_CursorSummaryDBSummary;
 
 extern PyTypeObject* dpy_CursorSummarySummary_Type;
@@ -121,6 +182,7 @@ extern PyTypeObject* dpy_CursorSummarySummary_Type;
 typedef struct {
     PyObject_HEAD
     std::shared_ptr<dballe::impl::CursorMessage> cur;
+    dballe::python::Interner interner;
 } dpy_CursorMessage;
 
 extern PyTypeObject* dpy_CursorMessage_Type;
@@ -189,6 +189,130 @@ database ID of its value.
     }
 };
 
+template<typename Impl>
+struct insert_data_many : MethKwargs<insert_data_many<Impl>, Impl>
+{
+    constexpr static const char* name = "insert_data_many";
+    constexpr static const char* signature = "records: Union[Iterable[Union[Dict[str, Any], dballe.Cursor, dballe.Data]], Dict[str, Any]], can_replace: bool=False, can_add_stations: bool=False, with_ids: bool=True";
+    constexpr static const char* returns = "Optional[List[Dict[str, int]]]";
+    constexpr static const char* summary = "Insert many data values in the database at once";
+    constexpr static const char* doc = R"(
+:arg records:
+ * an iterable of records, each in any of the forms accepted by
+   :func:`insert_data`
+ * a dict of columns, mapping each key to a list with one value for each
+   record; keys whose value is not a list have the same value in all records
+:arg with_ids: if True (default), return the IDs of what was inserted.
+
+This works as calling :func:`insert_data` for each record, but data is written
+to the database in bulk.
+
+If `with_ids` is True, the return value is a list with, for each record, a dict
+like the one returned by :func:`insert_data`. Otherwise, it is None.
+)";
+
+    static void add_record(std::vector<DataPtr>& records, PyObject* o)
+    {
+        records.emplace_back(o);
+        if (!records.back().data)
+        {
+            PyErr_SetString(PyExc_TypeError, "insert_data_many records cannot be None");
+            throw PythonException();
+        }
+    }
+
+    static void records_from_columns(std::vector<DataPtr>& records, PyObject* columns)
+    {
+        // Find the number of records
+        Py_ssize_t count = -1;
+        PyObject* key;
+        PyObject* value;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(columns, &pos, &key, &value))
+        {
+            if (!PyList_Check(value)) continue;
+            Py_ssize_t len = PyList_GET_SIZE(value);
+            if (count == -1)
+                count = len;
+            else if (count != len)
+            {
+                PyErr_SetString(PyExc_ValueError, "insert_data_many columns must all have the same length");
+                throw PythonException();
+            }
+        }
+        if (count == -1)
+        {
+            // No lists: the dict is a single record
+            add_record(records, columns);
+            return;
+        }
+
+        records.reserve(count);
+        for (Py_ssize_t i = 0; i < count; ++i)
+        {
+            pyo_unique_ptr row(throw_ifnull(PyDict_New()));
+            pos = 0;
+            while (PyDict_Next(columns, &pos, &key, &value))
+            {
+                PyObject* item = PyList_Check(value) ? PyList_GET_ITEM(value, i) : value;
+                if (PyDict_SetItem(row, key, item))
+                    throw PythonException();
+            }
+            add_record(records, row);
+        }
+    }
+
+    static PyObject* run(Impl* self, PyObject* args, PyObject* kw)
+    {
+        if (deprecate_on_db(self, name)) return nullptr;
+
+        static const char* kwlist[] = { "records", "can_replace", "can_add_stations", "with_ids", NULL };
+        PyObject* pyrecords;
+        int can_replace = 0;
+        int can_add_stations = 0;
+        int with_ids = 1;
+        if (!PyArg_ParseTupleAndKeywords(args, kw, "O|iii", const_cast<char**>(kwlist), &pyrecords, &can_replace, &can_add_stations, &with_ids))
+            return nullptr;
+
+        try {
+            std::vector<DataPtr> records;
+            // Records can borrow the data of dballe.Data objects, so keep all
+            // the input objects alive until the end
+            pyo_unique_ptr items;
+            if (PyDict_Check(pyrecords))
+                records_from_columns(records, pyrecords);
+            else
+            {
+                items = throw_ifnull(PySequence_List(pyrecords));
+                Py_ssize_t len = PyList_GET_SIZE(items.get());
+                records.reserve(len);
+                for (Py_ssize_t i = 0; i < len; ++i)
+                    add_record(records, PyList_GET_ITEM(items.get(), i));
+            }
+
+            std::vector<Data*> data;
+            data.reserve(records.size());
+            for (auto& r: records)
+                data.push_back(r.data);
+
+            ReleaseGIL gil;
+            impl::DBInsertOptions opts;
+            opts.can_replace = can_replace;
+            opts.can_add_stations = can_add_stations;
+            self->db->insert_data_many(data, opts, with_ids);
+            gil.lock();
+
+            if (!with_ids)
+                Py_RETURN_NONE;
+
+            pyo_unique_ptr res(throw_ifnull(PyList_New(records.size())));
+            for (size_t i = 0; i < records.size(); ++i)
+                PyList_SET_ITEM(res.get(), i, get_insert_ids(*records[i]));
+            return res.release();
+        } DBALLE_CATCH_RETURN_PYO
+    }
+};
+
 template<typename Base, typename Impl>
 struct MethQuery : public MethKwargs<Base, Impl>
 {
@@ -624,7 +748,7 @@ static unsigned db_load_file_enc(DB& db, Encoding encoding, FILE* file, bool clo
     std::unique_ptr<Importer> imp = Importer::create(f->encoding());
     unsigned count = 0;
     f->foreach([&](const BinaryMessage& raw) {
-        impl::Messages messages = imp->from_binary(raw);
+        impl::Messages messages = decode_binary(*imp, raw);
         db.import_messages(messages, opts);
         ++count;
         return true;
@@ -639,7 +763,7 @@ static unsigned db_load_file(DB& db, FILE* file, bool close_on_exit, const std::
     std::unique_ptr<Importer> imp = Importer::create(f->encoding());
     unsigned count = 0;
     f->foreach([&](const BinaryMessage& raw) {
-        impl::Messages messages = imp->from_binary(raw);
+        impl::Messages messages = decode_binary(*imp, raw);
         db.import_messages(messages, opts);
         ++count;
         return true;
@@ -870,11 +994,9 @@ struct import_messages : MethKwargs<import_messages<Impl>, Impl>
             if (dpy_ImporterFile_Check(obj))
             {
                 dpy_ImporterFile* impf = (dpy_ImporterFile*)obj;
-                while (auto binmsg = impf->file->file->file().read())
-                {
-                    auto messages = impf->importer->importer->from_binary(binmsg);
+                std::vector<std::shared_ptr<Message>> messages;
+                while (importerfile_next(impf, messages))
                     self->db->import_messages(messages, *opts);
-                }
                 Py_RETURN_NONE;
             }
 
@@ -1153,7 +1275,7 @@ See :ref:`python_how_dumpdb` and :ref:`python_how_insert` examples.
         connect_from_file, connect, connect_from_url, connect_test, is_url,
         disappear, reset, vacuum,
         transaction,
-        insert_station_data<Impl>, insert_data<Impl>,
+        insert_station_data<Impl>, insert_data<Impl>, insert_data_many<Impl>,
         remove_station_data<Impl>, remove_data<Impl>, remove_all<Impl>, remove<Impl>,
         query_stations<Impl>, query_station_data<Impl>, query_data<Impl>, query_summary<Impl>, query_messages<Impl>, query_attrs<Impl>,
         attr_query_station<Impl>, attr_query_data<Impl>,
@@ -1267,7 +1389,7 @@ See :ref:`python_how_dumpdb` and :ref:`python_how_insert` examples.
 
     GetSetters<> getsetters;
     Methods<
-        insert_station_data<Impl>, insert_data<Impl>,
+        insert_station_data<Impl>, insert_data<Impl>, insert_data_many<Impl>,
         remove_station_data<Impl>, remove_data<Impl>, remove_all<Impl>, remove<Impl>,
         query_stations<Impl>, query_station_data<Impl>, query_data<Impl>, query_summary<Impl>, query_messages<Impl>,
         attr_query_station<Impl>, attr_query_data<Impl>,
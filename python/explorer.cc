@@ -11,6 +11,7 @@
 #include "utils/type.h"
 #include <algorithm>
 #include <sstream>
+#include <cstring>
 #include "config.h"
 
 using namespace std;
@@ -620,8 +621,7 @@ Add the contents of the given JSON string to the Explorer.
         try {
             {
                 ReleaseGIL rg;
-                std::istringstream json(json_str);
-                core::json::Stream in(json);
+                core::json::Stream in(json_str, strlen(json_str));
                 self->update.add_json(in);
             }
         } DBALLE_CATCH_RETURN_PYO
@@ -700,11 +700,9 @@ It takes the same messages argument of :func:`dballe.DB.import_messages`.
             if (dpy_ImporterFile_Check(obj))
             {
                 dpy_ImporterFile* impf = (dpy_ImporterFile*)obj;
-                while (auto binmsg = impf->file->file->file().read())
-                {
-                    auto messages = impf->importer->importer->from_binary(binmsg);
+                std::vector<std::shared_ptr<Message>> messages;
+                while (importerfile_next(impf, messages))
                     self->update.add_messages(messages, station_data, data);
-                }
                 Py_RETURN_NONE;
             }
 
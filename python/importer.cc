@@ -8,6 +8,14 @@
 #include "dballe/msg/msg.h"
 #include "utils/type.h"
 #include "wreport/options.h"
+#include <wreport/bulletin.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
 
 using namespace std;
 using namespace dballe;
@@ -19,6 +27,281 @@ PyTypeObject* dpy_Importer_Type = nullptr;
 PyTypeObject* dpy_ImporterFile_Type = nullptr;
 }
 
+namespace dballe {
+namespace python {
+
+namespace {
+
+/**
+ * Process-wide coordination of wreport table loading.
+ *
+ * wreport loads tables on first use, and that is not safe to do while other
+ * threads are looking up tables. All decoding done without the GIL is
+ * registered here, and tables that have not been seen before are loaded only
+ * when no decoding is running in any thread.
+ */
+class TableLoader
+{
+protected:
+    std::mutex mutex;
+    /// Notified when decoding ends, and when tables have been loaded
+    std::condition_variable changed;
+    /// Number of threads currently decoding
+    unsigned decoding = 0;
+    /// Number of threads waiting to load tables
+    unsigned loading = 0;
+    /// Table identifiers of the messages whose tables have been loaded
+    std::set<std::string> loaded;
+
+    /**
+     * Return a string identifying the wreport tables needed to decode
+     * \a binmsg, or an empty string if its header cannot be decoded
+     */
+    static std::string table_id(const BinaryMessage& binmsg)
+    {
+        try {
+            switch (binmsg.encoding)
+            {
+                case Encoding::BUFR: {
+                    auto header = BufrBulletin::decode_header(binmsg.data, binmsg.pathname.c_str(), binmsg.offset);
+                    return "B" + std::to_string(header->edition_number)
+                         + "/" + std::to_string(header->master_table_number)
+                         + "/" + std::to_string(header->originating_centre)
+                         + "/" + std::to_string(header->originating_subcentre)
+                         + "/" + std::to_string(header->master_table_version_number)
+                         + "/" + std::to_string(header->master_table_version_number_local);
+                }
+                case Encoding::CREX: {
+                    auto header = CrexBulletin::decode_header(binmsg.data, binmsg.pathname.c_str(), binmsg.offset);
+                    return "C" + std::to_string(header->edition_number)
+                         + "/" + std::to_string(header->master_table_number)
+                         + "/" + std::to_string(header->master_table_version_number)
+                         + "/" + std::to_string(header->master_table_version_number_bufr)
+                         + "/" + std::to_string(header->master_table_version_number_local);
+                }
+                default:
+                    return std::string();
+            }
+        } catch (std::exception&) {
+            // Anything that cannot be read is left for the full decoding to
+            // report
+            return std::string();
+        }
+    }
+
+public:
+    /**
+     * Load the wreport tables needed by \a binmsg, if they have not been
+     * loaded yet, waiting for all running decoding to end.
+     *
+     * It must not be called by a thread that is decoding.
+     */
+    void load(const BinaryMessage& binmsg)
+    {
+        std::string id = table_id(binmsg);
+        if (id.empty())
+            return;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (loaded.find(id) != loaded.end())
+            return;
+
+        // Keep new decoding from starting until the tables are loaded
+        ++loading;
+        changed.wait(lock, [&] { return decoding == 0; });
+        if (loaded.find(id) == loaded.end())
+        {
+            try {
+                if (binmsg.encoding == Encoding::BUFR)
+                    BufrBulletin::decode_header(binmsg.data, binmsg.pathname.c_str(), binmsg.offset)->load_tables();
+                else
+                    CrexBulletin::decode_header(binmsg.data, binmsg.pathname.c_str(), binmsg.offset)->load_tables();
+            } catch (std::exception&) {
+                // Missing tables are reported by the full decoding
+            }
+            loaded.insert(id);
+        }
+        --loading;
+        changed.notify_all();
+    }
+
+    /// Mark the calling thread as decoding for the lifetime of the object
+    class Decoding
+    {
+        TableLoader& loader;
+
+    public:
+        Decoding(TableLoader& loader)
+            : loader(loader)
+        {
+            std::unique_lock<std::mutex> lock(loader.mutex);
+            loader.changed.wait(lock, [&] { return loader.loading == 0; });
+            ++loader.decoding;
+        }
+        Decoding(const Decoding&) = delete;
+        Decoding& operator=(const Decoding&) = delete;
+        ~Decoding()
+        {
+            std::lock_guard<std::mutex> lock(loader.mutex);
+            --loader.decoding;
+            loader.changed.notify_all();
+        }
+    };
+
+    /// Access the process-wide TableLoader
+    static TableLoader& get()
+    {
+        static TableLoader instance;
+        return instance;
+    }
+};
+
+}
+
+std::vector<std::shared_ptr<dballe::Message>> decode_binary(const Importer& importer, const BinaryMessage& binmsg)
+{
+    TableLoader& loader = TableLoader::get();
+    loader.load(binmsg);
+    TableLoader::Decoding decoding(loader);
+    return importer.from_binary(binmsg);
+}
+
+/**
+ * Decode binary messages using a pool of worker threads.
+ *
+ * Binary messages are submitted by the thread iterating the ImporterFile,
+ * which also collects the decoded messages, in the same order as they were
+ * submitted. Worker threads never touch Python objects, and run without the
+ * GIL.
+ */
+class ParallelDecoder
+{
+protected:
+    struct Job
+    {
+        size_t seq;
+        BinaryMessage binmsg;
+
+        Job(size_t seq, BinaryMessage&& binmsg)
+            : seq(seq), binmsg(std::move(binmsg)) {}
+    };
+
+    struct Result
+    {
+        std::vector<std::shared_ptr<dballe::Message>> messages;
+        std::exception_ptr error;
+    };
+
+    const Importer& importer;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    /// Notified when new jobs are queued, or on shutdown
+    std::condition_variable jobs_changed;
+    /// Notified when a job has been decoded
+    std::condition_variable results_changed;
+    std::deque<Job> jobs;
+    /// Decoded messages waiting to be collected, indexed by sequence
+    std::map<size_t, Result> results;
+    /// Sequence number of the next job to be submitted
+    size_t next_seq = 0;
+    /// Sequence number of the next result to be collected
+    size_t next_out = 0;
+    bool shutting_down = false;
+
+    void worker_main()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            jobs_changed.wait(lock, [&] { return shutting_down || !jobs.empty(); });
+            if (shutting_down)
+                return;
+            Job job(std::move(jobs.front()));
+            jobs.pop_front();
+            lock.unlock();
+
+            Result result;
+            try {
+                TableLoader::Decoding decoding(TableLoader::get());
+                result.messages = importer.from_binary(job.binmsg);
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+
+            lock.lock();
+            results.emplace(job.seq, std::move(result));
+            results_changed.notify_all();
+        }
+    }
+
+public:
+    ParallelDecoder(const Importer& importer, unsigned count)
+        : importer(importer)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            workers.emplace_back([this] { worker_main(); });
+    }
+    ParallelDecoder(const ParallelDecoder&) = delete;
+    ParallelDecoder& operator=(const ParallelDecoder&) = delete;
+    ~ParallelDecoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shutting_down = true;
+            jobs.clear();
+        }
+        jobs_changed.notify_all();
+        for (auto& w: workers)
+            w.join();
+    }
+
+    /// Number of messages submitted and not yet collected
+    size_t pending()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return next_seq - next_out;
+    }
+
+    /**
+     * Queue a binary message for decoding.
+     *
+     * If the message uses tables that have not been seen before, it blocks
+     * until all running decoding has ended, and loads the tables.
+     */
+    void submit(BinaryMessage&& binmsg)
+    {
+        TableLoader::get().load(binmsg);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.emplace_back(next_seq++, std::move(binmsg));
+        }
+        jobs_changed.notify_one();
+    }
+
+    /**
+     * Wait for the next message to be decoded, and return its contents.
+     *
+     * Exceptions raised while decoding are rethrown here. It must only be
+     * called when pending() is not zero.
+     */
+    std::vector<std::shared_ptr<dballe::Message>> next()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::map<size_t, Result>::iterator i;
+        results_changed.wait(lock, [&] { return (i = results.find(next_out)) != results.end(); });
+        Result result(std::move(i->second));
+        results.erase(i);
+        ++next_out;
+        lock.unlock();
+        if (result.error)
+            std::rethrow_exception(result.error);
+        return std::move(result.messages);
+    }
+};
+
+}
+}
+
 namespace {
 
 namespace importerfile {
@@ -38,6 +321,8 @@ struct __exit__ : MethVarargs<__exit__, dpy_ImporterFile>
             return nullptr;
 
         try {
+            delete self->decoder;
+            self->decoder = nullptr;
             Py_XDECREF(self->importer);
             self->importer = nullptr;
             Py_XDECREF(self->file);
@@ -76,6 +361,7 @@ of :class:`dballe.Message` objects.
 
     static void _dealloc(Impl* self)
     {
+        delete self->decoder;
         Py_XDECREF(self->importer);
         Py_XDECREF(self->file);
         Py_TYPE(self)->tp_free(self);
@@ -94,13 +380,12 @@ of :class:`dballe.Message` objects.
     {
         try {
             check_valid(self);
-            BinaryMessage binmsg = self->file->file->file().read();
-            if (!binmsg)
+            std::vector<std::shared_ptr<dballe::Message>> messages;
+            if (!importerfile_next(self, messages))
             {
                 PyErr_SetNone(PyExc_StopIteration);
                 return nullptr;
             }
-            auto messages = self->importer->importer->from_binary(binmsg);
             pyo_unique_ptr res(throw_ifnull(PyTuple_New(messages.size())));
             for (size_t i = 0; i < messages.size(); ++i)
                 PyTuple_SET_ITEM((PyTupleObject*)res.get(), i, (PyObject*)message_create(messages[i]));
@@ -126,7 +411,11 @@ struct from_binary : MethKwargs<from_binary, dpy_Importer>
         if (!PyArg_ParseTupleAndKeywords(args, kw, "O!", const_cast<char**>(kwlist), dpy_BinaryMessage_Type, &binmsg))
             return nullptr;
         try {
-            auto messages = self->importer->from_binary(binmsg->message);
+            std::vector<std::shared_ptr<dballe::Message>> messages;
+            {
+                ReleaseGIL gil;
+                messages = decode_binary(*self->importer, binmsg->message);
+            }
             pyo_unique_ptr res(throw_ifnull(PyTuple_New(messages.size())));
             for (size_t i = 0; i < messages.size(); ++i)
                 PyTuple_SET_ITEM((PyTupleObject*)res.get(), i, (PyObject*)message_create(messages[i]));
@@ -138,22 +427,42 @@ struct from_binary : MethKwargs<from_binary, dpy_Importer>
 struct from_file : MethKwargs<from_file, dpy_Importer>
 {
     constexpr static const char* name = "from_file";
-    constexpr static const char* signature = "file: Union[dballe.File, str, File]";
+    constexpr static const char* signature = "file: Union[dballe.File, str, File], workers: int=0, prefetch: int=None";
     constexpr static const char* returns = "dballe.ImporterFile";
     constexpr static const char* doc = R"(
 Wrap a :class:`dballe.File` into a sequence of tuples of :class:`dballe.Message` objects.
 
 `file` can be a :class:`dballe.File`, a file name, or a file-like object. A :class:`dballe.File`
 is automatically constructed if needed, using the importer encoding.
+
+If `workers` is greater than 0, messages are decoded ahead by that number of
+threads, which run without holding the GIL, and are still returned in file
+order. `prefetch` is the maximum number of messages read ahead of the one
+being returned, and defaults to 4 times `workers`.
 )";
     static PyObject* run(Impl* self, PyObject* args, PyObject* kw)
     {
-        static const char* kwlist[] = { "file", nullptr };
+        static const char* kwlist[] = { "file", "workers", "prefetch", nullptr };
         PyObject* obj = nullptr;
-        if (!PyArg_ParseTupleAndKeywords(args, kw, "O", const_cast<char**>(kwlist), &obj))
+        int workers = 0;
+        int prefetch = -1;
+        if (!PyArg_ParseTupleAndKeywords(args, kw, "O|ii", const_cast<char**>(kwlist), &obj, &workers, &prefetch))
             return nullptr;
 
         try {
+            if (workers < 0)
+            {
+                PyErr_SetString(PyExc_ValueError, "workers must not be negative");
+                throw PythonException();
+            }
+            if (prefetch == -1)
+                prefetch = workers * 4;
+            else if (prefetch < 1)
+            {
+                PyErr_SetString(PyExc_ValueError, "prefetch must be at least 1");
+                throw PythonException();
+            }
+
             py_unique_ptr<dpy_File> file;
 
             if (dpy_File_Check(obj))
@@ -168,6 +477,9 @@ is automatically constructed if needed, using the importer encoding.
             res->file = file.release();
             Py_INCREF(self);
             res->importer = self;
+            res->workers = workers;
+            res->prefetch = prefetch;
+            res->decoder = nullptr;
             return (PyObject*)res.release();
         } DBALLE_CATCH_RETURN_PYO
     }
@@ -275,6 +587,48 @@ Definition* definition = nullptr;
 namespace dballe {
 namespace python {
 
+bool importerfile_next(dpy_ImporterFile* self, std::vector<std::shared_ptr<dballe::Message>>& messages)
+{
+    const Importer& importer = *self->importer->importer;
+    dballe::File& file = self->file->file->file();
+
+    if (self->decoder)
+    {
+        // Keep the worker threads busy reading ahead
+        while (self->decoder->pending() < self->prefetch)
+        {
+            BinaryMessage binmsg = file.read();
+            if (!binmsg)
+                break;
+            ReleaseGIL gil;
+            self->decoder->submit(std::move(binmsg));
+        }
+        if (self->decoder->pending() == 0)
+            return false;
+        ReleaseGIL gil;
+        messages = self->decoder->next();
+        return true;
+    }
+
+    BinaryMessage binmsg = file.read();
+    if (!binmsg)
+        return false;
+    {
+        ReleaseGIL gil;
+        messages = decode_binary(importer, binmsg);
+    }
+
+    // Start the worker threads after decoding the first message in this
+    // thread, since it also loads dballe's variable table and initialises
+    // the importer registries, which are not safe to initialise
+    // concurrently. The wreport tables used by each message are loaded as
+    // the message is submitted to the workers
+    if (self->workers)
+        self->decoder = new ParallelDecoder(importer, self->workers);
+
+    return true;
+}
+
 dpy_Importer* importer_create(Encoding encoding, const dballe::ImporterOptions& opts)
 {
     dpy_Importer* res = PyObject_New(dpy_Importer, dpy_Importer_Type);
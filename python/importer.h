@@ -4,6 +4,13 @@
 #include "dballe/importer.h"
 #include "file.h"
 #include <memory>
+#include <vector>
+
+namespace dballe {
+namespace python {
+class ParallelDecoder;
+}
+}
 
 extern "C" {
 
@@ -23,6 +30,12 @@ typedef struct {
     PyObject_HEAD
     dpy_File* file;
     dpy_Importer* importer;
+    /// Number of decoding threads, or 0 to decode while iterating
+    unsigned workers;
+    /// Maximum number of messages read ahead and decoding
+    unsigned prefetch;
+    /// Decoding thread pool, started at the first iteration when workers > 0
+    dballe::python::ParallelDecoder* decoder;
 } dpy_ImporterFile;
 
 extern PyTypeObject* dpy_ImporterFile_Type;
@@ -43,6 +56,22 @@ namespace python {
  */
 dpy_Importer* importer_create(Encoding encoding, const dballe::ImporterOptions& opts=dballe::ImporterOptions::defaults);
 
+/**
+ * Decode a binary message.
+ *
+ * It can be called without holding the GIL: the wreport tables needed by the
+ * message are loaded while no other thread is decoding.
+ */
+std::vector<std::shared_ptr<dballe::Message>> decode_binary(const dballe::Importer& importer, const dballe::BinaryMessage& binmsg);
+
+/**
+ * Decode the next binary message of a dpy_ImporterFile.
+ *
+ * Returns false when the file has no more messages. The GIL is released while
+ * decoding.
+ */
+bool importerfile_next(dpy_ImporterFile* self, std::vector<std::shared_ptr<dballe::Message>>& messages);
+
 void register_importer(PyObject* m);
 
 }
@@ -8,6 +8,11 @@ from contextlib import contextmanager
 from decimal import Decimal
 from testlib import DballeDBMixin, test_pathname
 
+try:
+    import pyarrow
+except ImportError:
+    pyarrow = None
+
 
 class CommonDBTestMixin(DballeDBMixin):
     @contextmanager
@@ -729,6 +734,40 @@ class CommonDBTestMixin(DballeDBMixin):
                         "B01012": 500,
                     })
 
+    def test_cursor_interning(self):
+        # Rows with the same values share the same Python objects
+        with self.db.transaction() as tr:
+            rows = [(row["level"], row["trange"], row["datetime"], row["report"], row["lat"], row["lon"])
+                    for row in tr.query_data()]
+        self.assertEqual(len(rows), 2)
+        for a, b in zip(rows[0], rows[1]):
+            self.assertIs(a, b)
+
+    @unittest.skipIf(pyarrow is None, "pyarrow is not available")
+    def test_cursor_to_arrow(self):
+        with self.db.transaction() as tr:
+            with tr.query_data({"query": "attrs"}) as cur:
+                table = cur.to_arrow(batch_size=1)
+        self.assertEqual(table.num_rows, 2)
+        self.assertEqual(table.column_names, [
+            "ana_id", "report", "lat", "lon", "ident", "level", "trange", "datetime",
+            "var", "value", "value_str", "attrs"])
+        rows = sorted(table.to_pylist(), key=lambda r: r["var"])
+        self.assertEqual(rows[0]["var"], "B01011")
+        self.assertEqual(rows[0]["report"], "synop")
+        self.assertEqual(rows[0]["lat"], 1234560)
+        self.assertEqual(rows[0]["lon"], 7654320)
+        self.assertIsNone(rows[0]["ident"])
+        self.assertEqual(rows[0]["datetime"], datetime.datetime(1945, 4, 25, 8, 0, 0))
+        self.assertIsNone(rows[0]["value"])
+        self.assertEqual(rows[0]["value_str"], "Hey Hey!!")
+        self.assertEqual(sorted((a["code"], a["value"]) for a in rows[0]["attrs"]), [
+            ("B33007", 50.0), ("B33036", 75.0)])
+        self.assertEqual(rows[1]["var"], "B01012")
+        self.assertEqual(rows[1]["value"], 500.0)
+        self.assertIsNone(rows[1]["value_str"])
+        self.assertEqual(rows[1]["attrs"], [])
+
     def test_insert_cursor(self):
         with self.another_db() as db1:
             with db1.transaction() as tr1:
@@ -846,6 +885,41 @@ class CommonDBTestMixin(DballeDBMixin):
                 })
             self.assertEqual(str(e.exception), "'station not found in the database'")
 
+    def test_insert_data_many(self):
+        with self.transaction() as tr:
+            records = []
+            for hour in range(3):
+                for lat in (44.5, 45.5):
+                    records.append({
+                        "report": "synop",
+                        "lat": lat, "lon": 11.4,
+                        "level": dballe.Level(1),
+                        "trange": dballe.Trange(254),
+                        "datetime": datetime.datetime(2013, 4, 25, hour, 0, 0),
+                        "B12101": 280.0 + hour,
+                    })
+            ids = tr.insert_data_many(records, can_replace=True, can_add_stations=True)
+            self.assertEqual(len(ids), 6)
+            self.assertNotEqual(ids[0]["ana_id"], ids[1]["ana_id"])
+            self.assertEqual(ids[0]["ana_id"], ids[2]["ana_id"])
+            self.assertNotEqual(ids[0]["B12101"], ids[2]["B12101"])
+
+            # Columns, with the same value given twice
+            res = tr.insert_data_many({
+                "report": "synop",
+                "lat": 44.5, "lon": 11.4,
+                "level": dballe.Level(1),
+                "trange": dballe.Trange(254),
+                "datetime": [datetime.datetime(2013, 4, 25, 0, 0, 0), datetime.datetime(2013, 4, 25, 0, 0, 0)],
+                "B12101": [300.0, 301.0],
+            }, can_replace=True, with_ids=False)
+            self.assertIsNone(res)
+
+            values = {}
+            for row in tr.query_data({"lat": 44.5, "lon": 11.4, "var": "B12101"}):
+                values[row["datetime"].hour] = row["B12101"].enqd()
+            self.assertEqual(values, {0: 301.0, 1: 281.0, 2: 282.0})
+
     def test_cursor_delete(self):
         # See: #140
         with self.transaction() as tr:
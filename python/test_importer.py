@@ -151,3 +151,36 @@ class TestImporter(MessageTestMixin, unittest.TestCase):
         a = val.enqa("B33192")
         self.assertTrue(a)
         self.assertEqual(a.enqi(), 0)
+
+    def test_fromfile_workers(self):
+        pathname = test_pathname("json/issue134.json")
+        importer = dballe.Importer("JSON")
+
+        with importer.from_file(pathname) as f:
+            expected = [(m.datetime, m.coords) for msgs in f for m in msgs]
+
+        for workers, prefetch in ((1, 1), (2, 1), (3, 8)):
+            with importer.from_file(pathname, workers=workers, prefetch=prefetch) as f:
+                decoded = [(m.datetime, m.coords) for msgs in f for m in msgs]
+            self.assertEqual(decoded, expected)
+
+        with self.assertRaises(ValueError):
+            importer.from_file(pathname, workers=-1)
+        with self.assertRaises(ValueError):
+            importer.from_file(pathname, workers=2, prefetch=0)
+
+    def test_fromfile_workers_errors(self):
+        with open(test_pathname("json/issue134.json"), "rb") as fd:
+            data = fd.read()
+        with open(test_pathname("json/issue241.json"), "rb") as fd:
+            data += fd.read()
+
+        importer = dballe.Importer("JSON")
+        decoded = []
+        with io.BytesIO(data) as fd:
+            with importer.from_file(fd, workers=2) as f:
+                with self.assertRaises(OverflowError):
+                    for msgs in f:
+                        decoded.append(msgs)
+        # Errors are raised in file order, after all the previous messages
+        self.assertEqual(len(decoded), 5)
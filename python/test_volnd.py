@@ -343,5 +343,48 @@ class ReadMixin(DballeDBMixin):
             self.assertEqual(anas["B01001"].dims[0], vars["B13011"].dims[0])
 
 
+    def assertSameVolumes(self, vars1, vars2):
+        self.assertEqual(list(vars1.keys()), list(vars2.keys()))
+        for code in vars1:
+            v1, v2 = vars1[code], vars2[code]
+            self.assertEqual([list(d) for d in v1.dims], [list(d) for d in v2.dims])
+            self.assertEqual(v1.vals.dtype, v2.vals.dtype)
+            if v1.info.type == "string":
+                self.assertEqual(v1.vals.tolist(), v2.vals.tolist())
+            else:
+                self.assertEqual(v1.vals.mask.tolist(), v2.vals.mask.tolist())
+                self.assertEqual(v1.vals.compressed().tolist(), v2.vals.compressed().tolist())
+            self.assertEqual(sorted(v1.attrs.keys()), sorted(v2.attrs.keys()))
+            for a in v1.attrs:
+                self.assertEqual(v1.attrs[a].vals.mask.tolist(), v2.attrs[a].vals.mask.tolist())
+                self.assertEqual(v1.attrs[a].vals.compressed().tolist(), v2.attrs[a].vals.compressed().tolist())
+
+    def testNative(self):
+        # The C++ implementation gives the same results as the generic one,
+        # which is used when a filter is given
+        def make_indexes():
+            return [
+                (AnaIndex(), NetworkIndex(), LevelIndex(), TimeRangeIndex(), DateTimeIndex()),
+                (AnaIndex(), TimeRangeIndex(), DateTimeIndex(shared=False)),
+                (TimeRangeIndex(), LevelIndex(frozen=True, start=(dballe.Level(1, None, None, None),))),
+            ]
+
+        with self.db.transaction() as tr:
+            for native, generic in zip(make_indexes(), make_indexes()):
+                for attributes in None, True, ("B33040",):
+                    with warnings.catch_warnings():
+                        warnings.simplefilter("ignore", DeprecationWarning)
+                        vars1 = read(tr.query_data({}), native, checkConflicts=False, attributes=attributes)
+                        vars2 = read(tr.query_data({}), generic, checkConflicts=False, attributes=attributes,
+                                     filter=lambda rec: True)
+                    self.assertSameVolumes(vars1, vars2)
+
+            with self.assertRaises(IndexError) as e1:
+                read(tr.query_data({}), (AnaIndex(),))
+            with self.assertRaises(IndexError) as e2:
+                read(tr.query_data({}), (AnaIndex(),), filter=lambda rec: True)
+            self.assertEqual(str(e1.exception), str(e2.exception))
+
+
 class TestReadV7(ReadMixin, unittest.TestCase):
     DB_FORMAT = "V7"
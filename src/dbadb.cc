@@ -5,12 +5,15 @@
 #include <dballe/message.h>
 #include <dballe/msg/msg.h>
 #include <dballe/db/db.h>
+#include <dballe/db/v7/trace.h>
+#include <dballe/db/server.h>
 #include <wreport/error.h>
 #include <wreport/options.h>
 #include <wreport/utils/string.h>
 
 #include <cstdlib>
 #include <cstring>
+#include <csignal>
 
 using namespace dballe;
 using namespace dballe::cmdline;
@@ -36,6 +39,16 @@ int op_full_pseudoana = 0;
 int op_verbose = 0;
 int op_precise_import = 0;
 int op_wipe_disappear = 0;
+int op_jobs = 1;
+int op_max_subsets = 1;
+int op_max_bytes = 0;
+int op_compress = 0;
+int op_metrics = 0;
+const char* op_before = "";
+const char* op_socket = "";
+int op_pool = 4;
+int op_query_cache = 1024;
+int op_max_clients = 64;
 
 
 struct poptOption grepTable[] = {
@@ -59,10 +72,12 @@ struct poptOption dbTable[] = {
         "DSN, or URL-like database definition, to use for connecting to the DB-All.e database (can also be specified in the environment as DBA_DB)", "url" },
     { "wipe-first", 0, POPT_ARG_NONE, &op_wipe_first, 0,
         "wipe database before any other action", 0 },
+    { "metrics", 0, POPT_ARG_NONE, &op_metrics, 0,
+        "print statistics about database operations to standard error when done", 0 },
     POPT_TABLEEND
 };
 
-static std::shared_ptr<db::DB> connect()
+static std::unique_ptr<DBConnectOptions> connect_options()
 {
     const char* chosen_url;
 
@@ -75,9 +90,20 @@ static std::shared_ptr<db::DB> connect()
     } else
         chosen_url = op_url;
 
+    // Metrics are only collected when requested
+    if (op_metrics)
+        setenv("DBA_METRICS", "1", 1);
+
     /* If url looks like a url, treat it accordingly */
-    auto options = DBConnectOptions::create(chosen_url);
-    auto db = dynamic_pointer_cast<db::DB>(DB::connect(*options));
+    return DBConnectOptions::create(chosen_url);
+}
+
+/// Connect to the database directly
+static std::shared_ptr<db::DB> connect()
+{
+    auto db = dynamic_pointer_cast<db::DB>(DB::connect(*connect_options()));
+    if (!db)
+        throw error_consistency("this command needs to connect to the database directly, and cannot use a dballe server");
 
     // Wipe database if requested
     if (op_wipe_first)
@@ -86,6 +112,15 @@ static std::shared_ptr<db::DB> connect()
     return db;
 }
 
+/// Connect to the database directly, or through a dballe server
+static std::shared_ptr<DB> connect_any()
+{
+    // Wiping the database needs to connect to it directly
+    if (op_wipe_first)
+        return connect();
+    return DB::connect(*connect_options());
+}
+
 
 // Command line parsing wrappers for Dbadb methods
 
@@ -121,7 +156,7 @@ struct DumpCmd : public DatabaseCmd
         core::Query query;
         dba_cmdline_get_query(optCon, query);
 
-        auto db = connect();
+        auto db = connect_any();
         Dbadb dbadb(*db);
 
         return dbadb.do_dump(query, stdout);
@@ -150,7 +185,7 @@ struct StationsCmd : public DatabaseCmd
         core::Query query;
         dba_cmdline_get_query(optCon, query);
 
-        auto db = connect();
+        auto db = connect_any();
         Dbadb dbadb(*db);
 
         return dbadb.do_stations(query, stdout);
@@ -224,6 +259,44 @@ struct CleanupCmd : public DatabaseCmd
     }
 };
 
+/// Delete old data
+struct RetentionCmd : public DatabaseCmd
+{
+    RetentionCmd()
+    {
+        names.push_back("retention");
+        usage = "retention [options] --before=datetime";
+        desc = "Delete data older than a given date";
+        longdesc =
+            "Delete all the data with a datetime before the one given with "
+            "--before, as YYYY-MM-DD or YYYY-MM-DD HH:MM:SS. "
+            "On databases partitioned by time, expired partitions are "
+            "dropped as a whole. Run cleanup afterwards to remove stations "
+            "left without data.";
+    }
+
+    void add_to_optable(std::vector<poptOption>& opts) const override
+    {
+        DatabaseCmd::add_to_optable(opts);
+        opts.push_back({ "before", 0, POPT_ARG_STRING, &op_before, 0,
+            "delete data older than this date", "datetime" });
+    }
+
+    int main(poptContext optCon) override
+    {
+        if (!*op_before)
+            throw error_cmdline("please use --before to specify the oldest datetime to keep");
+
+        std::string before(op_before);
+        if (before.size() == 10)
+            before += " 00:00:00";
+
+        auto db = connect();
+        db->remove_data_before(Datetime::from_iso8601(before.c_str()));
+        return 0;
+    }
+};
+
 /// Update repinfo information in the database
 struct RepinfoCmd : public DatabaseCmd
 {
@@ -347,7 +420,7 @@ struct ImportCmd : public DatabaseCmd
         if (op_varlist[0])
             resolve_varlist(op_varlist, [&](wreport::Varcode code) { opts->varlist.push_back(code); });
 
-        auto db = connect();
+        auto db = connect_any();
 
         if (strcmp(op_report, "") != 0)
             opts->report = op_report;
@@ -378,11 +451,21 @@ struct ExportCmd : public DatabaseCmd
         opts.push_back({ "report", 'r', POPT_ARG_STRING, &op_report, 0,
             "force exported data to be of this type of report", "rep" });
         opts.push_back({ "dest", 'd', POPT_ARG_STRING, &op_output_type, 0,
-            "format of the data in output ('bufr', 'crex', 'json')", "type" });
+            "format of the data in output ('bufr', 'crex', 'json', or 'arrow' for an"
+            " Arrow IPC stream of the data values)", "type" });
         opts.push_back({ "template", 't', POPT_ARG_STRING, &op_output_template, 0,
             "template of the data in output (autoselect if not specified, 'list' gives a list)", "name" });
         opts.push_back({ "dump", 0, POPT_ARG_NONE, &op_dump, 0,
             "dump data to be encoded instead of encoding it", 0 });
+        opts.push_back({ "jobs", 'j', POPT_ARG_INT, &op_jobs, 0,
+            "number of threads used to encode output messages (default: 1)", "num" });
+        opts.push_back({ "subsets", 0, POPT_ARG_INT, &op_max_subsets, 0,
+            "group up to this number of consecutive messages with the same template"
+            " as subsets of the same BUFR/CREX message (default: 1)", "num" });
+        opts.push_back({ "max-bytes", 0, POPT_ARG_INT, &op_max_bytes, 0,
+            "split groups of subsets so that each output message is at most this size in bytes", "bytes" });
+        opts.push_back({ "compress", 0, POPT_ARG_NONE, &op_compress, 0,
+            "compress BUFR output messages, when their subsets allow it", 0 });
     }
 
     int main(poptContext optCon) override
@@ -403,17 +486,29 @@ struct ExportCmd : public DatabaseCmd
         auto db = connect();
         Dbadb dbadb(*db);
 
-        const char* forced_repmemo = NULL;
-        if (strcmp(op_report, "") != 0)
-            forced_repmemo = op_report;
+        if (op_jobs < 1)
+            dba_cmdline_error(optCon, "--jobs must be at least 1");
+        if (op_max_subsets < 1)
+            dba_cmdline_error(optCon, "--subsets must be at least 1");
+        if (op_max_bytes < 0)
+            dba_cmdline_error(optCon, "--max-bytes must not be negative");
 
         if (op_dump)
         {
             return dbadb.do_export_dump(query, stdout);
+        } else if (strcmp(op_output_type, "arrow") == 0) {
+            return dbadb.do_export_arrow(query, stdout);
         } else {
+            cmdline::ExportOptions opts;
+            opts.output_template = op_output_template;
+            opts.forced_repmemo = op_report;
+            opts.jobs = op_jobs;
+            opts.max_subsets = op_max_subsets;
+            opts.max_bytes = op_max_bytes;
+            opts.compress = op_compress;
             Encoding type = File::parse_encoding(op_output_type);
             auto file = File::create(type, stdout, false, "w");
-            return dbadb.do_export(query, *file, op_output_template, forced_repmemo);
+            return dbadb.do_export(query, *file, opts);
         }
     }
 };
@@ -475,6 +570,73 @@ struct InfoCmd : public DatabaseCmd
 };
 
 
+struct ServeCmd : public DatabaseCmd
+{
+    ServeCmd()
+    {
+        names.push_back("serve");
+        usage = "serve [options] --socket=path";
+        desc = "Share the database with local clients through a Unix socket";
+        longdesc =
+            "Keep a pool of connections open to the database, and answer the "
+            "queries and imports of clients connecting to the Unix socket "
+            "given with --socket, until interrupted. "
+            "Clients connect using unix://path as the database URL.";
+    }
+
+    void add_to_optable(std::vector<poptOption>& opts) const override
+    {
+        DatabaseCmd::add_to_optable(opts);
+        opts.push_back({ "socket", 0, POPT_ARG_STRING, &op_socket, 0,
+            "pathname of the Unix socket to listen on", "path" });
+        opts.push_back({ "pool", 0, POPT_ARG_INT, &op_pool, 0,
+            "number of database connections to keep open (default: 4)", "num" });
+        opts.push_back({ "query-cache", 0, POPT_ARG_INT, &op_query_cache, 0,
+            "number of station and summary query results to cache, 0 to disable (default: 1024)", "num" });
+        opts.push_back({ "max-clients", 0, POPT_ARG_INT, &op_max_clients, 0,
+            "number of clients served at the same time, others wait to be accepted (default: 64)", "num" });
+    }
+
+    static db::Server* running;
+
+    static void on_signal(int)
+    {
+        if (running)
+            running->stop();
+    }
+
+    int main(poptContext optCon) override
+    {
+        if (!*op_socket)
+            throw error_cmdline("please use --socket to specify the socket to listen on");
+        if (op_pool < 1)
+            dba_cmdline_error(optCon, "--pool must be at least 1");
+        if (op_query_cache < 0)
+            dba_cmdline_error(optCon, "--query-cache must not be negative");
+        if (op_max_clients < 1)
+            dba_cmdline_error(optCon, "--max-clients must be at least 1");
+
+        auto options = connect_options();
+        if (op_wipe_first)
+            options->wipe = true;
+
+        db::Server server(*options, op_pool, op_query_cache, op_max_clients);
+        server.listen(op_socket);
+
+        running = &server;
+        signal(SIGINT, on_signal);
+        signal(SIGTERM, on_signal);
+        server.serve_forever();
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        running = nullptr;
+        return 0;
+    }
+};
+
+db::Server* ServeCmd::running = nullptr;
+
+
 int main (int argc, const char* argv[])
 {
     Command dbadb;
@@ -488,13 +650,18 @@ int main (int argc, const char* argv[])
     dbadb.add_subcommand(new StationsCmd);
     dbadb.add_subcommand(new WipeCmd);
     dbadb.add_subcommand(new CleanupCmd);
+    dbadb.add_subcommand(new RetentionCmd);
     dbadb.add_subcommand(new RepinfoCmd);
     dbadb.add_subcommand(new ImportCmd);
     dbadb.add_subcommand(new ExportCmd);
     dbadb.add_subcommand(new DeleteCmd);
     dbadb.add_subcommand(new InfoCmd);
+    dbadb.add_subcommand(new ServeCmd);
 
-    return dbadb.main(argc, argv);
+    int res = dbadb.main(argc, argv);
+    if (op_metrics)
+        db::v7::trace::Metrics::get().print(stderr);
+    return res;
 }
 
 /* vim:set ts=4 sw=4: */